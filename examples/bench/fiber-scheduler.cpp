@@ -0,0 +1,177 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <memory>
+
+// measures the cost of a context switch depending on the number of fibers on the thread
+// yield: all fibers are READY and pass the thread around with TFiber::Yield()
+// wait:  two fibers play ping-pong over a pair of pipes (WaitForMany() on a THandleWaitable),
+//        while all other fibers are BLOCKED on pipes that never become readable
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+static const usys_t IDLE_FIBERS_PER_PIPE = 256;
+
+static usys_t sz_stack = 16 * 1024;
+
+static std::unique_ptr<TFiber> StartFiber(TFunction<void> main_func)
+{
+	return std::make_unique<TFiber>(main_func, true, sz_stack, nullptr, EStackAllocator::MALLOC);
+}
+
+static void JoinFiber(TFiber& fiber)
+{
+	if(auto e = fiber.Join())
+	{
+		e->Print("FIBER");
+		EL_THROW(TException, U"benchmark fiber failed");
+	}
+}
+
+static const char* BackendName(const ESchedulerBackend backend)
+{
+	return backend == ESchedulerBackend::EPOLL ? "epoll" : "poll";
+}
+
+static void BenchYield(const usys_t n_fibers, const usys_t n_switches)
+{
+	const usys_t n_rounds = util::Max<usys_t>(1, n_switches / n_fibers);
+	TList<std::unique_ptr<TFiber>> fibers;
+	fibers.Prealloc(n_fibers);
+
+	for(usys_t i = 0; i < n_fibers; i++)
+		fibers.MoveAppend(StartFiber([n_rounds](){
+			for(usys_t j = 0; j < n_rounds; j++)
+				TFiber::Yield();
+		}));
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(auto& fiber : fibers)
+		JoinFiber(*fiber);
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+
+	const f64_t n_total = (f64_t)(n_fibers * n_rounds);
+	printf("yield               fibers=%-7zu switches=%-9.0f: %8.3f s, %9.1f ns/switch\n", (size_t)n_fibers, n_total, duration, duration * 1e9 / n_total);
+}
+
+static void BenchWait(const ESchedulerBackend backend, const usys_t n_fibers, const usys_t n_roundtrips)
+{
+	TThread::Self()->SchedulerBackend(backend);
+
+	const usys_t n_idle = n_fibers > 2 ? n_fibers - 2 : 0;
+	TList<std::unique_ptr<TPipe>> idle_pipes;
+	TList<std::unique_ptr<TFiber>> idle_fibers;
+	idle_fibers.Prealloc(n_idle);
+
+	for(usys_t i = 0; i < n_idle; i++)
+	{
+		if(i % IDLE_FIBERS_PER_PIPE == 0)
+			idle_pipes.MoveAppend(std::make_unique<TPipe>());
+
+		TPipe* const pipe = idle_pipes[idle_pipes.Count() - 1].get();
+		idle_fibers.MoveAppend(StartFiber([pipe](){
+			for(;;)
+				pipe->OnInputReady()->WaitFor();
+		}));
+	}
+
+	// let the idle fibers block
+	TFiber::Yield();
+
+	TPipe ping;
+	TPipe pong;
+	ping.ReceiveSide().BlockingIO(false);
+	pong.ReceiveSide().BlockingIO(false);
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+
+	std::unique_ptr<TFiber> responder = StartFiber([&](){
+		byte_t token;
+		for(usys_t i = 0; i < n_roundtrips; i++)
+		{
+			ping.ReadAll(&token, 1);
+			pong.WriteAll(&token, 1);
+		}
+	});
+
+	std::unique_ptr<TFiber> requester = StartFiber([&](){
+		byte_t token = 0x5a;
+		for(usys_t i = 0; i < n_roundtrips; i++)
+		{
+			ping.WriteAll(&token, 1);
+			pong.ReadAll(&token, 1);
+		}
+	});
+
+	JoinFiber(*requester);
+	JoinFiber(*responder);
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+
+	for(auto& fiber : idle_fibers)
+		fiber->Shutdown();
+	for(auto& fiber : idle_fibers)
+		JoinFiber(*fiber);
+
+	// every round trip blocks each of the two fibers once
+	const f64_t n_waits = (f64_t)(2 * n_roundtrips);
+	printf("wait  %-9s     fibers=%-7zu waits=%-12.0f: %8.3f s, %9.1f ns/wait\n", BackendName(backend), (size_t)n_fibers, n_waits, duration, duration * 1e9 / n_waits);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_switches = 10000000;
+		s64_t n_roundtrips = 100000;
+		s64_t sz_stack_arg = (s64_t)sz_stack;
+		bool with_poll = false;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure Yield() and WaitForMany() latency of the fiber scheduler at 10, 1k and 100k fibers."),
+			TIntegerArgument(&n_switches, 's', U"switches", U"", true, false, U"Total number of Yield() calls per fiber count"),
+			TIntegerArgument(&n_roundtrips, 'n', U"roundtrips", U"", true, false, U"Ping-pong round trips per fiber count"),
+			TIntegerArgument(&sz_stack_arg, 'k', U"stack-size", U"", true, false, U"Stack size of every fiber in bytes"),
+			TFlagArgument(&with_poll, 'p', U"poll", U"", U"Also measure the POLL scheduler backend (up to 1k fibers)")
+		);
+
+		EL_ERROR(n_switches < 1, TInvalidArgumentException, "switches", "at least one switch");
+		EL_ERROR(n_roundtrips < 1, TInvalidArgumentException, "roundtrips", "at least one round trip");
+		EL_ERROR(sz_stack_arg < 4096, TInvalidArgumentException, "stack-size", "at least 4096 bytes");
+		sz_stack = (usys_t)sz_stack_arg;
+
+		const ESchedulerBackend previous_backend = TThread::Self()->SchedulerBackend();
+
+		for(const usys_t n_fibers : { 10, 1000, 100000 })
+			BenchYield(n_fibers, (usys_t)n_switches);
+
+		for(const usys_t n_fibers : { 10, 1000, 100000 })
+		{
+			BenchWait(ESchedulerBackend::EPOLL, n_fibers, (usys_t)n_roundtrips);
+			// poll() refuses more fds than RLIMIT_NOFILE allows - every blocked fiber contributes one
+			if(with_poll && n_fibers <= 1000)
+				BenchWait(ESchedulerBackend::POLL, n_fibers, (usys_t)n_roundtrips);
+		}
+
+		TThread::Self()->SchedulerBackend(previous_backend);
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,90 @@
+#include <el1/error.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+// measures the cost of constructing, running and destroying a short-lived fiber
+// this is what a per-connection fiber model pays for every accepted connection
+// pool:    VIRTUAL_ALLOC stacks recycled through the stack pool of the thread
+// mmap:    VIRTUAL_ALLOC with the stack pool disabled (mmap/munmap + guard pages on every spawn)
+// malloc:  MALLOC stacks without guard pages
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+static const usys_t MAX_TOUCH_BYTES = 32 * 1024;
+static volatile byte_t sink;
+
+static void BenchSpawn(const char* const name, const EStackAllocator allocator, const usys_t sz_pool, const usys_t sz_stack, const usys_t sz_touch, const usys_t n_spawns)
+{
+	const usys_t sz_pool_old = TFiber::STACK_POOL_MAX_BYTES;
+	TFiber::STACK_POOL_MAX_BYTES = sz_pool;
+	const stack_pool_stats_t before = TThread::Self()->StackPoolStats();
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_spawns; i++)
+	{
+		TFiber fiber([sz_touch](){
+			// dirty the top of the stack like a request handler would
+			volatile byte_t buffer[MAX_TOUCH_BYTES];
+			for(usys_t j = 0; j < sz_touch; j += 512)
+				buffer[MAX_TOUCH_BYTES - 1 - j] = (byte_t)j;
+			sink = buffer[MAX_TOUCH_BYTES - 1];
+		}, true, sz_stack, nullptr, allocator);
+
+		if(auto e = fiber.Join())
+		{
+			e->Print("FIBER");
+			EL_THROW(TException, U"benchmark fiber failed");
+		}
+	}
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+
+	const stack_pool_stats_t after = TThread::Self()->StackPoolStats();
+	TFiber::STACK_POOL_MAX_BYTES = sz_pool_old;
+
+	printf("spawn %-7s stack=%-8zu touch=%-6zu: %8.3f s, %9.1f ns/fiber (pool hits=%llu misses=%llu)\n", name, (size_t)sz_stack, (size_t)sz_touch, duration, duration * 1e9 / (f64_t)n_spawns,
+		(unsigned long long)(after.n_hits - before.n_hits), (unsigned long long)(after.n_misses - before.n_misses));
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_spawns = 200000;
+		s64_t sz_touch = 8 * 1024;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure the cost of spawning short-lived fibers with and without the stack pool."),
+			TIntegerArgument(&n_spawns, 'n', U"spawns", U"", true, false, U"Number of fibers spawned per configuration"),
+			TIntegerArgument(&sz_touch, 't', U"touch", U"", true, false, U"Bytes of stack every fiber writes to")
+		);
+
+		EL_ERROR(n_spawns < 1, TInvalidArgumentException, "spawns", "at least one fiber");
+		EL_ERROR(sz_touch < 1 || (usys_t)sz_touch > MAX_TOUCH_BYTES, TInvalidArgumentException, "touch", "between 1 and 32768 bytes");
+
+		for(const usys_t sz_stack : { 64 * 1024, 1024 * 1024 })
+		{
+			BenchSpawn("pool", EStackAllocator::VIRTUAL_ALLOC, 64 * 1024 * 1024, sz_stack, (usys_t)sz_touch, (usys_t)n_spawns);
+			BenchSpawn("mmap", EStackAllocator::VIRTUAL_ALLOC, 0, sz_stack, (usys_t)sz_touch, (usys_t)n_spawns);
+			BenchSpawn("malloc", EStackAllocator::MALLOC, 0, sz_stack, (usys_t)sz_touch, (usys_t)n_spawns);
+		}
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
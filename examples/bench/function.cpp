@@ -0,0 +1,142 @@
+#include <el1/error.hpp>
+#include <el1/io_file.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+#include <el1/util_function.hpp>
+
+#include <cstdio>
+
+// measures what it costs to hand a callable to TFunction/TUniqueFunction and call it
+// inline: the callable lives inside the function object (function pointers, member function bindings, small captures)
+// heap:   a capture larger than FUNCTION_INLINE_BYTES, this is the allocation + reference count every TFunction used to pay
+// create: construct, copy once (like passing it by value), call and destroy
+// fiber:  spawn, run and join a fiber whose main function is inline or heap-allocated
+// enum:   TDirectory::Enum() of --dir with an inline or heap-allocated receiver (TPath::Browse() is only declared, Enum() is the directory callback which exists)
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::file;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+using namespace el1::util::function;
+
+static volatile u64_t sink;
+
+static f64_t NanosecondsPerOp(const TTime ts_start, const usys_t n_ops)
+{
+	return (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS) * 1e9 / (f64_t)n_ops;
+}
+
+struct TAccumulator
+{
+	u64_t sum = 0;
+	void Add(u64_t x) { sum += x; }
+};
+
+// large enough to never be stored inline
+struct padding_t
+{
+	u64_t values[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+};
+
+template<typename F, typename G>
+static void BenchCreate(const char* const name, const usys_t n_ops, G make)
+{
+	TAccumulator accumulator;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_ops; i++)
+	{
+		F f = make(accumulator);
+		F g = std::move(f);
+		g((u64_t)i);
+	}
+	const f64_t ns = NanosecondsPerOp(ts_start, n_ops);
+	sink = accumulator.sum;
+	printf("create %-32s: %7.1f ns\n", name, ns);
+}
+
+static void BenchCreateAll(const usys_t n_ops)
+{
+	BenchCreate<TFunction<void, u64_t>>("TFunction member (inline)", n_ops, [](TAccumulator& a) { return TFunction<void, u64_t>(&a, &TAccumulator::Add); });
+	BenchCreate<TFunction<void, u64_t>>("TFunction lambda (inline)", n_ops, [](TAccumulator& a) { return TFunction<void, u64_t>([&a](u64_t x) { a.Add(x); }); });
+	BenchCreate<TFunction<void, u64_t>>("TFunction lambda (heap)", n_ops, [](TAccumulator& a) { return TFunction<void, u64_t>([&a, padding = padding_t()](u64_t x) { a.Add(x + padding.values[0]); }); });
+	BenchCreate<TUniqueFunction<void, u64_t>>("TUniqueFunction lambda (inline)", n_ops, [](TAccumulator& a) { return TUniqueFunction<void, u64_t>([&a](u64_t x) { a.Add(x); }); });
+	BenchCreate<TUniqueFunction<void, u64_t>>("TUniqueFunction lambda (heap)", n_ops, [](TAccumulator& a) { return TUniqueFunction<void, u64_t>([&a, padding = padding_t()](u64_t x) { a.Add(x + padding.values[0]); }); });
+}
+
+template<typename L>
+static void BenchFiber(const char* const name, const usys_t n_spawns, L main_func)
+{
+	// fills the stack pool of the thread first
+	for(usys_t i = 0; i < 16; i++)
+		EL_ERROR(TFiber(main_func, true, 64 * 1024).Join() != nullptr, TException, U"benchmark fiber failed");
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_spawns; i++)
+	{
+		TFiber fiber(main_func, true, 64 * 1024);
+		if(auto e = fiber.Join())
+		{
+			e->Print("FIBER");
+			EL_THROW(TException, U"benchmark fiber failed");
+		}
+	}
+	printf("fiber  %-32s: %7.1f ns\n", name, NanosecondsPerOp(ts_start, n_spawns));
+}
+
+template<typename L>
+static void BenchEnum(const char* const name, const TDirectory& dir, const usys_t n_enums, L receiver)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_enums; i++)
+		dir.Enum(receiver);
+	printf("enum   %-32s: %7.1f ns\n", name, NanosecondsPerOp(ts_start, n_enums));
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_ops = 10000000;
+		s64_t n_spawns = 200000;
+		s64_t n_enums = 20000;
+		TString dir_path = U"/etc";
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Compare inline and heap-allocated callables in TFunction, TUniqueFunction, fiber spawns and directory enumeration."),
+			TIntegerArgument(&n_ops, 'n', U"ops", U"", true, false, U"Function objects created per configuration"),
+			TIntegerArgument(&n_spawns, 's', U"spawns", U"", true, false, U"Fibers spawned per configuration"),
+			TIntegerArgument(&n_enums, 'e', U"enums", U"", true, false, U"Directory enumerations per configuration"),
+			TStringArgument(&dir_path, 'd', U"dir", U"", true, false, U"Directory to enumerate")
+		);
+
+		EL_ERROR(n_ops < 1 || n_spawns < 1 || n_enums < 1, TInvalidArgumentException, "ops", "at least one iteration");
+
+		BenchCreateAll((usys_t)n_ops);
+
+		u64_t n_runs = 0;
+		BenchFiber("inline", (usys_t)n_spawns, [&n_runs]() { n_runs++; });
+		BenchFiber("heap", (usys_t)n_spawns, [&n_runs, padding = padding_t()]() { n_runs += padding.values[0]; });
+		sink = n_runs;
+
+		const TDirectory dir = TPath(dir_path);
+		u64_t n_entries = 0;
+		BenchEnum("inline", dir, (usys_t)n_enums, [&n_entries](direntry_t&) { n_entries++; return true; });
+		BenchEnum("heap", dir, (usys_t)n_enums, [&n_entries, padding = padding_t()](direntry_t&) { n_entries += padding.values[0]; return true; });
+		sink = n_entries;
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,186 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_collection_map.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+#include "random.hpp"
+
+// compares THashMap against TSortedMap
+// int:    u64 keys, random insertion order, lookups of present and absent keys
+// string: TString keys, lookups through TStringView slices of a larger text (no temporary TString)
+// beyond --sorted-insert-max the sorted map is bulk-loaded instead of being filled one item at a time
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::collection::map;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+static volatile u64_t sink;
+
+static f64_t Seconds(const TTime ts_start)
+{
+	return (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+}
+
+template<typename TMap, typename TKeyList>
+static f64_t MeasureLookups(const TMap& map, const TKeyList& keys, const usys_t n_lookups)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	u64_t n_found = 0;
+	for(usys_t i = 0; i < n_lookups; i++)
+		n_found += map.Get(keys[i % keys.Count()]) != nullptr ? 1 : 0;
+	sink = n_found;
+	return Seconds(ts_start) * 1e9 / (f64_t)n_lookups;
+}
+
+static void PrintResult(const char* const workload, const char* const map, const usys_t n_items, const f64_t ns_insert, const f64_t ns_hit, const f64_t ns_miss)
+{
+	if(ns_insert < 0)
+		printf("%-6s %-6s items=%-9zu: insert   (bulk), hit %7.1f ns, miss %7.1f ns\n", workload, map, (size_t)n_items, ns_hit, ns_miss);
+	else
+		printf("%-6s %-6s items=%-9zu: insert %7.1f ns, hit %7.1f ns, miss %7.1f ns\n", workload, map, (size_t)n_items, ns_insert, ns_hit, ns_miss);
+}
+
+static void BenchInt(const usys_t n_items, const usys_t n_lookups, const usys_t n_sorted_insert_max)
+{
+	u64_t state = n_items;
+	TList<u64_t> keys;
+	TList<u64_t> absent;
+	keys.Prealloc(n_items);
+	for(usys_t i = 0; i < n_items; i++)
+		keys.Append(NextRandom(state) | 1);
+	for(usys_t i = 0; i < util::Min<usys_t>(n_items, 1 << 20); i++)
+		absent.Append(NextRandom(state) & ~(u64_t)1);
+
+	{
+		THashMap<u64_t, u64_t> map;
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		for(usys_t i = 0; i < n_items; i++)
+			map.Set(keys[i], i);
+		const f64_t ns_insert = Seconds(ts_start) * 1e9 / (f64_t)n_items;
+		PrintResult("int", "hash", n_items, ns_insert, MeasureLookups(map, keys, n_lookups), MeasureLookups(map, absent, n_lookups));
+	}
+
+	{
+		TSortedMap<u64_t, u64_t> map;
+		f64_t ns_insert = -1;
+		if(n_items <= n_sorted_insert_max)
+		{
+			const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+			for(usys_t i = 0; i < n_items; i++)
+				map.Set(keys[i], i);
+			ns_insert = Seconds(ts_start) * 1e9 / (f64_t)n_items;
+		}
+		else
+		{
+			TList<kv_pair_tt<u64_t, u64_t>> items;
+			items.Prealloc(n_items);
+			for(usys_t i = 0; i < n_items; i++)
+				items.Append({ keys[i], i });
+			map = TSortedMap<u64_t, u64_t>(std::move(items));
+		}
+		PrintResult("int", "sorted", n_items, ns_insert, MeasureLookups(map, keys, n_lookups), MeasureLookups(map, absent, n_lookups));
+	}
+}
+
+static void BenchString(const usys_t n_items, const usys_t n_lookups, const usys_t n_sorted_insert_max)
+{
+	// every key is a 12 digit hex number, the lookups slice them out of one long text
+	TString text;
+	u64_t state = n_items + 1;
+	const usys_t n_text = n_items + util::Min<usys_t>(n_items, 1 << 20);
+	for(usys_t i = 0; i < n_text; i++)
+		text += TString::Format(U"%012x", (u64_t)(NextRandom(state) & 0xffffffffffffULL));
+
+	TList<TStringView> keys;
+	TList<TStringView> absent;
+	keys.Prealloc(n_items);
+	for(usys_t i = 0; i < n_items; i++)
+		keys.Append(text.View().SliceSL(i * 12, 12));
+	for(usys_t i = n_items; i < n_text; i++)
+		absent.Append(text.View().SliceSL(i * 12, 12));
+
+	{
+		THashMap<TString, u64_t> map;
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		for(usys_t i = 0; i < n_items; i++)
+			map.Set(TString(keys[i]), i);
+		const f64_t ns_insert = Seconds(ts_start) * 1e9 / (f64_t)n_items;
+		PrintResult("string", "hash", n_items, ns_insert, MeasureLookups(map, keys, n_lookups), MeasureLookups(map, absent, n_lookups));
+	}
+
+	{
+		// TSortedMap has no heterogeneous lookup, it gets prebuilt TString keys so no allocation is measured
+		TList<TString> string_keys;
+		TList<TString> string_absent;
+		for(const TStringView key : keys)
+			string_keys.Append(TString(key));
+		for(const TStringView key : absent)
+			string_absent.Append(TString(key));
+
+		TSortedMap<TString, u64_t> map;
+		f64_t ns_insert = -1;
+		if(n_items <= n_sorted_insert_max)
+		{
+			const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+			for(usys_t i = 0; i < n_items; i++)
+				map.Set(string_keys[i], i);
+			ns_insert = Seconds(ts_start) * 1e9 / (f64_t)n_items;
+		}
+		else
+		{
+			TList<kv_pair_tt<TString, u64_t>> items;
+			for(usys_t i = 0; i < n_items; i++)
+				items.MoveAppend({ string_keys[i], i });
+			map = TSortedMap<TString, u64_t>(std::move(items));
+		}
+		PrintResult("string", "sorted", n_items, ns_insert, MeasureLookups(map, string_keys, n_lookups), MeasureLookups(map, string_absent, n_lookups));
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_max = 10000000;
+		s64_t n_string_max = 1000000;
+		s64_t n_lookups = 2000000;
+		s64_t n_sorted_insert_max = 100000;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Compare THashMap and TSortedMap on insert, hit and miss lookups from 1k to 10M entries."),
+			TIntegerArgument(&n_max, 'm', U"max-items", U"", true, false, U"Largest map size for the integer workload"),
+			TIntegerArgument(&n_string_max, 's', U"max-string-items", U"", true, false, U"Largest map size for the string workload"),
+			TIntegerArgument(&n_lookups, 'n', U"lookups", U"", true, false, U"Lookups per measurement"),
+			TIntegerArgument(&n_sorted_insert_max, 'i', U"sorted-insert-max", U"", true, false, U"Largest TSortedMap which is filled one item at a time")
+		);
+
+		EL_ERROR(n_max < 1000, TInvalidArgumentException, "max-items", "at least 1000 items");
+		EL_ERROR(n_lookups < 1, TInvalidArgumentException, "lookups", "at least one lookup");
+
+		for(usys_t n_items = 1000; n_items <= (usys_t)n_max; n_items *= 10)
+			BenchInt(n_items, (usys_t)n_lookups, (usys_t)n_sorted_insert_max);
+
+		for(usys_t n_items = 1000; n_items <= (usys_t)n_string_max; n_items *= 10)
+			BenchString(n_items, (usys_t)n_lookups, (usys_t)n_sorted_insert_max);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
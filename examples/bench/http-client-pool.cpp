@@ -0,0 +1,167 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_net_http.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/io_net_tls.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <memory>
+
+// HTTPS requests per second of concurrent client fibers against a loopback THttpServer, client and server share the thread
+// connect:  every request uses a new THttpClient, i.e. a new TCP connection and TLS handshake (resumed after the first)
+// pool-h1:  THttpClientPool with HTTP/1.1 keep-alive connections, at most --connections of them
+// pool-h2:  THttpClientPool multiplexing all requests as streams over one HTTP/2 connection (ALPN "h2")
+// the CPU time covers both ends of the connections
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::file;
+using namespace el1::io::net;
+using namespace el1::io::net::http;
+using namespace el1::io::net::ip;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+struct bench_t
+{
+	port_t port;
+	tls::TPemSource ca_certificates;
+	usys_t n_fibers;
+	usys_t n_requests;	// per fiber
+	usys_t body_size;
+};
+
+static void JoinFibers(TList<std::unique_ptr<TFiber>>& fibers)
+{
+	bool failed = false;
+	for(auto& fiber : fibers)
+		if(auto e = fiber->Join())
+		{
+			e->Print("FIBER");
+			failed = true;
+		}
+	EL_ERROR(failed, TException, U"benchmark fiber failed");
+}
+
+static void CheckResponse(const THttpClient::response_t& response, const bench_t& bench)
+{
+	EL_ERROR(response.status != EStatus::OK || response.body.Count() != bench.body_size, TException, U"unexpected response");
+}
+
+template<typename F>
+static void Measure(const char* const name, const bench_t& bench, F&& fiber_main, const THttpClientPool* const pool)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	const TTime ts_cpu_start = TTime::Now(EClock::PROCESS);
+
+	TList<std::unique_ptr<TFiber>> fibers;
+	for(usys_t i = 0; i < bench.n_fibers; i++)
+		fibers.MoveAppend(New<TFiber>(fiber_main));
+	JoinFibers(fibers);
+
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+	const f64_t cpu = (TTime::Now(EClock::PROCESS) - ts_cpu_start).ConvertToF(EUnit::SECONDS);
+	const f64_t n_requests = (f64_t)(bench.n_fibers * bench.n_requests);
+	printf("%-8s: %8.3f s, %8.0f req/s, %7.1f us CPU/req", name, duration, n_requests / duration, cpu * 1e6 / n_requests);
+	if(pool != nullptr)
+		printf(" (connects=%llu reused=%llu waits=%llu)", (unsigned long long)pool->Stats().n_connects, (unsigned long long)pool->Stats().n_reused, (unsigned long long)pool->Stats().n_waits);
+	printf("\n");
+}
+
+static void BenchConnect(const bench_t& bench)
+{
+	tls::client_config_t tls_config;
+	tls_config.ca_certificates = bench.ca_certificates;
+	tls_config.application_protocols = { U"http/1.1" };
+	tls_config.session_cache = New<tls::TSessionCache>();
+
+	Measure("connect", bench, [&bench, &tls_config]() {
+		for(usys_t i = 0; i < bench.n_requests; i++)
+		{
+			THttpClient client(U"localhost", bench.port, tls_config);
+			CheckResponse(client.Get(U"/"), bench);
+		}
+	}, nullptr);
+}
+
+static void BenchPool(const char* const name, const bench_t& bench, const bool http2, const usys_t max_connections)
+{
+	THttpClientPool::config_t config;
+	config.http2 = http2;
+	config.max_connections_per_origin = max_connections;
+	config.tls.ca_certificates = bench.ca_certificates;
+	THttpClientPool pool(config);
+	const THttpClientPool::origin_t origin = { U"localhost", bench.port, true };
+
+	Measure(name, bench, [&bench, &pool, &origin]() {
+		for(usys_t i = 0; i < bench.n_requests; i++)
+			CheckResponse(pool.Get(origin, U"/"), bench);
+	}, &pool);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_fibers = 32;
+		s64_t n_requests = 200;
+		s64_t n_connections = 8;
+		s64_t body_size = 1024;
+		TPath tls_certificate = U"support/tls-test-cert.pem";
+		TPath tls_key = U"support/tls-test-key.pem";
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure HTTPS requests per second with a new connection per request, with pooled HTTP/1.1 keep-alive connections and multiplexed over one HTTP/2 connection."),
+			TIntegerArgument(&n_fibers, 'f', U"fibers", U"", true, false, U"Concurrent client fibers"),
+			TIntegerArgument(&n_requests, 'n', U"requests", U"", true, false, U"Requests per fiber"),
+			TIntegerArgument(&n_connections, 'c', U"connections", U"", true, false, U"HTTP/1.1 connections of the pool"),
+			TIntegerArgument(&body_size, 'b', U"body-size", U"", true, false, U"Size of the response body in bytes"),
+			TPathArgument(&tls_certificate, 'C', U"tls-certificate", U"", true, false, U"PEM certificate chain of the server"),
+			TPathArgument(&tls_key, 'K', U"tls-key", U"", true, false, U"PEM private key of the server")
+		);
+
+		EL_ERROR(n_fibers < 1, TInvalidArgumentException, "fibers", "at least one fiber");
+		EL_ERROR(n_requests < 1, TInvalidArgumentException, "requests", "at least one request");
+		EL_ERROR(n_connections < 1, TInvalidArgumentException, "connections", "at least one connection");
+		EL_ERROR(body_size < 0, TInvalidArgumentException, "body-size", "must not be negative");
+
+		tls::server_config_t server_config;
+		server_config.certificate_chain = tls::TPemSource(tls_certificate);
+		server_config.private_key = tls::TPemSource(tls_key);
+		server_config.application_protocols = { U"h2", U"http/1.1" };
+
+		TTcpServer tcp_server(ipaddr_t(U"127.0.0.1"), 0);
+		tls::TServer tls_server(&tcp_server, server_config);
+		TList<byte_t> body;
+		body.SetCount((usys_t)body_size);
+		for(byte_t& byte : body)
+			byte = 'x';
+		THttpServer http_server(&tls_server, [&body](const THttpServer::request_t&, THttpServer::response_t& response) {
+			response.status = EStatus::OK;
+			response.body = New<TListSource<byte_t>>(body);
+		});
+
+		const bench_t bench = { tcp_server.LocalAddress().port, tls::TPemSource(tls_certificate), (usys_t)n_fibers, (usys_t)n_requests, (usys_t)body_size };
+		BenchConnect(bench);
+		BenchPool("pool-h1", bench, false, (usys_t)n_connections);
+		BenchPool("pool-h2", bench, true, (usys_t)n_connections);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
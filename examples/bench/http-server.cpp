@@ -0,0 +1,418 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_net_http.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/io_net_tls.hpp>
+#include <el1/io_stream.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+
+// HTTP/1.1 request throughput in the style of h1load
+// decode: THttpRequestDecoder alone, parsing pipelined requests from memory
+// encode: THttpResponseEncoder into a sink which counts Write() calls, on a socket every call is one write() syscall
+// server: THttpServer on loopback TCP, every client connection keeps sending requests and counts the (empty) responses
+//         --pipeline requests are sent at once before the responses are read
+// shards: the same against THttpShardedServer with --shards threads, the clients run on a TFiberPool of as many threads
+// files:  the same with a static file as response body, from memory (copied through user-space), as TFile opened
+//         for every request (sendfile) and from THttpFileCache (sendfile, no open() and no stat() per request)
+// https:  the cached file over TLS, with the records encrypted by OpenSSL in user-space and by the kernel (kTLS),
+//         kTLS lets sendfile() work for TLS connections as well, it falls back to OpenSSL when the kernel lacks support
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::file;
+using namespace el1::io::net::http;
+using namespace el1::io::net;
+using namespace el1::io::net::ip;
+using namespace el1::io::stream;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+static volatile u64_t sink;
+
+// what h1load and wrk send by default, plus a query string
+static const char* const REQUEST =
+	"GET /index.html?lang=en&page=1 HTTP/1.1\r\n"
+	"Host: localhost\r\n"
+	"User-Agent: h1load\r\n"
+	"Accept: */*\r\n"
+	"Accept-Encoding: gzip, deflate\r\n"
+	"Connection: keep-alive\r\n"
+	"\r\n";
+
+static f64_t Seconds(const TTime ts_start)
+{
+	return (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+}
+
+static void JoinFiber(TFiber& fiber)
+{
+	if(auto e = fiber.Join())
+	{
+		e->Print("FIBER");
+		EL_THROW(TException, U"benchmark fiber failed");
+	}
+}
+
+static TList<byte_t> RepeatRequest(const usys_t n_requests)
+{
+	const usys_t sz_request = strlen(REQUEST);
+	TList<byte_t> requests;
+	requests.Prealloc(n_requests * sz_request);
+	for(usys_t i = 0; i < n_requests; i++)
+		requests.Append((const byte_t*)REQUEST, sz_request);
+	return requests;
+}
+
+static void BenchDecode(const usys_t n_requests)
+{
+	TListSource<byte_t> source { RepeatRequest(n_requests) };
+	THttpRequestDecoder decoder(source);
+	THttpRequest request;
+
+	usys_t n_decoded = 0;
+	u64_t n_headers = 0;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	while(decoder.Read(&request, 1) != 0)
+	{
+		n_decoded++;
+		n_headers += request.header_fields.Items().Count();
+	}
+	const f64_t duration = Seconds(ts_start);
+
+	EL_ERROR(n_decoded != n_requests, TException, U"not all requests were decoded");
+	sink = n_headers;
+	printf("decode requests=%-8zu: %8.3f s, %12.0f req/s, %8.1f MB/s\n", (size_t)n_requests, duration, (f64_t)n_requests / duration, (f64_t)(n_requests * strlen(REQUEST)) / 1e6 / duration);
+}
+
+// counts the calls, like a socket counts write() syscalls
+struct TCountingSink : ISink<byte_t>
+{
+	u64_t n_writes = 0;
+	u64_t n_bytes = 0;
+
+	usys_t Write(const byte_t* const, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT
+	{
+		n_writes++;
+		n_bytes += n_items_max;
+		return n_items_max;
+	}
+};
+
+// a typical dynamic response: ten header fields and an optional body of the given size (chunked when n_body is NEG1)
+static THttpResponseEncoder::response_t MakeResponse(const usys_t n_body)
+{
+	THttpResponseEncoder::response_t response;
+	response.status = EStatus::OK;
+	response.version = EVersion::HTTP11;
+	response.header_fields.Set(U"Server", U"el1");
+	response.header_fields.Set(U"Date", U"Sat, 17 Oct 2026 12:00:00 GMT");
+	response.header_fields.Set(U"Content-Type", U"text/html; charset=utf-8");
+	response.header_fields.Set(U"Cache-Control", U"no-cache");
+	response.header_fields.Set(U"Connection", U"keep-alive");
+	response.header_fields.Set(U"Vary", U"Accept-Encoding");
+	response.header_fields.Set(U"X-Content-Type-Options", U"nosniff");
+	response.header_fields.Set(U"X-Frame-Options", U"DENY");
+	response.header_fields.Set(U"X-Request-Id", U"4f1c2a9e-7b3d-4e8a-9c61-0d2b5e7f8a13");
+	if(n_body == 0)
+		return response;
+
+	TList<byte_t> body;
+	body.SetCount(n_body == NEG1 ? 1024 : n_body);
+	if(n_body != NEG1)
+		response.header_fields.ContentLength(n_body);
+	response.body = New<TListSource<byte_t>>(std::move(body));
+	return response;
+}
+
+static void BenchEncode(const char* const name, const usys_t n_responses, const usys_t n_body)
+{
+	TCountingSink sink;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_responses; i++)
+	{
+		THttpResponseEncoder::response_t response = MakeResponse(n_body);
+		THttpResponseEncoder(sink).WriteResponse(response);
+	}
+	const f64_t duration = Seconds(ts_start);
+	printf("encode %-18s: %8.1f writes/response, %6.0f bytes/response, %8.0f ns/response\n", name, (f64_t)sink.n_writes / n_responses, (f64_t)sink.n_bytes / n_responses, duration * 1e9 / n_responses);
+}
+
+// reads until n_responses responses were received, each ends with the blank line after the header and n_body bytes of body
+static void ReceiveResponses(IStreamClient& connection, usys_t n_responses, u8_t& n_matched, const usys_t n_body = 0)
+{
+	static const byte_t TERMINATOR[4] = { '\r', '\n', '\r', '\n' };
+	byte_t buffer[64 * 1024];
+	usys_t n_skip = 0;
+	while(n_responses != 0 || n_skip != 0)
+	{
+		const usys_t n = connection.Read(buffer, sizeof(buffer));
+		if(n == 0)
+		{
+			const system::waitable::IWaitable* const waitable = connection.OnInputReady();
+			EL_ERROR(waitable == nullptr, TException, U"server closed the connection");
+			waitable->WaitFor();
+			continue;
+		}
+
+		for(usys_t i = 0; i < n; i++)
+		{
+			if(n_skip != 0)
+			{
+				const usys_t n_now = util::Min(n_skip, n - i);
+				n_skip -= n_now;
+				i += n_now - 1;
+				continue;
+			}
+
+			n_matched = buffer[i] == TERMINATOR[n_matched] ? n_matched + 1 : (buffer[i] == '\r' ? 1 : 0);
+			if(n_matched == 4)
+			{
+				n_matched = 0;
+				n_responses--;
+				n_skip = n_body;
+			}
+		}
+	}
+}
+
+static void BenchServer(const usys_t n_connections, const usys_t n_requests, const usys_t n_pipeline)
+{
+	TTcpServer tcp_server(ipaddr_t(U"127.0.0.1"), 0);
+	const port_t port = tcp_server.LocalAddress().port;
+	THttpServer http_server(&tcp_server, [](const THttpServer::request_t&, THttpServer::response_t& response) {
+		response.status = EStatus::OK;
+		response.header_fields.ContentLength(0);
+	});
+	// every client keeps its connection for all of its requests
+	http_server.connection_limits.max_requests = NEG1;
+
+	const TList<byte_t> batch = RepeatRequest(n_pipeline);
+	TList<std::unique_ptr<TFiber>> clients;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+
+	for(usys_t i = 0; i < n_connections; i++)
+		clients.MoveAppend(std::make_unique<TFiber>([port, n_requests, n_pipeline, &batch]() {
+			TTcpClient connection(ipaddr_t(U"127.0.0.1"), port);
+			u8_t n_matched = 0;
+			for(usys_t n_sent = 0; n_sent < n_requests; n_sent += n_pipeline)
+			{
+				const usys_t n_now = util::Min(n_pipeline, n_requests - n_sent);
+				connection.WriteAll(batch.ItemPtr(0), n_now * strlen(REQUEST));
+				ReceiveResponses(connection, n_now, n_matched);
+			}
+		}));
+
+	for(auto& client : clients)
+		JoinFiber(*client);
+
+	const f64_t duration = Seconds(ts_start);
+	const f64_t n_total = (f64_t)(n_connections * n_requests);
+	printf("server connections=%-4zu requests=%-7zu pipeline=%-3zu: %8.3f s, %12.0f req/s\n", (size_t)n_connections, (size_t)n_requests, (size_t)n_pipeline, duration, n_total / duration);
+}
+
+static void BenchShardedServer(const usys_t n_shards, const usys_t n_connections, const usys_t n_requests, const usys_t n_pipeline)
+{
+	THttpShardedServer::config_t config;
+	config.n_shards = n_shards;
+	config.connection_limits.max_requests = NEG1;
+	THttpShardedServer http_server(ipaddr_t(U"127.0.0.1"), 0, [](const THttpServer::request_t&, THttpServer::response_t& response) {
+		response.status = EStatus::OK;
+		response.header_fields.ContentLength(0);
+	}, config);
+	const port_t port = http_server.LocalAddress().port;
+
+	const TList<byte_t> batch = RepeatRequest(n_pipeline);
+	TFiberPool clients(http_server.CountShards());
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+
+	for(usys_t i = 0; i < n_connections; i++)
+		clients.Spawn([port, n_requests, n_pipeline, &batch]() {
+			TTcpClient connection(ipaddr_t(U"127.0.0.1"), port);
+			u8_t n_matched = 0;
+			for(usys_t n_sent = 0; n_sent < n_requests; n_sent += n_pipeline)
+			{
+				const usys_t n_now = util::Min(n_pipeline, n_requests - n_sent);
+				connection.WriteAll(batch.ItemPtr(0), n_now * strlen(REQUEST));
+				ReceiveResponses(connection, n_now, n_matched);
+			}
+		});
+	EL_ERROR(!clients.WaitIdle(), TException, U"clients did not finish");
+
+	const f64_t duration = Seconds(ts_start);
+	const f64_t n_total = (f64_t)(n_connections * n_requests);
+	printf("shards=%-3zu connections=%-4zu requests=%-7zu pipeline=%-3zu: %8.3f s, %12.0f req/s\n", (size_t)http_server.CountShards(), (size_t)n_connections, (size_t)n_requests, (size_t)n_pipeline, duration, n_total / duration);
+}
+
+enum class EFileMode : u8_t
+{
+	MEMORY,
+	FILE,
+	CACHE,
+};
+
+// tls_config selects HTTPS, the clients use kTLS when the server does
+static void BenchFiles(const char* const name, const EFileMode mode, const TPath& path, const usys_t n_connections, const usys_t n_requests, const tls::server_config_t* const tls_config = nullptr)
+{
+	TFile reference(path);
+	const usys_t n_body = (usys_t)reference.Size();
+	TList<byte_t> content;
+	content.SetCount(n_body);
+	reference.ReadAll(content.ItemPtr(0), n_body);
+
+	THttpFileCache cache;
+	TTcpServer tcp_server(ipaddr_t(U"127.0.0.1"), 0);
+	const port_t port = tcp_server.LocalAddress().port;
+	std::unique_ptr<tls::TServer> tls_server;
+	if(tls_config != nullptr)
+		tls_server = std::make_unique<tls::TServer>(&tcp_server, *tls_config);
+	const bool kernel_tls = tls_config != nullptr && tls_config->kernel_tls;
+	const char* kernel_tls_state = "";
+
+	THttpServer http_server(tls_server != nullptr ? (IStreamServer*)tls_server.get() : &tcp_server, [mode, &path, &content, &cache](const THttpServer::request_t&, THttpServer::response_t& response) {
+		switch(mode)
+		{
+			case EFileMode::MEMORY:
+				response.status = EStatus::OK;
+				response.header_fields.ContentLength(content.Count());
+				response.body = New<TListSource<byte_t>>(content);
+				break;
+			case EFileMode::FILE:
+				response.status = EStatus::OK;
+				response.body = New<TFile>(path);
+				break;
+			case EFileMode::CACHE:
+				cache.Respond(path, response);
+				break;
+		}
+	});
+	http_server.connection_limits.max_requests = NEG1;
+
+	TList<std::unique_ptr<TFiber>> clients;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	const TTime ts_cpu_start = TTime::Now(EClock::PROCESS);
+
+	for(usys_t i = 0; i < n_connections; i++)
+		clients.MoveAppend(std::make_unique<TFiber>([port, n_requests, n_body, tls_config, kernel_tls, &kernel_tls_state]() {
+			std::unique_ptr<IStreamClient> connection;
+			if(tls_config == nullptr)
+				connection = std::make_unique<TTcpClient>(ipaddr_t(U"127.0.0.1"), port);
+			else
+			{
+				auto tls_client = std::make_unique<tls::TClient>(U"127.0.0.1", port, tls::client_config_t{ .verify_peer = false, .kernel_tls = kernel_tls });
+				tls_client->Negotiate();
+				kernel_tls_state = tls_client->KernelTlsSend() ? (tls_client->KernelTlsReceive() ? " (kTLS tx+rx)" : " (kTLS tx)") : " (kTLS off)";
+				connection = std::move(tls_client);
+			}
+
+			u8_t n_matched = 0;
+			for(usys_t j = 0; j < n_requests; j++)
+			{
+				connection->WriteAll((const byte_t*)REQUEST, strlen(REQUEST));
+				connection->Flush();
+				ReceiveResponses(*connection, 1, n_matched, n_body);
+			}
+		}));
+
+	for(auto& client : clients)
+		JoinFiber(*client);
+
+	const f64_t duration = Seconds(ts_start);
+	const f64_t cpu = (TTime::Now(EClock::PROCESS) - ts_cpu_start).ConvertToF(EUnit::SECONDS);
+	const f64_t n_total = (f64_t)(n_connections * n_requests);
+	printf("files  %-6s size=%-9zu: %8.3f s, %10.0f req/s, %8.1f MB/s, %6.2f CPU-s/GB%s\n", name, (size_t)n_body, duration, n_total / duration, n_total * n_body / 1e6 / duration, cpu / (n_total * n_body / 1e9), kernel_tls_state);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_decode = 200000;
+		s64_t n_connections = 16;
+		s64_t n_requests = 5000;
+		s64_t n_pipeline = 16;
+		s64_t n_shards = 0;
+		s64_t sz_file = 1024 * 1024;
+		s64_t n_file_requests = 200;
+		TPath tls_certificate = U"support/tls-test-cert.pem";
+		TPath tls_key = U"support/tls-test-key.pem";
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure HTTP/1.1 request decoding, response encoding and requests per second of THttpServer over loopback TCP."),
+			TIntegerArgument(&n_decode, 'd', U"decode-requests", U"", true, false, U"Requests parsed and responses encoded in memory"),
+			TIntegerArgument(&n_connections, 'c', U"connections", U"", true, false, U"Concurrent keep-alive connections"),
+			TIntegerArgument(&n_requests, 'n', U"requests", U"", true, false, U"Requests per connection"),
+			TIntegerArgument(&n_pipeline, 'p', U"pipeline", U"", true, false, U"Largest number of requests sent before reading the responses"),
+			TIntegerArgument(&n_shards, 'S', U"shards", U"", true, false, U"Server threads of the sharded run, 0 = one per CPU"),
+			TIntegerArgument(&sz_file, 's', U"file-size", U"", true, false, U"Size of the static file in bytes"),
+			TIntegerArgument(&n_file_requests, 'f', U"file-requests", U"", true, false, U"File requests per connection"),
+			TPathArgument(&tls_certificate, 'C', U"tls-certificate", U"", true, false, U"PEM certificate chain for the HTTPS runs, they are skipped if it does not exist"),
+			TPathArgument(&tls_key, 'K', U"tls-key", U"", true, false, U"PEM private key for the HTTPS runs")
+		);
+
+		EL_ERROR(n_decode < 1, TInvalidArgumentException, "decode-requests", "at least one request");
+		EL_ERROR(n_connections < 1, TInvalidArgumentException, "connections", "at least one connection");
+		EL_ERROR(n_requests < 1, TInvalidArgumentException, "requests", "at least one request");
+		EL_ERROR(n_pipeline < 1, TInvalidArgumentException, "pipeline", "at least one request");
+		EL_ERROR(n_shards < 0, TInvalidArgumentException, "shards", "must not be negative");
+		EL_ERROR(sz_file < 0, TInvalidArgumentException, "file-size", "must not be negative");
+		EL_ERROR(n_file_requests < 1, TInvalidArgumentException, "file-requests", "at least one request");
+
+		TFiber::FIBER_DEFAULT_STACK_SIZE_BYTES = 128 * 1024;
+
+		BenchDecode((usys_t)n_decode);
+		BenchEncode("no body", (usys_t)n_decode, 0);
+		BenchEncode("1 KiB body", (usys_t)n_decode, 1024);
+		BenchEncode("1 KiB chunked", (usys_t)n_decode, NEG1);
+		BenchServer((usys_t)n_connections, (usys_t)n_requests, 1);
+		if(n_pipeline > 1)
+			BenchServer((usys_t)n_connections, (usys_t)n_requests, (usys_t)n_pipeline);
+		BenchShardedServer((usys_t)n_shards, (usys_t)n_connections, (usys_t)n_requests, 1);
+
+		// the file goes to the temporary directory, it stays in the page cache for all runs
+		const TPath path = TPath(U"/tmp") + TString::Format(U"el1-bench-http-%d.bin", (u64_t)getpid());
+		{
+			TFile file(path, TAccess::RW, ECreateMode::DELETE);
+			TList<byte_t> data;
+			data.SetCount((usys_t)sz_file);
+			for(usys_t i = 0; i < data.Count(); i++)
+				data[i] = (byte_t)('a' + i % 26);
+			file.WriteAll(data.ItemPtr(0), data.Count());
+		}
+		BenchFiles("memory", EFileMode::MEMORY, path, (usys_t)n_connections, (usys_t)n_file_requests);
+		BenchFiles("TFile", EFileMode::FILE, path, (usys_t)n_connections, (usys_t)n_file_requests);
+		BenchFiles("cache", EFileMode::CACHE, path, (usys_t)n_connections, (usys_t)n_file_requests);
+		if(tls_certificate.Exists())
+		{
+			tls::server_config_t tls_config;
+			tls_config.certificate_chain = tls::TPemSource(tls_certificate);
+			tls_config.private_key = tls::TPemSource(tls_key);
+			tls_config.kernel_tls = false;
+			BenchFiles("https", EFileMode::CACHE, path, (usys_t)n_connections, (usys_t)n_file_requests, &tls_config);
+			tls_config.kernel_tls = true;
+			BenchFiles("ktls", EFileMode::CACHE, path, (usys_t)n_connections, (usys_t)n_file_requests, &tls_config);
+		}
+		path.Delete(false);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,189 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+// compares the READINESS and IO_URING I/O backends of TThread
+// echo: many loopback TCP connections, every client does a fixed number of request/response round trips
+// copy: several fibers copy a file each through TFile::Read()/TFile::WriteAll()
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::file;
+using namespace el1::io::net::ip;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+static void JoinFiber(TFiber& fiber)
+{
+	if(auto e = fiber.Join())
+	{
+		e->Print("FIBER");
+		EL_THROW(TException, U"benchmark fiber failed");
+	}
+}
+
+static const char* BackendName(const EIoBackend backend)
+{
+	return backend == EIoBackend::IO_URING ? "io_uring" : "readiness";
+}
+
+static void BenchEcho(const EIoBackend backend, const usys_t n_connections, const usys_t n_roundtrips, const usys_t sz_message)
+{
+	TThread::Self()->IoBackend(backend);
+
+	TTcpServer server(ipaddr_t(U"127.0.0.1"), 0);
+	const port_t port = server.LocalAddress().port;
+	TList<std::unique_ptr<TFiber>> servers;
+	TList<std::unique_ptr<TFiber>> clients;
+
+	TFiber acceptor([&](){
+		for(usys_t i = 0; i < n_connections; i++)
+		{
+			server.OnClientConnect().WaitFor();
+			std::shared_ptr<TTcpClient> connection = server.AcceptClient();
+			if(connection == nullptr)
+			{
+				i--;
+				continue;
+			}
+
+			servers.MoveAppend(std::make_unique<TFiber>([connection, sz_message, n_roundtrips](){
+				std::unique_ptr<byte_t[]> buffer(new byte_t[sz_message]);
+				for(usys_t j = 0; j < n_roundtrips; j++)
+				{
+					connection->ReadAll(buffer.get(), sz_message);
+					connection->WriteAll(buffer.get(), sz_message);
+				}
+			}));
+		}
+	});
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+
+	for(usys_t i = 0; i < n_connections; i++)
+		clients.MoveAppend(std::make_unique<TFiber>([port, sz_message, n_roundtrips](){
+			TTcpClient connection(ipaddr_t(U"127.0.0.1"), port);
+			std::unique_ptr<byte_t[]> buffer(new byte_t[sz_message]);
+			memset(buffer.get(), 0x5a, sz_message);
+			for(usys_t j = 0; j < n_roundtrips; j++)
+			{
+				connection.WriteAll(buffer.get(), sz_message);
+				connection.ReadAll(buffer.get(), sz_message);
+			}
+		}));
+
+	for(auto& client : clients)
+		JoinFiber(*client);
+
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+
+	JoinFiber(acceptor);
+	for(auto& fiber : servers)
+		JoinFiber(*fiber);
+
+	const f64_t n_total = (f64_t)(n_connections * n_roundtrips);
+	printf("echo  %-9s connections=%zu roundtrips=%zu size=%zu: %8.3f s, %12.0f roundtrips/s\n", BackendName(backend), (size_t)n_connections, (size_t)n_roundtrips, (size_t)sz_message, duration, n_total / duration);
+}
+
+static void BenchCopy(const EIoBackend backend, const usys_t n_fibers, const usys_t sz_file, const usys_t sz_block)
+{
+	TThread::Self()->IoBackend(backend);
+
+	TFile source;
+	{
+		std::unique_ptr<byte_t[]> block(new byte_t[sz_block]);
+		for(usys_t i = 0; i < sz_block; i++)
+			block[i] = (byte_t)(i * 31);
+		for(usys_t n = 0; n < sz_file; n += sz_block)
+			source.WriteAll(block.get(), util::Min(sz_block, sz_file - n));
+	}
+
+	TList<std::unique_ptr<TFiber>> fibers;
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+
+	for(usys_t i = 0; i < n_fibers; i++)
+		fibers.MoveAppend(std::make_unique<TFiber>([&source, sz_block](){
+			// each fiber gets its own file offset
+			TFile input(source);
+			input.Offset(0);
+			TFile output;
+			std::unique_ptr<byte_t[]> block(new byte_t[sz_block]);
+
+			for(;;)
+			{
+				const usys_t r = input.Read(block.get(), sz_block);
+				if(r == 0)
+					break;
+				output.WriteAll(block.get(), r);
+			}
+		}));
+
+	for(auto& fiber : fibers)
+		JoinFiber(*fiber);
+
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+	const f64_t n_mib = (f64_t)(n_fibers * sz_file) / (1024.0 * 1024.0);
+	printf("copy  %-9s fibers=%zu file=%zu block=%zu: %8.3f s, %10.1f MiB/s\n", BackendName(backend), (size_t)n_fibers, (size_t)sz_file, (size_t)sz_block, duration, n_mib / duration);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_connections = 256;
+		s64_t n_roundtrips = 1000;
+		s64_t sz_message = 64;
+		s64_t n_copy_fibers = 4;
+		s64_t sz_copy_file = 64 * 1024 * 1024;
+		s64_t sz_copy_block = 64 * 1024;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Compare the readiness and io_uring I/O backends on echo and file-copy workloads."),
+			TIntegerArgument(&n_connections, 'c', U"connections", U"", true, false, U"Number of concurrent loopback TCP connections"),
+			TIntegerArgument(&n_roundtrips, 'n', U"roundtrips", U"", true, false, U"Request/response round trips per connection"),
+			TIntegerArgument(&sz_message, 'm', U"message-size", U"", true, false, U"Size of every echo message in bytes"),
+			TIntegerArgument(&n_copy_fibers, 'f', U"copy-fibers", U"", true, false, U"Number of fibers copying a file concurrently"),
+			TIntegerArgument(&sz_copy_file, 's', U"copy-size", U"", true, false, U"Size of the copied file in bytes"),
+			TIntegerArgument(&sz_copy_block, 'b', U"copy-block", U"", true, false, U"Block size used for copying in bytes")
+		);
+
+		EL_ERROR(n_connections < 1, TInvalidArgumentException, "connections", "at least one connection");
+		EL_ERROR(n_roundtrips < 1, TInvalidArgumentException, "roundtrips", "at least one round trip");
+		EL_ERROR(sz_message < 1, TInvalidArgumentException, "message-size", "positive size");
+		EL_ERROR(n_copy_fibers < 1, TInvalidArgumentException, "copy-fibers", "at least one fiber");
+		EL_ERROR(sz_copy_file < 0, TInvalidArgumentException, "copy-size", "non-negative size");
+		EL_ERROR(sz_copy_block < 1, TInvalidArgumentException, "copy-block", "positive size");
+
+		// connection fibers only need small stacks, the buffers live on the heap
+		TFiber::FIBER_DEFAULT_STACK_SIZE_BYTES = 64 * 1024;
+
+		for(const EIoBackend backend : { EIoBackend::READINESS, EIoBackend::IO_URING })
+			BenchEcho(backend, n_connections, n_roundtrips, sz_message);
+
+		for(const EIoBackend backend : { EIoBackend::READINESS, EIoBackend::IO_URING })
+			BenchCopy(backend, n_copy_fibers, sz_copy_file, sz_copy_block);
+
+		TThread::Self()->IoBackend(EIoBackend::READINESS);
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,168 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_format_json.hpp>
+#include <el1/io_text.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+#include "random.hpp"
+
+// TJsonValue::Parse() throughput in GB/s of UTF-8 input
+// grammar: the TJsonParser::Parser() combinators over a TStreamTextReader, which is how Parse(TFile) used to work
+// utf8:    Parse(array_t<const byte_t>), the SIMD structural index and tape builder, which Parse(TFile) uses now
+// reader:  TJsonReader pulling every token from an ISource<byte_t> without building a TJsonValue
+// corpora: testdata/test1.json, a twitter-style one (long unicode strings, nested user objects) and a citm-style one (numbers, small maps and arrays)
+// small documents are parsed repeatedly until --size bytes were processed
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::file;
+using namespace el1::io::format::json;
+using namespace el1::io::text;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+static TList<byte_t> ToBytes(const TString& text)
+{
+	const auto c_str = text.MakeCStr();
+	TList<byte_t> bytes;
+	bytes.Append((const byte_t*)c_str.get(), strlen(c_str.get()));
+	return bytes;
+}
+
+static TList<byte_t> MakeTwitter(const usys_t sz_min)
+{
+	static const char32_t* const WORDS[] = { U"RT", U"@el1_dev:", U"parsing", U"JSON", U"faster", U"今日は", U"いい天気", U"ですね", U"café", U"naïve", U"#simd", U"https://t.co/x1", U"\\n", U"\\\"quoted\\\"", U"\\u00e9t\\u00e9", U"😀" };
+	u64_t state = 1;
+	TString text = U"{\"statuses\":[";
+	for(usys_t i = 0; text.Length() < sz_min; i++)
+	{
+		if(i != 0)
+			text += U',';
+		TString tweet;
+		for(unsigned k = 0; k < 8 + NextRandom(state) % 16; k++)
+		{
+			if(k != 0)
+				tweet += U' ';
+			tweet += TString(WORDS[NextRandom(state) % (sizeof(WORDS) / sizeof(WORDS[0]))]);
+		}
+		text += TString::Format(
+			U"{\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"id\":%d,\"id_str\":\"%d\",\"text\":\"%s\",\"truncated\":false,"
+			U"\"entities\":{\"hashtags\":[{\"text\":\"simd\",\"indices\":[%d,%d]}],\"symbols\":[],\"urls\":[],\"user_mentions\":[]},"
+			U"\"user\":{\"id\":%d,\"name\":\"ユーザー %d\",\"screen_name\":\"user_%d\",\"location\":\"東京\",\"description\":\"%s\",\"followers_count\":%d,\"verified\":false,\"lang\":\"ja\"},"
+			U"\"retweet_count\":%d,\"favorite_count\":%d,\"favorited\":false,\"retweeted\":false,\"lang\":\"ja\",\"coordinates\":null}",
+			505874924095815681ULL + i, 505874924095815681ULL + i, tweet, i % 100, i % 100 + 5, 1186275104 + i, i, i, tweet, NextRandom(state) % 100000, NextRandom(state) % 1000, NextRandom(state) % 1000);
+	}
+	text += U"]}";
+	return ToBytes(text);
+}
+
+static TList<byte_t> MakeCitm(const usys_t sz_min)
+{
+	u64_t state = 2;
+	TString text = U"{\"performances\":[";
+	for(usys_t i = 0; text.Length() < sz_min; i++)
+	{
+		if(i != 0)
+			text += U',';
+		text += TString::Format(U"{\"eventId\":%d,\"id\":%d,\"logo\":null,\"name\":null,\"prices\":[", 138586341 + i % 200, 339887544 + i);
+		for(unsigned k = 0; k < 3; k++)
+			text += TString::Format(U"%s{\"amount\":%d,\"audienceSubCategoryId\":337100890,\"seatCategoryId\":%d}", k == 0 ? U"" : U",", NextRandom(state) % 100000, 338937295 + k);
+		text += U"],\"seatCategories\":[";
+		for(unsigned k = 0; k < 2; k++)
+		{
+			text += TString::Format(U"%s{\"areas\":[", k == 0 ? U"" : U",");
+			for(unsigned a = 0; a < 4; a++)
+				text += TString::Format(U"%s{\"areaId\":%d,\"blockIds\":[]}", a == 0 ? U"" : U",", 205705993 + a);
+			text += TString::Format(U"],\"seatCategoryId\":%d}", 338937295 + k);
+		}
+		text += TString::Format(U"],\"seatMapImage\":null,\"start\":%d,\"venueCode\":\"PLEYEL_PLEYEL\"}", 1372701600000ULL + i * 86400000ULL);
+	}
+	text += U"]}";
+	return ToBytes(text);
+}
+
+static volatile usys_t sink;
+
+template<typename F>
+static void Measure(const char* const corpus, const char* const parser, const TList<byte_t>& input, const usys_t sz_min, F&& parse)
+{
+	const usys_t n_repeat = util::Max<usys_t>(1, sz_min / input.Count());
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	usys_t n = 0;
+	for(usys_t i = 0; i < n_repeat; i++)
+		n += parse(input);
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+	sink = n;
+	const f64_t n_bytes = (f64_t)(input.Count() * n_repeat);
+	printf("%-8s %-8s: %8.2f MB in %7.3f s, %7.3f GB/s, %6.2f ns/byte\n", corpus, parser, n_bytes / 1e6, duration, n_bytes / duration / 1e9, duration * 1e9 / n_bytes);
+}
+
+static void Bench(const char* const corpus, const TList<byte_t>& input, const usys_t sz_min, const bool grammar)
+{
+	if(grammar)
+		Measure(corpus, "grammar", input, sz_min, [](const TList<byte_t>& input) {
+			auto source = input.Source();
+			TStreamTextReader reader(&source);
+			return (usys_t)TJsonValue::Parse(reader).Type();
+		});
+
+	Measure(corpus, "utf8", input, sz_min, [](const TList<byte_t>& input) {
+		return (usys_t)TJsonValue::Parse(input).Type();
+	});
+
+	Measure(corpus, "reader", input, sz_min, [](const TList<byte_t>& input) {
+		auto source = input.Source();
+		TJsonReader reader(&source);
+		usys_t n_tokens = 0;
+		while(reader.Next() != EJsonToken::END)
+			n_tokens++;
+		return n_tokens;
+	});
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t sz_corpus = 4 << 20;
+		bool skip_grammar = false;
+		TPath test1 = U"testdata/test1.json";
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure TJsonValue::Parse() throughput on UTF-8 input with the parser combinator grammar and with the SIMD structural index, and the token throughput of TJsonReader."),
+			TIntegerArgument(&sz_corpus, 's', U"size", U"", true, false, U"Bytes of the generated corpora and bytes parsed per run"),
+			TFlagArgument(&skip_grammar, 'G', U"skip-grammar", U"", U"Only measure the UTF-8 parser"),
+			TPathArgument(&test1, 't', U"test1", U"", true, false, U"Path of testdata/test1.json")
+		);
+
+		EL_ERROR(sz_corpus < 1024, TInvalidArgumentException, "size", "at least 1024 bytes");
+
+		TFile file(test1);
+		TMapping map(&file, TAccess::RO);
+		TList<byte_t> test1_bytes;
+		test1_bytes.Append(array_t<const byte_t>(map));
+
+		Bench("test1", test1_bytes, (usys_t)sz_corpus, !skip_grammar);
+		Bench("twitter", MakeTwitter((usys_t)sz_corpus), (usys_t)sz_corpus, !skip_grammar);
+		Bench("citm", MakeCitm((usys_t)sz_corpus), (usys_t)sz_corpus, !skip_grammar);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,143 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_format_base64.hpp>
+#include <el1/io_stream.hpp>
+#include <el1/io_text_encoding_utf8.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+// measures the throughput of IPipe chains, every workload is consumed twice and every item is added to a checksum:
+// batch: ToStream(), which pulls whole batches through NextBatch()
+// item:  ForEach(), which pulls one item at a time through NextItem()
+// the rates are in MB/s of pipe input, base64 text counts as one byte per character
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::format::base64;
+using namespace el1::io::stream;
+using namespace el1::io::text::encoding::utf8;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+static volatile u64_t sink;
+
+template<typename T>
+struct TChecksumSink : ISink<T>
+{
+	u64_t sum = 0;
+
+	usys_t Write(const T* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT
+	{
+		for(usys_t i = 0; i < n_items_max; i++)
+			sum += (u64_t)arr_items[i];
+		return n_items_max;
+	}
+};
+
+static f64_t MegabytesPerSecond(const TTime ts_start, const usys_t n_bytes)
+{
+	return (f64_t)n_bytes / 1e6 / (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+}
+
+// make_pipe() is called once for each run and must return a fresh pipe
+template<typename F>
+static void Bench(const char* const name, const usys_t n_bytes_input, F make_pipe)
+{
+	using item_t = std::remove_const_t<typename std::remove_reference_t<decltype(make_pipe())>::TOut>;
+
+	TChecksumSink<item_t> checksum_sink;
+	TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	(void)make_pipe().ToStream(checksum_sink);
+	const f64_t mbs_batch = MegabytesPerSecond(ts_start, n_bytes_input);
+
+	u64_t sum = 0;
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	make_pipe().ForEach([&sum](const item_t& item) { sum += (u64_t)item; });
+	const f64_t mbs_item = MegabytesPerSecond(ts_start, n_bytes_input);
+
+	EL_ERROR(sum != checksum_sink.sum, TException, TString::Format(U"checksum mismatch in %q", name));
+	sink = sum;
+
+	printf("%-24s: batch %8.1f MB/s, item %8.1f MB/s (x%.1f)\n", name, mbs_batch, mbs_item, mbs_batch / mbs_item);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_megabytes = 64;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure the throughput of IPipe chains pulled in batches and one item at a time."),
+			TIntegerArgument(&n_megabytes, 'm', U"megabytes", U"", true, false, U"Size of every input in MB")
+		);
+
+		EL_ERROR(n_megabytes < 1, TInvalidArgumentException, "megabytes", "at least 1 MB");
+		const usys_t n_bytes = (usys_t)n_megabytes * 1000000;
+
+		TList<u32_t> numbers;
+		numbers.Prealloc(n_bytes / 4);
+		for(usys_t i = 0; i < n_bytes / 4; i++)
+			numbers.Append((u32_t)(i * 2654435761U));
+
+		// ASCII text with a multi-byte sequence every 64 characters
+		TList<byte_t> ascii;
+		TList<byte_t> mixed;
+		ascii.Prealloc(n_bytes);
+		mixed.Prealloc(n_bytes);
+		for(usys_t i = 0; i < n_bytes; i++)
+		{
+			ascii.Append((byte_t)('a' + i % 26));
+			if(i % 64 == 62 && i + 1 < n_bytes)
+			{
+				mixed.Append(0xC3U);
+				mixed.Append(0xA4U);
+				i++;
+			}
+			else
+				mixed.Append((byte_t)('a' + i % 26));
+		}
+
+		const TList<char32_t> base64 = ascii.Pipe().Transform(TBase64Encoder()).Collect();
+
+		const TList<u32_t>& c_numbers = numbers;
+		const TList<byte_t>& c_ascii = ascii;
+		const TList<byte_t>& c_mixed = mixed;
+		const TList<char32_t>& c_base64 = base64;
+
+		Bench("u32 array", c_numbers.Count() * 4, [&]() { return c_numbers.Pipe(); });
+		Bench("u32 filter", c_numbers.Count() * 4, [&]() { return c_numbers.Pipe().Filter([](const u32_t v) { return (v & 1) == 0; }); });
+		Bench("u32 map", c_numbers.Count() * 4, [&]() { return c_numbers.Pipe().Map([](const u32_t v) { return (u64_t)v * 3; }); });
+		Bench("u32 reinterpret s32", c_numbers.Count() * 4, [&]() { return c_numbers.Pipe().Transform(TReinterpretCastTransformer<const s32_t>()); });
+
+		{
+			TListSource<byte_t> source { TList<byte_t>(c_ascii) };
+			TListSource<byte_t> source_item { TList<byte_t>(c_ascii) };
+			auto pipe = source.Pipe();
+			auto pipe_item = source_item.Pipe();
+			Bench("byte source", c_ascii.Count(), [&, n_calls = 0]() mutable -> TSourcePipe<byte_t>& { return n_calls++ == 0 ? pipe : pipe_item; });
+		}
+
+		Bench("utf8 decode ascii", c_ascii.Count(), [&]() { return c_ascii.Pipe().Transform(TUTF8Decoder()); });
+		Bench("utf8 decode mixed", c_mixed.Count(), [&]() { return c_mixed.Pipe().Transform(TUTF8Decoder()); });
+		Bench("base64 encode", c_ascii.Count(), [&]() { return c_ascii.Pipe().Transform(TBase64Encoder()); });
+		Bench("base64 decode", c_base64.Count(), [&]() { return c_base64.Pipe().Transform(TBase64Decoder()); });
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
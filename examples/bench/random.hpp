@@ -0,0 +1,12 @@
+#pragma once
+
+#include <el1/io_types.hpp>
+
+// splitmix64, a fast and reproducible source of benchmark keys and inputs
+inline el1::io::types::u64_t NextRandom(el1::io::types::u64_t& state)
+{
+	el1::io::types::u64_t z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
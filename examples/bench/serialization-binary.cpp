@@ -0,0 +1,324 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_serialization_binary.hpp>
+#include <el1/io_serialization_binary_mapped.hpp>
+#include <el1/io_text_encoding_utf8.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+
+// records per second of the packed binary serialization of a TList<record> with a TSchema
+// unbuffered: an archive which passes every byte to the sink/source on its own and goes through a TList for UTF-8,
+//             which is how binary::packed::TWriter/TReader used to work
+// buffered:   TWriter into a TListSink through its internal buffer, TReader on the window of a TListSource
+// in-place:   TReader straight on the bytes (FromBytes()), as it works on a TMapping
+// mapped:     binary::mapped, written and fully read like the packed rows; the access row opens the image and reads two
+//             fields of every 64th record in place through TView, it counts those records and no bytes
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::serialization;
+using namespace el1::io::stream;
+using namespace el1::io::text::encoding::utf8;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+namespace bench
+{
+	struct TOrder
+	{
+		u64_t id = 0;
+		s32_t quantity = 0;
+		double price = 0;
+		bool active = false;
+		TString symbol;
+		TString comment;
+		TList<s32_t> tags;
+	};
+
+	// same bytes as binary::packed, one virtual call per byte
+	class TUnbufferedWriter
+	{
+		IBinarySink* sink;
+
+		void Byte(const byte_t value) { sink->WriteAll(&value, 1); }
+
+		void VarUInt(u64_t value)
+		{
+			while(value >= 0x80)
+			{
+				Byte((byte_t)(value | 0x80));
+				value >>= 7;
+			}
+			Byte((byte_t)value);
+		}
+
+		void Fixed64(const u64_t value)
+		{
+			byte_t data[8];
+			for(unsigned i = 0; i < 8; i++)
+				data[i] = (byte_t)(value >> (i * 8));
+			sink->WriteAll(data, 8);
+		}
+
+	public:
+		explicit TUnbufferedWriter(IBinarySink* const sink) : sink(sink)
+		{
+			static constexpr byte_t MAGIC[] = {'E', 'L', '1', 'S'};
+			sink->WriteAll(MAGIC, sizeof(MAGIC));
+			VarUInt(binary::packed::FORMAT_VERSION);
+		}
+
+		void BeginOptional(const bool present) { Byte(present ? 1 : 0); }
+		void EndOptional() {}
+		void Boolean(const bool value) { Byte(value ? 1 : 0); }
+		void Signed(const s64_t value) { VarUInt(value >= 0 ? (u64_t)value * 2U : (u64_t)(-(value + 1)) * 2U + 1U); }
+		void Unsigned(const u64_t value) { VarUInt(value); }
+		void Floating(const double value) { Fixed64(std::bit_cast<u64_t>(value)); }
+		void String(const TStringView value)
+		{
+			const TList<byte_t> bytes = EncodeUTF8(value);
+			VarUInt(bytes.Count());
+			if(bytes.Count() != 0)
+				sink->WriteAll(bytes.Data(), bytes.Count());
+		}
+		void BeginObject(const TTypeInfo& info)
+		{
+			Fixed64(info.id.high);
+			Fixed64(info.id.low);
+			VarUInt(info.version);
+		}
+		void EndObject() {}
+		void BeginField(const TFieldInfo&) {}
+		void EndField() {}
+		void BeginArray(const usys_t count) { VarUInt(count); }
+		void BeginElement(const usys_t) {}
+		void EndElement() {}
+		void EndArray() {}
+		void BeginMap(const usys_t count) { VarUInt(count); }
+		void BeginMapEntry(const usys_t, const TStringView key) { String(key); }
+		void EndMapEntry() {}
+		void EndMap() {}
+	};
+
+	// without the checks of binary::packed::TReader, which only flatters this row
+	class TUnbufferedReader
+	{
+		IBinarySource* source;
+
+		byte_t Byte()
+		{
+			byte_t value;
+			source->ReadAll(&value, 1);
+			return value;
+		}
+
+		u64_t VarUInt()
+		{
+			u64_t value = 0;
+			for(unsigned shift = 0; shift < 64; shift += 7)
+			{
+				const byte_t byte = Byte();
+				value |= (u64_t)(byte & 0x7f) << shift;
+				if((byte & 0x80) == 0)
+					break;
+			}
+			return value;
+		}
+
+		u64_t Fixed64()
+		{
+			byte_t data[8];
+			source->ReadAll(data, 8);
+			u64_t value = 0;
+			for(unsigned i = 0; i < 8; i++)
+				value |= (u64_t)data[i] << (i * 8);
+			return value;
+		}
+
+	public:
+		explicit TUnbufferedReader(IBinarySource* const source) : source(source)
+		{
+			byte_t magic[4];
+			source->ReadAll(magic, 4);
+			VarUInt();
+		}
+
+		bool BeginOptional() { return Byte() != 0; }
+		void EndOptional() {}
+		bool Boolean() { return Byte() != 0; }
+		s64_t Signed()
+		{
+			const u64_t value = VarUInt();
+			return (value & 1U) == 0 ? (s64_t)(value >> 1) : -(s64_t)(value >> 1) - 1;
+		}
+		u64_t Unsigned() { return VarUInt(); }
+		double Floating() { return std::bit_cast<double>(Fixed64()); }
+		TString String()
+		{
+			TList<byte_t> bytes;
+			bytes.SetCount((usys_t)VarUInt());
+			if(bytes.Count() != 0)
+				source->ReadAll(bytes.Data(), bytes.Count());
+			return DecodeUTF8(bytes);
+		}
+		u32_t BeginObject(const TTypeInfo&)
+		{
+			Fixed64();
+			Fixed64();
+			return (u32_t)VarUInt();
+		}
+		void EndObject() {}
+		bool BeginField(const TFieldInfo&) { return true; }
+		void EndField() {}
+		usys_t BeginArray() { return (usys_t)VarUInt(); }
+		void BeginElement(const usys_t) {}
+		void EndElement() {}
+		void EndArray() {}
+		usys_t BeginMap() { return (usys_t)VarUInt(); }
+		TString BeginMapEntry(const usys_t) { return String(); }
+		void EndMapEntry() {}
+		void EndMap() {}
+	};
+}
+
+EL_SERIALIZABLE(bench::TOrder, 1,
+	EL_SERIALIZATION_MEMBER(id),
+	EL_SERIALIZATION_MEMBER(quantity),
+	EL_SERIALIZATION_MEMBER(price),
+	EL_SERIALIZATION_MEMBER(active),
+	EL_SERIALIZATION_MEMBER(symbol),
+	EL_SERIALIZATION_MEMBER(comment),
+	EL_SERIALIZATION_MEMBER(tags));
+
+static volatile usys_t sink;
+
+static TList<bench::TOrder> MakeOrders(const usys_t n_records)
+{
+	static const char32_t* const SYMBOLS[] = { U"AAPL", U"MSFT", U"7203.T", U"SAP.DE", U"NESN.SW" };
+	static const char32_t* const COMMENTS[] = { U"", U"limit order, good till cancelled", U"„Teilausführung“ erwünscht", U"注文は東京で", U"partial fill allowed" };
+
+	TList<bench::TOrder> orders;
+	orders.Prealloc(n_records);
+	for(usys_t i = 0; i < n_records; i++)
+	{
+		bench::TOrder order;
+		order.id = 9000000000ULL + i * 7;
+		order.quantity = (s32_t)(i % 1000) - 500;
+		order.price = 100.0 + (f64_t)(i % 10000) / 128.0;
+		order.active = i % 3 != 0;
+		order.symbol = SYMBOLS[i % 5];
+		order.comment = COMMENTS[(i / 5) % 5];
+		for(usys_t k = 0; k < i % 4; k++)
+			order.tags.Append((s32_t)(i + k));
+		orders.MoveAppend(std::move(order));
+	}
+	return orders;
+}
+
+template<typename F>
+static void Measure(const char* const name, const usys_t n_records, const usys_t n_bytes, const usys_t n_rounds, F&& run)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	usys_t n = 0;
+	for(usys_t i = 0; i < n_rounds; i++)
+		n += run();
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS) / (f64_t)n_rounds;
+	sink = n;
+	printf("%-16s: %8.3f s, %7.3f M records/s, %7.1f MB/s, %6.0f ns/record\n", name, duration, (f64_t)n_records / duration / 1e6, (f64_t)n_bytes / duration / 1e6, duration * 1e9 / (f64_t)n_records);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_records = 200000;
+		s64_t n_rounds = 3;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure records per second of the packed binary serialization of a large TList with a byte-at-a-time archive, with the buffered TWriter/TReader and with TReader in place on the bytes, and the random access binary::mapped format."),
+			TIntegerArgument(&n_records, 'n', U"records", U"", true, false, U"Records in the serialized list"),
+			TIntegerArgument(&n_rounds, 'r', U"rounds", U"", true, false, U"Runs per row, the average is printed")
+		);
+
+		EL_ERROR(n_records < 1, TInvalidArgumentException, "records", "at least one record");
+		EL_ERROR(n_rounds < 1, TInvalidArgumentException, "rounds", "at least one round");
+
+		const TList<bench::TOrder> orders = MakeOrders((usys_t)n_records);
+		const TList<byte_t> bytes = binary::packed::ToBytes(orders);
+		const usys_t n = (usys_t)n_records;
+
+		Measure("unbuffered write", n, bytes.Count(), (usys_t)n_rounds, [&]() {
+			TList<byte_t> output;
+			TListSink<byte_t> list_sink(&output, 1U << 20);
+			bench::TUnbufferedWriter writer(&list_sink);
+			Serialize(writer, orders);
+			EL_ERROR(output.Count() != bytes.Count() || memcmp(output.Data(), bytes.Data(), bytes.Count()) != 0, TException, U"unbuffered writer produced different bytes");
+			return output.Count();
+		});
+
+		Measure("buffered write", n, bytes.Count(), (usys_t)n_rounds, [&]() {
+			TList<byte_t> output;
+			TListSink<byte_t> list_sink(&output, 1U << 20);
+			binary::packed::Serialize(list_sink, orders);
+			return output.Count();
+		});
+
+		Measure("unbuffered read", n, bytes.Count(), (usys_t)n_rounds, [&]() {
+			auto source = bytes.Source();
+			bench::TUnbufferedReader reader(&source);
+			TList<bench::TOrder> decoded;
+			Deserialize(reader, decoded);
+			return decoded.Count();
+		});
+
+		Measure("buffered read", n, bytes.Count(), (usys_t)n_rounds, [&]() {
+			auto source = bytes.Source();
+			return binary::packed::Deserialize<TList<bench::TOrder>>(source).Count();
+		});
+
+		Measure("in-place read", n, bytes.Count(), (usys_t)n_rounds, [&]() {
+			return binary::packed::FromBytes<TList<bench::TOrder>>(bytes).Count();
+		});
+
+		const TList<byte_t> mapped_bytes = binary::mapped::ToBytes(orders);
+
+		Measure("mapped write", n, mapped_bytes.Count(), (usys_t)n_rounds, [&]() {
+			TList<byte_t> output;
+			TListSink<byte_t> list_sink(&output, 1U << 20);
+			binary::mapped::Serialize(list_sink, orders);
+			return output.Count();
+		});
+
+		Measure("mapped read", n, mapped_bytes.Count(), (usys_t)n_rounds, [&]() {
+			return binary::mapped::FromBytes<TList<bench::TOrder>>(mapped_bytes).Count();
+		});
+
+		Measure("mapped access", (n + 63) / 64, 0, (usys_t)n_rounds, [&]() {
+			const binary::mapped::TImage image(mapped_bytes);
+			const binary::mapped::TView<TList<bench::TOrder>> view(image);
+			usys_t sum = 0;
+			for(usys_t i = 0; i < view.Count(); i += 64)
+				sum += (usys_t)view[i].Field<&bench::TOrder::quantity>().Load() + view[i].Field<&bench::TOrder::symbol>().Utf8().Count();
+			return sum;
+		});
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,165 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_format_json.hpp>
+#include <el1/io_serialization_json.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+// records per second of JSON serialization of a TList<record> with a TSchema
+// dom:    json::ToString()/FromString(), i.e. TWriter/TReader building and walking a complete TJsonValue tree
+// stream: json::ToStream()/FromStream(), i.e. TStreamWriter/TStreamReader on UTF-8 bytes without a tree
+// sorted: FromStream() on the output of the DOM writer, whose keys are sorted by name and thus mostly out of schema order
+// the DOM rows include the conversion between TString and UTF-8 bytes, so every row starts or ends with the same bytes
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::serialization;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+namespace bench
+{
+	struct TOrder
+	{
+		u64_t id = 0;
+		s32_t quantity = 0;
+		double price = 0;
+		bool active = false;
+		TString symbol;
+		TString comment;
+		TList<s32_t> tags;
+	};
+
+	struct TBook
+	{
+		TString venue;
+		TList<TOrder> orders;
+	};
+}
+
+EL_SERIALIZABLE(bench::TOrder, 1,
+	EL_SERIALIZATION_MEMBER(id),
+	EL_SERIALIZATION_MEMBER(quantity),
+	EL_SERIALIZATION_MEMBER(price),
+	EL_SERIALIZATION_MEMBER(active),
+	EL_SERIALIZATION_MEMBER(symbol),
+	EL_SERIALIZATION_MEMBER(comment),
+	EL_SERIALIZATION_MEMBER(tags));
+
+EL_SERIALIZABLE(bench::TBook, 1,
+	EL_SERIALIZATION_MEMBER(venue),
+	EL_SERIALIZATION_MEMBER(orders));
+
+static volatile usys_t sink;
+
+static TList<byte_t> ToBytes(const TString& text)
+{
+	const auto c_str = text.MakeCStr();
+	return TList<byte_t>((const byte_t*)c_str.get(), strlen(c_str.get()));
+}
+
+static bench::TBook MakeBook(const usys_t n_records)
+{
+	static const char32_t* const SYMBOLS[] = { U"AAPL", U"MSFT", U"7203.T", U"SAP.DE", U"NESN.SW" };
+	static const char32_t* const COMMENTS[] = { U"", U"limit order, good till cancelled", U"„Teilausführung“ erwünscht", U"注文は東京で", U"line\nbreak and \"quotes\"" };
+
+	bench::TBook book;
+	book.venue = U"XETR";
+	book.orders.Prealloc(n_records);
+	for(usys_t i = 0; i < n_records; i++)
+	{
+		bench::TOrder order;
+		order.id = 9000000000ULL + i * 7;
+		order.quantity = (s32_t)(i % 1000) - 500;
+		order.price = 100.0 + (f64_t)(i % 10000) / 128.0;
+		order.active = i % 3 != 0;
+		order.symbol = SYMBOLS[i % 5];
+		order.comment = COMMENTS[(i / 5) % 5];
+		for(usys_t k = 0; k < i % 4; k++)
+			order.tags.Append((s32_t)(i + k));
+		book.orders.MoveAppend(std::move(order));
+	}
+	return book;
+}
+
+template<typename F>
+static void Measure(const char* const name, const usys_t n_records, const usys_t n_bytes, const usys_t n_rounds, F&& run)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	usys_t n = 0;
+	for(usys_t i = 0; i < n_rounds; i++)
+		n += run();
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS) / (f64_t)n_rounds;
+	sink = n;
+	printf("%-13s: %8.3f s, %7.3f M records/s, %7.1f MB/s, %6.0f ns/record\n", name, duration, (f64_t)n_records / duration / 1e6, (f64_t)n_bytes / duration / 1e6, duration * 1e9 / (f64_t)n_records);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_records = 200000;
+		s64_t n_rounds = 3;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure records per second of JSON serialization of a large TList through the TJsonValue DOM and through the streaming TStreamWriter/TStreamReader."),
+			TIntegerArgument(&n_records, 'n', U"records", U"", true, false, U"Records in the serialized list"),
+			TIntegerArgument(&n_rounds, 'r', U"rounds", U"", true, false, U"Runs per row, the average is printed")
+		);
+
+		EL_ERROR(n_records < 1, TInvalidArgumentException, "records", "at least one record");
+		EL_ERROR(n_rounds < 1, TInvalidArgumentException, "rounds", "at least one round");
+
+		const bench::TBook book = MakeBook((usys_t)n_records);
+		const TList<byte_t> dom_bytes = ToBytes(json::ToString(book));
+		TList<byte_t> stream_bytes;
+		{
+			TListSink<byte_t> list_sink(&stream_bytes);
+			json::ToStream(list_sink, book);
+		}
+		const usys_t n = (usys_t)n_records;
+
+		Measure("dom write", n, dom_bytes.Count(), (usys_t)n_rounds, [&]() {
+			return ToBytes(json::ToString(book)).Count();
+		});
+
+		Measure("stream write", n, stream_bytes.Count(), (usys_t)n_rounds, [&]() {
+			TList<byte_t> bytes;
+			TListSink<byte_t> list_sink(&bytes, 1U << 20);
+			json::ToStream(list_sink, book);
+			return bytes.Count();
+		});
+
+		Measure("dom read", n, dom_bytes.Count(), (usys_t)n_rounds, [&]() {
+			return json::FromValue<bench::TBook>(io::format::json::TJsonValue::Parse(dom_bytes)).orders.Count();
+		});
+
+		Measure("stream read", n, stream_bytes.Count(), (usys_t)n_rounds, [&]() {
+			auto source = stream_bytes.Source();
+			return json::FromStream<bench::TBook>(source).orders.Count();
+		});
+
+		Measure("sorted read", n, dom_bytes.Count(), (usys_t)n_rounds, [&]() {
+			auto source = dom_bytes.Source();
+			return json::FromStream<bench::TBook>(source).orders.Count();
+		});
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
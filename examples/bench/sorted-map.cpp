@@ -0,0 +1,162 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_collection_map.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+#include "random.hpp"
+
+// measures TSortedMap on insertion, bulk loading and lookups from 1k to 10M entries
+// random:    keys inserted one by one in random order
+// ascending: keys inserted one by one in ascending order (always appends to the last chunk)
+// bulk:      the map takes over a presorted list (EInputOrder::ASSUME_SORTED) or sorts it first (UNSORTED)
+// flat:      a single sorted TList with binary search, which is what every insertion into a large map used to cost, only run up to --flat-max
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::collection::map;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+using map_t = TSortedMap<u64_t, u64_t>;
+using pair_t = map_t::kv_pair_t;
+
+static volatile u64_t sink;
+
+static f64_t NanosecondsPerItem(const TTime ts_start, const usys_t n_items)
+{
+	return (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS) * 1e9 / (f64_t)n_items;
+}
+
+static f64_t MeasureLookups(const map_t& map, const TList<u64_t>& keys, const usys_t n_lookups)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	u64_t n_found = 0;
+	for(usys_t i = 0; i < n_lookups; i++)
+		n_found += map.Get(keys[i % keys.Count()]) != nullptr ? 1 : 0;
+	sink = n_found;
+	return NanosecondsPerItem(ts_start, n_lookups);
+}
+
+static void Bench(const usys_t n_items, const usys_t n_lookups, const usys_t n_flat_max)
+{
+	// odd keys are present, even keys are absent
+	u64_t state = n_items;
+	TList<u64_t> keys;
+	TList<u64_t> absent;
+	keys.Prealloc(n_items);
+	for(usys_t i = 0; i < n_items; i++)
+		keys.Append(NextRandom(state) | 1);
+	for(usys_t i = 0; i < util::Min<usys_t>(n_items, 1 << 20); i++)
+		absent.Append(NextRandom(state) & ~(u64_t)1);
+
+	TList<u64_t> sorted_keys = keys;
+	sorted_keys.Sort();
+
+	f64_t ns_random;
+	f64_t ns_hit;
+	f64_t ns_miss;
+	{
+		map_t map;
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		for(usys_t i = 0; i < n_items; i++)
+			map.Set(keys[i], i);
+		ns_random = NanosecondsPerItem(ts_start, n_items);
+		ns_hit = MeasureLookups(map, keys, n_lookups);
+		ns_miss = MeasureLookups(map, absent, n_lookups);
+	}
+
+	f64_t ns_ascending;
+	{
+		map_t map;
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		for(usys_t i = 0; i < n_items; i++)
+			map.Set(sorted_keys[i], i);
+		ns_ascending = NanosecondsPerItem(ts_start, n_items);
+	}
+
+	f64_t ns_bulk_sorted;
+	f64_t ns_bulk_hit;
+	{
+		TList<pair_t> items;
+		items.Prealloc(n_items);
+		for(usys_t i = 0; i < n_items; i++)
+			items.Append({ sorted_keys[i], i });
+
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		map_t map(std::move(items), EInputOrder::ASSUME_SORTED);
+		ns_bulk_sorted = NanosecondsPerItem(ts_start, n_items);
+		ns_bulk_hit = MeasureLookups(map, keys, n_lookups);
+	}
+
+	f64_t ns_bulk_unsorted;
+	{
+		TList<pair_t> items;
+		items.Prealloc(n_items);
+		for(usys_t i = 0; i < n_items; i++)
+			items.Append({ keys[i], i });
+
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		map_t map(std::move(items), EInputOrder::UNSORTED);
+		ns_bulk_unsorted = NanosecondsPerItem(ts_start, n_items);
+	}
+
+	printf("items=%-9zu: insert random %7.1f ns, ascending %7.1f ns | bulk sorted %6.1f ns, unsorted %7.1f ns | hit %7.1f ns (bulk %7.1f ns), miss %7.1f ns\n",
+		(size_t)n_items, ns_random, ns_ascending, ns_bulk_sorted, ns_bulk_unsorted, ns_hit, ns_bulk_hit, ns_miss);
+
+	if(n_items <= n_flat_max)
+	{
+		TList<pair_t> flat;
+		const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+		for(usys_t i = 0; i < n_items; i++)
+		{
+			const u64_t key = keys[i];
+			const usys_t index = flat.BinarySearch([key](const pair_t& item) { return StdSorter(item.key, key); }, true);
+			if(index == NEG1)
+				flat.Append({ key, i });
+			else if(flat[index].key == key)
+				flat[index].value = i;
+			else
+				flat.Insert(flat[index].key > key ? index : index + 1, { key, i });
+		}
+		printf("items=%-9zu: insert random %7.1f ns (flat sorted list)\n", (size_t)n_items, NanosecondsPerItem(ts_start, n_items));
+	}
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_max = 10000000;
+		s64_t n_lookups = 2000000;
+		s64_t n_flat_max = 100000;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure TSortedMap insertion, bulk loading and lookups from 1k to 10M entries."),
+			TIntegerArgument(&n_max, 'm', U"max-items", U"", true, false, U"Largest map size"),
+			TIntegerArgument(&n_lookups, 'n', U"lookups", U"", true, false, U"Lookups per measurement"),
+			TIntegerArgument(&n_flat_max, 'f', U"flat-max", U"", true, false, U"Largest flat sorted list which is filled for comparison")
+		);
+
+		EL_ERROR(n_max < 1000, TInvalidArgumentException, "max-items", "at least 1000 items");
+		EL_ERROR(n_lookups < 1, TInvalidArgumentException, "lookups", "at least one lookup");
+
+		for(usys_t n_items = 1000; n_items <= (usys_t)n_max; n_items *= 10)
+			Bench(n_items, (usys_t)n_lookups, (usys_t)n_flat_max);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,136 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <malloc.h>
+
+// memory: heap bytes per string (mallinfo2) for a million strings of the given length, TString with its inline buffer
+//         against a TList<char32_t> per string, which is how TString used to store its characters
+// format: TString::Format() calls per second with short and long results
+// ops:    compare, Find(), Split() and MakeCStr() on short and long strings
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+static volatile u64_t sink;
+
+static f64_t Seconds(const TTime ts_start)
+{
+	return (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+}
+
+static usys_t HeapInUse()
+{
+	return mallinfo2().uordblks;
+}
+
+template<typename T, typename F>
+static void MeasureMemory(const char* const name, const usys_t n_strings, const usys_t length, F&& make)
+{
+	TList<T> strings;
+	strings.Prealloc(n_strings);
+	const usys_t sz_before = HeapInUse();
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	for(usys_t i = 0; i < n_strings; i++)
+		strings.MoveAppend(make(i));
+	const f64_t duration = Seconds(ts_start);
+	const usys_t sz_heap = HeapInUse() - sz_before;
+	printf("memory %-6s length=%-4zu: %7.1f bytes/string (%2zu inline + %6.1f heap), %6.1f ns/string\n", name, (size_t)length,
+		(f64_t)(sizeof(T) * n_strings + sz_heap) / (f64_t)n_strings, sizeof(T), (f64_t)sz_heap / (f64_t)n_strings, duration * 1e9 / (f64_t)n_strings);
+}
+
+static void BenchMemory(const usys_t n_strings, const usys_t length)
+{
+	TString text;
+	for(usys_t i = 0; i < length; i++)
+		text += (char32_t)(U'a' + i % 26);
+
+	MeasureMemory<TString>("string", n_strings, length, [&text](const usys_t i) {
+		TString str = text;
+		if(str.Length() > 0)
+			str[0] = (char32_t)(U'a' + i % 26);
+		return str;
+	});
+
+	MeasureMemory<TList<char32_t>>("list", n_strings, length, [&text](const usys_t i) {
+		TList<char32_t> str(text.chars.View());
+		if(str.Count() > 0)
+			str[0] = (char32_t)(U'a' + i % 26);
+		return str;
+	});
+}
+
+template<typename F>
+static void MeasureOps(const char* const name, const usys_t n_ops, F&& op)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	u64_t n = 0;
+	for(usys_t i = 0; i < n_ops; i++)
+		n += op(i);
+	const f64_t duration = Seconds(ts_start);
+	sink = n;
+	printf("%-20s: %8.3f s, %7.2f M/s, %7.1f ns/op\n", name, duration, (f64_t)n_ops / duration / 1e6, duration * 1e9 / (f64_t)n_ops);
+}
+
+static void BenchFormat(const usys_t n_ops)
+{
+	const TString name = U"sensor";
+	MeasureOps("format short", n_ops, [](const usys_t i) { return TString::Format(U"%d", i).Length(); });
+	MeasureOps("format long", n_ops, [&name](const usys_t i) { return TString::Format(U"%s #%d reports %d degrees", name, i, i % 100).Length(); });
+}
+
+static void BenchOps(const usys_t n_ops)
+{
+	const TString short_a = U"key=42";
+	const TString short_b = U"key=43";
+	const TString long_a = U"the quick brown fox jumps over the lazy dog, key=value; another=pair";
+	const TString long_b = U"the quick brown fox jumps over the lazy dog, key=value; another=pain";
+
+	MeasureOps("compare short", n_ops, [&](const usys_t) { return short_a < short_b ? 1U : 0U; });
+	MeasureOps("compare long", n_ops, [&](const usys_t) { return long_a < long_b ? 1U : 0U; });
+	MeasureOps("find short", n_ops, [&](const usys_t) { return short_a.Find(U'='); });
+	MeasureOps("find long", n_ops, [&](const usys_t) { return long_a.Find(TStringView(U"another")); });
+	MeasureOps("split short", n_ops, [&](const usys_t) { return short_a.Split(U'=').Count(); });
+	MeasureOps("split long", n_ops, [&](const usys_t) { return long_a.Split(U' ').Count(); });
+	MeasureOps("makecstr short", n_ops, [&](const usys_t) { return (usys_t)strlen(short_a.MakeCStr().get()); });
+	MeasureOps("makecstr long", n_ops, [&](const usys_t) { return (usys_t)strlen(long_a.MakeCStr().get()); });
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_strings = 1000000;
+		s64_t n_ops = 2000000;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure the memory per string of TString with its inline buffer against a TList<char32_t> per string, TString::Format() throughput and compare, Find(), Split() and MakeCStr() on short and long strings."),
+			TIntegerArgument(&n_strings, 'n', U"strings", U"", true, false, U"Strings allocated per memory run"),
+			TIntegerArgument(&n_ops, 'o', U"ops", U"", true, false, U"Operations per format and ops run")
+		);
+
+		EL_ERROR(n_strings < 1, TInvalidArgumentException, "strings", "at least one string");
+		EL_ERROR(n_ops < 1, TInvalidArgumentException, "ops", "at least one operation");
+
+		for(const usys_t length : { 0U, 4U, 8U, 16U, 32U })
+			BenchMemory((usys_t)n_strings, length);
+		BenchFormat((usys_t)n_ops);
+		BenchOps((usys_t)n_ops);
+
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
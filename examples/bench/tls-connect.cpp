@@ -0,0 +1,116 @@
+#include <el1/error.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/io_net_tls.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+#include <memory>
+
+// TLS connections per second over loopback TCP, client and server fibers share the thread
+// every connection does the handshake, the server sends one byte (after its session tickets) and closes
+// full:    no session cache, every connection does certificate exchange and key agreement
+// resumed: the clients share a tls::TSessionCache and resume with the server's session tickets (TLS 1.3 PSK)
+// the CPU time covers both ends of the connection
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::file;
+using namespace el1::io::net;
+using namespace el1::io::net::ip;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+static void JoinFiber(TFiber& fiber)
+{
+	if(auto e = fiber.Join())
+	{
+		e->Print("FIBER");
+		EL_THROW(TException, U"benchmark fiber failed");
+	}
+}
+
+static void BenchConnect(const char* const name, const tls::server_config_t& server_config, const bool resume, const usys_t n_connections)
+{
+	TTcpServer tcp_server(ipaddr_t(U"127.0.0.1"), 0);
+	tls::TServer tls_server(&tcp_server, server_config);
+	const port_t port = tcp_server.LocalAddress().port;
+
+	tls::client_config_t client_config;
+	client_config.verify_peer = false;
+	client_config.min_version = tls::EVersion::TLS13;
+	if(resume)
+		client_config.session_cache = New<tls::TSessionCache>();
+
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	const TTime ts_cpu_start = TTime::Now(EClock::PROCESS);
+
+	TFiber server([&tls_server, n_connections]() {
+		for(usys_t i = 0; i < n_connections; i++)
+		{
+			std::unique_ptr<tls::TClient> connection;
+			while((connection = tls_server.AcceptClient()) == nullptr)
+				tls_server.OnClientConnect().WaitFor();
+			connection->Negotiate();
+			const byte_t byte = 1;
+			connection->WriteAll(&byte, 1);
+			connection->Flush();
+		}
+	});
+
+	for(usys_t i = 0; i < n_connections; i++)
+	{
+		tls::TClient client(U"127.0.0.1", port, client_config);
+		client.Negotiate();
+		byte_t byte;
+		client.ReadAll(&byte, 1);
+	}
+	JoinFiber(server);
+
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+	const f64_t cpu = (TTime::Now(EClock::PROCESS) - ts_cpu_start).ConvertToF(EUnit::SECONDS);
+	const tls::handshake_stats_t stats = tls_server.HandshakeStats();
+	printf("connect %-8s: %8.3f s, %8.0f conn/s, %7.1f us CPU/conn (full=%llu resumed=%llu)\n", name, duration, (f64_t)n_connections / duration, cpu * 1e6 / (f64_t)n_connections,
+		(unsigned long long)stats.n_full, (unsigned long long)stats.n_resumed);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_connections = 2000;
+		TPath tls_certificate = U"support/tls-test-cert.pem";
+		TPath tls_key = U"support/tls-test-key.pem";
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure TLS connections per second with full handshakes and with session resumption."),
+			TIntegerArgument(&n_connections, 'n', U"connections", U"", true, false, U"Connections per run"),
+			TPathArgument(&tls_certificate, 'C', U"tls-certificate", U"", true, false, U"PEM certificate chain of the server"),
+			TPathArgument(&tls_key, 'K', U"tls-key", U"", true, false, U"PEM private key of the server")
+		);
+
+		EL_ERROR(n_connections < 1, TInvalidArgumentException, "connections", "at least one connection");
+
+		tls::server_config_t server_config;
+		server_config.certificate_chain = tls::TPemSource(tls_certificate);
+		server_config.private_key = tls::TPemSource(tls_key);
+
+		BenchConnect("full", server_config, false, (usys_t)n_connections);
+		BenchConnect("resumed", server_config, true, (usys_t)n_connections);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
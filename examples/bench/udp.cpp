@@ -0,0 +1,150 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_task.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+// UDP datagrams per second over loopback, sender and receiver share the thread
+// the sender submits a window of datagrams, then the receiver drains them before the next window is sent
+// single: one Send()/Receive() syscall per datagram, every received datagram allocates its TList
+// mmsg:   batched sendmmsg()/recvmmsg() through TUdpSocket::Send(array_t<const udp_message_t>) and a TUdpReceiveArena
+// gso:    batched, and every message is a train of --segments datagrams with UDP_SEGMENT, received with UDP_GRO
+// the CPU time covers both ends
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::net::ip;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::task;
+using namespace el1::system::time;
+
+struct bench_t
+{
+	usys_t n_datagrams;
+	usys_t window;
+	usys_t datagram_size;
+	usys_t n_segments;
+};
+
+static void WaitForReceive(TUdpSocket& receiver)
+{
+	EL_ERROR(!receiver.OnReceiveMsg().WaitFor(1), TException, U"datagrams were lost");
+}
+
+template<typename F>
+static void Measure(const char* const name, const bench_t& bench, F&& run_window)
+{
+	const TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	const TTime ts_cpu_start = TTime::Now(EClock::PROCESS);
+
+	for(usys_t n_done = 0; n_done < bench.n_datagrams; n_done += bench.window)
+		run_window();
+
+	const f64_t duration = (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+	const f64_t cpu = (TTime::Now(EClock::PROCESS) - ts_cpu_start).ConvertToF(EUnit::SECONDS);
+	const f64_t n_datagrams = (f64_t)((bench.n_datagrams + bench.window - 1) / bench.window * bench.window);
+	printf("%-6s: %8.3f s, %7.3f Mpps, %7.2f Gbit/s, %6.3f us CPU/datagram\n", name, duration, n_datagrams / duration / 1e6, n_datagrams * (f64_t)bench.datagram_size * 8 / duration / 1e9, cpu * 1e6 / n_datagrams);
+}
+
+static void BenchSingle(const bench_t& bench, const TList<byte_t>& payload)
+{
+	TUdpSocket sender(ipaddr_t(U"127.0.0.1"));
+	TUdpSocket receiver(ipaddr_t(U"127.0.0.1"));
+	const ipport_t target = receiver.LocalAddress();
+	udp_datagram_t datagram;
+
+	Measure("single", bench, [&]() {
+		for(usys_t i = 0; i < bench.window; i++)
+			EL_ERROR(!sender.Send(target, payload.Slice(i * bench.datagram_size, bench.datagram_size)), TException, U"socket buffer full");
+
+		for(usys_t n_received = 0; n_received < bench.window; )
+			if(receiver.Receive(datagram))
+				n_received++;
+			else
+				WaitForReceive(receiver);
+	});
+}
+
+static void BenchBatch(const char* const name, const bench_t& bench, const TList<byte_t>& payload, const usys_t n_segments)
+{
+	TUdpSocket sender(ipaddr_t(U"127.0.0.1"));
+	TUdpSocket receiver(ipaddr_t(U"127.0.0.1"));
+	const bool offload = n_segments > 1;
+	if(offload && !receiver.ReceiveOffload(true))
+	{
+		printf("%-6s: UDP_GRO not supported\n", name);
+		return;
+	}
+
+	TList<udp_message_t> messages;
+	for(usys_t i = 0; i < bench.window; i += n_segments)
+	{
+		const usys_t n = util::Min(n_segments, bench.window - i);
+		messages.Append({ receiver.LocalAddress(), payload.Slice(i * bench.datagram_size, n * bench.datagram_size), offload ? bench.datagram_size : 0U, false });
+	}
+
+	TUdpReceiveArena arena(messages.Count(), offload ? 65536U : bench.datagram_size);
+
+	Measure(name, bench, [&]() {
+		EL_ERROR(sender.Send(messages) != messages.Count(), TException, U"socket buffer full");
+
+		for(usys_t n_received = 0; n_received < bench.window; )
+			if(receiver.Receive(arena) > 0)
+			{
+				for(const udp_message_t& message : arena.Messages())
+					n_received += message.CountSegments();
+			}
+			else
+				WaitForReceive(receiver);
+	});
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_datagrams = 1000000;
+		s64_t window = 64;
+		s64_t datagram_size = 1200;
+		s64_t n_segments = 16;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure UDP datagrams per second over loopback with one syscall per datagram, with recvmmsg()/sendmmsg() batches and with GSO/GRO segmentation offload."),
+			TIntegerArgument(&n_datagrams, 'n', U"datagrams", U"", true, false, U"Datagrams per run"),
+			TIntegerArgument(&window, 'w', U"window", U"", true, false, U"Datagrams in flight before the receiver drains them"),
+			TIntegerArgument(&datagram_size, 's', U"size", U"", true, false, U"Payload bytes per datagram"),
+			TIntegerArgument(&n_segments, 'g', U"segments", U"", true, false, U"Datagrams per GSO train")
+		);
+
+		EL_ERROR(n_datagrams < 1, TInvalidArgumentException, "datagrams", "at least one datagram");
+		EL_ERROR(window < 1, TInvalidArgumentException, "window", "at least one datagram");
+		EL_ERROR(datagram_size < 1 || datagram_size > 1472, TInvalidArgumentException, "size", "between 1 and 1472 bytes");
+		EL_ERROR(n_segments < 2 || n_segments > 64 || n_segments * datagram_size > 65000, TInvalidArgumentException, "segments", "between 2 and 64 segments, at most 65000 bytes per train");
+
+		const bench_t bench = { (usys_t)n_datagrams, (usys_t)window, (usys_t)datagram_size, (usys_t)n_segments };
+		TList<byte_t> payload;
+		payload.SetCount(bench.window * bench.datagram_size);
+		for(usys_t i = 0; i < payload.Count(); i++)
+			payload[i] = (byte_t)i;
+
+		BenchSingle(bench, payload);
+		BenchBatch("mmsg", bench, payload, 1);
+		BenchBatch("gso", bench, payload, bench.n_segments);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -0,0 +1,153 @@
+#include <el1/error.hpp>
+#include <el1/io_collection_list.hpp>
+#include <el1/io_stream.hpp>
+#include <el1/io_text_encoding_utf8.hpp>
+#include <el1/io_text_string.hpp>
+#include <el1/system_cmdline.hpp>
+#include <el1/system_time.hpp>
+
+#include <cstdio>
+
+// measures UTF-8 transcoding throughput
+// bulk:  DecodeUTF8() / EncodeUTF8() on whole arrays, validation and ASCII runs go through the SIMD kernels
+// batch: TUTF8Decoder / TUTF8Encoder pulled through NextBatch() by ToStream()
+// item:  TUTF8Decoder / TUTF8Encoder pulled one item at a time by ForEach()
+// the rates are in GB/s of UTF-8 bytes for both directions
+
+using namespace el1;
+using namespace el1::error;
+using namespace el1::io::collection::list;
+using namespace el1::io::stream;
+using namespace el1::io::text::encoding::utf8;
+using namespace el1::io::text::string;
+using namespace el1::io::types;
+using namespace el1::system::cmdline;
+using namespace el1::system::time;
+
+static volatile u64_t sink;
+
+template<typename T>
+struct TChecksumSink : ISink<T>
+{
+	u64_t sum = 0;
+
+	usys_t Write(const T* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT
+	{
+		for(usys_t i = 0; i < n_items_max; i++)
+			sum += (u64_t)arr_items[i];
+		return n_items_max;
+	}
+};
+
+static f64_t GigabytesPerSecond(const TTime ts_start, const usys_t n_bytes)
+{
+	return (f64_t)n_bytes / 1e9 / (TTime::Now(EClock::MONOTONIC) - ts_start).ConvertToF(EUnit::SECONDS);
+}
+
+template<typename T>
+static u64_t Checksum(const T* const arr_items, const usys_t n_items)
+{
+	u64_t sum = 0;
+	for(usys_t i = 0; i < n_items; i++)
+		sum += (u64_t)arr_items[i];
+	return sum;
+}
+
+// all outputs go to preallocated memory or into a checksum, so only the transcoding is measured
+static void Bench(const char* const name, const TList<char32_t>& text)
+{
+	const TList<byte_t> utf8 = EncodeUTF8(text);
+	const usys_t n_bytes = utf8.Count();
+
+	TList<char32_t> chars_out;
+	TList<byte_t> bytes_out;
+	chars_out.SetCount(n_bytes);
+	bytes_out.SetCount(text.Count() * 4);
+
+	usys_t n_chars;
+	TTime ts_start = TTime::Now(EClock::MONOTONIC);
+	(void)DecodeUTF8(utf8.Data(), n_bytes, chars_out.Data(), n_chars);
+	const f64_t dec_bulk = GigabytesPerSecond(ts_start, n_bytes);
+	const u64_t sum_chars = Checksum(chars_out.Data(), n_chars);
+
+	TChecksumSink<char32_t> chars_sink;
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	(void)utf8.Pipe().Transform(TUTF8Decoder()).ToStream(chars_sink);
+	const f64_t dec_batch = GigabytesPerSecond(ts_start, n_bytes);
+
+	u64_t sum_item = 0;
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	utf8.Pipe().Transform(TUTF8Decoder()).ForEach([&sum_item](const char32_t chr) { sum_item += chr; });
+	const f64_t dec_item = GigabytesPerSecond(ts_start, n_bytes);
+
+	EL_ERROR(n_chars != text.Count() || chars_sink.sum != sum_chars || sum_item != sum_chars, TException, TString::Format(U"decoding mismatch in %q", name));
+
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	const usys_t n_encoded = EncodeUTF8(text.Data(), text.Count(), bytes_out.Data());
+	const f64_t enc_bulk = GigabytesPerSecond(ts_start, n_bytes);
+	const u64_t sum_bytes = Checksum(bytes_out.Data(), n_encoded);
+
+	TChecksumSink<byte_t> bytes_sink;
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	(void)text.Pipe().Transform(TUTF8Encoder()).ToStream(bytes_sink);
+	const f64_t enc_batch = GigabytesPerSecond(ts_start, n_bytes);
+
+	sum_item = 0;
+	ts_start = TTime::Now(EClock::MONOTONIC);
+	text.Pipe().Transform(TUTF8Encoder()).ForEach([&sum_item](const byte_t b) { sum_item += b; });
+	const f64_t enc_item = GigabytesPerSecond(ts_start, n_bytes);
+
+	EL_ERROR(n_encoded != n_bytes || bytes_sink.sum != sum_bytes || sum_item != sum_bytes, TException, TString::Format(U"encoding mismatch in %q", name));
+	sink = sum_chars + sum_bytes;
+
+	printf("%-6s decode: bulk %6.2f GB/s, batch %6.2f GB/s, item %6.2f GB/s\n", name, dec_bulk, dec_batch, dec_item);
+	printf("%-6s encode: bulk %6.2f GB/s, batch %6.2f GB/s, item %6.2f GB/s\n", name, enc_bulk, enc_batch, enc_item);
+}
+
+int main(const int argc, char* argv[])
+{
+	try
+	{
+		s64_t n_megabytes = 64;
+
+		ParseCmdlineArguments(argc, argv,
+			THelpArgument(U"Measure UTF-8 decoding and encoding throughput of the bulk functions and the pipe transformers."),
+			TIntegerArgument(&n_megabytes, 'm', U"megabytes", U"", true, false, U"Approximate size of every UTF-8 input in MB")
+		);
+
+		EL_ERROR(n_megabytes < 1, TInvalidArgumentException, "megabytes", "at least 1 MB");
+		const usys_t n_bytes = (usys_t)n_megabytes * 1000000;
+
+		// ascii: plain text
+		// mixed: ASCII text with a 2-byte sequence every 64 characters
+		// cjk:   3-byte sequences only, the SIMD kernels never apply
+		TList<char32_t> ascii;
+		TList<char32_t> mixed;
+		TList<char32_t> cjk;
+		ascii.Prealloc(n_bytes);
+		mixed.Prealloc(n_bytes);
+		cjk.Prealloc(n_bytes / 3);
+		for(usys_t i = 0; i < n_bytes; i++)
+		{
+			ascii.Append((char32_t)('a' + i % 26));
+			mixed.Append(i % 64 == 63 ? 0x00E4U : (char32_t)('a' + i % 26));
+		}
+		for(usys_t i = 0; i < n_bytes / 3; i++)
+			cjk.Append((char32_t)(0x4E00U + i % 0x5000U));
+
+		Bench("ascii", ascii);
+		Bench("mixed", mixed);
+		Bench("cjk", cjk);
+
+		return 0;
+	}
+	catch(const shutdown_t&)
+	{
+		return 0;
+	}
+	catch(const IException& exception)
+	{
+		exception.Print("TOP LEVEL");
+		return 1;
+	}
+}
@@ -265,6 +265,15 @@ namespace el1::io::collection::array
 				return nullptr;
 			}
 
+			// hands out slices of the array without copying
+			usys_t NextBatch(std::remove_const_t<T>* const, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				const usys_t n = util::Min(n_items - index, n_items_max);
+				batch = arr_items + index;
+				index += n;
+				return n;
+			}
+
 			constexpr TArrayPipe(T* const arr_items EL_LIFETIME_BOUND, const usys_t n_items) noexcept : arr_items(arr_items), n_items(n_items), index(0) {}
 		};
 
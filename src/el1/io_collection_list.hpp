@@ -799,14 +799,21 @@ namespace el1::io::stream
 	collection::list::TList<std::remove_const_t<TOut>> IPipe<TStream, TOut>::Collect(const usys_t n_prealloc)
 	{
 		collection::list::TList<std::remove_const_t<TOut>> list;
-		TStream* source = static_cast<TStream*>(this);
 
-		for(TOut* item = source->NextItem(); item != nullptr; item = source->NextItem())
+		if constexpr(IS_BATCHABLE<TOut>)
 		{
-			if constexpr(std::is_const_v<TOut>)
-				list.Append(*item);
-			else
-				list.MoveAppend(std::move(*item));
+			this->AppendTo(list);
+		}
+		else
+		{
+			TStream* source = static_cast<TStream*>(this);
+			for(TOut* item = source->NextItem(); item != nullptr; item = source->NextItem())
+			{
+				if constexpr(std::is_const_v<TOut>)
+					list.Append(*item);
+				else
+					list.MoveAppend(std::move(*item));
+			}
 		}
 
 		return list;
@@ -1,5 +1,6 @@
 #include "io_collection_map.hpp"
 #include "io_text_string.hpp"
+#include <string.h>
 
 namespace el1::io::collection::map
 {
@@ -14,4 +15,36 @@ namespace el1::io::collection::map
 	{
 		return U"the key associated with the new item already exists in the map";
 	}
+
+	static inline u64_t RotateLeft(const u64_t x, const unsigned n)
+	{
+		return (x << n) | (x >> (64 - n));
+	}
+
+	usys_t HashBytes(const void* const data, const usys_t sz_data)
+	{
+		// mixes 8 bytes per round (MurmurHash3 style), the tail is padded with zeros and the length goes into the final mix
+		static const u64_t C1 = 0x87c37b91114253d5ULL;
+		static const u64_t C2 = 0x4cf5ad432745937fULL;
+		const byte_t* p = reinterpret_cast<const byte_t*>(data);
+		u64_t h = 0x9e3779b97f4a7c15ULL;
+		usys_t n = sz_data;
+
+		for(; n >= 8; n -= 8, p += 8)
+		{
+			u64_t word;
+			memcpy(&word, p, sizeof(word));
+			h ^= RotateLeft(word * C1, 31) * C2;
+			h = RotateLeft(h, 27) * 5 + 0x52dce729;
+		}
+
+		if(n > 0)
+		{
+			u64_t word = 0;
+			memcpy(&word, p, n);
+			h ^= RotateLeft(word * C1, 31) * C2;
+		}
+
+		return HashMix(h ^ (u64_t)sz_data);
+	}
 }
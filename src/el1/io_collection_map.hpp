@@ -4,6 +4,13 @@
 #include "io_types.hpp"
 #include "io_collection_list.hpp"
 #include "io_text_string.hpp"
+#include <concepts>
+#include <memory>
+#include <string.h>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
 
 namespace el1::io::collection::map
 {
@@ -62,6 +69,94 @@ namespace el1::io::collection::map
 
 	/*****************************************************************************/
 
+	// ordered sequence stored as a list of chunks, this is the storage behind TSortedMap
+	// inserting or removing an item only moves the items of one chunk, full chunks are split and sparse ones are merged with a neighbour
+	// a list which is handed over in one piece is adopted as a single chunk and only cut into regular chunks once it gets modified
+	// indexed access walks the chunks, iterate instead where possible
+	template<typename T>
+	class TChunkedList
+	{
+		template<typename, typename>
+		friend class TSortedMap;
+
+		public:
+			// a chunk never grows beyond CHUNK_MAX items, splitting one leaves the parts filled to no more than CHUNK_FILL
+			static const usys_t CHUNK_MAX = util::Max<usys_t>(16, 4096 / sizeof(T));
+			static const usys_t CHUNK_FILL = CHUNK_MAX / 4 * 3;
+
+			template<typename TItem, typename TChunk>
+			class iterator_tt
+			{
+				friend class TChunkedList;
+				protected:
+					TChunk* chunk;
+					usys_t index;
+
+					iterator_tt(TChunk* const chunk) : chunk(chunk), index(0) {}
+
+				public:
+					TItem& operator*() const { return *chunk->ItemPtr(index); }
+					TItem* operator->() const { return chunk->ItemPtr(index); }
+					iterator_tt& operator++() { if(++index == chunk->Count()) { chunk++; index = 0; } return *this; }
+					bool operator==(const iterator_tt& rhs) const { return chunk == rhs.chunk && index == rhs.index; }
+					bool operator!=(const iterator_tt& rhs) const { return chunk != rhs.chunk || index != rhs.index; }
+			};
+
+			using iterator_t = iterator_tt<T, TList<T>>;
+			using const_iterator_t = iterator_tt<const T, const TList<T>>;
+
+		protected:
+			struct position_t
+			{
+				usys_t idx_chunk;
+				usys_t idx_item;	// equals the size of the last chunk for the position behind the last item
+			};
+
+			TList<TList<T>> chunks;	// none of them is ever empty
+			usys_t n_items;
+
+			// returns the position of the first item for which comparator(item) >= 0
+			template<typename C>
+			position_t LowerBound(C comparator) const EL_GETTER;
+
+			// returns nullptr for the position behind the last item
+			T* At(const position_t pos) EL_GETTER;
+			const T* At(const position_t pos) const EL_GETTER;
+
+			T& Insert(position_t pos, T&& item);
+			void Remove(position_t pos);
+
+			// cuts the chunk at pos into pieces of at most CHUNK_FILL items, pos is updated to point to the same item
+			void Split(position_t& pos);
+
+			// moves all items of the chunk following idx_chunk into idx_chunk
+			void Merge(const usys_t idx_chunk);
+
+			void Assign(TList<T>&& list);
+			void Clear() { chunks.Clear(); n_items = 0; }
+
+		public:
+			usys_t Count() const EL_GETTER { return n_items; }
+
+			T& operator[](const usys_t index) EL_GETTER;
+			const T& operator[](const usys_t index) const EL_GETTER;
+			T* ItemPtr(const usys_t index) EL_GETTER;
+			const T* ItemPtr(const usys_t index) const EL_GETTER;
+
+			iterator_t begin() { return iterator_t(chunks.ItemPtr(0)); }
+			iterator_t end() { return iterator_t(chunks.ItemPtr(0) + chunks.Count()); }
+			const_iterator_t begin() const { return const_iterator_t(chunks.ItemPtr(0)); }
+			const_iterator_t end() const { return const_iterator_t(chunks.ItemPtr(0) + chunks.Count()); }
+
+			TChunkedList& operator=(TChunkedList&& other);
+			TChunkedList& operator=(const TChunkedList& other) = default;
+			TChunkedList(TChunkedList&& other);
+			TChunkedList(const TChunkedList& other) = default;
+			TChunkedList() : n_items(0) {}
+	};
+
+	/*****************************************************************************/
+
 	template<typename TKey, typename TValue>
 	class TSortedMap<TKey, const TValue>
 	{
@@ -70,14 +165,22 @@ namespace el1::io::collection::map
 			typedef int (*sorter_function_t)(const TKey&, const TKey&);
 
 		protected:
-			TList<kv_pair_t> items;
+			using position_t = typename TChunkedList<kv_pair_t>::position_t;
+
+			TChunkedList<kv_pair_t> items;
 			sorter_function_t sorter;
 
+			// position of the item with the specified key or of the first item which sorts after it
+			position_t Locate(const TKey& key) const EL_GETTER;
+
+			// returns the item at pos if it has the specified key
+			kv_pair_t* Match(const position_t pos, const TKey& key) const EL_GETTER;
+
 		public:
 			void Clear() { items.Clear(); }
 
-			const TList<kv_pair_t>& Items() const { return items; }
-			array_t<kv_pair_t>& Items() { return items; }
+			const TChunkedList<kv_pair_t>& Items() const { return items; }
+			TChunkedList<kv_pair_t>& Items() { return items; }
 			sorter_function_t Sorter() const { return sorter; }
 
 			// retrieves the value associated with a key; throws if the key does not exist
@@ -108,6 +211,8 @@ namespace el1::io::collection::map
 			TSortedMap(TSortedMap&& other) = default;
 			TSortedMap(const TSortedMap& other) = default;
 			TSortedMap(sorter_function_t sorter = &StdSorter<TKey>);
+
+			// takes over the list without copying; with ASSUME_SORTED the items are only checked for duplicate keys, which is O(n)
 			TSortedMap(TList<kv_pair_t>&& items, EInputOrder input_order = EInputOrder::UNSORTED, sorter_function_t sorter = &StdSorter<TKey>);
 			TSortedMap(const TList<kv_pair_t>& items, sorter_function_t sorter = &StdSorter<TKey>);
 			TSortedMap(std::initializer_list<kv_pair_t> list, sorter_function_t sorter = &StdSorter<TKey>);
@@ -120,6 +225,10 @@ namespace el1::io::collection::map
 			using typename TSortedMap<TKey, const TValue>::kv_pair_t;
 			using typename TSortedMap<TKey, const TValue>::sorter_function_t;
 
+		protected:
+			using typename TSortedMap<TKey, const TValue>::position_t;
+
+		public:
 			using TSortedMap<TKey, const TValue>::Items;
 
 			// retrieves the value associated with a key; throws if the key does not exist
@@ -153,53 +262,464 @@ namespace el1::io::collection::map
 
 	/*****************************************************************************/
 
+	// hash function used by THashMap, specialize it for own key types: static usys_t Hash(const T&)
+	// types which compare equal to each other (e.g. TString and TStringView) must produce the same hash
+	template<typename T>
+	struct hasher_t;
+
+	// fast non-cryptographic hash over a block of memory
+	usys_t HashBytes(const void* const data, const usys_t sz_data) EL_GETTER;
+
+	// finalizer of MurmurHash3, spreads every input bit over the whole result
+	static inline usys_t HashMix(u64_t x)
+	{
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdULL;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ULL;
+		x ^= x >> 33;
+		return (usys_t)x;
+	}
+
+	template<typename T>
+	requires (std::is_integral_v<T> || std::is_enum_v<T>)
+	struct hasher_t<T>
+	{
+		static usys_t Hash(const T value) { return HashMix((u64_t)value); }
+	};
+
+	template<typename T>
+	struct hasher_t<T*>
+	{
+		static usys_t Hash(const T* const value) { return HashMix((u64_t)(uintptr_t)value); }
+	};
+
+	template<>
+	struct hasher_t<io::text::string::TStringView>
+	{
+		static usys_t Hash(const io::text::string::TStringView& value) { return HashBytes(value.ItemPtr(0), value.Count() * sizeof(char32_t)); }
+	};
+
+	template<>
+	struct hasher_t<io::text::string::TString>
+	{
+		static usys_t Hash(const io::text::string::TString& value) { return hasher_t<io::text::string::TStringView>::Hash(value.View()); }
+	};
+
+	// K can be used to look up entries of a map with keys of type TKey without converting it to TKey first
+	// integers and enums are always converted, they compare equal across types which hash differently (e.g. -1 and 0xffffffffU)
+	template<typename TKey, typename K>
+	concept transparent_key_c = !std::is_same_v<std::remove_cvref_t<K>, TKey> && !std::is_arithmetic_v<std::remove_cvref_t<K>> && !std::is_enum_v<std::remove_cvref_t<K>> && requires(const TKey& key, const K& other)
+	{
+		{ hasher_t<K>::Hash(other) } -> std::convertible_to<usys_t>;
+		{ key == other } -> std::convertible_to<bool>;
+	};
+
+	namespace detail
+	{
+		// control byte of an unused slot and of a slot whose item was removed
+		// a used slot stores the lower 7 bits of the hash of its key, so the highest bit tells used and unused slots apart
+		static const u8_t HASH_CTRL_EMPTY = 0x80;
+		static const u8_t HASH_CTRL_DELETED = 0xfe;
+
+		// a group of control bytes which is checked at once, each set bit in the returned masks stands for one slot
+		#if defined(__SSE2__)
+			struct hash_group_t
+			{
+				static const usys_t WIDTH = 16;
+				__m128i ctrl;
+
+				static unsigned Index(const u32_t mask) { return (unsigned)__builtin_ctz(mask); }
+				u32_t Match(const u8_t h2) const { return (u32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8((char)h2), ctrl)); }
+				u32_t MatchEmpty() const { return Match(HASH_CTRL_EMPTY); }
+				u32_t MatchUnused() const { return (u32_t)_mm_movemask_epi8(ctrl); }
+
+				explicit hash_group_t(const u8_t* const p_ctrl) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_ctrl))) {}
+			};
+		#else
+			// portable fallback which tests 8 control bytes in a 64bit word
+			// Match() may report false positives (never false negatives), the keys are compared anyway
+			struct hash_group_t
+			{
+				static const usys_t WIDTH = 8;
+				static const u64_t LSB = 0x0101010101010101ULL;
+				static const u64_t MSB = 0x8080808080808080ULL;
+				u64_t ctrl;
+
+				static unsigned Index(const u64_t mask) { return (unsigned)__builtin_ctzll(mask) >> 3; }
+				u64_t Match(const u8_t h2) const { const u64_t x = ctrl ^ (LSB * h2); return (x - LSB) & ~x & MSB; }
+				u64_t MatchEmpty() const { return ctrl & ~(ctrl << 6) & MSB; }
+				u64_t MatchUnused() const { return ctrl & MSB; }
+
+				explicit hash_group_t(const u8_t* const p_ctrl) { memcpy(&ctrl, p_ctrl, sizeof(ctrl)); }
+			};
+		#endif
+	}
+
+	// open-addressing hash map (SwissTable layout)
+	// the control bytes are kept apart from the items, a lookup probes whole groups of them with a single SIMD compare and only touches items whose 7 bit hash tag matches
+	// lookups, insertions and removals are O(1) on average, the order of the items is unspecified and changes when the table grows
+	// pointers and references to items are invalidated by every insertion
 	template<typename TKey, typename TValue>
 	class THashMap<TKey, const TValue>
 	{
 		public:
 			using kv_pair_t = kv_pair_tt<TKey, TValue>;
+			using group_t = detail::hash_group_t;
+
+			template<typename TPair>
+			class iterator_tt
+			{
+				friend class THashMap<TKey, const TValue>;
+				friend class THashMap<TKey, TValue>;
+				protected:
+					const u8_t* ctrl;
+					TPair* slots;
+					usys_t index;
+					usys_t n_slots;
+
+					void SkipUnused() { while(index < n_slots && (ctrl[index] & 0x80) != 0) index++; }
+					iterator_tt(const u8_t* const ctrl, TPair* const slots, const usys_t index, const usys_t n_slots) : ctrl(ctrl), slots(slots), index(index), n_slots(n_slots) { SkipUnused(); }
+
+				public:
+					TPair& operator*() const { return slots[index]; }
+					TPair* operator->() const { return slots + index; }
+					iterator_tt& operator++() { index++; SkipUnused(); return *this; }
+					bool operator==(const iterator_tt& rhs) const { return index == rhs.index; }
+					bool operator!=(const iterator_tt& rhs) const { return index != rhs.index; }
+			};
+
+			using const_iterator_t = iterator_tt<const kv_pair_t>;
 
 		protected:
-			TList<kv_pair_t> items;
-// 			TView<kv_pair_t> view;	// TODO
-			usys_t (*hasher)(TKey);
+			static const usys_t MAX_LOAD_NUMERATOR = 7;
+			static const usys_t MAX_LOAD_DENOMINATOR = 8;
+
+			u8_t* ctrl;	// one control byte per slot (see detail::HASH_CTRL_*)
+			kv_pair_t* slots;
+			usys_t n_slots;	// 0 or a power of two which is a multiple of group_t::WIDTH
+			usys_t n_items;
+			usys_t n_growth_left;	// unused slots which can still be taken before the table has to grow, tombstones do not count
+
+			static usys_t Capacity(const usys_t n_slots) { return n_slots / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR; }
+
+			template<typename K>
+			usys_t Find(const K& key, const usys_t hash) const EL_GETTER;
+
+			template<typename K>
+			usys_t Find(const K& key) const EL_GETTER { return Find(key, hasher_t<K>::Hash(key)); }
+
+			// returns the first unused slot in the probe sequence of hash - there always is one
+			usys_t FindUnused(const usys_t hash) const EL_GETTER;
+
+			// places a new item into the table, the key must not exist yet
+			template<typename ... A>
+			kv_pair_t& Emplace(const usys_t hash, A&& ... args);
+
+			void EraseSlot(const usys_t index);
+			void Rehash(const usys_t n_slots_new);
+			void Release();
 
 		public:
-			const TValue& operator[](TKey key) const;
+			usys_t Count() const EL_GETTER { return n_items; }
+			void Clear();
+
+			// makes room for n_items_min items without further growing
+			void Reserve(const usys_t n_items_min);
+
+			const_iterator_t begin() const { return const_iterator_t(ctrl, slots, 0, n_slots); }
+			const_iterator_t end() const { return const_iterator_t(ctrl, slots, n_slots, n_slots); }
+
+			// retrieves the value associated with a key; throws if the key does not exist
+			const TValue& operator[](const TKey& key) const;
+			template<typename K> requires transparent_key_c<TKey, K>
+			const TValue& operator[](const K& key) const;
 
 			// receives the value associated with the specified key; return nullptr if the key does not exist
-			const TValue* Get(TKey key) const EL_GETTER;
+			const TValue* Get(const TKey& key) const EL_GETTER;
+			template<typename K> requires transparent_key_c<TKey, K>
+			const TValue* Get(const K& key) const EL_GETTER;
+
+			// receives the value associated with the specified key; otherwise a default-value is returned, which is NOT inserted
+			const TValue& GetWithDefault(const TKey& key, const TValue& _default) const EL_GETTER;
+
+			bool Contains(const TKey& key) const EL_GETTER { return Find(key) != NEG1; }
+			template<typename K> requires transparent_key_c<TKey, K>
+			bool Contains(const K& key) const EL_GETTER { return Find(key) != NEG1; }
 
 			// adds a new key/value pair to the map; if the key already exists it will throw an exception
 			TValue& Add(TKey key, const TValue& value);
+			TValue& Add(TKey key, TValue&& value);
+			TValue& Add(kv_pair_t&& pair);
+
+			// adds a default value if the key does not exist yet, otherwise the existing value is returned
+			const TValue& GetOrInsertDefault(const TKey& key, const TValue& _default);
+
+			THashMap& operator=(THashMap&& other);
+			THashMap& operator=(const THashMap& other);
+
+			THashMap(THashMap&& other);
+			THashMap(const THashMap& other);
+			THashMap();
+			THashMap(TList<kv_pair_t>&& items);
+			THashMap(const TList<kv_pair_t>& items);
+			THashMap(std::initializer_list<kv_pair_t> list);
+			~THashMap();
 	};
 
 	template<typename TKey, typename TValue>
-	class THashMap : public TSortedMap<TKey, const TValue>
+	class THashMap : public THashMap<TKey, const TValue>
 	{
 		public:
-			TValue& operator[](TKey key) const;
+			using typename THashMap<TKey, const TValue>::kv_pair_t;
+			using iterator_t = typename THashMap<TKey, const TValue>::template iterator_tt<kv_pair_t>;
+			using THashMap<TKey, const TValue>::begin;
+			using THashMap<TKey, const TValue>::end;
 
-			// retreivs the value associated with the specified key; return nullptr if the key does not exist
-			TValue* Get(TKey key) const EL_GETTER;
+			iterator_t begin() { return iterator_t(this->ctrl, this->slots, 0, this->n_slots); }
+			iterator_t end() { return iterator_t(this->ctrl, this->slots, this->n_slots, this->n_slots); }
+
+			// retrieves the value associated with a key; throws if the key does not exist
+			TValue& operator[](const TKey& key) const;
+			template<typename K> requires transparent_key_c<TKey, K>
+			TValue& operator[](const K& key) const;
+
+			// retrieves the value associated with the specified key; return nullptr if the key does not exist
+			TValue* Get(const TKey& key) const EL_GETTER;
+			template<typename K> requires transparent_key_c<TKey, K>
+			TValue* Get(const K& key) const EL_GETTER;
 
 			// updates the value asociated with a key; calls Add() if the key does not exist yet
-			TValue& Set(TKey key, const TValue& value);
+			TValue& Set(const TKey& key, const TValue& value);
+			TValue& Set(const TKey& key, TValue&& value);
+			TValue& Set(kv_pair_t&& pair);
 
 			// removes the specified key (along with its value) from the map; return false if the key did not exist; true otherwise
-			bool Remove(TKey key);
+			bool Remove(const TKey& key);
+			template<typename K> requires transparent_key_c<TKey, K>
+			bool Remove(const K& key);
+
+			// adds a default value if the key does not exist yet, otherwise the existing value is returned
+			TValue& GetOrInsertDefault(const TKey& key, const TValue& _default);
+
+			using THashMap<TKey, const TValue>::THashMap;
+			THashMap& operator=(THashMap&& other) = default;
+			THashMap& operator=(const THashMap& other) = default;
+			THashMap(THashMap&& other) = default;
+			THashMap(const THashMap& other) = default;
+			THashMap() = default;
 	};
 
 	/*****************************************************************************/
 
+	template<typename T>
+	template<typename C>
+	typename TChunkedList<T>::position_t TChunkedList<T>::LowerBound(C comparator) const
+	{
+		const TList<T>* const arr_chunks = chunks.ItemPtr(0);
+		const usys_t n_chunks = chunks.Count();
+
+		// first chunk whose last item is not below the needle
+		usys_t idx_chunk = 0;
+		for(usys_t n = n_chunks; n > 0;)
+		{
+			const usys_t half = n / 2;
+			const TList<T>& chunk = arr_chunks[idx_chunk + half];
+			if(comparator(*chunk.ItemPtr(chunk.Count() - 1)) < 0)
+			{
+				idx_chunk += half + 1;
+				n -= half + 1;
+			}
+			else
+				n = half;
+		}
+
+		if(idx_chunk == n_chunks)
+			return n_chunks == 0 ? position_t { 0, 0 } : position_t { n_chunks - 1, arr_chunks[n_chunks - 1].Count() };
+
+		const T* const arr_items = arr_chunks[idx_chunk].ItemPtr(0);
+		usys_t idx_item = 0;
+		for(usys_t n = arr_chunks[idx_chunk].Count(); n > 0;)
+		{
+			const usys_t half = n / 2;
+			if(comparator(arr_items[idx_item + half]) < 0)
+			{
+				idx_item += half + 1;
+				n -= half + 1;
+			}
+			else
+				n = half;
+		}
+
+		return { idx_chunk, idx_item };
+	}
+
+	template<typename T>
+	T* TChunkedList<T>::At(const position_t pos)
+	{
+		return pos.idx_chunk < chunks.Count() ? chunks[pos.idx_chunk].ItemPtr(pos.idx_item) : nullptr;
+	}
+
+	template<typename T>
+	const T* TChunkedList<T>::At(const position_t pos) const
+	{
+		return pos.idx_chunk < chunks.Count() ? chunks[pos.idx_chunk].ItemPtr(pos.idx_item) : nullptr;
+	}
+
+	template<typename T>
+	T& TChunkedList<T>::Insert(position_t pos, T&& item)
+	{
+		if(chunks.Count() == 0)
+		{
+			chunks.MoveAppend(TList<T>());
+			pos = { 0, 0 };
+		}
+		else if(chunks[pos.idx_chunk].Count() >= CHUNK_MAX)
+			Split(pos);
+
+		T& inserted = chunks[pos.idx_chunk].MoveInsert(pos.idx_item, std::move(item));
+		n_items++;
+		return inserted;
+	}
+
+	template<typename T>
+	void TChunkedList<T>::Remove(position_t pos)
+	{
+		if(chunks[pos.idx_chunk].Count() > CHUNK_MAX)
+			Split(pos);
+
+		TList<T>& chunk = chunks[pos.idx_chunk];
+		chunk.Remove(pos.idx_item, 1);
+		n_items--;
+
+		if(chunk.Count() == 0)
+			chunks.Remove(pos.idx_chunk, 1);
+		else if(chunk.Count() < CHUNK_MAX / 4)
+		{
+			if(pos.idx_chunk + 1 < chunks.Count() && chunk.Count() + chunks[pos.idx_chunk + 1].Count() <= CHUNK_FILL)
+				Merge(pos.idx_chunk);
+			else if(pos.idx_chunk > 0 && chunk.Count() + chunks[pos.idx_chunk - 1].Count() <= CHUNK_FILL)
+				Merge(pos.idx_chunk - 1);
+		}
+	}
+
+	template<typename T>
+	void TChunkedList<T>::Split(position_t& pos)
+	{
+		const usys_t idx_chunk = pos.idx_chunk;
+		const usys_t n = chunks[idx_chunk].Count();
+		const usys_t n_pieces = util::Max<usys_t>(2, (n + CHUNK_FILL - 1) / CHUNK_FILL);
+
+		TList<TList<T>> pieces;
+		pieces.Prealloc(n_pieces - 1);
+		for(usys_t i = 1; i < n_pieces; i++)
+		{
+			const usys_t idx_start = n * i / n_pieces;
+			const usys_t idx_end = n * (i + 1) / n_pieces;
+			pieces.MoveAppend(TList<T>()).MoveAppend(chunks[idx_chunk].ItemPtr(idx_start), idx_end - idx_start);
+		}
+
+		chunks[idx_chunk].Remove(n / n_pieces, n - n / n_pieces);
+		chunks.MoveInsert(idx_chunk + 1, pieces.ItemPtr(0), pieces.Count());
+
+		while(pos.idx_chunk < idx_chunk + n_pieces - 1 && pos.idx_item >= chunks[pos.idx_chunk].Count())
+		{
+			pos.idx_item -= chunks[pos.idx_chunk].Count();
+			pos.idx_chunk++;
+		}
+	}
+
+	template<typename T>
+	void TChunkedList<T>::Merge(const usys_t idx_chunk)
+	{
+		TList<T>& next = chunks[idx_chunk + 1];
+		chunks[idx_chunk].MoveAppend(next.ItemPtr(0), next.Count());
+		chunks.Remove(idx_chunk + 1, 1);
+	}
+
+	template<typename T>
+	void TChunkedList<T>::Assign(TList<T>&& list)
+	{
+		chunks.Clear();
+		n_items = list.Count();
+		if(n_items > 0)
+			chunks.MoveAppend(std::move(list));
+	}
+
+	template<typename T>
+	T* TChunkedList<T>::ItemPtr(usys_t index)
+	{
+		for(TList<T>& chunk : chunks)
+		{
+			if(index < chunk.Count())
+				return chunk.ItemPtr(index);
+			index -= chunk.Count();
+		}
+		return nullptr;
+	}
+
+	template<typename T>
+	const T* TChunkedList<T>::ItemPtr(usys_t index) const
+	{
+		return const_cast<TChunkedList*>(this)->ItemPtr(index);
+	}
+
+	template<typename T>
+	T& TChunkedList<T>::operator[](const usys_t index)
+	{
+		T* const item = ItemPtr(index);
+		EL_ERROR(item == nullptr, TIndexOutOfBoundsException, 0, (ssys_t)n_items - 1, index);
+		return *item;
+	}
+
+	template<typename T>
+	const T& TChunkedList<T>::operator[](const usys_t index) const
+	{
+		return const_cast<TChunkedList*>(this)->operator[](index);
+	}
+
+	template<typename T>
+	TChunkedList<T>& TChunkedList<T>::operator=(TChunkedList&& other)
+	{
+		chunks = std::move(other.chunks);
+		n_items = other.n_items;
+		other.n_items = 0;
+		return *this;
+	}
+
+	template<typename T>
+	TChunkedList<T>::TChunkedList(TChunkedList&& other) : chunks(std::move(other.chunks)), n_items(other.n_items)
+	{
+		other.n_items = 0;
+	}
+
+	/*****************************************************************************/
+
+	template<typename TKey, typename TValue>
+	typename TSortedMap<TKey, const TValue>::position_t TSortedMap<TKey, const TValue>::Locate(const TKey& key) const
+	{
+		return this->items.LowerBound([&](const kv_pair_t& item) {
+			return this->sorter(item.key, key);
+		});
+	}
+
+	template<typename TKey, typename TValue>
+	typename TSortedMap<TKey, const TValue>::kv_pair_t* TSortedMap<TKey, const TValue>::Match(const position_t pos, const TKey& key) const
+	{
+		const kv_pair_t* const item = this->items.At(pos);
+		return item != nullptr && this->sorter(item->key, key) == 0 ? const_cast<kv_pair_t*>(item) : nullptr;
+	}
+
 	template<typename TKey, typename TValue>
-	TSortedMap<TKey, const TValue>::TSortedMap(TList<kv_pair_t>&& items, const EInputOrder input_order, sorter_function_t sorter) : items(std::move(items)), sorter(sorter)
+	TSortedMap<TKey, const TValue>::TSortedMap(TList<kv_pair_t>&& items, const EInputOrder input_order, sorter_function_t sorter) : sorter(sorter)
 	{
 		if(input_order == EInputOrder::UNSORTED)
-			this->items.Sort(ESortOrder::ASCENDING, [this](const kv_pair_t& a, const kv_pair_t& b) { return this->sorter(a.key, b.key); });
+			items.Sort(ESortOrder::ASCENDING, [this](const kv_pair_t& a, const kv_pair_t& b) { return this->sorter(a.key, b.key); });
+
+		for(usys_t i = 1; i < items.Count(); i++)
+			EL_ERROR(this->sorter(items[i - 1].key, items[i].key) == 0, TKeyAlreadyExistsException<TKey>, items[i].key);
 
-		for(usys_t i = 1; i < this->items.Count(); i++)
-			EL_ERROR(this->sorter(this->items[i - 1].key, this->items[i].key) == 0, TKeyAlreadyExistsException<TKey>, this->items[i].key);
+		this->items.Assign(std::move(items));
 	}
 
 	template<typename TKey, typename TValue>
@@ -228,14 +748,8 @@ namespace el1::io::collection::map
 	template<typename TKey, typename TValue>
 	const TValue* TSortedMap<TKey, const TValue>::Get(const TKey& key) const
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, false);
-
-		if(index == NEG1)
-			return nullptr;
-		else
-			return &this->items[index].value;
+		const kv_pair_t* const item = this->Match(this->Locate(key), key);
+		return item == nullptr ? nullptr : &item->value;
 	}
 
 	template<typename TKey, typename TValue>
@@ -254,56 +768,33 @@ namespace el1::io::collection::map
 	template<typename TKey, typename TValue>
 	TValue& TSortedMap<TKey, const TValue>::Add(TKey key, const TValue& value)
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, true);
-
-		EL_ERROR(index != NEG1 && this->items[index].key == key, TKeyAlreadyExistsException<TKey>, key);
-
-		if(index == NEG1)
-		{
-			return this->items.Append({ key, value }).value;
-		}
-		else if(this->sorter(this->items[index].key, key) > 0)
-		{
-			return this->items.Insert(index, { key, value }).value;
-		}
-		else
-		{
-			return this->items.Insert(index + 1, { key, value }).value;
-		}
+		const position_t pos = this->Locate(key);
+		EL_ERROR(this->Match(pos, key) != nullptr, TKeyAlreadyExistsException<TKey>, key);
+		return this->items.Insert(pos, { std::move(key), value }).value;
 	}
 
 	template<typename TKey, typename TValue>
 	TValue& TSortedMap<TKey, const TValue>::Add(TKey key, TValue&& value)
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, true);
-
-		EL_ERROR(index != NEG1 && this->items[index].key == key, TKeyAlreadyExistsException<TKey>, key);
+		const position_t pos = this->Locate(key);
+		EL_ERROR(this->Match(pos, key) != nullptr, TKeyAlreadyExistsException<TKey>, key);
+		return this->items.Insert(pos, { std::move(key), std::move(value) }).value;
+	}
 
-		if(index == NEG1)
-		{
-			return this->items.MoveAppend({ key, std::move(value) }).value;
-		}
-		else if(this->sorter(this->items[index].key, key) > 0)
-		{
-			return this->items.MoveInsert(index, { key, std::move(value) }).value;
-		}
-		else
-		{
-			return this->items.MoveInsert(index + 1, { key, std::move(value) }).value;
-		}
+	template<typename TKey, typename TValue>
+	TValue& TSortedMap<TKey, const TValue>::Add(kv_pair_t&& pair)
+	{
+		const position_t pos = this->Locate(pair.key);
+		EL_ERROR(this->Match(pos, pair.key) != nullptr, TKeyAlreadyExistsException<TKey>, pair.key);
+		return this->items.Insert(pos, std::move(pair)).value;
 	}
 
 	template<typename TKey, typename TValue>
 	const TValue& TSortedMap<TKey, const TValue>::GetOrInsertDefault(const TKey& key, const TValue& _default)
 	{
-		const TValue* value = this->Get(key);
-		if(value == nullptr)
-			value = &this->Add(key, _default);
-		return *value;
+		const position_t pos = this->Locate(key);
+		const kv_pair_t* const item = this->Match(pos, key);
+		return item != nullptr ? item->value : this->items.Insert(pos, { key, _default }).value;
 	}
 
 	template<typename TKey, typename TValue>
@@ -316,7 +807,7 @@ namespace el1::io::collection::map
 	/*****************************************************************************/
 
 	template<typename TKey, typename TValue>
-	TSortedMap<TKey, TValue>::TSortedMap(const TSortedMap<TKey, const TValue>& other) : TSortedMap<TKey, const TValue>(TList<kv_pair_t>(other.Items()), EInputOrder::ASSUME_SORTED, other.Sorter())
+	TSortedMap<TKey, TValue>::TSortedMap(const TSortedMap<TKey, const TValue>& other) : TSortedMap<TKey, const TValue>(other)
 	{
 	}
 
@@ -355,73 +846,470 @@ namespace el1::io::collection::map
 	template<typename TKey, typename TValue>
 	TValue& TSortedMap<TKey, TValue>::Set(const TKey& key, const TValue& value)
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, true);
+		const position_t pos = this->Locate(key);
+		kv_pair_t* const item = this->Match(pos, key);
+		if(item != nullptr)
+			return item->value = value;
+		return this->items.Insert(pos, { key, value }).value;
+	}
 
-		if(index == NEG1)
-		{
-			return this->items.Append({ key, value }).value;
-		}
-		else if(this->sorter(this->items[index].key, key) == 0)
+	template<typename TKey, typename TValue>
+	TValue& TSortedMap<TKey, TValue>::Set(const TKey& key, TValue&& value)
+	{
+		const position_t pos = this->Locate(key);
+		kv_pair_t* const item = this->Match(pos, key);
+		if(item != nullptr)
+			return item->value = std::move(value);
+		return this->items.Insert(pos, { key, std::move(value) }).value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& TSortedMap<TKey, TValue>::Set(kv_pair_t&& pair)
+	{
+		const position_t pos = this->Locate(pair.key);
+		kv_pair_t* const item = this->Match(pos, pair.key);
+		if(item != nullptr)
+			return item->value = std::move(pair.value);
+		return this->items.Insert(pos, std::move(pair)).value;
+	}
+
+	template<typename TKey, typename TValue>
+	bool TSortedMap<TKey, TValue>::Remove(const TKey& key)
+	{
+		const position_t pos = this->Locate(key);
+		if(this->Match(pos, key) == nullptr)
+			return false;
+
+		this->items.Remove(pos);
+		return true;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& TSortedMap<TKey, TValue>::GetOrInsertDefault(const TKey& key, const TValue& _default)
+	{
+		const position_t pos = this->Locate(key);
+		kv_pair_t* const item = this->Match(pos, key);
+		return item != nullptr ? item->value : this->items.Insert(pos, { key, _default }).value;
+	}
+
+	/*****************************************************************************/
+
+	template<typename TKey, typename TValue>
+	template<typename K>
+	usys_t THashMap<TKey, const TValue>::Find(const K& key, const usys_t hash) const
+	{
+		if(this->n_items == 0)
+			return NEG1;
+
+		// triangular probing over whole groups visits every group once as long as the number of groups is a power of two
+		const u8_t h2 = (u8_t)(hash & 0x7f);
+		const usys_t group_mask = this->n_slots / group_t::WIDTH - 1;
+		usys_t group_index = (hash >> 7) & group_mask;
+
+		for(usys_t step = 1;; step++)
 		{
-			return this->items[index].value = value;
+			const usys_t base = group_index * group_t::WIDTH;
+			const group_t group(this->ctrl + base);
+
+			for(auto match = group.Match(h2); match != 0; match &= match - 1)
+			{
+				const usys_t index = base + group_t::Index(match);
+				if(EL_LIKELY(this->slots[index].key == key))
+					return index;
+			}
+
+			// a probe sequence never continues past a group which still has an empty slot
+			if(EL_LIKELY(group.MatchEmpty() != 0))
+				return NEG1;
+
+			group_index = (group_index + step) & group_mask;
 		}
-		else if(this->sorter(this->items[index].key, key) > 0)
+	}
+
+	template<typename TKey, typename TValue>
+	usys_t THashMap<TKey, const TValue>::FindUnused(const usys_t hash) const
+	{
+		const usys_t group_mask = this->n_slots / group_t::WIDTH - 1;
+		usys_t group_index = (hash >> 7) & group_mask;
+
+		for(usys_t step = 1;; step++)
 		{
-			return this->items.Insert(index, { key, value }).value;
+			const usys_t base = group_index * group_t::WIDTH;
+			const auto unused = group_t(this->ctrl + base).MatchUnused();
+			if(unused != 0)
+				return base + group_t::Index(unused);
+			group_index = (group_index + step) & group_mask;
 		}
-		else
+	}
+
+	template<typename TKey, typename TValue>
+	template<typename ... A>
+	typename THashMap<TKey, const TValue>::kv_pair_t& THashMap<TKey, const TValue>::Emplace(const usys_t hash, A&& ... args)
+	{
+		if(this->n_growth_left == 0)
 		{
-			return this->items.Insert(index + 1, { key, value }).value;
+			// a table full of tombstones is cleaned up in place, otherwise it doubles
+			if(this->n_slots > 0 && this->n_items < Capacity(this->n_slots) / 2)
+				this->Rehash(this->n_slots);
+			else
+				this->Rehash(this->n_slots == 0 ? group_t::WIDTH : this->n_slots * 2);
 		}
+
+		const usys_t index = this->FindUnused(hash);
+		kv_pair_t* const slot = new (this->slots + index) kv_pair_t { std::forward<A>(args)... };
+
+		if(this->ctrl[index] == detail::HASH_CTRL_EMPTY)
+			this->n_growth_left--;
+		this->ctrl[index] = (u8_t)(hash & 0x7f);
+		this->n_items++;
+
+		return *slot;
 	}
 
 	template<typename TKey, typename TValue>
-	TValue& TSortedMap<TKey, TValue>::Set(const TKey& key, TValue&& value)
+	void THashMap<TKey, const TValue>::EraseSlot(const usys_t index)
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, true);
+		this->slots[index].~kv_pair_t();
+		this->n_items--;
 
-		if(index == NEG1)
+		// no probe sequence went past this group if it still has an empty slot, so the slot can become empty again
+		const usys_t base = index - index % group_t::WIDTH;
+		if(group_t(this->ctrl + base).MatchEmpty() != 0)
 		{
-			return this->items.MoveAppend({ key, std::move(value) }).value;
+			this->ctrl[index] = detail::HASH_CTRL_EMPTY;
+			this->n_growth_left++;
 		}
-		else if(this->sorter(this->items[index].key, key) == 0)
+		else
+			this->ctrl[index] = detail::HASH_CTRL_DELETED;
+	}
+
+	template<typename TKey, typename TValue>
+	void THashMap<TKey, const TValue>::Rehash(const usys_t n_slots_new)
+	{
+		u8_t* const ctrl_old = this->ctrl;
+		kv_pair_t* const slots_old = this->slots;
+		const usys_t n_slots_old = this->n_slots;
+
+		this->ctrl = new u8_t[n_slots_new];
+		try
 		{
-			return this->items[index].value = std::move(value);
+			this->slots = std::allocator<kv_pair_t>().allocate(n_slots_new);
 		}
-		else if(this->sorter(this->items[index].key, key) > 0)
+		catch(...)
 		{
-			return this->items.MoveInsert(index, { key, std::move(value) }).value;
+			delete[] this->ctrl;
+			this->ctrl = ctrl_old;
+			throw;
 		}
-		else
+
+		memset(this->ctrl, detail::HASH_CTRL_EMPTY, n_slots_new);
+		this->n_slots = n_slots_new;
+		this->n_growth_left = Capacity(n_slots_new) - this->n_items;
+
+		for(usys_t i = 0; i < n_slots_old; i++)
+			if((ctrl_old[i] & 0x80) == 0)
+			{
+				const usys_t hash = hasher_t<TKey>::Hash(slots_old[i].key);
+				const usys_t index = this->FindUnused(hash);
+				new (this->slots + index) kv_pair_t(std::move(slots_old[i]));
+				slots_old[i].~kv_pair_t();
+				this->ctrl[index] = (u8_t)(hash & 0x7f);
+			}
+
+		delete[] ctrl_old;
+		if(slots_old != nullptr)
+			std::allocator<kv_pair_t>().deallocate(slots_old, n_slots_old);
+	}
+
+	template<typename TKey, typename TValue>
+	void THashMap<TKey, const TValue>::Release()
+	{
+		for(usys_t i = 0; i < this->n_slots; i++)
+			if((this->ctrl[i] & 0x80) == 0)
+				this->slots[i].~kv_pair_t();
+
+		delete[] this->ctrl;
+		if(this->slots != nullptr)
+			std::allocator<kv_pair_t>().deallocate(this->slots, this->n_slots);
+
+		this->ctrl = nullptr;
+		this->slots = nullptr;
+		this->n_slots = 0;
+		this->n_items = 0;
+		this->n_growth_left = 0;
+	}
+
+	template<typename TKey, typename TValue>
+	void THashMap<TKey, const TValue>::Clear()
+	{
+		// keeps the table allocated, a map is usually filled up again to a similar size
+		for(usys_t i = 0; i < this->n_slots; i++)
+			if((this->ctrl[i] & 0x80) == 0)
+				this->slots[i].~kv_pair_t();
+
+		if(this->n_slots > 0)
+			memset(this->ctrl, detail::HASH_CTRL_EMPTY, this->n_slots);
+		this->n_items = 0;
+		this->n_growth_left = Capacity(this->n_slots);
+	}
+
+	template<typename TKey, typename TValue>
+	void THashMap<TKey, const TValue>::Reserve(const usys_t n_items_min)
+	{
+		usys_t n_slots_new = group_t::WIDTH;
+		while(Capacity(n_slots_new) < n_items_min)
+			n_slots_new *= 2;
+
+		if(n_slots_new > this->n_slots)
+			this->Rehash(n_slots_new);
+	}
+
+	template<typename TKey, typename TValue>
+	const TValue& THashMap<TKey, const TValue>::operator[](const TKey& key) const
+	{
+		const TValue* const value = this->Get(key);
+		EL_ERROR(value == nullptr, TKeyNotFoundException<TKey>, key);
+		return *value;
+	}
+
+	template<typename TKey, typename TValue>
+	template<typename K> requires transparent_key_c<TKey, K>
+	const TValue& THashMap<TKey, const TValue>::operator[](const K& key) const
+	{
+		const TValue* const value = this->Get(key);
+		EL_ERROR(value == nullptr, TKeyNotFoundException<TKey>, TKey(key));
+		return *value;
+	}
+
+	template<typename TKey, typename TValue>
+	const TValue* THashMap<TKey, const TValue>::Get(const TKey& key) const
+	{
+		const usys_t index = this->Find(key);
+		return index == NEG1 ? nullptr : &this->slots[index].value;
+	}
+
+	template<typename TKey, typename TValue>
+	template<typename K> requires transparent_key_c<TKey, K>
+	const TValue* THashMap<TKey, const TValue>::Get(const K& key) const
+	{
+		const usys_t index = this->Find(key);
+		return index == NEG1 ? nullptr : &this->slots[index].value;
+	}
+
+	template<typename TKey, typename TValue>
+	const TValue& THashMap<TKey, const TValue>::GetWithDefault(const TKey& key, const TValue& _default) const
+	{
+		const TValue* const value = this->Get(key);
+		return value == nullptr ? _default : *value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, const TValue>::Add(TKey key, const TValue& value)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(key);
+		EL_ERROR(this->Find(key, hash) != NEG1, TKeyAlreadyExistsException<TKey>, key);
+		return this->Emplace(hash, std::move(key), value).value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, const TValue>::Add(TKey key, TValue&& value)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(key);
+		EL_ERROR(this->Find(key, hash) != NEG1, TKeyAlreadyExistsException<TKey>, key);
+		return this->Emplace(hash, std::move(key), std::move(value)).value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, const TValue>::Add(kv_pair_t&& pair)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(pair.key);
+		EL_ERROR(this->Find(pair.key, hash) != NEG1, TKeyAlreadyExistsException<TKey>, pair.key);
+		return this->Emplace(hash, std::move(pair.key), std::move(pair.value)).value;
+	}
+
+	template<typename TKey, typename TValue>
+	const TValue& THashMap<TKey, const TValue>::GetOrInsertDefault(const TKey& key, const TValue& _default)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(key);
+		const usys_t index = this->Find(key, hash);
+		if(index != NEG1)
+			return this->slots[index].value;
+		return this->Emplace(hash, key, _default).value;
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>& THashMap<TKey, const TValue>::operator=(THashMap&& other)
+	{
+		if(this != &other)
 		{
-			return this->items.MoveInsert(index + 1, { key, std::move(value) }).value;
+			this->Release();
+			this->ctrl = other.ctrl;
+			this->slots = other.slots;
+			this->n_slots = other.n_slots;
+			this->n_items = other.n_items;
+			this->n_growth_left = other.n_growth_left;
+			other.ctrl = nullptr;
+			other.slots = nullptr;
+			other.n_slots = 0;
+			other.n_items = 0;
+			other.n_growth_left = 0;
 		}
+		return *this;
 	}
 
 	template<typename TKey, typename TValue>
-	bool TSortedMap<TKey, TValue>::Remove(const TKey& key)
+	THashMap<TKey, const TValue>& THashMap<TKey, const TValue>::operator=(const THashMap& other)
 	{
-		const usys_t index = this->items.BinarySearch([&](const kv_pair_t& item) {
-			return this->sorter(item.key, key);
-		}, false);
+		if(this != &other)
+			*this = THashMap(other);
+		return *this;
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap(THashMap&& other) : THashMap()
+	{
+		*this = std::move(other);
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap(const THashMap& other) : THashMap()
+	{
+		// the copy gets the same layout, no key has to be hashed again
+		if(other.n_items == 0)
+			return;
+
+		this->Rehash(other.n_slots);
+		for(usys_t i = 0; i < other.n_slots; i++)
+			if((other.ctrl[i] & 0x80) == 0)
+			{
+				new (this->slots + i) kv_pair_t(other.slots[i]);
+				this->ctrl[i] = other.ctrl[i];
+				this->n_items++;
+			}
+
+		// tombstones have to be copied too, they are part of the probe sequences
+		memcpy(this->ctrl, other.ctrl, other.n_slots);
+		this->n_growth_left = other.n_growth_left;
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap() : ctrl(nullptr), slots(nullptr), n_slots(0), n_items(0), n_growth_left(0)
+	{
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap(TList<kv_pair_t>&& items) : THashMap()
+	{
+		this->Reserve(items.Count());
+		for(kv_pair_t& item : items)
+			this->Add(std::move(item));
+		items.Clear();
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap(const TList<kv_pair_t>& items) : THashMap()
+	{
+		this->Reserve(items.Count());
+		for(const kv_pair_t& item : items)
+			this->Add(item.key, item.value);
+	}
 
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::THashMap(std::initializer_list<kv_pair_t> list) : THashMap()
+	{
+		this->Reserve(list.size());
+		for(const kv_pair_t& item : list)
+			this->Add(item.key, item.value);
+	}
+
+	template<typename TKey, typename TValue>
+	THashMap<TKey, const TValue>::~THashMap()
+	{
+		this->Release();
+	}
+
+	/*****************************************************************************/
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, TValue>::operator[](const TKey& key) const
+	{
+		return const_cast<TValue&>(static_cast<const THashMap<TKey, const TValue>*>(this)->operator[](key));
+	}
+
+	template<typename TKey, typename TValue>
+	template<typename K> requires transparent_key_c<TKey, K>
+	TValue& THashMap<TKey, TValue>::operator[](const K& key) const
+	{
+		return const_cast<TValue&>(static_cast<const THashMap<TKey, const TValue>*>(this)->operator[](key));
+	}
+
+	template<typename TKey, typename TValue>
+	TValue* THashMap<TKey, TValue>::Get(const TKey& key) const
+	{
+		return const_cast<TValue*>(static_cast<const THashMap<TKey, const TValue>*>(this)->Get(key));
+	}
+
+	template<typename TKey, typename TValue>
+	template<typename K> requires transparent_key_c<TKey, K>
+	TValue* THashMap<TKey, TValue>::Get(const K& key) const
+	{
+		return const_cast<TValue*>(static_cast<const THashMap<TKey, const TValue>*>(this)->Get(key));
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, TValue>::Set(const TKey& key, const TValue& value)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(key);
+		const usys_t index = this->Find(key, hash);
+		if(index != NEG1)
+			return this->slots[index].value = value;
+		return this->Emplace(hash, key, value).value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, TValue>::Set(const TKey& key, TValue&& value)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(key);
+		const usys_t index = this->Find(key, hash);
+		if(index != NEG1)
+			return this->slots[index].value = std::move(value);
+		return this->Emplace(hash, key, std::move(value)).value;
+	}
+
+	template<typename TKey, typename TValue>
+	TValue& THashMap<TKey, TValue>::Set(kv_pair_t&& pair)
+	{
+		const usys_t hash = hasher_t<TKey>::Hash(pair.key);
+		const usys_t index = this->Find(pair.key, hash);
+		if(index != NEG1)
+			return this->slots[index].value = std::move(pair.value);
+		return this->Emplace(hash, std::move(pair.key), std::move(pair.value)).value;
+	}
+
+	template<typename TKey, typename TValue>
+	bool THashMap<TKey, TValue>::Remove(const TKey& key)
+	{
+		const usys_t index = this->Find(key);
 		if(index == NEG1)
 			return false;
+		this->EraseSlot(index);
+		return true;
+	}
 
-		this->items.Remove(index, 1);
+	template<typename TKey, typename TValue>
+	template<typename K> requires transparent_key_c<TKey, K>
+	bool THashMap<TKey, TValue>::Remove(const K& key)
+	{
+		const usys_t index = this->Find(key);
+		if(index == NEG1)
+			return false;
+		this->EraseSlot(index);
 		return true;
 	}
 
 	template<typename TKey, typename TValue>
-	TValue& TSortedMap<TKey, TValue>::GetOrInsertDefault(const TKey& key, const TValue& _default)
+	TValue& THashMap<TKey, TValue>::GetOrInsertDefault(const TKey& key, const TValue& _default)
 	{
-		TValue* value = this->Get(key);
-		if(value == nullptr)
-			value = &this->Add(key, _default);
-		return *value;
+		return const_cast<TValue&>(static_cast<THashMap<TKey, const TValue>*>(this)->GetOrInsertDefault(key, _default));
 	}
 }
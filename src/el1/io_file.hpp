@@ -142,6 +142,10 @@ namespace el1::io::file
 			bool IsSocket() const EL_WARN_UNUSED_RESULT { return Type() == EObjectType::SOCKET; }
 			bool IsMountpoint() const EL_WARN_UNUSED_RESULT;
 
+			// retrieves information about the file-system object this path points to
+			// the type is EObjectType::NX if it does not exist
+			direntry_t QueryInfo(const bool follow_symlinks = true) const EL_WARN_UNUSED_RESULT;
+
 			TFile CreateAsFile(bool recursive) const;
 			void CreateAsDirectory(bool recursive) const;
 			void Resolve();
@@ -275,6 +279,18 @@ namespace el1::io::file
 			// the result is volatile in nature, as other processes could be actively writing to the file
 			iosize_t Size() const EL_WARN_UNUSED_RESULT;
 
+			// reads from the given position without using or moving the IO-offset
+			// any number of readers can share the same file object this way
+			usys_t ReadAt(const iosize_t position, byte_t* const arr_items, const usys_t n_items_max) const EL_WARN_UNUSED_RESULT;
+
+			// writes up to n_items_max bytes starting at position into the sink without using or moving the IO-offset
+			// if the sink has a kernel handle the data is copied by the kernel (sendfile) instead of passing through user-space
+			// returns 0 if the sink is blocked, throws TStreamDryException if the file ends before position
+			iosize_t WriteOutAt(const iosize_t position, ISink<byte_t>& sink, const iosize_t n_items_max) const EL_WARN_UNUSED_RESULT;
+
+			// retrieves size, timestamps and identity of the open file, the name is left empty
+			direntry_t QueryInfo() const EL_WARN_UNUSED_RESULT;
+
 			// compares if the two open files refer to the same underlying file-system object
 			bool operator==(const TFile& rhs) const EL_WARN_UNUSED_RESULT;
 			bool operator!=(const TFile& rhs) const EL_WARN_UNUSED_RESULT { return !(*this == rhs); }
@@ -9,6 +9,7 @@
 #include <dirent.h>
 #include <sys/sysmacros.h>
 #include <sys/vfs.h>    /* or <sys/statfs.h> */
+#include <sys/sendfile.h>
 #include "system_task.hpp"
 
 namespace el1::io::file
@@ -17,6 +18,9 @@ namespace el1::io::file
 
 	static const TPath SYSFS_FD_PATH("/proc/self/fd");
 
+	// the most sendfile() transfers in one call
+	static const iosize_t SENDFILE_MAX = 0x7ffff000U;
+
 	static TPath ReadLink(const TPath& symlink)
 	{
 		TList<char> buffer;
@@ -339,12 +343,12 @@ namespace el1::io::file
 		}
 	}
 
-	direntry_t TDirectory::QueryInfo(const TStringView name) const
+	static direntry_t QueryInfoAt(const handle_t dir, const char* const name, const int flags, TString display_name)
 	{
 		direntry_t e = {
 			.obj_id = (u64_t)-1,
 			.fs_id = (u64_t)-1,
-			.name = name,
+			.name = std::move(display_name),
 			.size = (iosize_t)-1,
 			.usage = (iosize_t)-1,
 			.type = EObjectType::UNKNOWN,
@@ -356,7 +360,7 @@ namespace el1::io::file
 		};
 
 		struct statx st = {};
-		const int r = statx(this->handle, name.MakeCStr().get(), AT_NO_AUTOMOUNT | AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_BASIC_STATS | STATX_BTIME, &st);
+		const int r = statx(dir, name, flags | AT_NO_AUTOMOUNT | AT_STATX_DONT_SYNC, STATX_BASIC_STATS | STATX_BTIME, &st);
 		if(r < 0)
 		{
 			if(errno == ENOENT)
@@ -404,6 +408,16 @@ namespace el1::io::file
 		return e;
 	}
 
+	direntry_t TDirectory::QueryInfo(const TStringView name) const
+	{
+		return QueryInfoAt(this->handle, name.MakeCStr().get(), AT_SYMLINK_NOFOLLOW, name);
+	}
+
+	direntry_t TPath::QueryInfo(const bool follow_symlinks) const
+	{
+		return QueryInfoAt(AT_FDCWD, *this, follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW, FullName());
+	}
+
 	TDirectory::TDirectory(const TPath& path) : handle(THandle(EL_SYSERR(open(path, O_RDONLY|O_CLOEXEC|O_DIRECTORY)), true))
 	{
 	}
@@ -530,6 +544,37 @@ namespace el1::io::file
 		return GetHandlePath(this->handle);
 	}
 
+	direntry_t TFile::QueryInfo() const
+	{
+		return QueryInfoAt(this->handle, "", AT_EMPTY_PATH, TString());
+	}
+
+	iosize_t TFile::WriteOutAt(const iosize_t position, ISink<byte_t>& sink, const iosize_t n_items_max) const
+	{
+		if(n_items_max == 0)
+			return 0;
+
+		const handle_t h_sink = sink.Handle();
+		if(h_sink != INVALID_HANDLE)
+		{
+			off_t offset = (off_t)position;
+			const ssize_t r = sendfile(h_sink, this->handle, &offset, util::Min<iosize_t>(n_items_max, SENDFILE_MAX));
+			if(r > 0)
+				return r;
+			if(r == 0)
+				EL_THROW(TStreamDryException);
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			EL_ERROR(errno != EINVAL && errno != ENOSYS, TSyscallException, errno);
+			// the sink does not support sendfile(), the data is copied below
+		}
+
+		byte_t buffer[16U * 1024U];
+		const usys_t n_read = ReadAt(position, buffer, util::Min<iosize_t>(n_items_max, sizeof(buffer)));
+		EL_ERROR(n_read == 0, TStreamDryException);
+		return sink.Write(buffer, n_read);
+	}
+
 	TFile::~TFile()
 	{
 		// nothing to do
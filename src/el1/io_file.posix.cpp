@@ -6,6 +6,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include "io_file.hpp"
+#include "system_task.hpp"
 #include <sys/mman.h>
 
 namespace el1::io::file
@@ -209,15 +210,39 @@ namespace el1::io::file
 
 	/************************************************************************/
 
+	// regular files are always "ready", so the readiness model blocks the whole thread on disk I/O
+	// the io_uring backend lets the other fibers run until the kernel completed the transfer
+	static bool UseIoRing()
+	{
+		const system::task::TThread* const thread = system::task::TThread::Self();
+		return thread != nullptr && thread->IoBackend() == system::task::EIoBackend::IO_URING;
+	}
+
 	usys_t TFile::Read(byte_t* const arr_items, const usys_t n_items_max)
 	{
+		if(UseIoRing())
+			return system::task::TFiber::RingRead(this->handle, arr_items, n_items_max, -1, false);
+
 		const ssize_t n = EL_SYSERR(read(this->handle, arr_items, n_items_max));
 		EL_ERROR(n < 0, TLogicException);
 		return n;
 	}
 
+	usys_t TFile::ReadAt(const iosize_t position, byte_t* const arr_items, const usys_t n_items_max) const
+	{
+		if(UseIoRing())
+			return system::task::TFiber::RingRead(this->handle, arr_items, n_items_max, (s64_t)position, false);
+
+		const ssize_t n = EL_SYSERR(pread(this->handle, arr_items, n_items_max, (off_t)position));
+		EL_ERROR(n < 0, TLogicException);
+		return n;
+	}
+
 	usys_t TFile::Write(const byte_t* const arr_items, const usys_t n_items_max)
 	{
+		if(UseIoRing())
+			return system::task::TFiber::RingWrite(this->handle, arr_items, n_items_max, -1, false);
+
 		const ssize_t n = EL_SYSERR(write(this->handle, arr_items, n_items_max));
 		EL_ERROR(n < 0, TLogicException);
 		return n;
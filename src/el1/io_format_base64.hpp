@@ -13,9 +13,38 @@ namespace el1::io::format::base64
 	TString EncodeBase64Url(collection::list::array_t<const byte_t> data);
 	collection::list::TList<byte_t> DecodeBase64Url(TStringView text);
 
+	// values of the base64 symbols for TBase64Decoder::NextBatch(), 0xff marks characters which are not part of the alphabet
+	struct base64_decode_table_t
+	{
+		byte_t values[128];
+
+		constexpr base64_decode_table_t() : values()
+		{
+			for(unsigned i = 0; i < 128; i++)
+				values[i] = 0xff;
+
+			for(unsigned i = 0; i < 26; i++)
+			{
+				values['A' + i] = i;
+				values['a' + i] = 26 + i;
+			}
+
+			for(unsigned i = 0; i < 10; i++)
+				values['0' + i] = 52 + i;
+
+			values['+'] = 62;
+			values['/'] = 63;
+			values['='] = 64;
+		}
+	};
+
+	inline constexpr base64_decode_table_t BASE64_DECODE_TABLE;
+
 	class TBase64Decoder
 	{
 		protected:
+			static const usys_t N_CHARS_BATCH = 256;
+
 			byte_t buffer[3];
 			byte_t n_remaining : 4;
 			byte_t index : 4;
@@ -24,33 +53,39 @@ namespace el1::io::format::base64
 			using TIn = char32_t;
 			using TOut = byte_t;
 
-			template<typename TSourceStream>
-			static byte_t ReadNextChar(TSourceStream* const source)
+			// translates a base64 symbol into its value, '=' becomes 64
+			static byte_t DecodeChar(const char32_t chr)
 			{
-				const char32_t* const chr = source->NextItem();
-
-				if(chr == nullptr)
-					return 65;
-
-				if(*chr >= 'A' && *chr <= 'Z')
-					return *chr - 'A' +  0;
+				if(chr >= 'A' && chr <= 'Z')
+					return chr - 'A' +  0;
 
-				if(*chr >= 'a' && *chr <= 'z')
-					return *chr - 'a' + 26;
+				if(chr >= 'a' && chr <= 'z')
+					return chr - 'a' + 26;
 
-				if(*chr >= '0' && *chr <= '9')
-					return *chr - '0' + 52;
+				if(chr >= '0' && chr <= '9')
+					return chr - '0' + 52;
 
-				if(*chr == '+')
+				if(chr == '+')
 					return 62;
 
-				if(*chr == '/')
+				if(chr == '/')
 					return 63;
 
-				if(*chr == '=')
+				if(chr == '=')
 					return 64;
 
-				EL_THROW(TException, TString::Format(U"invalid base64 input %q", *chr));
+				EL_THROW(TException, TString::Format(U"invalid base64 input %q", chr));
+			}
+
+			template<typename TSourceStream>
+			static byte_t ReadNextChar(TSourceStream* const source)
+			{
+				const char32_t* const chr = source->NextItem();
+
+				if(chr == nullptr)
+					return 65;
+
+				return DecodeChar(*chr);
 			}
 
 			// arr_input must contain 4 bytes with values between 0-65, the value 64 is used to indicate padding, 65 indicates EOF
@@ -108,6 +143,65 @@ namespace el1::io::format::base64
 				return buffer + index;
 			}
 
+			// decodes whole blocks of four symbols straight into arr_buffer
+			// a block which is cut off at the end of the input batch is completed from NextItem() of the source
+			// like NextItem() the batch ends at a block which starts with padding
+			template<typename TSourceStream>
+			usys_t NextBatch(TSourceStream* const source, byte_t* const arr_buffer, const usys_t n_items_max, byte_t*& batch)
+			{
+				batch = arr_buffer;
+				usys_t n_out = 0;
+
+				// bytes left over from a block decoded by NextItem()
+				for(; n_remaining > 0 && n_out < n_items_max; n_out++)
+				{
+					index++;
+					n_remaining--;
+					arr_buffer[n_out] = buffer[index];
+				}
+
+				const usys_t n_blocks = util::Min((n_items_max - n_out) / 3, N_CHARS_BATCH / 4);
+				if(n_blocks == 0)
+				{
+					for(; n_out < n_items_max; n_out++)
+					{
+						const byte_t* const b = NextItem(source);
+						if(b == nullptr)
+							break;
+						arr_buffer[n_out] = *b;
+					}
+					return n_out;
+				}
+
+				using TIn = typename TSourceStream::TOut;
+				char32_t in_buffer[N_CHARS_BATCH];
+				TIn* in;
+				const usys_t n_in = source->NextBatch(in_buffer, n_blocks * 4, in);
+
+				for(usys_t i = 0; i < n_in; i += 4)
+				{
+					byte_t v[4];
+					const usys_t n_have = util::Min<usys_t>(4, n_in - i);
+					for(usys_t k = 0; k < n_have; k++)
+					{
+						const char32_t chr = in[i + k];
+						v[k] = chr < 128 ? BASE64_DECODE_TABLE.values[chr] : 0xff;
+						if(EL_UNLIKELY(v[k] == 0xff))
+							v[k] = DecodeChar(chr);
+					}
+
+					for(usys_t k = n_have; k < 4; k++)
+						v[k] = ReadNextChar(source);
+
+					const u8_t r = DecodeBlock(v, arr_buffer + n_out);
+					n_out += r;
+					if(r == 0)
+						break;
+				}
+
+				return n_out;
+			}
+
 			TBase64Decoder() : n_remaining(0), index(3) {}
 	};
 
@@ -117,6 +211,8 @@ namespace el1::io::format::base64
 	class TBase64Encoder
 	{
 		protected:
+			static const usys_t N_BYTES_BATCH = 768;
+
 			byte_t index : 4;
 			byte_t n_remaining : 4;
 			byte_t buffer[3];
@@ -127,9 +223,9 @@ namespace el1::io::format::base64
 			using TOut = char32_t;
 
 			template<typename TSourceStream>
-			static unsigned Read(TSourceStream* const source, byte_t* buffer)
+			static unsigned Read(TSourceStream* const source, byte_t* buffer, const unsigned n_bytes = 3)
 			{
-				for(unsigned i = 0; i < 3; i++)
+				for(unsigned i = 0; i < n_bytes; i++)
 				{
 					const byte_t* b = source->NextItem();
 					if(b == nullptr)
@@ -138,7 +234,7 @@ namespace el1::io::format::base64
 					buffer[i] = *b;
 				}
 
-				return 3;
+				return n_bytes;
 			}
 
 			// buffer must always at least 4 bytes large - 3 input bytes will be translated into 4 output bytes
@@ -199,6 +295,60 @@ namespace el1::io::format::base64
 				return &chr;
 			}
 
+			// encodes whole blocks of three bytes straight into arr_buffer
+			// a block which is cut off at the end of the input batch is completed from NextItem() of the source
+			template<typename TSourceStream>
+			usys_t NextBatch(TSourceStream* const source, char32_t* const arr_buffer, const usys_t n_items_max, char32_t*& batch)
+			{
+				batch = arr_buffer;
+				usys_t n_out = 0;
+
+				const char32_t* const symbols = BASE64_SYMBOLS.Data();
+
+				// symbols left over from a block encoded by NextItem()
+				for(; n_remaining > 0 && n_out < n_items_max; n_out++)
+				{
+					arr_buffer[n_out] = symbols[this->buffer[index]];
+					index++;
+					n_remaining--;
+				}
+
+				const usys_t n_blocks = util::Min((n_items_max - n_out) / 4, N_BYTES_BATCH / 3);
+				if(n_blocks == 0)
+				{
+					for(; n_out < n_items_max; n_out++)
+					{
+						const char32_t* const c = NextItem(source);
+						if(c == nullptr)
+							break;
+						arr_buffer[n_out] = *c;
+					}
+					return n_out;
+				}
+
+				using TIn = typename TSourceStream::TOut;
+				byte_t in_buffer[N_BYTES_BATCH];
+				TIn* in;
+				const usys_t n_in = source->NextBatch(in_buffer, n_blocks * 3, in);
+
+				for(usys_t i = 0; i < n_in; i += 3)
+				{
+					byte_t local_buffer[4] = {};
+					const usys_t n_have = util::Min<usys_t>(3, n_in - i);
+					for(usys_t k = 0; k < n_have; k++)
+						local_buffer[k] = in[i + k];
+
+					const unsigned r = n_have == 3 ? 3 : n_have + Read(source, local_buffer + n_have, 3 - n_have);
+
+					EncodeBlock(local_buffer, r);
+					for(unsigned k = 0; k < 4; k++)
+						arr_buffer[n_out + k] = symbols[local_buffer[k]];
+					n_out += 4;
+				}
+
+				return n_out;
+			}
+
 			TBase64Encoder() : index(0), n_remaining(0) {}
 	};
 }
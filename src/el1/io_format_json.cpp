@@ -1,5 +1,17 @@
 #include "io_format_json.hpp"
 #include "io_file.hpp"
+#include "io_text_encoding_utf8.hpp"
+#include <charconv>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(EL_CC_GCC) || defined(EL_CC_CLANG))
+	#include <immintrin.h>
+	#define EL_JSON_X86_KERNELS
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define EL_JSON_NEON_KERNELS
+#endif
 
 namespace el1::io::format::json
 {
@@ -155,8 +167,8 @@ namespace el1::io::format::json
 					if(a1.Count() != a2.Count())
 						return false;
 
-					for(usys_t i = 0; i < a1.Count(); i++)
-						if(a1[i].key != a2[i].key || a1[i].value != a2[i].value)
+					for(auto it1 = a1.begin(), it2 = a2.begin(); it1 != a1.end(); ++it1, ++it2)
+						if(it1->key != it2->key || it1->value != it2->value)
 							return false;
 
 					return true;
@@ -458,7 +470,7 @@ namespace el1::io::format::json
 	TString TJsonValue::ToString() const
 	{
 		TString str;
-		TListSink<char32_t> sink(&str.chars);
+		TStringSink sink(&str);
 		this->ToStream(sink);
 		return str;
 	}
@@ -654,6 +666,855 @@ namespace el1::io::format::json
 		return ConvertNumber(token);
 	}
 
+	/**************************************************************************/
+	// UTF-8 parser in the style of simdjson
+	// stage 1 classifies 64 input bytes at a time into bit masks and reduces them to the
+	// structural index: the offsets of { } [ ] : , of every quote which starts or ends a
+	// string and of the first byte of every number or literal, all outside of strings
+	// stage 2 walks the index with an explicit stack and records the document on a tape,
+	// the tape knows the size of every array and map, so the TJsonValue is built without regrowing lists
+	namespace
+	{
+		using namespace text::encoding::utf8;
+
+		struct block_masks_t
+		{
+			u64_t quote;
+			u64_t backslash;
+			u64_t op;		// { } [ ] : ,
+			u64_t space;	// ' ' \t \n \r
+			u64_t control;	// < 0x20
+		};
+
+		static inline u64_t PrefixXor(u64_t bits)
+		{
+			bits ^= bits << 1;
+			bits ^= bits << 2;
+			bits ^= bits << 4;
+			bits ^= bits << 8;
+			bits ^= bits << 16;
+			bits ^= bits << 32;
+			return bits;
+		}
+
+		// carries the string and escape state from one block to the next
+		struct scanner_t
+		{
+			u64_t prev_escaped = 0;		// 1 => the first byte of the next block is escaped
+			u64_t prev_in_string = 0;	// all ones while a string continues into the next block
+			u64_t prev_scalar = 0;		// 1 => the last byte of the previous block belonged to a number or literal
+			usys_t offset = 0;			// of the next block
+			usys_t pos_control = NEG1;	// first control character inside a string
+
+			// the bytes which follow an odd number of backslashes
+			u64_t Escaped(u64_t backslash)
+			{
+				static constexpr u64_t ODD_BITS = 0xAAAAAAAAAAAAAAAAULL;
+				backslash &= ~prev_escaped;
+				const u64_t run_starts = backslash & ~(backslash << 1 | prev_escaped);
+
+				// adding the start of a run to the run carries into the first byte after it,
+				// the parity of the start and of that byte tells the length of the run
+				const u64_t even_carries = (backslash + (run_starts & ~ODD_BITS)) & ~backslash;
+				u64_t odd_carries;
+				const bool odd_overflow = __builtin_add_overflow(backslash, run_starts & ODD_BITS, &odd_carries);
+				odd_carries &= ~backslash;
+
+				const u64_t escaped = (even_carries & ODD_BITS) | (odd_carries & ~ODD_BITS) | prev_escaped;
+				prev_escaped = odd_overflow ? 1 : 0;
+				return escaped;
+			}
+
+			u64_t Structurals(const block_masks_t& masks)
+			{
+				const u64_t quote = masks.quote & ~Escaped(masks.backslash);
+				const u64_t in_string = PrefixXor(quote) ^ prev_in_string;
+				prev_in_string = (u64_t)((s64_t)in_string >> 63);
+
+				const u64_t control = masks.control & in_string;
+				if(EL_UNLIKELY(control != 0) && pos_control == NEG1)
+					pos_control = offset + (usys_t)__builtin_ctzll(control);
+
+				const u64_t scalar = ~(masks.op | masks.space | masks.quote | in_string);
+				const u64_t scalar_starts = scalar & ~(scalar << 1 | prev_scalar);
+				prev_scalar = scalar >> 63;
+
+				return (masks.op & ~in_string) | quote | scalar_starts;
+			}
+
+			usys_t Flatten(const block_masks_t& masks, u32_t* const arr_index, usys_t n_index, const u32_t block_offset)
+			{
+				u64_t bits = Structurals(masks);
+				offset += 64;
+				while(bits != 0)
+				{
+					arr_index[n_index++] = block_offset + (u32_t)__builtin_ctzll(bits);
+					bits &= bits - 1;
+				}
+				return n_index;
+			}
+		};
+
+		// the kernels process n_blocks blocks of 64 bytes and append the offsets of the structurals, relative to arr_bytes
+
+	#if !defined(EL_JSON_X86_KERNELS) && !defined(EL_JSON_NEON_KERNELS)
+		static usys_t IndexBlocksScalar(scanner_t& scanner, const byte_t* const arr_bytes, const usys_t n_blocks, u32_t* const arr_index)
+		{
+			usys_t n_index = 0;
+			for(usys_t b = 0; b < n_blocks; b++)
+			{
+				block_masks_t masks = {};
+				const byte_t* const block = arr_bytes + b * 64;
+				for(unsigned i = 0; i < 64; i++)
+				{
+					const byte_t chr = block[i];
+					const u64_t bit = (u64_t)1 << i;
+					switch(chr)
+					{
+						case '"':  masks.quote |= bit; break;
+						case '\\': masks.backslash |= bit; break;
+						case '{': case '}': case '[': case ']': case ':': case ',': masks.op |= bit; break;
+						case ' ': case '\t': case '\n': case '\r': masks.space |= bit; break;
+					}
+					if(chr < 0x20)
+						masks.control |= bit;
+				}
+				n_index = scanner.Flatten(masks, arr_index, n_index, (u32_t)(b * 64));
+			}
+			return n_index;
+		}
+	#endif
+
+	#if defined(EL_JSON_X86_KERNELS)
+		// SSE2 is part of x86-64, this kernel needs no runtime check
+		static usys_t IndexBlocksSSE2(scanner_t& scanner, const byte_t* const arr_bytes, const usys_t n_blocks, u32_t* const arr_index)
+		{
+			usys_t n_index = 0;
+			for(usys_t b = 0; b < n_blocks; b++)
+			{
+				block_masks_t masks = {};
+				for(unsigned k = 0; k < 4; k++)
+				{
+					const __m128i v = _mm_loadu_si128((const __m128i*)(arr_bytes + b * 64 + k * 16));
+					// '[' and ']' only differ from '{' and '}' in bit 5
+					const __m128i v_lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+					const __m128i op = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v_lower, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v_lower, _mm_set1_epi8('}'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+					const __m128i space = _mm_or_si128(
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+						_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+					const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f));
+
+					const unsigned shift = k * 16;
+					masks.quote |= (u64_t)(u32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << shift;
+					masks.backslash |= (u64_t)(u32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << shift;
+					masks.op |= (u64_t)(u32_t)_mm_movemask_epi8(op) << shift;
+					masks.space |= (u64_t)(u32_t)_mm_movemask_epi8(space) << shift;
+					masks.control |= (u64_t)(u32_t)_mm_movemask_epi8(control) << shift;
+				}
+				n_index = scanner.Flatten(masks, arr_index, n_index, (u32_t)(b * 64));
+			}
+			return n_index;
+		}
+
+		__attribute__((target("avx2")))
+		static usys_t IndexBlocksAVX2(scanner_t& scanner, const byte_t* const arr_bytes, const usys_t n_blocks, u32_t* const arr_index)
+		{
+			usys_t n_index = 0;
+			for(usys_t b = 0; b < n_blocks; b++)
+			{
+				block_masks_t masks = {};
+				for(unsigned k = 0; k < 2; k++)
+				{
+					const __m256i v = _mm256_loadu_si256((const __m256i*)(arr_bytes + b * 64 + k * 32));
+					const __m256i v_lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+					const __m256i op = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v_lower, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v_lower, _mm256_set1_epi8('}'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+					const __m256i space = _mm256_or_si256(
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+						_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+					const __m256i control = _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1f)), _mm256_set1_epi8(0x1f));
+
+					const unsigned shift = k * 32;
+					masks.quote |= (u64_t)(u32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << shift;
+					masks.backslash |= (u64_t)(u32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << shift;
+					masks.op |= (u64_t)(u32_t)_mm256_movemask_epi8(op) << shift;
+					masks.space |= (u64_t)(u32_t)_mm256_movemask_epi8(space) << shift;
+					masks.control |= (u64_t)(u32_t)_mm256_movemask_epi8(control) << shift;
+				}
+				n_index = scanner.Flatten(masks, arr_index, n_index, (u32_t)(b * 64));
+			}
+			return n_index;
+		}
+	#elif defined(EL_JSON_NEON_KERNELS)
+		// NEON has no movemask, each lane keeps its own bit and pairwise additions fold 64 lanes into 64 bits
+		static inline u64_t MaskNEON(const uint8x16_t a, const uint8x16_t b, const uint8x16_t c, const uint8x16_t d)
+		{
+			const uint8x16_t bits = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+			uint8x16_t sum_ab = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+			const uint8x16_t sum_cd = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+			sum_ab = vpaddq_u8(sum_ab, sum_cd);
+			sum_ab = vpaddq_u8(sum_ab, sum_ab);
+			return vgetq_lane_u64(vreinterpretq_u64_u8(sum_ab), 0);
+		}
+
+		static usys_t IndexBlocksNEON(scanner_t& scanner, const byte_t* const arr_bytes, const usys_t n_blocks, u32_t* const arr_index)
+		{
+			usys_t n_index = 0;
+			for(usys_t b = 0; b < n_blocks; b++)
+			{
+				uint8x16_t quote[4], backslash[4], op[4], space[4], control[4];
+				for(unsigned k = 0; k < 4; k++)
+				{
+					const uint8x16_t v = vld1q_u8(arr_bytes + b * 64 + k * 16);
+					const uint8x16_t v_lower = vorrq_u8(v, vdupq_n_u8(0x20));
+					quote[k] = vceqq_u8(v, vdupq_n_u8('"'));
+					backslash[k] = vceqq_u8(v, vdupq_n_u8('\\'));
+					op[k] = vorrq_u8(
+						vorrq_u8(vceqq_u8(v_lower, vdupq_n_u8('{')), vceqq_u8(v_lower, vdupq_n_u8('}'))),
+						vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+					space[k] = vorrq_u8(
+						vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+						vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+					control[k] = vcltq_u8(v, vdupq_n_u8(0x20));
+				}
+
+				const block_masks_t masks = {
+					MaskNEON(quote[0], quote[1], quote[2], quote[3]),
+					MaskNEON(backslash[0], backslash[1], backslash[2], backslash[3]),
+					MaskNEON(op[0], op[1], op[2], op[3]),
+					MaskNEON(space[0], space[1], space[2], space[3]),
+					MaskNEON(control[0], control[1], control[2], control[3])
+				};
+				n_index = scanner.Flatten(masks, arr_index, n_index, (u32_t)(b * 64));
+			}
+			return n_index;
+		}
+	#endif
+
+		using index_kernel_t = usys_t (*)(scanner_t& scanner, const byte_t* const arr_bytes, const usys_t n_blocks, u32_t* const arr_index);
+
+		static index_kernel_t SelectIndexKernel()
+		{
+		#if defined(EL_JSON_X86_KERNELS)
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx2"))
+				return &IndexBlocksAVX2;
+			return &IndexBlocksSSE2;
+		#elif defined(EL_JSON_NEON_KERNELS)
+			return &IndexBlocksNEON;
+		#else
+			return &IndexBlocksScalar;
+		#endif
+		}
+
+		static index_kernel_t IndexKernel()
+		{
+			static const index_kernel_t kernel = SelectIndexKernel();
+			return kernel;
+		}
+
+		// stage 1 runs a chunk ahead of stage 2, so the index stays in the cache and its size is bounded
+		class TStructuralIndex
+		{
+			protected:
+				static constexpr usys_t SZ_CHUNK = 256 * 64;
+
+				const byte_t* const arr_bytes;
+				const usys_t n_bytes;
+				const index_kernel_t kernel;
+				TList<u32_t> index;
+				usys_t i_index;
+				usys_t n_index;
+				usys_t chunk_base;
+				usys_t chunk_end;
+
+				void Refill()
+				{
+					chunk_base = chunk_end;
+					const usys_t n_chunk = util::Min(SZ_CHUNK, n_bytes - chunk_base);
+					const usys_t n_blocks = n_chunk / 64;
+					u32_t* const arr_index = &index[0];
+					n_index = kernel(scanner, arr_bytes + chunk_base, n_blocks, arr_index);
+
+					// only the last chunk ends with a partial block, it is padded with whitespace
+					const usys_t n_tail = n_chunk % 64;
+					if(n_tail != 0)
+					{
+						byte_t block[64];
+						memset(block, ' ', sizeof(block));
+						memcpy(block, arr_bytes + chunk_base + n_blocks * 64, n_tail);
+						const usys_t n_tail_index = kernel(scanner, block, 1, arr_index + n_index);
+						for(usys_t i = n_index; i < n_index + n_tail_index; i++)
+							arr_index[i] += (u32_t)(n_blocks * 64);
+						n_index += n_tail_index;
+					}
+
+					chunk_end = chunk_base + n_chunk;
+					i_index = 0;
+				}
+
+			public:
+				static constexpr usys_t END = NEG1;
+
+				scanner_t scanner;
+
+				// offset of the next structural character, END after the last one
+				usys_t Next()
+				{
+					while(i_index == n_index)
+					{
+						if(chunk_end >= n_bytes)
+							return END;
+						Refill();
+					}
+					return chunk_base + index[i_index++];
+				}
+
+				TStructuralIndex(const array_t<const byte_t> input) : arr_bytes(input.Data()), n_bytes(input.Count()), kernel(IndexKernel()), i_index(0), n_index(0), chunk_base(0), chunk_end(0)
+				{
+					index.SetCount(util::Min(SZ_CHUNK, (n_bytes + 63) / 64 * 64));
+				}
+		};
+
+		enum class ETapeTag : u8_t
+		{
+			NULLVALUE,
+			TRUE,
+			FALSE,
+			STRING,		// index into tape_t::strings
+			SIGNED_INTEGER,
+			UNSIGNED_INTEGER,
+			FLOATING,
+			ARRAY,		// count of items
+			MAP,		// count of members, every member is a STRING key followed by its value
+			END			// of the innermost ARRAY or MAP
+		};
+
+		struct tape_entry_t
+		{
+			ETapeTag tag;
+			union
+			{
+				usys_t count;
+				usys_t i_string;
+				s64_t signed_integer;
+				u64_t unsigned_integer;
+				double floating;
+			};
+		};
+
+		struct tape_t
+		{
+			TList<tape_entry_t> entries;
+			TList<TString> strings;
+		};
+
+		// decodes literals, numbers and strings from UTF-8, shared by TTapeBuilder and TJsonReader
+		class TUtf8Scanner
+		{
+			public:
+				const byte_t* const arr_bytes;
+				const usys_t n_bytes;
+				const bool tolerant;
+				// characters and lines before arr_bytes[0], for error positions
+				const iosize_t n_chars_before;
+				const iosize_t n_lines_before;
+
+				[[noreturn]] void Fail(const usys_t pos) const
+				{
+					// positions are reported in characters, like the grammar does
+					iosize_t n_chars = n_chars_before;
+					iosize_t n_lines = 1 + n_lines_before;
+					const usys_t end = util::Min(pos, n_bytes);
+					for(usys_t i = 0; i < end; i++)
+					{
+						n_chars += (arr_bytes[i] & 0xc0) != 0x80 ? 1 : 0;
+						n_lines += arr_bytes[i] == '\n' ? 1 : 0;
+					}
+
+					char32_t chr = U'\0';
+					if(pos < n_bytes)
+					{
+						chr = arr_bytes[pos];
+						if(chr >= 0x80)
+						{
+							usys_t n_decoded = 0;
+							try { DecodeUTF8(arr_bytes + pos, util::Min<usys_t>(4, n_bytes - pos), &chr, n_decoded); }
+							catch(const IException&) {}
+							if(n_decoded == 0)
+								chr = U'\uFFFD';
+						}
+					}
+
+					EL_THROW(TInvalidJsonException, n_chars, n_lines, chr);
+				}
+
+				bool IsDelimiter(const usys_t pos) const
+				{
+					if(pos >= n_bytes)
+						return true;
+					switch(arr_bytes[pos])
+					{
+						case ' ': case '\t': case '\n': case '\r':
+						case ',': case ':': case '[': case ']': case '{': case '}':
+							return true;
+					}
+					return false;
+				}
+
+				void Literal(const usys_t pos, const char* const literal, const usys_t len) const
+				{
+					if(pos + len > n_bytes || memcmp(arr_bytes + pos, literal, len) != 0)
+						Fail(pos);
+					if(!IsDelimiter(pos + len))
+						Fail(pos + len);
+				}
+
+				// returns the position after the number
+				usys_t Number(const usys_t pos, tape_entry_t& entry) const
+				{
+					// RFC 8259: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+					usys_t p = pos;
+					const bool negative = arr_bytes[p] == '-';
+					if(negative)
+						p++;
+
+					u64_t magnitude = 0;
+					bool overflow = false;
+					if(p < n_bytes && arr_bytes[p] == '0')
+						p++;
+					else if(p < n_bytes && arr_bytes[p] >= '1' && arr_bytes[p] <= '9')
+						for(; p < n_bytes && arr_bytes[p] >= '0' && arr_bytes[p] <= '9'; p++)
+							overflow |= __builtin_mul_overflow(magnitude, 10U, &magnitude) || __builtin_add_overflow(magnitude, (u64_t)(arr_bytes[p] - '0'), &magnitude);
+					else
+						Fail(p);
+
+					bool integer = true;
+					if(p < n_bytes && arr_bytes[p] == '.')
+					{
+						integer = false;
+						p++;
+						if(p >= n_bytes || arr_bytes[p] < '0' || arr_bytes[p] > '9')
+							Fail(p);
+						while(p < n_bytes && arr_bytes[p] >= '0' && arr_bytes[p] <= '9')
+							p++;
+					}
+
+					if(p < n_bytes && (arr_bytes[p] == 'e' || arr_bytes[p] == 'E'))
+					{
+						integer = false;
+						p++;
+						if(p < n_bytes && (arr_bytes[p] == '+' || arr_bytes[p] == '-'))
+							p++;
+						if(p >= n_bytes || arr_bytes[p] < '0' || arr_bytes[p] > '9')
+							Fail(p);
+						while(p < n_bytes && arr_bytes[p] >= '0' && arr_bytes[p] <= '9')
+							p++;
+					}
+
+					if(!IsDelimiter(p))
+						Fail(p);
+
+					// same representations as TJsonParser::ConvertNumeric()
+					if(integer && !overflow && !negative)
+					{
+						entry.tag = ETapeTag::UNSIGNED_INTEGER;
+						entry.unsigned_integer = magnitude;
+					}
+					else if(integer && !overflow && magnitude <= (u64_t)1 << 63)
+					{
+						entry.tag = ETapeTag::SIGNED_INTEGER;
+						entry.signed_integer = (s64_t)(0 - magnitude);
+					}
+					else
+					{
+						entry.tag = ETapeTag::FLOATING;
+						const char* const first = (const char*)arr_bytes + pos;
+						const char* const last = (const char*)arr_bytes + p;
+						const std::from_chars_result result = std::from_chars(first, last, entry.floating);
+						if(result.ec == std::errc::result_out_of_range)
+						{
+							// the grammar rejects numbers beyond the range of double and rounds tiny ones to zero
+							if(std::isinf(strtod(TString(first, p - pos).MakeCStr().get(), nullptr)))
+								Fail(pos);
+							entry.floating = negative ? -0.0 : 0.0;
+						}
+						else if(result.ec != std::errc() || result.ptr != last)
+							Fail(pos);
+						else if(entry.floating == 0)
+							entry.floating = 0;
+					}
+					return p;
+				}
+
+				bool HexCodeUnit(const byte_t* const arr_src, const usys_t n_src, const usys_t i, u16_t& value) const
+				{
+					if(i + 4 > n_src)
+						return false;
+					value = 0;
+					for(usys_t k = i; k < i + 4; k++)
+					{
+						const byte_t chr = arr_src[k];
+						unsigned digit;
+						if(chr >= '0' && chr <= '9')
+							digit = chr - '0';
+						else if((chr | 0x20) >= 'a' && (chr | 0x20) <= 'f')
+							digit = (chr | 0x20) - 'a' + 10;
+						else
+							return false;
+						value = (u16_t)(value << 4 | digit);
+					}
+					return true;
+				}
+
+				// decodes the string between the quotes at open and close into arr_chars and returns the number of characters
+				// no escape sequence produces more characters than it has bytes, so arr_chars needs room for close - open - 1 characters
+				usys_t DecodeString(const usys_t open, const usys_t close, char32_t* const arr_chars) const
+				{
+					const byte_t* const arr_src = arr_bytes + open + 1;
+					const usys_t n_src = close - open - 1;
+					usys_t n_chars = 0;
+
+					for(usys_t i = 0; ; )
+					{
+						const byte_t* const backslash = (const byte_t*)memchr(arr_src + i, '\\', n_src - i);
+						const usys_t run_end = backslash != nullptr ? (usys_t)(backslash - arr_src) : n_src;
+						if(run_end > i)
+						{
+							usys_t n_run;
+							const usys_t n_used = DecodeUTF8(arr_src + i, run_end - i, arr_chars + n_chars, n_run, open + 1 + i);
+							if(n_used < run_end - i)
+								Fail(open + 1 + i + n_used);
+							n_chars += n_run;
+						}
+
+						if(backslash == nullptr)
+							break;
+
+						// a backslash right before the closing quote would have escaped it
+						i = run_end + 1;
+						switch(arr_src[i])
+						{
+							case '"':  arr_chars[n_chars++] = U'"';  i++; break;
+							case '\\': arr_chars[n_chars++] = U'\\'; i++; break;
+							case '/':  arr_chars[n_chars++] = U'/';  i++; break;
+							case 'b':  arr_chars[n_chars++] = U'\b'; i++; break;
+							case 'f':  arr_chars[n_chars++] = U'\f'; i++; break;
+							case 'n':  arr_chars[n_chars++] = U'\n'; i++; break;
+							case 'r':  arr_chars[n_chars++] = U'\r'; i++; break;
+							case 't':  arr_chars[n_chars++] = U'\t'; i++; break;
+
+							case 'u':
+							{
+								u16_t unit;
+								if(!HexCodeUnit(arr_src, n_src, i + 1, unit))
+									Fail(open + 1 + i + 1);
+
+								if(unit >= 0xd800 && unit <= 0xdbff)
+								{
+									u16_t low;
+									if(i + 6 >= n_src || arr_src[i + 5] != '\\' || arr_src[i + 6] != 'u' || !HexCodeUnit(arr_src, n_src, i + 7, low) || low < 0xdc00 || low > 0xdfff)
+										Fail(open + 1 + i + 5);
+									arr_chars[n_chars++] = (char32_t)(0x10000u + (((u32_t)unit - 0xd800u) << 10) + ((u32_t)low - 0xdc00u));
+									i += 11;
+								}
+								else if(unit >= 0xdc00 && unit <= 0xdfff)
+								{
+									Fail(open + 1 + i);
+								}
+								else
+								{
+									arr_chars[n_chars++] = (char32_t)unit;
+									i += 5;
+								}
+								break;
+							}
+
+							default:
+							{
+								if(!tolerant)
+									Fail(open + 1 + run_end);
+
+								// the tolerant grammar takes any other escaped character literally, DecodeUTF8() reports a byte which cannot start a sequence
+								const usys_t n_sequence = util::Min<usys_t>(util::Max<usys_t>(GetDecodedSequenceLength(arr_src[i]), 1), n_src - i);
+								usys_t n_decoded;
+								if(DecodeUTF8(arr_src + i, n_sequence, arr_chars + n_chars, n_decoded, open + 1 + i) < n_sequence || n_decoded != 1)
+									Fail(open + 1 + i);
+								n_chars++;
+								i += n_sequence;
+								break;
+							}
+						}
+					}
+
+					return n_chars;
+				}
+
+				TUtf8Scanner(const byte_t* const arr_bytes, const usys_t n_bytes, const bool tolerant, const iosize_t n_chars_before = 0, const iosize_t n_lines_before = 0) : arr_bytes(arr_bytes), n_bytes(n_bytes), tolerant(tolerant), n_chars_before(n_chars_before), n_lines_before(n_lines_before) {}
+		};
+
+		class TTapeBuilder : protected TUtf8Scanner
+		{
+			protected:
+				struct container_t
+				{
+					usys_t i_entry;
+					usys_t n_items;
+					bool is_map;
+				};
+
+				TStructuralIndex index;
+				TList<container_t> stack;
+				TList<char32_t> scratch;
+				tape_t& tape;
+
+				void Literal(const usys_t pos, const char* const literal, const usys_t len, const ETapeTag tag)
+				{
+					TUtf8Scanner::Literal(pos, literal, len);
+					tape.entries.Append({ tag, {} });
+				}
+
+				void Number(const usys_t pos)
+				{
+					tape_entry_t entry;
+					TUtf8Scanner::Number(pos, entry);
+					tape.entries.Append(entry);
+				}
+
+				// decodes the string between the quotes at open and close and appends it to the tape
+				void String(const usys_t open, const usys_t close)
+				{
+					if(close == TStructuralIndex::END)
+						Fail(n_bytes);
+					if(!tolerant && index.scanner.pos_control > open && index.scanner.pos_control < close)
+						Fail(index.scanner.pos_control);
+
+					// the scratch buffer only grows, short strings end up in the inline buffer of the TString, longer ones get an exact allocation
+					if(scratch.Count() < close - open - 1)
+						scratch.SetCount(close - open - 1);
+					const usys_t n_chars = DecodeString(open, close, scratch.Data());
+					tape.strings.MoveAppend(TString(scratch.Slice(0, n_chars)));
+					tape.entries.Append({ ETapeTag::STRING, { .i_string = tape.strings.Count() - 1 } });
+				}
+
+				// parses a map key and the following colon, returns the position of the value
+				usys_t Key(const usys_t pos)
+				{
+					if(pos == TStructuralIndex::END)
+						Fail(n_bytes);
+					if(arr_bytes[pos] != '"')
+						Fail(pos);
+					String(pos, index.Next());
+
+					const usys_t colon = index.Next();
+					if(colon == TStructuralIndex::END)
+						Fail(n_bytes);
+					if(arr_bytes[colon] != ':')
+						Fail(colon);
+					return index.Next();
+				}
+
+				void Open(const bool is_map)
+				{
+					stack.Append({ tape.entries.Count(), 0, is_map });
+					tape.entries.Append({ is_map ? ETapeTag::MAP : ETapeTag::ARRAY, { .count = 0 } });
+				}
+
+				void Close()
+				{
+					const container_t& container = stack[-1];
+					tape.entries[container.i_entry].count = container.n_items;
+					tape.entries.Append({ ETapeTag::END, {} });
+					stack.Remove(-1);
+				}
+
+			public:
+				void Build()
+				{
+					usys_t pos = index.Next();
+					for(;;)
+					{
+						// a value starts at pos
+						if(pos == TStructuralIndex::END)
+							Fail(n_bytes);
+
+						switch(arr_bytes[pos])
+						{
+							case '[':
+							case '{':
+							{
+								const bool is_map = arr_bytes[pos] == '{';
+								Open(is_map);
+								pos = index.Next();
+								if(pos != TStructuralIndex::END && arr_bytes[pos] == (is_map ? '}' : ']'))
+								{
+									Close();
+									break;
+								}
+								if(is_map)
+									pos = Key(pos);
+								continue;
+							}
+
+							case '"':
+								String(pos, index.Next());
+								break;
+
+							case 't':
+								Literal(pos, "true", 4, ETapeTag::TRUE);
+								break;
+
+							case 'f':
+								Literal(pos, "false", 5, ETapeTag::FALSE);
+								break;
+
+							case 'n':
+								Literal(pos, "null", 4, ETapeTag::NULLVALUE);
+								break;
+
+							case '-':
+							case '0': case '1': case '2': case '3': case '4':
+							case '5': case '6': case '7': case '8': case '9':
+								Number(pos);
+								break;
+
+							default:
+								Fail(pos);
+						}
+
+						// the value is complete, it is followed by a separator, the end of its container or the end of the input
+						for(;;)
+						{
+							pos = index.Next();
+							if(stack.Count() == 0)
+							{
+								if(pos != TStructuralIndex::END)
+									Fail(pos);
+								return;
+							}
+
+							container_t& container = stack[-1];
+							container.n_items++;
+							if(pos == TStructuralIndex::END)
+								Fail(n_bytes);
+
+							if(arr_bytes[pos] == ',')
+							{
+								pos = index.Next();
+								if(container.is_map)
+									pos = Key(pos);
+								break;
+							}
+
+							if(arr_bytes[pos] != (container.is_map ? '}' : ']'))
+								Fail(pos);
+							Close();
+						}
+					}
+				}
+
+				TTapeBuilder(const array_t<const byte_t> input, const bool tolerant, tape_t& tape) : TUtf8Scanner(input.Data(), input.Count(), tolerant), index(input), tape(tape) {}
+		};
+
+		TJsonValue BuildValue(tape_t& tape)
+		{
+			struct container_t
+			{
+				TJsonArray items;
+				TList<TJsonMap::kv_pair_t> members;
+				TString key;
+				bool is_map;
+				bool expect_key;
+			};
+
+			// builds the document without recursion, its depth does not depend on the stack size
+			TList<container_t> stack;
+			for(usys_t i = 0; ; i++)
+			{
+				const tape_entry_t& entry = tape.entries[i];
+				TJsonValue value;
+				switch(entry.tag)
+				{
+					case ETapeTag::NULLVALUE:
+						break;
+
+					case ETapeTag::TRUE:
+					case ETapeTag::FALSE:
+						value = TJsonValue(entry.tag == ETapeTag::TRUE);
+						break;
+
+					case ETapeTag::STRING:
+						if(stack.Count() != 0 && stack[-1].expect_key)
+						{
+							stack[-1].key = std::move(tape.strings[entry.i_string]);
+							stack[-1].expect_key = false;
+							continue;
+						}
+						value = TJsonValue(std::move(tape.strings[entry.i_string]));
+						break;
+
+					case ETapeTag::SIGNED_INTEGER:
+						value = TJsonValue(entry.signed_integer);
+						break;
+
+					case ETapeTag::UNSIGNED_INTEGER:
+						value = TJsonValue(entry.unsigned_integer);
+						break;
+
+					case ETapeTag::FLOATING:
+						value = TJsonValue(entry.floating);
+						break;
+
+					case ETapeTag::ARRAY:
+					case ETapeTag::MAP:
+					{
+						container_t& container = stack.Append(container_t());
+						container.is_map = entry.tag == ETapeTag::MAP;
+						container.expect_key = container.is_map;
+						if(container.is_map)
+							container.members.Prealloc(entry.count);
+						else
+							container.items.Prealloc(entry.count);
+						continue;
+					}
+
+					case ETapeTag::END:
+					{
+						container_t& container = stack[-1];
+						if(container.is_map)
+							value = TJsonValue(TJsonMap(std::move(container.members)));
+						else
+							value = TJsonValue(std::move(container.items));
+						stack.Remove(-1);
+						break;
+					}
+				}
+
+				if(stack.Count() == 0)
+					return value;
+
+				container_t& parent = stack[-1];
+				if(parent.is_map)
+				{
+					parent.members.MoveAppend({ std::move(parent.key), std::move(value) });
+					parent.expect_key = true;
+				}
+				else
+					parent.items.MoveAppend(std::move(value));
+			}
+		}
+	}
+
+	TJsonValue TJsonValue::Parse(const array_t<const byte_t> utf8, const bool tolerant)
+	{
+		tape_t tape;
+		TTapeBuilder(utf8, tolerant, tape).Build();
+		return BuildValue(tape);
+	}
+
 	TJsonValue TJsonValue::Parse(const TStringView str, const bool tolerant)
 	{
 		TStringViewTextReader reader(str);
@@ -685,9 +1546,394 @@ namespace el1::io::format::json
 	TJsonValue TJsonValue::Parse(const TFile& file, const bool tolerant)
 	{
 		TMapping map(const_cast<TFile*>(&file), TAccess::RO);
-		auto source = map.Source();
-		TStreamTextReader reader(&source);
-		return Parse(reader, tolerant);
+		return Parse(array_t<const byte_t>(map), tolerant);
+	}
+
+	////////////////////////////////////////////////////////////////////
+
+	static TJsonValue NumberValue(const tape_entry_t& entry)
+	{
+		switch(entry.tag)
+		{
+			case ETapeTag::SIGNED_INTEGER:   return TJsonValue(entry.signed_integer);
+			case ETapeTag::UNSIGNED_INTEGER: return TJsonValue(entry.unsigned_integer);
+			default:                         return TJsonValue(entry.floating);
+		}
+	}
+
+	static bool IsNumberByte(const byte_t chr)
+	{
+		return (chr >= '0' && chr <= '9') || chr == '-' || chr == '+' || chr == '.' || chr == 'e' || chr == 'E';
+	}
+
+	static const usys_t SZ_READ_MAX = 64U << 10;
+
+	bool TJsonReader::Refill()
+	{
+		if(eof)
+			return false;
+
+		// drop what was consumed, but remember its characters and lines for error positions
+		if(pos > 0)
+		{
+			for(usys_t i = 0; i < pos; i++)
+			{
+				n_chars_before += (buffer[i] & 0xc0) != 0x80 ? 1 : 0;
+				n_lines_before += buffer[i] == '\n' ? 1 : 0;
+			}
+			memmove(buffer.ItemPtr(0), buffer.ItemPtr(pos), n_buffered - pos);
+			n_buffered -= pos;
+			pos = 0;
+		}
+
+		// only a single token larger than the buffer makes it grow
+		if(n_buffered == buffer.Count())
+		{
+			EL_ERROR(buffer.Count() >= sz_buffer_max, TException, TString::Format(U"JSON token is larger than %d bytes", sz_buffer_max));
+			buffer.SetCount(util::Min(buffer.Count() * 2, sz_buffer_max));
+		}
+
+		const usys_t n_free = buffer.Count() - n_buffered;
+		const usys_t n_read = source->Read(buffer.ItemPtr(n_buffered), n_free);
+		if(n_read == 0)
+		{
+			eof = source->OnInputReady() == nullptr;
+			return false;
+		}
+
+		// small documents do not pay for a large buffer, a source which keeps filling it gets larger reads
+		if(n_read == n_free && buffer.Count() < SZ_READ_MAX && buffer.Count() < sz_buffer_max)
+			buffer.SetCount(util::Min(buffer.Count() * 2, SZ_READ_MAX, sz_buffer_max));
+
+		n_buffered += n_read;
+		return true;
+	}
+
+	// returns an empty optional when the next token is not completely buffered yet, the state is left as it was
+	// once eof is set every incomplete token is a syntax error
+	std::optional<EJsonToken> TJsonReader::Scan()
+	{
+		const TUtf8Scanner scanner(buffer.ItemPtr(0), n_buffered, tolerant, n_chars_before, n_lines_before);
+		const byte_t* const arr_bytes = scanner.arr_bytes;
+
+		for(;;)
+		{
+			while(pos < n_buffered && (arr_bytes[pos] == ' ' || arr_bytes[pos] == '\t' || arr_bytes[pos] == '\n' || arr_bytes[pos] == '\r'))
+				pos++;
+
+			if(pos == n_buffered)
+			{
+				if(!eof)
+					return {};
+				if(state == EState::DONE || (state == EState::AFTER_VALUE && stack.Count() == 0) || (state == EState::VALUE && multiple && stack.Count() == 0))
+				{
+					state = EState::DONE;
+					return EJsonToken::END;
+				}
+				scanner.Fail(n_buffered);
+			}
+
+			const byte_t chr = arr_bytes[pos];
+			switch(state)
+			{
+				case EState::DONE:
+					scanner.Fail(pos);
+
+				case EState::AFTER_VALUE:
+					if(stack.Count() == 0)
+					{
+						if(!multiple)
+							scanner.Fail(pos);
+						state = EState::VALUE;
+						continue;
+					}
+					if(chr == ',')
+					{
+						pos++;
+						state = stack[-1] ? EState::KEY : EState::VALUE;
+						continue;
+					}
+					if(chr != (stack[-1] ? '}' : ']'))
+						scanner.Fail(pos);
+					pos++;
+					stack.Remove(-1);
+					return chr == '}' ? EJsonToken::END_MAP : EJsonToken::END_ARRAY;
+
+				case EState::COLON:
+					if(chr != ':')
+						scanner.Fail(pos);
+					pos++;
+					state = EState::VALUE;
+					continue;
+
+				case EState::FIRST_ITEM:
+				case EState::FIRST_KEY:
+					if(chr == (state == EState::FIRST_KEY ? '}' : ']'))
+					{
+						pos++;
+						stack.Remove(-1);
+						state = EState::AFTER_VALUE;
+						return chr == '}' ? EJsonToken::END_MAP : EJsonToken::END_ARRAY;
+					}
+					break;
+
+				case EState::KEY:
+				case EState::VALUE:
+					break;
+			}
+
+			const bool is_key = state == EState::FIRST_KEY || state == EState::KEY;
+			if(is_key && chr != '"')
+				scanner.Fail(pos);
+
+			switch(chr)
+			{
+				case '[':
+				case '{':
+					pos++;
+					stack.Append(chr == '{');
+					state = chr == '{' ? EState::FIRST_KEY : EState::FIRST_ITEM;
+					return chr == '{' ? EJsonToken::BEGIN_MAP : EJsonToken::BEGIN_ARRAY;
+
+				case '"':
+				{
+					// the closing quote is the first one which is not preceded by an odd number of backslashes
+					usys_t close = pos + 1 + n_scanned;
+					for(;;)
+					{
+						const byte_t* const quote = (const byte_t*)memchr(arr_bytes + close, '"', n_buffered - close);
+						if(quote == nullptr)
+						{
+							if(eof)
+								scanner.Fail(n_buffered);
+							n_scanned = n_buffered - pos - 1;
+							return {};
+						}
+						close = (usys_t)(quote - arr_bytes);
+						usys_t n_backslashes = 0;
+						while(close - n_backslashes > pos + 1 && arr_bytes[close - n_backslashes - 1] == '\\')
+							n_backslashes++;
+						if(n_backslashes % 2 == 0)
+							break;
+						close++;
+					}
+
+					if(!tolerant)
+						for(usys_t i = pos + 1; i < close; i++)
+							if(arr_bytes[i] < 0x20)
+								scanner.Fail(i);
+
+					// text keeps its buffer, so decoding a string does not allocate once text has grown to the longest one
+					text.chars.SetCount(close - pos - 1);
+					text.chars.SetCount(scanner.DecodeString(pos, close, text.chars.Data()));
+
+					pos = close + 1;
+					n_scanned = 0;
+					state = is_key ? EState::COLON : EState::AFTER_VALUE;
+					return is_key ? EJsonToken::KEY : EJsonToken::STRING;
+				}
+
+				case 't':
+				case 'f':
+				case 'n':
+				{
+					const char* const literal = chr == 't' ? "true" : (chr == 'f' ? "false" : "null");
+					const usys_t len = strlen(literal);
+					// one more byte shows whether the literal ends there
+					if(pos + len >= n_buffered && !eof)
+						return {};
+					scanner.Literal(pos, literal, len);
+					pos += len;
+					state = EState::AFTER_VALUE;
+					if(chr == 'n')
+					{
+						scalar.SetNull();
+						return EJsonToken::NULLVALUE;
+					}
+					scalar = TJsonValue(chr == 't');
+					return EJsonToken::BOOLEAN;
+				}
+
+				case '-':
+				case '0': case '1': case '2': case '3': case '4':
+				case '5': case '6': case '7': case '8': case '9':
+				{
+					usys_t end = pos + 1;
+					while(end < n_buffered && IsNumberByte(arr_bytes[end]))
+						end++;
+					if(end == n_buffered && !eof)
+						return {};
+					tape_entry_t entry;
+					pos = scanner.Number(pos, entry);
+					scalar = NumberValue(entry);
+					state = EState::AFTER_VALUE;
+					return EJsonToken::NUMBER;
+				}
+
+				default:
+					scanner.Fail(pos);
+			}
+		}
+	}
+
+	const TString& TJsonReader::String() const
+	{
+		EL_ERROR(token != EJsonToken::KEY && token != EJsonToken::STRING, TException, U"the current JSON token is not a key or string");
+		return text;
+	}
+
+	double TJsonReader::Number() const
+	{
+		EL_ERROR(token != EJsonToken::NUMBER, TException, U"the current JSON token is not a number");
+		return scalar.Number();
+	}
+
+	bool TJsonReader::Boolean() const
+	{
+		EL_ERROR(token != EJsonToken::BOOLEAN, TException, U"the current JSON token is not a boolean");
+		return scalar.Boolean();
+	}
+
+	TJsonValue TJsonReader::Value() const
+	{
+		switch(token)
+		{
+			case EJsonToken::STRING:
+				return TJsonValue(text);
+
+			case EJsonToken::NUMBER:
+			case EJsonToken::BOOLEAN:
+			case EJsonToken::NULLVALUE:
+				return scalar;
+
+			default:
+				EL_THROW(TException, U"the current JSON token is not a scalar value");
+		}
+	}
+
+	std::optional<EJsonToken> TJsonReader::TryNext()
+	{
+		for(;;)
+		{
+			if(const std::optional<EJsonToken> next = Scan())
+				return token = *next;
+
+			// once the source is dry Scan() no longer waits for more input
+			if(!Refill() && !eof)
+				return {};
+		}
+	}
+
+	EJsonToken TJsonReader::Next()
+	{
+		for(;;)
+		{
+			if(const std::optional<EJsonToken> next = TryNext())
+				return *next;
+
+			const system::waitable::IWaitable* const on_input_ready = source->OnInputReady();
+			if(on_input_ready != nullptr)
+				on_input_ready->WaitFor();
+		}
+	}
+
+	void TJsonReader::Skip()
+	{
+		if(token != EJsonToken::BEGIN_ARRAY && token != EJsonToken::BEGIN_MAP)
+			return;
+
+		const usys_t depth = stack.Count() - 1;
+		while(stack.Count() > depth)
+			Next();
+	}
+
+	TJsonValue TJsonReader::ReadValue()
+	{
+		if(token != EJsonToken::BEGIN_ARRAY && token != EJsonToken::BEGIN_MAP)
+			return Value();
+
+		// records the subtree on a tape, so BuildValue() can preallocate every container
+		tape_t tape;
+		TList<usys_t> containers;
+		const usys_t depth = stack.Count() - 1;
+		for(;;)
+		{
+			if(containers.Count() != 0 && (token != EJsonToken::END_ARRAY && token != EJsonToken::END_MAP))
+			{
+				// map members are counted by their key, array items by their first token
+				tape_entry_t& container = tape.entries[containers[-1]];
+				if((container.tag == ETapeTag::MAP) == (token == EJsonToken::KEY))
+					container.count++;
+			}
+
+			switch(token)
+			{
+				case EJsonToken::BEGIN_ARRAY:
+				case EJsonToken::BEGIN_MAP:
+					containers.Append(tape.entries.Count());
+					tape.entries.Append({ token == EJsonToken::BEGIN_MAP ? ETapeTag::MAP : ETapeTag::ARRAY, { .count = 0 } });
+					break;
+
+				case EJsonToken::END_ARRAY:
+				case EJsonToken::END_MAP:
+					containers.Remove(-1);
+					tape.entries.Append({ ETapeTag::END, {} });
+					break;
+
+				case EJsonToken::KEY:
+				case EJsonToken::STRING:
+					tape.strings.Append(text);
+					tape.entries.Append({ ETapeTag::STRING, { .i_string = tape.strings.Count() - 1 } });
+					break;
+
+				case EJsonToken::NUMBER:
+					switch(scalar.NumberRepresentation())
+					{
+						case TJsonValue::ENumberRepresentation::SIGNED_INTEGER:
+							tape.entries.Append({ ETapeTag::SIGNED_INTEGER, { .signed_integer = scalar.number.signed_integer } });
+							break;
+						case TJsonValue::ENumberRepresentation::UNSIGNED_INTEGER:
+							tape.entries.Append({ ETapeTag::UNSIGNED_INTEGER, { .unsigned_integer = scalar.number.unsigned_integer } });
+							break;
+						case TJsonValue::ENumberRepresentation::FLOATING:
+							tape.entries.Append({ ETapeTag::FLOATING, { .floating = scalar.number.floating } });
+							break;
+					}
+					break;
+
+				case EJsonToken::BOOLEAN:
+					tape.entries.Append({ scalar.Boolean() ? ETapeTag::TRUE : ETapeTag::FALSE, {} });
+					break;
+
+				case EJsonToken::NULLVALUE:
+					tape.entries.Append({ ETapeTag::NULLVALUE, {} });
+					break;
+
+				case EJsonToken::END:
+					EL_THROW(TLogicException);
+			}
+
+			if(stack.Count() == depth)
+				return BuildValue(tape);
+			Next();
+		}
+	}
+
+	TJsonReader::TJsonReader(stream::ISource<byte_t>* const source, const bool tolerant, const bool multiple, const usys_t sz_buffer_max) :
+		source(source),
+		tolerant(tolerant),
+		multiple(multiple),
+		sz_buffer_max(util::Max<usys_t>(sz_buffer_max, 64)),
+		n_buffered(0),
+		pos(0),
+		n_scanned(0),
+		n_chars_before(0),
+		n_lines_before(0),
+		eof(false),
+		state(EState::VALUE),
+		token(EJsonToken::NULLVALUE)
+	{
+		buffer.SetCount(util::Min<usys_t>(this->sz_buffer_max, 4096));
 	}
 
 	const TJsonValue TJsonValue::NULLVALUE = TJsonValue();
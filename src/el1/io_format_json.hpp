@@ -9,6 +9,7 @@
 #include <concepts>
 #include <cmath>
 #include <limits>
+#include <optional>
 #include <type_traits>
 #include <utility>
 
@@ -26,6 +27,7 @@ namespace el1::io::format::json
 	using namespace io::collection::map;
 
 	class TJsonValue;
+	class TJsonReader;
 	using TJsonMap = TSortedMap<TString, TJsonValue>;
 	using TConstJsonMap = TSortedMap<TString, const TJsonValue>;
 	using TJsonArray = TList<TJsonValue>;
@@ -62,6 +64,7 @@ namespace el1::io::format::json
 
 	class TJsonValue
 	{
+		friend class TJsonReader;
 		protected:
 			enum class ENumberRepresentation : u8_t
 			{
@@ -273,6 +276,11 @@ namespace el1::io::format::json
 
 			static TJsonValue Parse(const TStringView str, const bool tolerant = false);
 			static TJsonValue Parse(ITextReader& reader, const bool tolerant = false);
+
+			// parses UTF-8 directly, without decoding the input to char32_t first
+			// a SIMD pass indexes the structural characters outside of strings, a second pass walks the index and records the document on a tape
+			// accepts the same documents as the grammar of TJsonParser::Parser(), the whole input must be one JSON value
+			static TJsonValue Parse(const array_t<const byte_t> utf8, const bool tolerant = false);
 			static TJsonValue Parse(const file::TFile& file, const bool tolerant = false);
 	};
 
@@ -421,4 +429,95 @@ namespace el1::io::format::json
 			});
 		}
 	};
+
+	enum class EJsonToken : u8_t
+	{
+		BEGIN_ARRAY,
+		END_ARRAY,
+		BEGIN_MAP,
+		END_MAP,
+		KEY,		// => String()
+		STRING,		// => String()
+		NUMBER,		// => Number() / ToInteger()
+		BOOLEAN,	// => Boolean()
+		NULLVALUE,
+		END			// of the input, repeated on every further call
+	};
+
+	// pull parser for documents which are too large to be held as TJsonValue
+	// reads UTF-8 from the source in chunks and returns one token per call, the memory use is bounded by the largest string or number and the nesting depth
+	// accepts the same documents as TJsonValue::Parse(), with multiple set the input may hold any number of whitespace separated values (e.g. newline delimited JSON)
+	class TJsonReader
+	{
+		protected:
+			enum class EState : u8_t
+			{
+				VALUE,			// a value is expected
+				FIRST_ITEM,		// after '[' => a value or ']'
+				FIRST_KEY,		// after '{' => a key or '}'
+				KEY,			// after ',' in a map
+				COLON,			// after a key
+				AFTER_VALUE,	// => ',', ']', '}' or the end of a root value
+				DONE
+			};
+
+			stream::ISource<byte_t>* const source;
+			const bool tolerant;
+			const bool multiple;
+			const usys_t sz_buffer_max;
+			TList<byte_t> buffer;
+			usys_t n_buffered;
+			usys_t pos;
+			usys_t n_scanned;	// bytes after the opening quote at pos already searched for the closing quote
+			iosize_t n_chars_before;	// characters and lines consumed before buffer[0], for error positions
+			iosize_t n_lines_before;
+			bool eof;
+			EState state;
+			EJsonToken token;
+			TList<bool> stack;	// true for maps
+			TString text;
+			TJsonValue scalar;
+
+			bool Refill();
+			std::optional<EJsonToken> Scan();
+
+		public:
+			stream::ISource<byte_t>* Source() const EL_GETTER { return source; }
+
+			EJsonToken Token() const EL_GETTER { return token; }
+			usys_t Depth() const EL_GETTER { return stack.Count(); }
+
+			const TString& String() const EL_GETTER;
+			double Number() const EL_GETTER;
+			bool Boolean() const EL_GETTER;
+
+			template<std::integral T>
+			requires (!std::same_as<std::remove_cv_t<T>, bool>)
+			T ToInteger() const EL_GETTER
+			{
+				EL_ERROR(token != EJsonToken::NUMBER, TException, U"the current JSON token is not a number");
+				return scalar.ToInteger<T>();
+			}
+
+			// the current STRING, NUMBER, BOOLEAN or NULLVALUE token as TJsonValue
+			TJsonValue Value() const;
+
+			// blocks (or suspends the calling fiber) until the next token is complete
+			EJsonToken Next();
+
+			// returns an empty optional instead of blocking, call it again once Source()->OnInputReady() signals
+			// a token which was split across reads is resumed where the previous call stopped
+			std::optional<EJsonToken> TryNext();
+
+			// after BEGIN_ARRAY or BEGIN_MAP, skips to the matching END_ARRAY or END_MAP
+			// does nothing after other tokens, blocks like Next()
+			void Skip();
+
+			// materializes the value which starts with the current token, for BEGIN_ARRAY and BEGIN_MAP this reads up to the matching end
+			// blocks like Next()
+			TJsonValue ReadValue();
+
+			TJsonReader(stream::ISource<byte_t>* const source, const bool tolerant = false, const bool multiple = false, const usys_t sz_buffer_max = 64U << 20);
+			TJsonReader(const TJsonReader&) = delete;
+	};
 }
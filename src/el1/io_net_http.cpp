@@ -1,7 +1,7 @@
 #include "io_net_http.hpp"
 #include "io_text.hpp"
-#include "io_bcd.hpp"
 #include "io_text_encoding_utf8.hpp"
+#include "system_time_timer.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -15,13 +15,14 @@ namespace el1::io::net::http
 	using namespace text::string;
 	using namespace text::encoding;
 	using namespace text::encoding::utf8;
-	using namespace bcd;
 	using namespace ip;
 	using namespace file;
 	using namespace collection::list;
 	using namespace collection::map;
 	using namespace system::task;
 	using namespace system::waitable;
+	using namespace system::time;
+	using namespace system::time::timer;
 
 	// https://stackoverflow.com/questions/1097651/is-there-a-practical-http-header-length-limit
 	// => 8192 characters (UTF32) seems to be reasonable limit
@@ -39,20 +40,45 @@ namespace el1::io::net::http
 		return new THttpProcessingException(*this);
 	}
 
-	static EMethod MethodFromString(const TStringView str)
+	static bool BytesEqual(const byte_t* const arr_bytes, const usys_t n_bytes, const char* const str)
 	{
-		     if(str == U"GET") return EMethod::GET;
-		else if(str == U"POST") return EMethod::POST;
-		else if(str == U"HEAD") return EMethod::HEAD;
-		else if(str == U"PUT") return EMethod::PUT;
-		else if(str == U"PATCH") return EMethod::PATCH;
-		else if(str == U"DELETE") return EMethod::DELETE;
-		else if(str == U"TRACE") return EMethod::TRACE;
-		else if(str == U"OPTIONS") return EMethod::OPTIONS;
-		else if(str == U"CONNECT") return EMethod::CONNECT;
+		return n_bytes == strlen(str) && memcmp(arr_bytes, str, n_bytes) == 0;
+	}
+
+	// every byte becomes one character, just like the header used to be read
+	static TString StringFromBytes(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		TString str;
+		str.chars.SetCount(n_bytes);
+		char32_t* const arr_chars = str.chars.Data();
+		for(usys_t i = 0; i < n_bytes; i++)
+			arr_chars[i] = arr_bytes[i];
+		return str;
+	}
+
+	static EMethod MethodFromBytes(const byte_t* const str, const usys_t len)
+	{
+		     if(BytesEqual(str, len, "GET")) return EMethod::GET;
+		else if(BytesEqual(str, len, "POST")) return EMethod::POST;
+		else if(BytesEqual(str, len, "HEAD")) return EMethod::HEAD;
+		else if(BytesEqual(str, len, "PUT")) return EMethod::PUT;
+		else if(BytesEqual(str, len, "PATCH")) return EMethod::PATCH;
+		else if(BytesEqual(str, len, "DELETE")) return EMethod::DELETE;
+		else if(BytesEqual(str, len, "TRACE")) return EMethod::TRACE;
+		else if(BytesEqual(str, len, "OPTIONS")) return EMethod::OPTIONS;
+		else if(BytesEqual(str, len, "CONNECT")) return EMethod::CONNECT;
 		else EL_THROW(THttpProcessingException, EStatus::BAD_REQUEST, U"unknown method");
 	}
 
+	static EVersion VersionFromBytes(const byte_t* const str, const usys_t len)
+	{
+		     if(BytesEqual(str, len, "HTTP/1.1")) return EVersion::HTTP11;
+		else if(BytesEqual(str, len, "HTTP/1.0")) return EVersion::HTTP10;
+		else if(BytesEqual(str, len, "HTTP/2"))   return EVersion::HTTP20;
+		else if(BytesEqual(str, len, "HTTP/2.0")) return EVersion::HTTP20;
+		else EL_THROW(THttpProcessingException, EStatus::BAD_REQUEST, U"unknown http version");
+	}
+
 	static EVersion VersionFromString(const TStringView str)
 	{
 		     if(str == U"HTTP/1.1") return EVersion::HTTP11;
@@ -75,26 +101,37 @@ namespace el1::io::net::http
 		EL_THROW(TLogicException);
 	}
 
-	static const char* StatusToString(const EStatus status)
+	template<usys_t N>
+	static array_t<const byte_t> ByteLiteral(const char (&str)[N])
+	{
+		return array_t<const byte_t>::FromUnsafePointer(reinterpret_cast<const byte_t*>(str), N - 1U);
+	}
+
+	// complete pre-encoded status lines, other versions than HTTP/1.1 replace the first 8 bytes
+	static array_t<const byte_t> StatusLine(const EStatus status)
 	{
+		#define STATUS_LINE(name, code, reason) case EStatus::name: static_assert((u16_t)EStatus::name == code); return ByteLiteral("HTTP/1.1 " #code " " reason "\r\n")
 		switch(status)
 		{
-			case EStatus::OK: return "OK";
-			case EStatus::CREATED: return "Created";
-			case EStatus::ACCEPTED: return "Accepted";
-			case EStatus::NO_CONTENT: return "No Content";
-			case EStatus::PARTIAL_CONTENT: return "Partial Content";
-			case EStatus::BAD_REQUEST: return "Bad Request";
-			case EStatus::UNAUTHORIZED: return "Unauthorized";
-			case EStatus::FORBIDDEN: return "Forbidden";
-			case EStatus::NOT_FOUND: return "Not Found";
-			case EStatus::METHOD_NOT_ALLOWED: return "Method Not Allowed";
-			case EStatus::CONFLICT: return "Conflict";
-			case EStatus::RANGE_NOT_SATISFIABLE: return "Range Not Satisfiable";
-			case EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE: return "Request Header Fields Too Large";
-			case EStatus::INTERNAL_SERVER_ERROR: return "Internal Server Error";
+			STATUS_LINE(OK, 200, "OK");
+			STATUS_LINE(CREATED, 201, "Created");
+			STATUS_LINE(ACCEPTED, 202, "Accepted");
+			STATUS_LINE(NO_CONTENT, 204, "No Content");
+			STATUS_LINE(PARTIAL_CONTENT, 206, "Partial Content");
+			STATUS_LINE(NOT_MODIFIED, 304, "Not Modified");
+			STATUS_LINE(BAD_REQUEST, 400, "Bad Request");
+			STATUS_LINE(UNAUTHORIZED, 401, "Unauthorized");
+			STATUS_LINE(FORBIDDEN, 403, "Forbidden");
+			STATUS_LINE(NOT_FOUND, 404, "Not Found");
+			STATUS_LINE(METHOD_NOT_ALLOWED, 405, "Method Not Allowed");
+			STATUS_LINE(REQUEST_TIMEOUT, 408, "Request Timeout");
+			STATUS_LINE(CONFLICT, 409, "Conflict");
+			STATUS_LINE(RANGE_NOT_SATISFIABLE, 416, "Range Not Satisfiable");
+			STATUS_LINE(REQUEST_HEADER_FIELDS_TOO_LARGE, 431, "Request Header Fields Too Large");
+			STATUS_LINE(INTERNAL_SERVER_ERROR, 500, "Internal Server Error");
 			case EStatus::EOF: break;
 		}
+		#undef STATUS_LINE
 
 		EL_THROW(TException, U"unsupported status code");
 	}
@@ -117,13 +154,20 @@ namespace el1::io::net::http
 		EL_THROW(TLogicException);
 	}
 
+	static char32_t AsciiLower(const char32_t chr)
+	{
+		return chr >= U'A' && chr <= U'Z' ? chr + (U'a' - U'A') : chr;
+	}
+
+	// field names are tokens (RFC 9110 section 5.1), so folding ASCII letters is enough and needs no copies
 	static bool HeaderNameEquals(const TStringView a, const TStringView b)
 	{
-		TString aa(a);
-		TString bb(b);
-		aa.ToLower();
-		bb.ToLower();
-		return aa == bb;
+		if(a.Count() != b.Count())
+			return false;
+		for(usys_t i = 0; i < a.Count(); i++)
+			if(AsciiLower(a.Data()[i]) != AsciiLower(b.Data()[i]))
+				return false;
+		return true;
 	}
 
 	static TString* FindHeaderField(THttpHeaderFields& fields, const TStringView name)
@@ -156,10 +200,10 @@ namespace el1::io::net::http
 
 	static bool RemoveHeaderField(THttpHeaderFields& fields, const TStringView name)
 	{
-		for(usys_t i = 0; i < fields.Items().Count(); i++)
-			if(HeaderNameEquals(fields.Items()[i].key, name))
+		for(const auto& field : fields.Items())
+			if(HeaderNameEquals(field.key, name))
 			{
-				const TString key = fields.Items()[i].key;
+				const TString key = field.key;
 				fields.Remove(key);
 				return true;
 			}
@@ -205,20 +249,124 @@ namespace el1::io::net::http
 			EL_ERROR(chr < 0x20 || chr == 0x7f, TInvalidArgumentException, "url", "decoded HTTP request path contains a control character");
 	}
 
-	static bool HeaderHasToken(const TStringView value, const TStringView token)
+	// calls predicate for every element of a comma separated list, with the surrounding whitespace removed, until it returns true
+	template<typename P>
+	static bool AnyListItem(const TStringView value, P&& predicate)
 	{
-		TString token_lower(token);
-		token_lower.ToLower();
-		for(TString item : TString(value).Split(','))
+		const char32_t* const chars = value.Data();
+		for(usys_t begin = 0; begin <= value.Count();)
 		{
-			item.Trim();
-			item.ToLower();
-			if(item == token_lower)
+			usys_t end = begin;
+			while(end < value.Count() && chars[end] != ',')
+				end++;
+
+			usys_t item_begin = begin;
+			usys_t item_end = end;
+			while(item_begin < item_end && WHITESPACE_CHARS.Contains(chars[item_begin]))
+				item_begin++;
+			while(item_end > item_begin && WHITESPACE_CHARS.Contains(chars[item_end - 1]))
+				item_end--;
+
+			if(predicate(value.SliceBE(item_begin, item_end)))
 				return true;
+			begin = end + 1;
 		}
 		return false;
 	}
 
+	static bool HeaderHasToken(const TStringView value, const TStringView token)
+	{
+		return AnyListItem(value, [&token](const TStringView item) { return HeaderNameEquals(item, token); });
+	}
+
+	static const char* const MONTH_NAMES[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+	static s64_t DaysFromCivil(int year, const unsigned month, const unsigned day)
+	{
+		year -= month <= 2;
+		const int era = (year >= 0 ? year : year - 399) / 400;
+		const unsigned year_of_era = (unsigned)(year - era * 400);
+		const unsigned adjusted_month = month > 2 ? month - 3U : month + 9U;
+		const unsigned day_of_year = (153U * adjusted_month + 2U) / 5U + day - 1U;
+		const unsigned day_of_era = year_of_era * 365U + year_of_era / 4U - year_of_era / 100U + day_of_year;
+		return (s64_t)era * 146097 + (s64_t)day_of_era - 719468;
+	}
+
+	static bool AsciiEqualsIgnoreCase(const char* a, const char* b)
+	{
+		while(*a != '\0' && *b != '\0')
+		{
+			char ca = *a++;
+			char cb = *b++;
+			if(ca >= 'A' && ca <= 'Z')
+				ca = (char)(ca - 'A' + 'a');
+			if(cb >= 'A' && cb <= 'Z')
+				cb = (char)(cb - 'A' + 'a');
+			if(ca != cb)
+				return false;
+		}
+		return *a == *b;
+	}
+
+	static bool ParseHttpDate(const TStringView value, s64_t& unix_time)
+	{
+		auto cstr = value.MakeCStr();
+		char weekday[4] = {};
+		char month_name[4] = {};
+		char zone[8] = {};
+		int day = 0;
+		int year = 0;
+		int hour = 0;
+		int minute = 0;
+		int second = 0;
+		if(sscanf(cstr.get(), "%3[^,], %d %3s %d %d:%d:%d %7s", weekday, &day, month_name, &year, &hour, &minute, &second, zone) != 8)
+			return false;
+
+		unsigned month = 0;
+		for(unsigned i = 0; i < 12; i++)
+			if(AsciiEqualsIgnoreCase(month_name, MONTH_NAMES[i]))
+			{
+				month = i + 1;
+				break;
+			}
+
+		if(month == 0 || day < 1 || day > 31 || year < 1601 || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60 || !AsciiEqualsIgnoreCase(zone, "GMT"))
+			return false;
+
+		unix_time = DaysFromCivil(year, month, (unsigned)day) * 86400 + hour * 3600 + minute * 60 + second;
+		return true;
+	}
+
+	static void CivilFromDays(s64_t days, s64_t& year, unsigned& month, unsigned& day)
+	{
+		days += 719468;
+		const s64_t era = (days >= 0 ? days : days - 146096) / 146097;
+		const unsigned day_of_era = (unsigned)(days - era * 146097);
+		const unsigned year_of_era = (day_of_era - day_of_era / 1460U + day_of_era / 36524U - day_of_era / 146096U) / 365U;
+		const unsigned day_of_year = day_of_era - (365U * year_of_era + year_of_era / 4U - year_of_era / 100U);
+		const unsigned adjusted_month = (5U * day_of_year + 2U) / 153U;
+		day = day_of_year - (153U * adjusted_month + 2U) / 5U + 1U;
+		month = adjusted_month < 10U ? adjusted_month + 3U : adjusted_month - 9U;
+		year = (s64_t)year_of_era + era * 400 + (month <= 2U);
+	}
+
+	// IMF-fixdate, the preferred format of RFC 9110 section 5.6.7
+	static TString FormatHttpDate(const s64_t unix_time)
+	{
+		static const char* const WEEKDAYS[] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };	// 1970-01-01 was a thursday
+
+		const s64_t days = unix_time >= 0 ? unix_time / 86400 : (unix_time - 86399) / 86400;
+		const s64_t seconds = unix_time - days * 86400;
+		s64_t year = 0;
+		unsigned month = 0;
+		unsigned day = 0;
+		CivilFromDays(days, year, month, day);
+
+		char buffer[48];
+		snprintf(buffer, sizeof(buffer), "%s, %02u %s %04lld %02u:%02u:%02u GMT", WEEKDAYS[((days % 7) + 7) % 7], day, MONTH_NAMES[month - 1U], (long long)year, (unsigned)(seconds / 3600), (unsigned)(seconds / 60 % 60), (unsigned)(seconds % 60));
+		return TString(buffer);
+	}
+
 	static void WriteString(ISink<byte_t>& sink, const TStringView str)
 	{
 		auto cstr = str.MakeCStr();
@@ -300,18 +448,21 @@ namespace el1::io::net::http
 		}
 	}
 
+	static u8_t HexDigit(const char32_t chr)
+	{
+		if(chr >= '0' && chr <= '9') return chr - '0';
+		if(chr >= 'a' && chr <= 'f') return chr - 'a' + 10;
+		if(chr >= 'A' && chr <= 'F') return chr - 'A' + 10;
+		EL_THROW(TException, U"invalid hex digit");
+	}
+
 	static usys_t ParseHex(const TStringView str)
 	{
 		EL_ERROR(str.Length() == 0, TException, U"empty HTTP chunk size");
 		usys_t value = 0;
 		for(usys_t i = 0; i < str.Length(); i++)
 		{
-			const char32_t chr = str[i];
-			u8_t digit;
-			if(chr >= '0' && chr <= '9') digit = chr - '0';
-			else if(chr >= 'a' && chr <= 'f') digit = chr - 'a' + 10;
-			else if(chr >= 'A' && chr <= 'F') digit = chr - 'A' + 10;
-			else EL_THROW(TException, U"invalid HTTP chunk size");
+			const u8_t digit = HexDigit(str[i]);
 			EL_ERROR(value > (NEG1 - digit) / 16U, TException, U"HTTP chunk size overflow");
 			value = value * 16U + digit;
 		}
@@ -319,19 +470,39 @@ namespace el1::io::net::http
 	}
 
 
-	static void WriteChunkedBody(ISource<byte_t>& source, ISink<byte_t>& sink);
+	static void WriteChunkedBody(ISource<byte_t>& source, ISink<byte_t>& sink, TList<byte_t> pending = TList<byte_t>());
+
+	// at most this much of a body is read ahead to go out in the same write as the response head
+	static const usys_t RESPONSE_FIRST_CHUNK_SIZE = 16384U;
+
+	static void AppendUTF8(TList<byte_t>& out, const TStringView str)
+	{
+		const usys_t n_before = out.Count();
+		out.SetCount(n_before + str.Count() * 4U);
+		out.SetCount(n_before + EncodeUTF8(str.Data(), str.Count(), out.Data() + n_before));
+	}
+
+	static void SendFileBody(THttpFileBody& body, ISink<byte_t>& sink)
+	{
+		while(body.Remaining() != 0)
+			if(body.WriteOut(sink, body.Remaining()) == 0)
+			{
+				const IWaitable* const waitable = sink.OnOutputReady();
+				EL_ERROR(waitable == nullptr, TSinkFloodedException);
+				waitable->WaitFor();
+			}
+	}
 
 	static void SendResponse(ISink<byte_t>& sink, THttpResponseEncoder::response_t& response, const bool suppress_body = false)
 	{
-		const char* const str_version = VersionToString(response.version);
-		const char* const str_status_text = StatusToString(response.status);
-		auto str_status_code = TString::Format(U"%d", (u16_t)response.status).MakeCStr();
+		const array_t<const byte_t> status_line = StatusLine(response.status);
 
 		const usys_t content_length = response.header_fields.ContentLength();
 		const TString* const transfer_encoding = FindHeaderField(response.header_fields, U"Transfer-Encoding");
 		EL_ERROR(content_length != NEG1 && transfer_encoding != nullptr, TInvalidArgumentException, "response", "response must not contain both Content-Length and Transfer-Encoding");
 
-		if(response.body == nullptr && content_length == NEG1)
+		// a 304 has no body and a Content-Length would describe the one of the 200 response
+		if(response.body == nullptr && content_length == NEG1 && response.status != EStatus::NOT_MODIFIED)
 			response.header_fields.ContentLength(0);
 		else if(response.body != nullptr && content_length == NEG1 && transfer_encoding == nullptr)
 		{
@@ -343,38 +514,63 @@ namespace el1::io::net::http
 				response.header_fields.Set(U"Connection", U"close");
 		}
 
+		// the whole head is assembled in one buffer and written with a single call
+		usys_t sz_head = status_line.Count() + 2U;
 		for(const auto& field : response.header_fields.Items())
+		{
 			ValidateHeaderField(field.key, field.value);
+			sz_head += (field.key.Length() + field.value.Length()) * 4U + 4U;
+		}
 
-		sink.WriteAll((const byte_t*)str_version, strlen(str_version));
-		sink.WriteAll((const byte_t*)" ", 1);
-		sink.WriteAll((const byte_t*)str_status_code.get(), strlen(str_status_code.get()));
-		sink.WriteAll((const byte_t*)" ", 1);
-		sink.WriteAll((const byte_t*)str_status_text, strlen(str_status_text));
-		sink.WriteAll((const byte_t*)"\r\n", 2);
+		TList<byte_t> head;
+		head.Prealloc(sz_head);
+		if(response.version == EVersion::HTTP11)
+			head.Append(status_line.Data(), status_line.Count());
+		else
+		{
+			const char* const str_version = VersionToString(response.version);
+			head.Append(reinterpret_cast<const byte_t*>(str_version), strlen(str_version));
+			head.Append(status_line.Data() + 8U, status_line.Count() - 8U);
+		}
 
 		for(const auto& field : response.header_fields.Items())
 		{
-			auto str_key = field.key.MakeCStr();
-			auto str_value = field.value.MakeCStr();
-
-			sink.WriteAll((const byte_t*)str_key.get(), strlen(str_key.get()));
-			sink.WriteAll((const byte_t*)": ", 2);
-			sink.WriteAll((const byte_t*)str_value.get(), strlen(str_value.get()));
-			sink.WriteAll((const byte_t*)"\r\n", 2);
+			AppendUTF8(head, field.key);
+			head.Append(reinterpret_cast<const byte_t*>(": "), 2);
+			AppendUTF8(head, field.value);
+			head.Append(reinterpret_cast<const byte_t*>("\r\n"), 2);
 		}
+		head.Append(reinterpret_cast<const byte_t*>("\r\n"), 2);
 
-		sink.WriteAll((const byte_t*)"\r\n", 2);
+		if(response.body == nullptr || suppress_body)
+		{
+			sink.WriteAll(head.Data(), head.Count());
+			return;
+		}
 
-		if(response.body != nullptr && !suppress_body)
+		const usys_t n_content_length = response.header_fields.ContentLength();
+		const TString* const transfer_encoding_body = FindHeaderField(response.header_fields, U"Transfer-Encoding");
+		if(transfer_encoding_body != nullptr && HeaderHasToken(*transfer_encoding_body, U"chunked"))
 		{
-			const usys_t n_content_length = response.header_fields.ContentLength();
-			const TString* const transfer_encoding_body = FindHeaderField(response.header_fields, U"Transfer-Encoding");
-			if(transfer_encoding_body != nullptr && HeaderHasToken(*transfer_encoding_body, U"chunked"))
-				WriteChunkedBody(*response.body, sink);
-			else
-				Pump(*response.body, sink, n_content_length, true);
+			WriteChunkedBody(*response.body, sink, std::move(head));
+			return;
 		}
+
+		// whatever part of the body is available right away is sent along with the head
+		const usys_t n_head = head.Count();
+		head.SetCount(n_head + util::Min(n_content_length, RESPONSE_FIRST_CHUNK_SIZE));
+		const usys_t n_first = response.body->Read(head.Data() + n_head, head.Count() - n_head);
+		head.SetCount(n_head + n_first);
+		sink.WriteAll(head.Data(), head.Count());
+		if(n_first == n_content_length)
+			return;
+
+		// the rest may take a while, what there is goes out now
+		sink.Flush();
+		if(auto* const file_body = dynamic_cast<THttpFileBody*>(response.body.get()))
+			SendFileBody(*file_body, sink);
+		else
+			Pump(*response.body, sink, n_content_length == NEG1 ? NEG1 : n_content_length - n_first, true);
 	}
 
 	usys_t THttpHeaderFields::ContentLength() const
@@ -578,99 +774,193 @@ namespace el1::io::net::http
 		}
 	}
 
+	THttpRequestDecoder::TReceiveBuffer::TReceiveBuffer(ISource<byte_t>* const source, const usys_t size) : source(source)
+	{
+		buffer.SetCount(size);
+	}
+
+	usys_t THttpRequestDecoder::TReceiveBuffer::Fill()
+	{
+		if(pos_head == pos_tail)
+		{
+			pos_head = 0;
+			pos_tail = 0;
+		}
+		else if(pos_head != 0)
+		{
+			memmove(buffer.Data(), buffer.Data() + pos_head, pos_tail - pos_head);
+			pos_tail -= pos_head;
+			pos_head = 0;
+		}
+
+		if(pos_tail == buffer.Count())
+			return 0;
+
+		const usys_t n = source->Read(buffer.Data() + pos_tail, buffer.Count() - pos_tail);
+		pos_tail += n;
+		return n;
+	}
+
+	usys_t THttpRequestDecoder::TReceiveBuffer::Read(byte_t* const arr_items, const usys_t n_items_max)
+	{
+		if(Buffered() == 0)
+		{
+			// large reads (request bodies) bypass the buffer, small ones (chunk headers) are served from a refill
+			if(n_items_max >= buffer.Count() / 2)
+				return source->Read(arr_items, n_items_max);
+			if(Fill() == 0)
+				return 0;
+		}
+
+		const usys_t n = util::Min(n_items_max, Buffered());
+		memcpy(arr_items, Head(), n);
+		pos_head += n;
+		return n;
+	}
+
+	const IWaitable* THttpRequestDecoder::TReceiveBuffer::OnInputReady() const
+	{
+		return source->OnInputReady();
+	}
+
+	void THttpRequestDecoder::TReceiveBuffer::Close()
+	{
+		pos_head = 0;
+		pos_tail = 0;
+		source->Close();
+	}
+
 	THttpRequestDecoder::THttpRequestDecoder(ISource<byte_t>& new_source, const ipport_t new_remote_address, const usys_t new_header_char_limit) :
-		source(&new_source),
+		receive_buffer(&new_source, util::Max(RECEIVE_BUFFER_SIZE, new_header_char_limit + 2U)),
 		remote_address(new_remote_address),
 		header_char_limit(new_header_char_limit)
 	{
 		EL_ERROR(header_char_limit == 0, TInvalidArgumentException, "header_char_limit", "header_char_limit must be greater than zero");
 	}
 
-	THttpRequestDecoder::ELineResult THttpRequestDecoder::ReadLine()
+	THttpRequestDecoder::ELineResult THttpRequestDecoder::ReadLine(const byte_t*& line, usys_t& n_line)
 	{
 		for(;;)
 		{
-			byte_t byte = 0;
-			const usys_t n = source->Read(&byte, 1);
-			if(n == 0)
-			{
-				if(source->OnInputReady() != nullptr)
-					return ELineResult::BLOCKED;
-				EL_ERROR(line.Length() != 0, THttpProcessingException, EStatus::BAD_REQUEST, U"unexpected EOF in HTTP header");
-				return ELineResult::EOF_REACHED;
-			}
+			const byte_t* const head = receive_buffer.Head();
+			const usys_t n_buffered = receive_buffer.Buffered();
+			const byte_t* const lf = n_scanned < n_buffered ? (const byte_t*)memchr(head + n_scanned, '\n', n_buffered - n_scanned) : nullptr;
 
-			if(byte == '\n')
+			if(lf != nullptr)
 			{
-				if(line.Length() != 0 && line[-1] == '\r')
-					line.chars.Remove(-1);
+				n_line = lf - head;
+				EL_ERROR(n_line > header_char_limit, THttpProcessingException, EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, U"HTTP header line exceeds configured limit");
+				receive_buffer.Consume(n_line + 1);
+				n_scanned = 0;
+				if(n_line != 0 && head[n_line - 1] == '\r')
+					n_line--;
+				line = head;
 				return ELineResult::COMPLETE;
 			}
 
-			EL_ERROR(line.Length() >= header_char_limit, THttpProcessingException, EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, U"HTTP header line exceeds configured limit");
-			line += char32_t((u32_t)byte);
+			n_scanned = n_buffered;
+			EL_ERROR(n_buffered > header_char_limit, THttpProcessingException, EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, U"HTTP header line exceeds configured limit");
+
+			if(receive_buffer.Fill() == 0)
+			{
+				if(receive_buffer.OnInputReady() != nullptr)
+					return ELineResult::BLOCKED;
+				EL_ERROR(n_buffered != 0, THttpProcessingException, EStatus::BAD_REQUEST, U"unexpected EOF in HTTP header");
+				return ELineResult::EOF_REACHED;
+			}
 		}
 	}
 
-	void THttpRequestDecoder::ParseRequestLine()
+	void THttpRequestDecoder::ParseRequestLine(const byte_t* const line, const usys_t n_line)
 	{
-		header_size = line.Length();
-		EL_ERROR(line.Length() < 14U, THttpProcessingException, EStatus::BAD_REQUEST, U"request too short");
-		auto arr_req = line.Split(' ', 3U);
-		EL_ERROR(arr_req.Count() != 3U, THttpProcessingException, EStatus::BAD_REQUEST, U"request METHOD/URL/VERSION malformed");
+		header_size = n_line;
+		EL_ERROR(n_line < 14U, THttpProcessingException, EStatus::BAD_REQUEST, U"request too short");
+		const byte_t* const end = line + n_line;
+		const byte_t* const sp1 = (const byte_t*)memchr(line, ' ', n_line);
+		const byte_t* const sp2 = sp1 == nullptr ? nullptr : (const byte_t*)memchr(sp1 + 1, ' ', end - sp1 - 1);
+		EL_ERROR(sp2 == nullptr, THttpProcessingException, EStatus::BAD_REQUEST, U"request METHOD/URL/VERSION malformed");
+
 		request = request_t{};
 		request.remote_address = remote_address;
-		request.method = MethodFromString(arr_req[0]);
-		request.version = VersionFromString(arr_req[2]);
-		try { ValidateRequestTarget(arr_req[1]); }
-		catch(const IException&) { EL_THROW(THttpProcessingException, EStatus::BAD_REQUEST, U"invalid request target"); }
-		request.url = std::move(arr_req[1]);
+		request.method = MethodFromBytes(line, sp1 - line);
+		request.version = VersionFromBytes(sp2 + 1, end - sp2 - 1);
 
-		const usys_t pos_args = request.url.Find('?');
+		const byte_t* const target = sp1 + 1;
+		const usys_t n_target = sp2 - target;
+		EL_ERROR(n_target == 0, THttpProcessingException, EStatus::BAD_REQUEST, U"invalid request target");
+		for(usys_t i = 0; i < n_target; i++)
+			EL_ERROR(target[i] <= 0x20 || target[i] == 0x7f, THttpProcessingException, EStatus::BAD_REQUEST, U"invalid request target");
+
+		const TString str_target = StringFromBytes(target, n_target);
+		const TStringView view_target = str_target;
+		TStringView path = view_target;
+
+		const usys_t pos_args = view_target.Find('?');
 		if(pos_args != NEG1)
 		{
 			EL_ERROR(pos_args == 0, THttpProcessingException, EStatus::BAD_REQUEST, U"empty URL");
-			TList<TString> arg_strs = request.url.SliceSL(pos_args + 1).Split('&');
-			for(auto& arg : arg_strs)
+			path = view_target.SliceBE(0, pos_args);
+			TStringView args = view_target.SliceSL(pos_args + 1);
+			for(;;)
 			{
+				const usys_t pos_amp = args.Find('&');
+				const TStringView arg = pos_amp == NEG1 ? args : args.SliceBE(0, pos_amp);
 				EL_ERROR(arg.Length() == 0, THttpProcessingException, EStatus::BAD_REQUEST, U"empty request parameter");
-				if(arg.Contains('='))
-				{
-					auto kv = arg.SplitKV('=');
-					request.args.Add(UrlDecode(std::move(kv.key)), UrlDecode(std::move(kv.value)));
-				}
+
+				const usys_t pos_eq = arg.Find('=');
+				if(pos_eq != NEG1)
+					request.args.Add(UrlDecode(arg.SliceBE(0, pos_eq)), UrlDecode(arg.SliceSL(pos_eq + 1)));
 				else
-					request.args.Add(UrlDecode(std::move(arg)), U"");
+					request.args.Add(UrlDecode(arg), U"");
+
+				if(pos_amp == NEG1)
+					break;
+				args = args.SliceSL(pos_amp + 1);
 			}
-			request.url = request.url.SliceBE(0, pos_args);
 		}
 
-		request.url = UrlDecode(std::move(request.url));
+		request.url = UrlDecode(path);
 		try { ValidateDecodedRequestPath(request.url); }
 		catch(const IException&) { EL_THROW(THttpProcessingException, EStatus::BAD_REQUEST, U"invalid decoded request path"); }
 	}
 
-	void THttpRequestDecoder::ParseHeaderLine()
+	void THttpRequestDecoder::ParseHeaderLine(const byte_t* const line, const usys_t n_line)
 	{
-		header_size += line.Length();
+		header_size += n_line;
 		EL_ERROR(header_size > header_char_limit, THttpProcessingException, EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, U"HTTP request header exceeds configured limit");
-		auto fields = line.Split(':', 2U);
-		EL_ERROR(fields.Count() != 2U, THttpProcessingException, EStatus::BAD_REQUEST, U"invalid header field encountered");
-		try { ValidateHeaderField(fields[0], fields[1]); }
-		catch(const IException&) { EL_THROW(THttpProcessingException, EStatus::BAD_REQUEST, U"invalid header field encountered"); }
-		fields[0].ToLower();
-		fields[1].Trim();
-		TString* const existing_header = request.header_fields.Get(fields[0]);
+		const byte_t* const colon = (const byte_t*)memchr(line, ':', n_line);
+		EL_ERROR(colon == nullptr || colon == line, THttpProcessingException, EStatus::BAD_REQUEST, U"invalid header field encountered");
+
+		// the name is validated and lowercased, the value is trimmed, both without intermediate strings
+		const usys_t n_name = colon - line;
+		TString name;
+		name.chars.SetCount(n_name);
+		for(usys_t i = 0; i < n_name; i++)
+		{
+			EL_ERROR(!IsHeaderNameChar(line[i]), THttpProcessingException, EStatus::BAD_REQUEST, U"invalid header field encountered");
+			name.chars[i] = line[i] >= 'A' && line[i] <= 'Z' ? line[i] + ('a' - 'A') : line[i];
+		}
+
+		const byte_t* value = colon + 1;
+		const byte_t* value_end = line + n_line;
+		for(const byte_t* p = value; p < value_end; p++)
+			EL_ERROR(*p == '\r' || *p == 0, THttpProcessingException, EStatus::BAD_REQUEST, U"invalid header field encountered");
+		while(value < value_end && WHITESPACE_CHARS.Contains(*value))
+			value++;
+		while(value_end > value && WHITESPACE_CHARS.Contains(value_end[-1]))
+			value_end--;
+
+		TString* const existing_header = request.header_fields.Get(name);
 		if(existing_header == nullptr)
-			request.header_fields.Add(std::move(fields[0]), std::move(fields[1]));
+			request.header_fields.Add(std::move(name), StringFromBytes(value, value_end - value));
 		else
 		{
 			EL_ERROR(
-				fields[0] == U"content-length" || fields[0] == U"host" || fields[0] == U"authorization" || fields[0] == U"proxy-authorization",
+				name == U"content-length" || name == U"host" || name == U"authorization" || name == U"proxy-authorization",
 				THttpProcessingException, EStatus::BAD_REQUEST, U"duplicate singleton header field encountered"
 			);
-			*existing_header += fields[0] == U"cookie" ? TStringView(U"; ") : TStringView(U", ");
-			*existing_header += fields[1];
+			*existing_header += name == U"cookie" ? TStringView(U"; ") : TStringView(U", ");
+			*existing_header += StringFromBytes(value, value_end - value);
 		}
 	}
 
@@ -693,7 +983,7 @@ namespace el1::io::net::http
 
 		EL_ERROR(request.method == EMethod::TRACE, THttpProcessingException, EStatus::METHOD_NOT_ALLOWED, U"TRACE is not supported");
 		const usys_t effective_length = content_length == NEG1 ? 0 : content_length;
-		body.Reset(source, effective_length, chunked);
+		body.Reset(&receive_buffer, effective_length, chunked);
 		body_outstanding = chunked || effective_length != 0;
 		request.body = body_outstanding ? &body : nullptr;
 	}
@@ -713,7 +1003,9 @@ namespace el1::io::net::http
 
 		for(;;)
 		{
-			const ELineResult result = ReadLine();
+			const byte_t* line;
+			usys_t n_line;
+			const ELineResult result = ReadLine(line, n_line);
 			if(result == ELineResult::BLOCKED)
 				return 0;
 			if(result == ELineResult::EOF_REACHED)
@@ -725,23 +1017,20 @@ namespace el1::io::net::http
 
 			if(state == EState::REQUEST_LINE)
 			{
-				ParseRequestLine();
-				line = TString();
+				ParseRequestLine(line, n_line);
 				state = EState::HEADERS;
 				continue;
 			}
 
-			if(line.Length() != 0)
+			if(n_line != 0)
 			{
-				ParseHeaderLine();
-				line = TString();
+				ParseHeaderLine(line, n_line);
 				continue;
 			}
 
 			FinishHeaders();
 			arr_items[0] = std::move(request);
 			request = request_t{};
-			line = TString();
 			header_size = 0;
 			state = EState::REQUEST_LINE;
 			return 1;
@@ -752,7 +1041,13 @@ namespace el1::io::net::http
 	{
 		if(state == EState::EOF_REACHED || (body_outstanding && !body.Complete()))
 			return nullptr;
-		return source->OnInputReady();
+		return receive_buffer.OnInputReady();
+	}
+
+	void THttpRequestDecoder::Close()
+	{
+		state = EState::EOF_REACHED;
+		receive_buffer.Close();
 	}
 
 	void THttpResponseEncoder::WriteResponse(response_t& response, const bool suppress_body)
@@ -762,90 +1057,371 @@ namespace el1::io::net::http
 
 	EStatus THttpServer::HandleSingleRequest(ISource<byte_t>& source, ISink<byte_t>& sink, request_handler_t handler, const ipport_t remote_address)
 	{
-		bool response_in_progress = false;
-		try
-		{
-			THttpRequestDecoder decoder(source, remote_address);
-			THttpResponseEncoder encoder(sink);
-			request_t request;
-			for(;;)
-			{
-				if(decoder.Read(&request, 1) != 0)
-					break;
-				const IWaitable* const waitable = decoder.OnInputReady();
-				if(waitable == nullptr)
-					return EStatus::EOF;
-				waitable->WaitFor();
-			}
+		THttpRequestDecoder decoder(source, remote_address);
+		return HandleSingleRequest(decoder, sink, std::move(handler));
+	}
 
-			response_t response;
-			response.status = EStatus::INTERNAL_SERVER_ERROR;
-			response.version = request.version;
-			handler(request, response);
+	// collects small writes until Flush(), writes which do not fit go straight through
+	class TCoalescingSink final : public ISink<byte_t>
+	{
+		protected:
+			ISink<byte_t>* const sink;
+			TList<byte_t> buffer;
 
-			const bool request_body_consumed = request.body == nullptr || request.body->Complete();
-			const bool keep_alive = request.KeepAlive() && request_body_consumed;
-			if(!keep_alive)
-				response.header_fields.Set(U"Connection", U"close");
+		public:
+			static const usys_t CAPACITY = 16384U;
 
-			TFile* file = nullptr;
-			if(response.body != nullptr && response.header_fields.ContentLength() == NEG1 && (file = dynamic_cast<TFile*>(response.body.get())) != nullptr)
-				response.header_fields.ContentLength(file->Size() - file->Offset());
+			usys_t Write(const byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT
+			{
+				if(buffer.Count() + n_items_max > CAPACITY)
+				{
+					Flush();
+					if(n_items_max >= CAPACITY)
+						return sink->Write(arr_items, n_items_max);
+				}
+				buffer.Append(arr_items, n_items_max);
+				return n_items_max;
+			}
 
-			const bool close_for_http10_body = response.version == EVersion::HTTP10 && response.body != nullptr && response.header_fields.ContentLength() == NEG1;
-			response_in_progress = true;
-			encoder.WriteResponse(response, request.method == EMethod::HEAD);
-			if(!keep_alive || close_for_http10_body)
+			const IWaitable* OnOutputReady() const final override
 			{
-				source.Close();
-				sink.Close();
+				return buffer.Count() == 0 ? sink->OnOutputReady() : nullptr;
 			}
-			return response.status;
-		}
-		catch(const IException& e1)
-		{
-			if(EL_UNLIKELY(DEBUG))
-				e1.Print("THttpServer::HandleSingleRequest(): caught exception");
 
-			if(!response_in_progress)
+			// only with nothing buffered the kernel may write to the connection directly (sendfile/splice)
+			system::handle::handle_t Handle() final override
 			{
-				const THttpProcessingException* const http_error = dynamic_cast<const THttpProcessingException*>(&e1);
-				try
-				{
-					THttpResponseEncoder encoder(sink);
-					response_t response;
-					response.status = http_error != nullptr ? http_error->status : EStatus::INTERNAL_SERVER_ERROR;
-					response.version = EVersion::HTTP11;
-					response.header_fields.Set(U"Connection", U"close");
-					response_in_progress = true;
-					encoder.WriteResponse(response);
-				}
-				catch(const IException&)
+				return buffer.Count() == 0 ? sink->Handle() : system::handle::INVALID_HANDLE;
+			}
+
+			void Flush() final override
+			{
+				if(buffer.Count() != 0)
 				{
+					sink->WriteAll(buffer.Data(), buffer.Count());
+					buffer.Clear(NEG1);
 				}
-				source.Close();
-				sink.Close();
-				return http_error != nullptr ? http_error->status : EStatus::INTERNAL_SERVER_ERROR;
+				sink->Flush();
 			}
 
-			source.Close();
-			sink.Close();
-			return EStatus::INTERNAL_SERVER_ERROR;
+			void Close() final override
+			{
+				try { Flush(); }
+				catch(const IException&) {}
+				buffer.Clear();
+				sink->Close();
+			}
+
+			explicit TCoalescingSink(ISink<byte_t>& sink) : sink(&sink) {}
+	};
+
+	// weak comparison (RFC 9110 section 8.8.3.2), "W/" is ignored on both sides
+	static bool EntityTagListMatches(const TStringView list, const TStringView etag)
+	{
+		const TStringView opaque_etag = etag.BeginsWith(U"W/") ? etag.SliceSL(2) : etag;
+		return AnyListItem(list, [opaque_etag](const TStringView item) {
+			return item == U"*" || (item.BeginsWith(U"W/") ? item.SliceSL(2) : item) == opaque_etag;
+		});
+	}
+
+	static bool NotModified(const THttpServer::request_t& request, const THttpServer::response_t& response)
+	{
+		// If-Modified-Since is only considered without If-None-Match (RFC 9110 section 13.2.2)
+		const TString* const if_none_match = FindHeaderField(request.header_fields, U"If-None-Match");
+		if(if_none_match != nullptr)
+		{
+			const TString* const etag = FindHeaderField(response.header_fields, U"ETag");
+			return etag != nullptr && EntityTagListMatches(*if_none_match, *etag);
 		}
+
+		const TString* const if_modified_since = FindHeaderField(request.header_fields, U"If-Modified-Since");
+		const TString* const last_modified = FindHeaderField(response.header_fields, U"Last-Modified");
+		s64_t ts_since = 0;
+		s64_t ts_modified = 0;
+		return if_modified_since != nullptr && last_modified != nullptr && ParseHttpDate(*if_modified_since, ts_since) && ParseHttpDate(*last_modified, ts_modified) && ts_modified <= ts_since;
 	}
 
-	void THttpServer::FiberMain()
+	// a Range is only honored if the representation still is the one If-Range names, which needs a strong validator
+	static bool IfRangeMatches(const THttpServer::request_t& request, const THttpServer::response_t& response)
 	{
-		IF_DEBUG_PRINTF("THttpServer::FiberMain(): enter\n");
-		TList<std::unique_ptr<TFiber>> handlers;
-		u8_t cleanup_handlers = 0;
-		TMemoryWaitable<u8_t> wait_cleanup(&cleanup_handlers, nullptr, 0xff);
+		const TString* const if_range = FindHeaderField(request.header_fields, U"If-Range");
+		if(if_range == nullptr)
+			return true;
 
-		if(quic_server != nullptr)
-		{
-			for(;;)
-			{
-				auto connection = quic_server->TryAcceptConnection();
+		const TString* const validator = FindHeaderField(response.header_fields, if_range->BeginsWith(U"\"") ? TStringView(U"ETag") : TStringView(U"Last-Modified"));
+		return validator != nullptr && *validator == *if_range;
+	}
+
+	static bool ParseDecimal(const TStringView str, iosize_t& value)
+	{
+		if(str.Count() == 0)
+			return false;
+
+		value = 0;
+		for(const char32_t chr : str)
+		{
+			if(chr < '0' || chr > '9' || value > (NEG1 - (chr - '0')) / 10U)
+				return false;
+			value = value * 10U + (chr - '0');
+		}
+		return true;
+	}
+
+	enum class ERangeResult : u8_t
+	{
+		IGNORE,
+		UNSATISFIABLE,
+		SATISFIABLE,
+	};
+
+	// only a single range is served, a request for multiple ranges would need a multipart/byteranges body and gets the whole content instead
+	static ERangeResult ParseByteRange(const TStringView value, const iosize_t n_content, iosize_t& first, iosize_t& n_bytes)
+	{
+		if(value.Count() < 6 || !HeaderNameEquals(value.SliceSL(0, 6), U"bytes=") || value.Find(',') != NEG1)
+			return ERangeResult::IGNORE;
+
+		const TStringView spec = value.SliceSL(6);
+		const usys_t pos_dash = spec.Find('-');
+		if(pos_dash == NEG1)
+			return ERangeResult::IGNORE;
+		const TStringView str_first = spec.SliceSL(0, pos_dash);
+		const TStringView str_last = spec.SliceSL(pos_dash + 1);
+
+		// "-n" are the last n bytes
+		if(str_first.Count() == 0)
+		{
+			if(!ParseDecimal(str_last, n_bytes))
+				return ERangeResult::IGNORE;
+			if(n_bytes == 0 || n_content == 0)
+				return ERangeResult::UNSATISFIABLE;
+			n_bytes = util::Min(n_bytes, n_content);
+			first = n_content - n_bytes;
+			return ERangeResult::SATISFIABLE;
+		}
+
+		iosize_t last = NEG1;
+		if(!ParseDecimal(str_first, first) || (str_last.Count() != 0 && (!ParseDecimal(str_last, last) || last < first)))
+			return ERangeResult::IGNORE;
+		if(first >= n_content)
+			return ERangeResult::UNSATISFIABLE;
+
+		n_bytes = util::Min(last, n_content - 1U) - first + 1U;
+		return ERangeResult::SATISFIABLE;
+	}
+
+	// file bodies get their length, and answers to conditional and range requests (RFC 9110 section 13 and 14)
+	static void PrepareResponse(const THttpServer::request_t& request, THttpServer::response_t& response)
+	{
+		TFile* const file = response.body != nullptr ? dynamic_cast<TFile*>(response.body.get()) : nullptr;
+		THttpFileBody* const file_body = response.body != nullptr && file == nullptr ? dynamic_cast<THttpFileBody*>(response.body.get()) : nullptr;
+
+		iosize_t n_file = NEG1;
+		if(file != nullptr)
+		{
+			const iosize_t size = file->Size();
+			if(size != NEG1)
+				n_file = size - file->Offset();
+		}
+		else if(file_body != nullptr)
+			n_file = file_body->Remaining();
+
+		if(n_file != NEG1 && response.header_fields.ContentLength() == NEG1)
+			response.header_fields.ContentLength(n_file);
+
+		if(response.status != EStatus::OK || (request.method != EMethod::GET && request.method != EMethod::HEAD))
+			return;
+
+		if(NotModified(request, response))
+		{
+			response.status = EStatus::NOT_MODIFIED;
+			response.body.reset();
+			RemoveHeaderField(response.header_fields, U"Content-Length");
+			RemoveHeaderField(response.header_fields, U"Transfer-Encoding");
+			return;
+		}
+
+		if(n_file == NEG1 || response.header_fields.ContentLength() != n_file || FindHeaderField(response.header_fields, U"Content-Encoding") != nullptr || FindHeaderField(response.header_fields, U"Content-Range") != nullptr)
+			return;
+
+		if(FindHeaderField(response.header_fields, U"Accept-Ranges") == nullptr)
+			response.header_fields.Set(U"Accept-Ranges", U"bytes");
+
+		const TString* const range = FindHeaderField(request.header_fields, U"Range");
+		if(range == nullptr || request.method != EMethod::GET || !IfRangeMatches(request, response))
+			return;
+
+		iosize_t first = 0;
+		iosize_t n_bytes = 0;
+		switch(ParseByteRange(*range, n_file, first, n_bytes))
+		{
+			case ERangeResult::IGNORE:
+				return;
+
+			case ERangeResult::UNSATISFIABLE:
+				response.status = EStatus::RANGE_NOT_SATISFIABLE;
+				response.body.reset();
+				response.header_fields.ContentLength(0);
+				response.header_fields.Set(U"Content-Range", TString::Format(U"bytes */%d", (u64_t)n_file));
+				return;
+
+			case ERangeResult::SATISFIABLE:
+				response.status = EStatus::PARTIAL_CONTENT;
+				response.header_fields.ContentLength(n_bytes);
+				response.header_fields.Set(U"Content-Range", TString::Format(U"bytes %d-%d/%d", (u64_t)first, (u64_t)(first + n_bytes - 1U), (u64_t)n_file));
+				if(file != nullptr)
+					file->Offset(first, ESeekOrigin::CURRENT);
+				else
+					file_body->Select(first, n_bytes);
+				return;
+		}
+	}
+
+	// wait_for_input(waitable) blocks until the waitable is ready, false closes the connection without a response
+	template<typename W>
+	static EStatus ServeRequest(THttpRequestDecoder& decoder, ISink<byte_t>& sink, const THttpServer::request_handler_t& handler, W& wait_for_input, const bool last_request)
+	{
+		using request_t = THttpServer::request_t;
+		using response_t = THttpServer::response_t;
+
+		bool response_in_progress = false;
+		try
+		{
+			THttpResponseEncoder encoder(sink);
+			request_t request;
+			for(;;)
+			{
+				if(decoder.Read(&request, 1) != 0)
+					break;
+				const IWaitable* const waitable = decoder.OnInputReady();
+				if(waitable == nullptr)
+					return EStatus::EOF;
+				if(!wait_for_input(*waitable))
+				{
+					sink.Close();
+					decoder.Close();
+					return EStatus::EOF;
+				}
+			}
+
+			response_t response;
+			response.status = EStatus::INTERNAL_SERVER_ERROR;
+			response.version = request.version;
+			handler(request, response);
+
+			const bool request_body_consumed = request.body == nullptr || request.body->Complete();
+			const bool keep_alive = request.KeepAlive() && request_body_consumed && !last_request;
+			if(!keep_alive)
+				response.header_fields.Set(U"Connection", U"close");
+
+			PrepareResponse(request, response);
+
+			const bool close_for_http10_body = response.version == EVersion::HTTP10 && response.body != nullptr && response.header_fields.ContentLength() == NEG1;
+			response_in_progress = true;
+			encoder.WriteResponse(response, request.method == EMethod::HEAD);
+			if(!keep_alive || close_for_http10_body)
+			{
+				sink.Close();
+				decoder.Close();
+			}
+			return response.status;
+		}
+		catch(const IException& e1)
+		{
+			if(EL_UNLIKELY(THttpServer::DEBUG))
+				e1.Print("THttpServer: caught exception while serving a request");
+
+			if(!response_in_progress)
+			{
+				const THttpProcessingException* const http_error = dynamic_cast<const THttpProcessingException*>(&e1);
+				try
+				{
+					THttpResponseEncoder encoder(sink);
+					response_t response;
+					response.status = http_error != nullptr ? http_error->status : EStatus::INTERNAL_SERVER_ERROR;
+					response.version = EVersion::HTTP11;
+					response.header_fields.Set(U"Connection", U"close");
+					response_in_progress = true;
+					encoder.WriteResponse(response);
+				}
+				catch(const IException&)
+				{
+				}
+				sink.Close();
+				decoder.Close();
+				return http_error != nullptr ? http_error->status : EStatus::INTERNAL_SERVER_ERROR;
+			}
+
+			sink.Close();
+			decoder.Close();
+			return EStatus::INTERNAL_SERVER_ERROR;
+		}
+	}
+
+	EStatus THttpServer::HandleSingleRequest(THttpRequestDecoder& decoder, ISink<byte_t>& sink, request_handler_t handler)
+	{
+		auto wait_for_input = [](const IWaitable& waitable) { waitable.WaitFor(); return true; };
+		return ServeRequest(decoder, sink, handler, wait_for_input, false);
+	}
+
+	void THttpServer::HandleHttp1Connection(ISource<byte_t>& source, ISink<byte_t>& sink, request_handler_t handler, const ipport_t remote_address, const connection_limits_t limits)
+	{
+		THttpRequestDecoder decoder(source, remote_address);
+		TCoalescingSink output(sink);
+		TTime ts_idle;
+		TTime ts_request;
+
+		auto wait_for_input = [&](const IWaitable& on_input_ready)
+		{
+			// nothing more is pipelined, the responses collected so far go out before waiting
+			output.Flush();
+
+			const bool idle = decoder.Idle();
+			if(!idle && ts_request < 0)
+				ts_request = TTime::Now(EClock::MONOTONIC);
+
+			TTimeWaitable on_timeout(EClock::MONOTONIC, idle ? ts_idle + limits.idle_timeout : ts_request + limits.request_timeout);
+			TFiber::WaitForMany({ &on_input_ready, &on_timeout });
+			if(on_input_ready.IsReady())
+				return true;
+
+			EL_ERROR(!decoder.Idle(), THttpProcessingException, EStatus::REQUEST_TIMEOUT, U"request was not received in time");
+			return false;
+		};
+
+		try
+		{
+			for(usys_t n_requests = 1;; n_requests++)
+			{
+				ts_idle = TTime::Now(EClock::MONOTONIC);
+				ts_request = -1;
+				if(ServeRequest(decoder, output, handler, wait_for_input, n_requests == limits.max_requests) == EStatus::EOF)
+					break;
+			}
+
+			// the peer may close its side right after sending its last pipelined requests
+			output.Flush();
+		}
+		catch(const IException& e)
+		{
+			if(EL_UNLIKELY(DEBUG))
+				e.Print("THttpServer::HandleHttp1Connection(): caught exception");
+		}
+	}
+
+	static const usys_t ACCEPT_BATCH_MAX = 64;
+
+	void THttpServer::FiberMain()
+	{
+		IF_DEBUG_PRINTF("THttpServer::FiberMain(): enter\n");
+		TList<std::unique_ptr<TFiber>> handlers;
+		u8_t cleanup_handlers = 0;
+		TMemoryWaitable<u8_t> wait_cleanup(&cleanup_handlers, nullptr, 0xff);
+
+		if(quic_server != nullptr)
+		{
+			for(;;)
+			{
+				auto connection = quic_server->TryAcceptConnection();
 				if(connection == nullptr)
 				{
 					for(ssys_t i = handlers.Count() - 1; i >= 0; i--)
@@ -871,12 +1447,21 @@ namespace el1::io::net::http
 			}
 		}
 
+		// the backlog is drained on every wakeup, but after a batch of accepts the handlers of the new connections get to run
+		usys_t n_accepted = 0;
 		for(;;)
 		{
+			if(++n_accepted > ACCEPT_BATCH_MAX)
+			{
+				n_accepted = 1;
+				TFiber::Yield();
+			}
+
 			IF_DEBUG_PRINTF("calling AcceptClient()\n");
 			std::unique_ptr<IStreamClient> stream_client = stream_server->AcceptStreamClient();
 			if(stream_client == nullptr)
 			{
+				n_accepted = 0;
 				IF_DEBUG_PRINTF("no new client waiting, just cleaning up\n");
 				for(ssys_t i = handlers.Count() - 1; i >= 0; i--)
 					if(!handlers[i]->IsAlive())
@@ -891,46 +1476,65 @@ namespace el1::io::net::http
 				IF_DEBUG_PRINTF("waiting ...\n");
 				TFiber::WaitForMany({ &stream_server->OnClientConnect(), &wait_cleanup });
 			}
+			else if(pool != nullptr)
+			{
+				IF_DEBUG_PRINTF("accepted new client, handing it to the fiber pool\n");
+				// the connection fiber can outlive this server object, it gets its own copy of everything it needs
+				pool->Spawn([handler = this->handler, protocol = this->protocol, limits = this->connection_limits, stream_client = std::move(stream_client)]()
+				{
+					HandleStreamConnection(*stream_client, handler, protocol, limits);
+				});
+			}
 			else
 			{
 				IF_DEBUG_PRINTF("accepted new client, spawning handler\n");
 				handlers.MoveAppend(New<TFiber>([this, stream_client = std::move(stream_client), &cleanup_handlers]()
 				{
-					EProtocol connection_protocol = protocol;
-					if(connection_protocol == EProtocol::AUTO)
-					{
-						auto* const tls_client = dynamic_cast<tls::TClient*>(stream_client.get());
-						if(tls_client != nullptr)
-							tls_client->Negotiate();
-						connection_protocol = tls_client != nullptr && tls_client->ApplicationProtocol() == U"h2" ? EProtocol::HTTP2 : EProtocol::HTTP1;
-					}
-
-					if(connection_protocol == EProtocol::HTTP2)
-						HandleHttp2Connection(*stream_client, *stream_client, this->handler, stream_client->RemoteAddress());
-					else
-						while(HandleSingleRequest(*stream_client, *stream_client, this->handler, stream_client->RemoteAddress()) != EStatus::EOF);
-
+					HandleStreamConnection(*stream_client, this->handler, this->protocol, this->connection_limits);
 					cleanup_handlers = 1;
 				}));
 			}
 		}
 	}
 
-	THttpServer::THttpServer(IStreamServer* const stream_server, request_handler_t handler, const EProtocol protocol) :
-		stream_server(stream_server), quic_server(nullptr), handler(handler), protocol(protocol),
+	void THttpServer::HandleStreamConnection(IStreamClient& stream_client, request_handler_t handler, const EProtocol protocol, const connection_limits_t limits)
+	{
+		// responses are coalesced by HandleHttp1Connection(), so the tail of a large body must not wait for an ACK
+		if(auto* const tcp_client = dynamic_cast<TTcpClient*>(&stream_client))
+			tcp_client->NoDelay(true);
+		else if(auto* const tls_client = dynamic_cast<tls::TClient*>(&stream_client))
+			tls_client->NoDelay(true);
+
+		EProtocol connection_protocol = protocol;
+		if(connection_protocol == EProtocol::AUTO)
+		{
+			auto* const tls_client = dynamic_cast<tls::TClient*>(&stream_client);
+			if(tls_client != nullptr)
+				tls_client->Negotiate();
+			connection_protocol = tls_client != nullptr && tls_client->ApplicationProtocol() == U"h2" ? EProtocol::HTTP2 : EProtocol::HTTP1;
+		}
+
+		if(connection_protocol == EProtocol::HTTP2)
+			HandleHttp2Connection(stream_client, stream_client, handler, stream_client.RemoteAddress());
+		else
+			HandleHttp1Connection(stream_client, stream_client, handler, stream_client.RemoteAddress(), limits);
+	}
+
+	THttpServer::THttpServer(IStreamServer* const stream_server, request_handler_t handler, const EProtocol protocol, TFiberPool* const pool) :
+		stream_server(stream_server), quic_server(nullptr), handler(handler), protocol(protocol), pool(pool),
 		fiber(TFunction<void>(this, &THttpServer::FiberMain), true)
 	{
 		EL_ERROR(stream_server == nullptr, TInvalidArgumentException, "stream_server", "stream_server must not be null");
 		EL_ERROR(protocol == EProtocol::HTTP3, TInvalidArgumentException, "protocol", "HTTP/3 requires a QUIC server");
 	}
 
-	THttpServer::THttpServer(TTcpServer* const tcp_server, request_handler_t handler, const EProtocol protocol) :
-		THttpServer(static_cast<IStreamServer*>(tcp_server), std::move(handler), protocol)
+	THttpServer::THttpServer(TTcpServer* const tcp_server, request_handler_t handler, const EProtocol protocol, TFiberPool* const pool) :
+		THttpServer(static_cast<IStreamServer*>(tcp_server), std::move(handler), protocol, pool)
 	{
 	}
 
 	THttpServer::THttpServer(quic::TServer* const quic_server, request_handler_t handler) :
-		stream_server(nullptr), quic_server(quic_server), handler(std::move(handler)), protocol(EProtocol::HTTP3),
+		stream_server(nullptr), quic_server(quic_server), handler(std::move(handler)), protocol(EProtocol::HTTP3), pool(nullptr),
 		fiber(TFunction<void>(this, &THttpServer::FiberMain), true)
 	{
 		EL_ERROR(quic_server == nullptr, TInvalidArgumentException, "quic_server", "quic_server must not be null");
@@ -942,41 +1546,246 @@ namespace el1::io::net::http
 ");
 	}
 
-	static void WriteChunkedBody(ISource<byte_t>& source, ISink<byte_t>& sink)
+	void THttpShardedServer::ShardMain(const usys_t index)
 	{
-		byte_t buffer[4U * 1024U];
-		for(;;)
+		// a shard which cannot be pinned still has to accept the connections steered to its socket
+		if(steering)
 		{
-			const usys_t n = ReadSomeBlocking(source, buffer, sizeof(buffer));
-			if(n == 0)
-				break;
+			try { TThread::Self()->PinToCpu(cpus[index]); }
+			catch(const IException&) {}
+		}
 
-			char chunk_header[32];
-			const int n_header = snprintf(chunk_header, sizeof(chunk_header), "%zx\r\n", (size_t)n);
-			EL_ERROR(n_header <= 0 || (usys_t)n_header >= sizeof(chunk_header), TLogicException);
-			sink.WriteAll(reinterpret_cast<const byte_t*>(chunk_header), n_header);
-			sink.WriteAll(buffer, n);
-			sink.WriteAll(reinterpret_cast<const byte_t*>("\r\n"), 2);
+		THttpServer server(tcp_servers[index].get(), handler, config.protocol);
+		server.connection_limits = config.connection_limits;
+		TFiber::Self()->Stop();
+	}
+
+	ipport_t THttpShardedServer::LocalAddress() const
+	{
+		return tcp_servers[0]->LocalAddress();
+	}
+
+	THttpShardedServer::THttpShardedServer(const ipaddr_t bind_ip, const port_t port, THttpServer::request_handler_t handler) :
+		THttpShardedServer(bind_ip, port, std::move(handler), config_t())
+	{
+	}
+
+	THttpShardedServer::THttpShardedServer(const ipaddr_t bind_ip, const port_t port, THttpServer::request_handler_t handler, const config_t& config) :
+		handler(std::move(handler)), config(config), steering(false)
+	{
+		EL_ERROR(config.protocol == THttpServer::EProtocol::HTTP3, TInvalidArgumentException, "protocol", "HTTP/3 requires a QUIC server");
+		cpus = TThread::AllowedCpus();
+		const usys_t n_shards = config.n_shards != 0 ? config.n_shards : util::Max<usys_t>(1, cpus.Count());
+
+		// all sockets are bound before the first shard accepts, the first one picks the port if port == 0
+		for(usys_t i = 0; i < n_shards; i++)
+			tcp_servers.MoveAppend(New<TTcpServer>(bind_ip, i == 0 ? port : tcp_servers[0]->LocalAddress().port, true));
+
+		// a CPU with two shards would leave one of them without connections
+		if(config.steer_by_cpu && n_shards <= cpus.Count())
+			steering = tcp_servers[0]->SteerByCpu(cpus.Slice(0, n_shards));
+
+		for(usys_t i = 0; i < n_shards; i++)
+			threads.MoveAppend(New<TThread>(TString::Format(U"http-shard/%d", (int)i), TUniqueFunction<void>([this, i]() { ShardMain(i); })));
+	}
+
+	THttpShardedServer::~THttpShardedServer()
+	{
+		// stop all shards before joining the first one
+		for(auto& thread : threads)
+			thread->Shutdown();
+
+		threads.Clear();
+	}
+
+	void THttpFileBody::Select(const iosize_t first, const iosize_t n_bytes)
+	{
+		EL_ERROR(first > n_remaining || n_bytes > n_remaining - first, TInvalidArgumentException, "first", "range exceeds the remaining file body");
+		offset += first;
+		n_remaining = n_bytes;
+	}
+
+	usys_t THttpFileBody::Read(byte_t* const arr_items, const usys_t n_items_max)
+	{
+		if(n_remaining == 0)
+			return 0;
+
+		const usys_t n_read = file->ReadAt(offset, arr_items, (usys_t)util::Min<iosize_t>(n_items_max, n_remaining));
+		EL_ERROR(n_read == 0 && n_items_max != 0, TException, U"file was truncated while it was being sent");
+		offset += n_read;
+		n_remaining -= n_read;
+		return n_read;
+	}
+
+	iosize_t THttpFileBody::WriteOut(ISink<byte_t>& sink, const iosize_t n_items_max, const bool)
+	{
+		const iosize_t n_written = file->WriteOutAt(offset, sink, util::Min(n_items_max, n_remaining));
+		offset += n_written;
+		n_remaining -= n_written;
+		return n_written;
+	}
+
+	THttpFileBody::THttpFileBody(std::shared_ptr<const TFile> file, const iosize_t offset, const iosize_t n_bytes) : file(std::move(file)), offset(offset), n_remaining(n_bytes)
+	{
+		EL_ERROR(this->file == nullptr, TInvalidArgumentException, "file", "file must not be null");
+	}
+
+	/**************************************************************************/
+
+	// the least recently used entry is found by a scan, which only happens when a new file is opened while the cache is full
+	void THttpFileCache::Evict()
+	{
+		const TString* victim = nullptr;
+		u64_t last_use = NEG1;
+		for(const auto& entry : entries)
+			if(entry.value.last_use < last_use)
+			{
+				victim = &entry.key;
+				last_use = entry.value.last_use;
+			}
+
+		if(victim != nullptr)
+		{
+			const TString key = *victim;
+			entries.Remove(key);
 		}
+	}
 
-		sink.WriteAll(reinterpret_cast<const byte_t*>("0\r\n\r\n"), 5);
+	static bool SameFile(const THttpFileCache::file_t& file, const direntry_t& info)
+	{
+		return info.type == EObjectType::FILE && info.obj_id == file.obj_id && info.size == file.size && info.ts_write == file.ts_write;
 	}
 
-	static void AddResponseHeader(THttpClient::response_header_t& response, TString name, TString value)
+	std::shared_ptr<const THttpFileCache::file_t> THttpFileCache::Open(const TPath& path)
 	{
-		response.header_lines.Append({ name, value });
-		TString* const existing = FindHeaderField(response.header_fields, name);
-		if(existing == nullptr)
+		const TString key = path;
+		const TTime ts_now = TTime::Now(EClock::MONOTONIC);
+		std::shared_ptr<const file_t> stale;
 		{
-			response.header_fields.Add(std::move(name), std::move(value));
+			const TMutexAutoLock lock(&mutex);
+			entry_t* const entry = entries.Get(key);
+			if(entry != nullptr)
+			{
+				entry->last_use = ++n_uses;
+				if(ts_now - entry->ts_checked < revalidate_interval)
+					return entry->file;
+				stale = entry->file;
+			}
 		}
-		else if(!HeaderNameEquals(name, U"set-cookie"))
+
+		// the file-system is asked without holding the lock
+		const direntry_t info = path.QueryInfo();
+		if(stale != nullptr && SameFile(*stale, info))
 		{
-			*existing += U", ";
-			*existing += value;
+			const TMutexAutoLock lock(&mutex);
+			if(entry_t* const entry = entries.Get(key))
+				entry->ts_checked = ts_now;
+			return stale;
 		}
+
+		if(info.type != EObjectType::FILE)
+		{
+			const TMutexAutoLock lock(&mutex);
+			entries.Remove(key);
+			return nullptr;
+		}
+
+		// the validators are taken from the opened file, it might have been replaced after the path was checked
+		TFile opened_file(path, TAccess::RO);
+		const direntry_t opened = opened_file.QueryInfo();
+
+		char etag[48];
+		snprintf(etag, sizeof(etag), "\"%llx-%llx\"", (unsigned long long)opened.ts_write.Seconds(), (unsigned long long)opened.size);
+
+		std::shared_ptr<const file_t> result = New<file_t>(file_t{
+			.file = std::move(opened_file),
+			.obj_id = opened.obj_id,
+			.size = opened.size,
+			.ts_write = opened.ts_write,
+			.etag = etag,
+			.last_modified = FormatHttpDate(opened.ts_write.Seconds())
+		});
+		const TMutexAutoLock lock(&mutex);
+		if(entries.Get(key) == nullptr && entries.Count() >= max_open_files)
+			Evict();
+		entries.Set(key, entry_t{ .file = result, .ts_checked = ts_now, .last_use = ++n_uses });
+		return result;
 	}
 
+	void THttpFileCache::Respond(const TPath& path, THttpResponseEncoder::response_t& response)
+	{
+		const std::shared_ptr<const file_t> file = Open(path);
+		if(file == nullptr)
+		{
+			response.status = EStatus::NOT_FOUND;
+			return;
+		}
+
+		response.status = EStatus::OK;
+		response.header_fields.ContentLength(file->size);
+		response.header_fields.Set(U"ETag", file->etag);
+		response.header_fields.Set(U"Last-Modified", file->last_modified);
+		response.body = New<THttpFileBody>(std::shared_ptr<const TFile>(file, &file->file), 0, file->size);
+	}
+
+	usys_t THttpFileCache::Count() const
+	{
+		const TMutexAutoLock lock(&mutex);
+		return entries.Count();
+	}
+
+	void THttpFileCache::Clear()
+	{
+		const TMutexAutoLock lock(&mutex);
+		entries.Clear();
+	}
+
+	THttpFileCache::THttpFileCache(const usys_t max_open_files, const TTime revalidate_interval) : max_open_files(max_open_files), revalidate_interval(revalidate_interval)
+	{
+		EL_ERROR(max_open_files == 0, TInvalidArgumentException, "max_open_files", "max_open_files must not be zero");
+	}
+
+	// every chunk is framed and written with a single call, the first one together with what is pending (the response head)
+	static void WriteChunkedBody(ISource<byte_t>& source, ISink<byte_t>& sink, TList<byte_t> pending)
+	{
+		byte_t buffer[4U * 1024U];
+		usys_t n = source.Read(buffer, sizeof(buffer));
+		for(;;)
+		{
+			if(n == 0)
+			{
+				if(source.OnInputReady() == nullptr)
+					break;
+
+				// the body is not ready yet, what is pending must not wait for it
+				if(pending.Count() != 0)
+				{
+					sink.WriteAll(pending.Data(), pending.Count());
+					pending.Clear(NEG1);
+				}
+				sink.Flush();
+				n = ReadSomeBlocking(source, buffer, sizeof(buffer));
+				continue;
+			}
+
+			char chunk_header[32];
+			const int n_header = snprintf(chunk_header, sizeof(chunk_header), "%zx\r\n", (size_t)n);
+			EL_ERROR(n_header <= 0 || (usys_t)n_header >= sizeof(chunk_header), TLogicException);
+			pending.Append(reinterpret_cast<const byte_t*>(chunk_header), n_header);
+			pending.Append(buffer, n);
+			pending.Append(reinterpret_cast<const byte_t*>("\r\n"), 2);
+
+			// the last chunk goes out together with the terminating one
+			n = source.Read(buffer, sizeof(buffer));
+			if(n == 0 && source.OnInputReady() == nullptr)
+				break;
+			sink.WriteAll(pending.Data(), pending.Count());
+			pending.Clear(NEG1);
+		}
+
+		pending.Append(reinterpret_cast<const byte_t*>("0\r\n\r\n"), 5);
+		sink.WriteAll(pending.Data(), pending.Count());
+	}
 
 	static void ParseHeaderLine(const TStringView line, TString& name, TString& value)
 	{
@@ -1011,7 +1820,7 @@ namespace el1::io::net::http
 					TString name;
 					TString value;
 					ParseHeaderLine(line, name, value);
-					AddResponseHeader(response, std::move(name), std::move(value));
+					response.AddHeader(std::move(name), std::move(value));
 				}
 			}
 
@@ -1060,63 +1869,6 @@ namespace el1::io::net::http
 		return offset > 0 && host[offset - 1] == '.' && host.SliceSL(offset) == domain;
 	}
 
-	static s64_t DaysFromCivil(int year, const unsigned month, const unsigned day)
-	{
-		year -= month <= 2;
-		const int era = (year >= 0 ? year : year - 399) / 400;
-		const unsigned year_of_era = (unsigned)(year - era * 400);
-		const unsigned adjusted_month = month > 2 ? month - 3U : month + 9U;
-		const unsigned day_of_year = (153U * adjusted_month + 2U) / 5U + day - 1U;
-		const unsigned day_of_era = year_of_era * 365U + year_of_era / 4U - year_of_era / 100U + day_of_year;
-		return (s64_t)era * 146097 + (s64_t)day_of_era - 719468;
-	}
-
-	static bool AsciiEqualsIgnoreCase(const char* a, const char* b)
-	{
-		while(*a != '\0' && *b != '\0')
-		{
-			char ca = *a++;
-			char cb = *b++;
-			if(ca >= 'A' && ca <= 'Z')
-				ca = (char)(ca - 'A' + 'a');
-			if(cb >= 'A' && cb <= 'Z')
-				cb = (char)(cb - 'A' + 'a');
-			if(ca != cb)
-				return false;
-		}
-		return *a == *b;
-	}
-
-	static bool ParseCookieExpires(const TStringView value, s64_t& unix_time)
-	{
-		auto cstr = value.MakeCStr();
-		char weekday[4] = {};
-		char month_name[4] = {};
-		char zone[8] = {};
-		int day = 0;
-		int year = 0;
-		int hour = 0;
-		int minute = 0;
-		int second = 0;
-		if(sscanf(cstr.get(), "%3[^,], %d %3s %d %d:%d:%d %7s", weekday, &day, month_name, &year, &hour, &minute, &second, zone) != 8)
-			return false;
-
-		static const char* const MONTHS[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
-		unsigned month = 0;
-		for(unsigned i = 0; i < 12; i++)
-			if(AsciiEqualsIgnoreCase(month_name, MONTHS[i]))
-			{
-				month = i + 1;
-				break;
-			}
-
-		if(month == 0 || day < 1 || day > 31 || year < 1601 || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 60 || !AsciiEqualsIgnoreCase(zone, "GMT"))
-			return false;
-
-		unix_time = DaysFromCivil(year, month, (unsigned)day) * 86400 + hour * 3600 + minute * 60 + second;
-		return true;
-	}
-
 	static bool CookiePathMatches(const TStringView request_path, const TStringView cookie_path)
 	{
 		if(cookie_path == U"/")
@@ -1147,6 +1899,21 @@ namespace el1::io::net::http
 		return values;
 	}
 
+	void THttpClient::response_header_t::AddHeader(TString name, TString value)
+	{
+		header_lines.Append({ name, value });
+		TString* const existing = FindHeaderField(header_fields, name);
+		if(existing == nullptr)
+		{
+			header_fields.Add(std::move(name), std::move(value));
+		}
+		else if(!HeaderNameEquals(name, U"set-cookie"))
+		{
+			*existing += U", ";
+			*existing += value;
+		}
+	}
+
 	THttpClient::THttpClient(TString host, const port_t port) :
 		host(std::move(host)),
 		port(port),
@@ -1164,6 +1931,10 @@ namespace el1::io::net::http
 	{
 		EL_ERROR(this->host.Length() == 0, TInvalidArgumentException, "host", "host must not be empty");
 		EL_ERROR(port == 0, TInvalidArgumentException, "port", "port must not be zero");
+
+		// reconnects resume the session instead of repeating the full handshake
+		if(this->tls_config.session_cache == nullptr)
+			this->tls_config.session_cache = New<tls::TSessionCache>();
 	}
 
 	void THttpClient::Connect()
@@ -1269,7 +2040,7 @@ namespace el1::io::net::http
 			else if(attr_name == U"expires" && !has_max_age)
 			{
 				s64_t expires_unix = -1;
-				if(ParseCookieExpires(attr_value, expires_unix))
+				if(ParseHttpDate(attr_value, expires_unix))
 				{
 					cookie.expires_unix = expires_unix;
 					if(expires_unix <= system::time::TTime::Now().Seconds())
@@ -1457,7 +2228,7 @@ namespace el1::io::net::http
 					TString name;
 					TString value;
 					ParseHeaderLine(line, name, value);
-					AddResponseHeader(response, std::move(name), std::move(value));
+					response.AddHeader(std::move(name), std::move(value));
 				}
 
 				if(status_code < 100 || status_code >= 200 || status_code == 101)
@@ -1518,19 +2289,322 @@ namespace el1::io::net::http
 	}
 
 
+	static bool IdleConnectionUsable(IStreamClient& connection)
+	{
+		// nothing is expected on an idle HTTP/1.1 connection, the read notices when the server has closed it meanwhile
+		try
+		{
+			byte_t byte;
+			return connection.Read(&byte, 1) == 0 && connection.OnInputReady() != nullptr;
+		}
+		catch(const IException&)
+		{
+			return false;
+		}
+	}
+
+	// HTTP/2 wants lowercase field names and forbids the connection-specific ones (RFC 9113 8.2.2)
+	static THttpHeaderFields Http2RequestHeaders(const THttpClientPool::origin_t& origin, const THttpClient::request_t& request)
+	{
+		THttpHeaderFields headers;
+		for(const auto& field : request.header_fields.Items())
+		{
+			TString name = field.key;
+			name.ToLower();
+			if(name == U"connection" || name == U"keep-alive" || name == U"proxy-connection" || name == U"transfer-encoding" || name == U"upgrade" || name == U"content-length")
+				continue;
+			if(name == U"te" && !HeaderNameEquals(field.value, U"trailers"))
+				continue;
+			if(name == U"host")
+				headers.Set(U":authority", field.value);
+			else
+				headers.Set(std::move(name), field.value);
+		}
+
+		if(headers.Get(U":authority") == nullptr)
+		{
+			const bool default_port = origin.port == (origin.tls ? 443 : 80);
+			headers.Set(U":authority", default_port ? origin.host : TString::Format(U"%s:%d", origin.host, origin.port));
+		}
+		headers.Set(U":method", TString(MethodToString(request.method)));
+		headers.Set(U":scheme", origin.tls ? TString(U"https") : TString(U"http"));
+		headers.Set(U":path", request.url);
+		if(request.body != nullptr && request.content_length != NEG1)
+			headers.Set(U"content-length", TString::Format(U"%d", request.content_length));
+		return headers;
+	}
+
+	static THttpClientPool::config_t PoolConfig(THttpClientPool::config_t config)
+	{
+		EL_ERROR(config.max_connections_per_origin == 0, TInvalidArgumentException, "max_connections_per_origin", "at least one connection per origin is required");
+		EL_ERROR(config.max_streams_per_connection == 0, TInvalidArgumentException, "max_streams_per_connection", "at least one stream per connection is required");
+
+		// new connections to a known server resume the TLS session
+		if(config.tls.session_cache == nullptr)
+			config.tls.session_cache = New<tls::TSessionCache>();
+		return config;
+	}
+
+	THttpClientPool::origin_state_t& THttpClientPool::State(const origin_t& origin)
+	{
+		EL_ERROR(origin.host.Length() == 0, TInvalidArgumentException, "origin", "host must not be empty");
+		EL_ERROR(origin.port == 0, TInvalidArgumentException, "origin", "port must not be zero");
+
+		const TString key = TString::Format(U"%s://%s:%d", origin.tls ? TString(U"https") : TString(U"http"), origin.host, origin.port);
+		if(std::unique_ptr<origin_state_t>* const state = origins.Get(key))
+			return **state;
+
+		origin_state_t& state = *origins.Set(key, New<origin_state_t>());
+		if(!origin.tls)
+			state.protocol = config.http2_prior_knowledge ? EProtocol::HTTP2 : EProtocol::HTTP1;
+		else if(!config.http2)
+			state.protocol = EProtocol::HTTP1;
+		return state;
+	}
+
+	std::unique_ptr<IStreamClient> THttpClientPool::Connect(const origin_t& origin, EProtocol& protocol)
+	{
+		stats.n_connects++;
+
+		// requests are written in several parts, they must not wait for the ACK of the previous one
+		if(origin.tls)
+		{
+			tls::client_config_t tls_config = config.tls;
+			tls_config.application_protocols.Clear();
+			if(config.http2)
+				tls_config.application_protocols.Append(U"h2");
+			tls_config.application_protocols.Append(U"http/1.1");
+
+			auto client = New<tls::TClient>(origin.host, origin.port, std::move(tls_config));
+			client->NoDelay(true);
+			client->Negotiate();
+			protocol = client->ApplicationProtocol() == U"h2" ? EProtocol::HTTP2 : EProtocol::HTTP1;
+			return client;
+		}
+
+		auto client = New<TTcpClient>(origin.host, origin.port);
+		client->NoDelay(true);
+		protocol = config.http2_prior_knowledge ? EProtocol::HTTP2 : EProtocol::HTTP1;
+		return client;
+	}
+
+	THttpClientPool::response_t THttpClientPool::RequestHttp1(origin_state_t& state, std::unique_ptr<THttpClient> client, request_t& request, ISink<byte_t>* const response_body_sink, const usys_t body_limit)
+	{
+		response_t response;
+		try
+		{
+			response = client->Request(std::move(request), response_body_sink, body_limit);
+		}
+		catch(...)
+		{
+			// THttpClient::Request() closed the connection
+			Release(state, nullptr);
+			throw;
+		}
+		Release(state, std::move(client));
+		return response;
+	}
+
+	void THttpClientPool::Release(origin_state_t& state, std::unique_ptr<THttpClient> client)
+	{
+		// the client is dropped when the server did not keep the connection open
+		if(client != nullptr && client->connection != nullptr)
+		{
+			client->ClearCookies();
+			state.idle.MoveAppend(idle_t{ std::move(client), TTime::Now(EClock::MONOTONIC) });
+		}
+		else
+			state.n_connections--;
+		state.generation++;
+	}
+
+	THttpClientPool::response_t THttpClientPool::Request(const origin_t& origin, request_t request, ISink<byte_t>* const response_body_sink, const usys_t body_limit)
+	{
+		ValidateRequestTarget(request.url);
+		EL_ERROR(request.body == nullptr && request.content_length != 0, TInvalidArgumentException, "content_length", "non-zero content length requires a request body");
+		for(const auto& field : request.header_fields.Items())
+			ValidateHeaderField(field.key, field.value);
+
+		EvictIdle();
+		origin_state_t& state = State(origin);
+		bool connected = false;
+		bool waited = false;
+		for(;;)
+		{
+			if(state.http2 != nullptr)
+			{
+				if(!Http2Usable(*state.http2))
+				{
+					// streams still in flight hold their own reference to the session
+					state.http2.reset();
+					state.n_connections--;
+					state.generation++;
+					continue;
+				}
+
+				if(Http2HasCapacity(*state.http2))
+				{
+					const std::shared_ptr<http2_session_t> session = state.http2;
+					stats.n_http2_requests++;
+					if(!connected)
+						stats.n_reused++;
+					return RequestHttp2(*session, request, Http2RequestHeaders(origin, request), response_body_sink, body_limit);
+				}
+			}
+			else
+			{
+				// the most recently used connection is the least likely to have been closed by the server
+				while(state.idle.Count() != 0)
+				{
+					std::unique_ptr<THttpClient> client = std::move(state.idle[state.idle.Count() - 1U].client);
+					state.idle.Remove(state.idle.Count() - 1U);
+					if(IdleConnectionUsable(*client->connection))
+					{
+						stats.n_reused++;
+						return RequestHttp1(state, std::move(client), request, response_body_sink, body_limit);
+					}
+					state.n_connections--;
+					stats.n_evicted++;
+				}
+
+				// until the first connection told whether the origin speaks HTTP/2 only one is established
+				const bool may_connect = state.protocol == EProtocol::HTTP1 ? state.n_connections < config.max_connections_per_origin : !state.connecting;
+				if(may_connect)
+				{
+					EProtocol protocol = EProtocol::UNKNOWN;
+					std::unique_ptr<IStreamClient> connection;
+					state.n_connections++;
+					state.connecting = true;
+					try
+					{
+						connection = Connect(origin, protocol);
+					}
+					catch(...)
+					{
+						state.n_connections--;
+						state.connecting = false;
+						state.generation++;
+						throw;
+					}
+					state.connecting = false;
+					state.protocol = protocol;
+					state.generation++;
+
+					if(protocol == EProtocol::HTTP2)
+					{
+						if(state.http2 == nullptr)
+						{
+							state.http2 = StartHttp2(std::move(connection), config.max_streams_per_connection, &state.generation);
+							connected = true;
+						}
+						else
+							state.n_connections--;	// raced with another fiber which already established one
+						continue;
+					}
+
+					std::unique_ptr<THttpClient> client = origin.tls ? New<THttpClient>(origin.host, origin.port, config.tls) : New<THttpClient>(origin.host, origin.port);
+					client->connection = std::move(connection);
+					return RequestHttp1(state, std::move(client), request, response_body_sink, body_limit);
+				}
+			}
+
+			if(!waited)
+			{
+				stats.n_waits++;
+				waited = true;
+			}
+			const u32_t generation = state.generation;
+			TMemoryWaitable<u32_t>(&state.generation, &generation, ~0U).WaitFor();
+		}
+	}
+
+	THttpClientPool::response_t THttpClientPool::Get(const origin_t& origin, TString url, ISink<byte_t>* const response_body_sink, const usys_t body_limit)
+	{
+		request_t request;
+		request.method = EMethod::GET;
+		request.url = std::move(url);
+		return Request(origin, std::move(request), response_body_sink, body_limit);
+	}
+
+	void THttpClientPool::EvictIdle()
+	{
+		const TTime ts_deadline = TTime::Now(EClock::MONOTONIC) - config.idle_timeout;
+		for(const auto& origin : origins)
+		{
+			origin_state_t& state = *origin.value;
+			while(state.idle.Count() != 0 && state.idle[0].ts_idle < ts_deadline)
+			{
+				state.idle.Remove(0);
+				state.n_connections--;
+				stats.n_evicted++;
+			}
+
+			TTime ts_idle;
+			if(state.http2 != nullptr && Http2Idle(*state.http2, ts_idle) && (ts_idle < ts_deadline || !Http2Usable(*state.http2)))
+			{
+				state.http2.reset();
+				state.n_connections--;
+				stats.n_evicted++;
+			}
+		}
+	}
+
+	void THttpClientPool::Clear()
+	{
+		for(const auto& origin : origins)
+		{
+			origin_state_t& state = *origin.value;
+			state.n_connections -= state.idle.Count();
+			state.idle.Clear();
+
+			TTime ts_idle;
+			if(state.http2 != nullptr && Http2Idle(*state.http2, ts_idle))
+			{
+				state.http2.reset();
+				state.n_connections--;
+			}
+			state.generation++;
+		}
+	}
+
+	usys_t THttpClientPool::CountConnections() const
+	{
+		usys_t n_connections = 0;
+		for(const auto& origin : origins)
+			n_connections += origin.value->n_connections;
+		return n_connections;
+	}
+
+	THttpClientPool::THttpClientPool() : THttpClientPool(config_t())
+	{
+	}
+
+	THttpClientPool::THttpClientPool(config_t config) : config(PoolConfig(std::move(config)))
+	{
+	}
+
+	THttpClientPool::~THttpClientPool()
+	{
+		Clear();
+	}
+
 	TString UrlDecode(const TStringView input)
 	{
-		TString url(input);
-		if(url.Length() == 0) return url;
-		const TString hex = U"0123456789abcdef";
-		for(usys_t i = 0; i + 2 < url.Length(); i++)
-			if(url[i] == '%')
+		const char32_t* const arr_chars = input.Data();
+		TList<byte_t> bytes;
+		bytes.SetCount(input.Length());
+		byte_t* const arr_bytes = bytes.Data();
+		usys_t n_bytes = 0;
+		for(usys_t i = 0; i < input.Length(); i++)
+			if(arr_chars[i] == '%' && i + 2 < input.Length())
 			{
-				auto str = url.SliceSL(i + 1, 2).ToLower().Reverse();
-				url.chars[i] = TBCD::FromString(str, hex).ToUnsignedInt();
-				url.chars.Remove(i + 1, 2);
+				arr_bytes[n_bytes++] = (byte_t)(HexDigit(arr_chars[i + 1]) * 16U + HexDigit(arr_chars[i + 2]));
+				i += 2;
 			}
-		return url.chars.Pipe().Map([](char32_t chr){ return (byte_t)chr; }).Transform(TUTF8Decoder()).Collect();
+			else
+				arr_bytes[n_bytes++] = (byte_t)arr_chars[i];
+		bytes.SetCount(n_bytes);
+		return DecodeUTF8(bytes);
 	}
 
 	TString UrlEncode(const TStringView url)
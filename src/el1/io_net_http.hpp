@@ -6,6 +6,7 @@
 #include "io_collection_list.hpp"
 #include "io_collection_map.hpp"
 #include "io_text_string.hpp"
+#include "io_file.hpp"
 #include "system_task.hpp"
 #include "system_waitable.hpp"
 #include "util_function.hpp"
@@ -30,11 +31,13 @@ namespace el1::io::net::http
 		ACCEPTED = 202,
 		NO_CONTENT = 204,
 		PARTIAL_CONTENT = 206,
+		NOT_MODIFIED = 304,
 		BAD_REQUEST = 400,
 		UNAUTHORIZED = 401,
 		FORBIDDEN = 403,
 		NOT_FOUND = 404,
 		METHOD_NOT_ALLOWED = 405,
+		REQUEST_TIMEOUT = 408,
 		CONFLICT = 409,
 		RANGE_NOT_SATISFIABLE = 416,
 		REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
@@ -166,7 +169,36 @@ namespace el1::io::net::http
 		public:
 			using request_t = THttpRequest;
 
+			// the connection is read in chunks of this size (or the header limit, whichever is larger)
+			static const usys_t RECEIVE_BUFFER_SIZE = 16384U;
+
 		protected:
+			// the request bodies and pipelined requests are served from the bytes left over in the buffer before the connection is read again
+			class TReceiveBuffer final : public stream::ISource<byte_t>
+			{
+				protected:
+					collection::list::TList<byte_t> buffer;
+					usys_t pos_head = 0;
+					usys_t pos_tail = 0;
+
+				public:
+					stream::ISource<byte_t>* const source;
+
+					const byte_t* Head() const EL_GETTER { return buffer.Data() + pos_head; }
+					usys_t Buffered() const EL_GETTER { return pos_tail - pos_head; }
+					void Consume(const usys_t n_bytes) { pos_head += n_bytes; }
+
+					// moves the buffered bytes to the front and reads as much as fits behind them, returns the number of bytes read
+					// invalidates pointers obtained from Head()
+					usys_t Fill();
+
+					usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
+					const system::waitable::IWaitable* OnInputReady() const final override;
+					void Close() final override;
+
+					TReceiveBuffer(stream::ISource<byte_t>* const source, const usys_t size);
+			};
+
 			enum class EState : u8_t
 			{
 				REQUEST_LINE,
@@ -174,20 +206,21 @@ namespace el1::io::net::http
 				EOF_REACHED,
 			};
 
-			stream::ISource<byte_t>* const source;
+			TReceiveBuffer receive_buffer;
 			const ip::ipport_t remote_address;
 			const usys_t header_char_limit;
 			EState state = EState::REQUEST_LINE;
-			text::string::TString line;
+			usys_t n_scanned = 0;	// bytes of the incomplete line at Head() already known to contain no LF
 			request_t request;
 			THttpRequestBody body;
 			usys_t header_size = 0;
 			bool body_outstanding = false;
 
+			// the line points into the receive buffer and stays valid until the next call
 			enum class ELineResult : u8_t { COMPLETE, BLOCKED, EOF_REACHED };
-			ELineResult ReadLine();
-			void ParseRequestLine();
-			void ParseHeaderLine();
+			ELineResult ReadLine(const byte_t*& line, usys_t& n_line);
+			void ParseRequestLine(const byte_t* const line, const usys_t n_line);
+			void ParseHeaderLine(const byte_t* const line, const usys_t n_line);
 			void FinishHeaders();
 
 		public:
@@ -195,7 +228,14 @@ namespace el1::io::net::http
 
 			usys_t Read(request_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
 			const system::waitable::IWaitable* OnInputReady() const final override;
+			void Close() final override;
 			THttpRequestBody* ActiveBody() EL_GETTER { return body_outstanding ? &body : nullptr; }
+
+			// bytes received beyond the current request (e.g. pipelined requests)
+			usys_t Buffered() const EL_GETTER { return receive_buffer.Buffered(); }
+
+			// true while nothing of the next request has been received
+			bool Idle() const EL_GETTER { return state == EState::REQUEST_LINE && n_scanned == 0 && receive_buffer.Buffered() == 0; }
 	};
 
 	class THttpResponseEncoder
@@ -216,6 +256,90 @@ namespace el1::io::net::http
 			const system::waitable::IWaitable* OnOutputReady() const { return sink->OnOutputReady(); }
 	};
 
+	// a part of a file which can be shared between concurrent responses (see THttpFileCache)
+	// it is read at explicit positions and goes out with sendfile() when the connection has a kernel handle
+	class THttpFileBody final : public stream::ISource<byte_t>
+	{
+		protected:
+			std::shared_ptr<const file::TFile> file;
+			iosize_t offset;
+			iosize_t n_remaining;
+
+		public:
+			iosize_t Offset() const EL_GETTER { return offset; }
+			iosize_t Remaining() const EL_GETTER { return n_remaining; }
+
+			// narrows the body to n_bytes starting at first, both count from the current offset
+			void Select(const iosize_t first, const iosize_t n_bytes);
+
+			usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
+			iosize_t WriteOut(stream::ISink<byte_t>& sink, const iosize_t n_items_max = (iosize_t)-1, const bool allow_recursion = true) final override;
+
+			THttpFileBody(std::shared_ptr<const file::TFile> file, const iosize_t offset, const iosize_t n_bytes);
+	};
+
+	// keeps frequently requested files open along with their validators (ETag and Last-Modified)
+	// so serving a hot file costs neither open() nor stat() nor formatting dates
+	// it can be used from multiple threads at once
+	class THttpFileCache
+	{
+		public:
+			struct file_t
+			{
+				file::TFile file;
+				u64_t obj_id;
+				iosize_t size;
+				system::time::TTime ts_write;
+				text::string::TString etag;
+				text::string::TString last_modified;
+			};
+
+		protected:
+			struct entry_t
+			{
+				std::shared_ptr<const file_t> file;
+				system::time::TTime ts_checked;
+				u64_t last_use;
+			};
+
+			mutable system::task::TSimpleMutex mutex;
+			collection::map::THashMap<text::string::TString, entry_t> entries;
+			u64_t n_uses = 0;
+
+			void Evict();
+
+		public:
+			// the least recently used file is closed when another one would exceed this limit
+			const usys_t max_open_files;
+
+			// a cached file is used without asking the file-system for this long
+			// afterwards the path is checked again, so replaced or modified files are picked up
+			const system::time::TTime revalidate_interval;
+
+			// returns nullptr if path does not name a regular file
+			std::shared_ptr<const file_t> Open(const file::TPath& path);
+
+			// fills in a 200 response with Content-Length, ETag, Last-Modified and the file as body, or a 404 if there is no such file
+			// THttpServer answers conditional and range requests for it (304, 206, 416)
+			void Respond(const file::TPath& path, THttpResponseEncoder::response_t& response);
+
+			usys_t Count() const EL_GETTER;
+			void Clear();
+
+			THttpFileCache(const usys_t max_open_files = 1024U, const system::time::TTime revalidate_interval = 1);
+			THttpFileCache(const THttpFileCache&) = delete;
+	};
+
+	struct connection_limits_t
+	{
+		// an HTTP/1.x connection without a pending request is closed after this time
+		system::time::TTime idle_timeout = 5;
+		// a request head must be complete this long after its first part arrived, otherwise 408 is sent
+		system::time::TTime request_timeout = 10;
+		// the response to this request announces "Connection: close", NEG1 for no limit
+		usys_t max_requests = 1000;
+	};
+
 	class THttpServer
 	{
 		public:
@@ -233,14 +357,19 @@ namespace el1::io::net::http
 			using response_t = THttpResponseEncoder::response_t;
 			using request_handler_t = util::function::TFunction<void, const request_t&, response_t&>;
 
+			// applies to connections accepted afterwards
+			connection_limits_t connection_limits;
+
 		protected:
 			ip::IStreamServer* const stream_server;
 			quic::TServer* const quic_server;
 			request_handler_t handler;
 			const EProtocol protocol;
+			system::task::TFiberPool* const pool;
 			system::task::TFiber fiber;
 
 			void FiberMain();
+			static void HandleStreamConnection(ip::IStreamClient& stream_client, request_handler_t handler, const EProtocol protocol, const connection_limits_t limits);
 
 		public:
 			static EStatus HandleSingleRequest(
@@ -250,6 +379,23 @@ namespace el1::io::net::http
 				const ip::ipport_t remote_address = ip::ipport_t{}
 			);
 
+			// pipelined requests which were received along with this one stay in the decoder for the next call
+			static EStatus HandleSingleRequest(
+				THttpRequestDecoder& decoder,
+				stream::ISink<byte_t>& sink,
+				request_handler_t handler
+			);
+
+			// serves requests until the connection closes, pipelined requests are parsed from the buffer
+			// and their responses are collected until the next request has to be waited for
+			static void HandleHttp1Connection(
+				stream::ISource<byte_t>& source,
+				stream::ISink<byte_t>& sink,
+				request_handler_t handler,
+				const ip::ipport_t remote_address = ip::ipport_t{},
+				const connection_limits_t limits = connection_limits_t{}
+			);
+
 			static void HandleHttp2Connection(
 				stream::ISource<byte_t>& source,
 				stream::ISink<byte_t>& sink,
@@ -263,14 +409,59 @@ namespace el1::io::net::http
 				const ip::ipport_t remote_address = ip::ipport_t{}
 			);
 
-			THttpServer(ip::IStreamServer* const stream_server, request_handler_t handler, const EProtocol protocol = EProtocol::AUTO);
-			THttpServer(ip::TTcpServer* const tcp_server, request_handler_t handler, const EProtocol protocol = EProtocol::AUTO);
+			// with a pool the connections are handled by the worker threads of the pool, only accepting happens on the calling thread
+			// the handler is then called concurrently from multiple threads
+			THttpServer(ip::IStreamServer* const stream_server, request_handler_t handler, const EProtocol protocol = EProtocol::AUTO, system::task::TFiberPool* const pool = nullptr);
+			THttpServer(ip::TTcpServer* const tcp_server, request_handler_t handler, const EProtocol protocol = EProtocol::AUTO, system::task::TFiberPool* const pool = nullptr);
 			THttpServer(quic::TServer* const quic_server, request_handler_t handler);
 			~THttpServer();
 	};
 
+	// serves one port from several threads without handing connections between them
+	// every shard is a TThread with its own THttpServer, accepting from its own SO_REUSEPORT listening socket
+	// the kernel distributes new connections among the sockets, a connection stays on the shard which accepted it
+	// the handler is called concurrently from all shards
+	class THttpShardedServer
+	{
+		public:
+			struct config_t
+			{
+				usys_t n_shards = 0;	// 0 => one shard per CPU the constructing thread may run on (see TThread::AllowedCpus())
+				bool steer_by_cpu = false;	// shard i runs on the i-th allowed CPU and receives the connections which arrive on it, only with n_shards <= allowed CPUs
+				THttpServer::EProtocol protocol = THttpServer::EProtocol::AUTO;
+				connection_limits_t connection_limits;
+			};
+
+		protected:
+			THttpServer::request_handler_t handler;
+			const config_t config;
+			io::collection::list::TList<std::unique_ptr<ip::TTcpServer>> tcp_servers;
+			io::collection::list::TList<std::unique_ptr<system::task::TThread>> threads;
+			io::collection::list::TList<usys_t> cpus;	// allowed CPUs of the constructing thread, shard i is pinned to cpus[i] while steering
+			bool steering;
+
+			void ShardMain(const usys_t index);
+
+		public:
+			usys_t CountShards() const EL_GETTER { return tcp_servers.Count(); }
+
+			// false if steer_by_cpu was requested but the kernel does not support it or there are more shards than allowed CPUs
+			// (connections are then distributed by hash)
+			bool IsSteeringByCpu() const EL_GETTER { return steering; }
+
+			ip::ipport_t LocalAddress() const EL_GETTER;
+
+			// if port == 0 => random free port, shared by all shards
+			THttpShardedServer(const ip::ipaddr_t bind_ip, const ip::port_t port, THttpServer::request_handler_t handler);
+			THttpShardedServer(const ip::ipaddr_t bind_ip, const ip::port_t port, THttpServer::request_handler_t handler, const config_t& config);
+			THttpShardedServer(const THttpShardedServer&) = delete;
+			~THttpShardedServer();
+	};
+
 	class THttpClient
 	{
+		friend class THttpClientPool;
+
 		public:
 			struct cookie_t
 			{
@@ -301,6 +492,9 @@ namespace el1::io::net::http
 
 				const text::string::TString* FindHeader(const text::string::TStringView name) const EL_GETTER;
 				collection::list::TList<text::string::TString> FindHeaders(const text::string::TStringView name) const EL_GETTER;
+
+				// records the line and merges the value into header_fields (except for Set-Cookie)
+				void AddHeader(text::string::TString name, text::string::TString value);
 			};
 
 			struct response_t : response_header_t
@@ -365,6 +559,107 @@ namespace el1::io::net::http
 			void Close();
 	};
 
+	// keeps warm connections to any number of origins and shares them between the fibers of one thread
+	// HTTP/1.1 connections serve one request at a time, up to max_connections_per_origin of them per origin
+	// when an origin speaks HTTP/2 (ALPN "h2" over TLS, or prior knowledge for cleartext), all requests are
+	// multiplexed as concurrent streams over a single connection
+	// requests which find no free connection or stream wait until one becomes available
+	// unlike THttpClient the pool does not keep cookies
+	class THttpClientPool
+	{
+		public:
+			using request_t = THttpClient::request_t;
+			using response_t = THttpClient::response_t;
+
+			struct origin_t
+			{
+				text::string::TString host;
+				ip::port_t port = 443;
+				bool tls = true;
+			};
+
+			struct config_t
+			{
+				usys_t max_connections_per_origin = 8;	// HTTP/1.1 connections (in use and idle) per origin
+				usys_t max_streams_per_connection = 100;	// concurrent HTTP/2 streams, the server's SETTINGS_MAX_CONCURRENT_STREAMS may lower it
+				system::time::TTime idle_timeout = 30;	// idle connections are closed after this time
+				bool http2 = true;	// offer "h2" through ALPN on TLS connections
+				bool http2_prior_knowledge = false;	// speak HTTP/2 right away on cleartext connections (h2c)
+				tls::client_config_t tls;	// for TLS origins, application_protocols is set by the pool
+			};
+
+			struct stats_t
+			{
+				u64_t n_connects = 0;	// new connections
+				u64_t n_reused = 0;	// requests served on an existing connection (idle HTTP/1.1 or a further HTTP/2 stream)
+				u64_t n_http2_requests = 0;
+				u64_t n_waits = 0;	// requests which had to wait for a connection or stream
+				u64_t n_evicted = 0;	// idle connections closed by the pool (timeout or closed by the server)
+			};
+
+		protected:
+			struct http2_session_t;	// io_net_http2.cpp
+
+			enum class EProtocol : u8_t
+			{
+				UNKNOWN,
+				HTTP1,
+				HTTP2,
+			};
+
+			struct idle_t
+			{
+				std::unique_ptr<THttpClient> client;
+				system::time::TTime ts_idle;
+			};
+
+			struct origin_state_t
+			{
+				u32_t generation = 0;	// changes whenever a connection or stream is released, waiters watch it
+				EProtocol protocol = EProtocol::UNKNOWN;
+				bool connecting = false;
+				usys_t n_connections = 0;	// HTTP/1.1 connections in use, idle or being established, an HTTP/2 connection counts as one
+				collection::list::TList<idle_t> idle;	// least recently used first
+				std::shared_ptr<http2_session_t> http2;
+			};
+
+			collection::map::THashMap<text::string::TString, std::unique_ptr<origin_state_t>> origins;
+			stats_t stats;
+
+			origin_state_t& State(const origin_t& origin);
+			std::unique_ptr<ip::IStreamClient> Connect(const origin_t& origin, EProtocol& protocol);
+			static response_t RequestHttp1(origin_state_t& state, std::unique_ptr<THttpClient> client, request_t& request, stream::ISink<byte_t>* const response_body_sink, const usys_t body_limit);
+			static void Release(origin_state_t& state, std::unique_ptr<THttpClient> client);
+
+			// io_net_http2.cpp
+			static std::shared_ptr<http2_session_t> StartHttp2(std::unique_ptr<ip::IStreamClient> connection, const usys_t max_streams, u32_t* const generation);
+			static bool Http2Usable(const http2_session_t& session) EL_GETTER;	// false once the connection failed or the server sent GOAWAY
+			static bool Http2HasCapacity(const http2_session_t& session) EL_GETTER;
+			static bool Http2Idle(const http2_session_t& session, system::time::TTime& ts_idle);	// true if no stream is active, ts_idle tells since when
+			static response_t RequestHttp2(http2_session_t& session, const request_t& request, const THttpHeaderFields& headers, stream::ISink<byte_t>* const response_body_sink, const usys_t body_limit);
+
+		public:
+			const config_t config;
+
+			response_t Request(const origin_t& origin, request_t request, stream::ISink<byte_t>* const response_body_sink = nullptr, const usys_t body_limit = THttpClient::DEFAULT_RESPONSE_BODY_LIMIT);
+			response_t Get(const origin_t& origin, text::string::TString url, stream::ISink<byte_t>* const response_body_sink = nullptr, const usys_t body_limit = THttpClient::DEFAULT_RESPONSE_BODY_LIMIT);
+
+			// closes the connections which were idle for longer than config.idle_timeout, also done by every Request()
+			void EvictIdle();
+
+			// closes all idle connections, requests in flight keep theirs
+			void Clear();
+
+			usys_t CountConnections() const EL_GETTER;
+			const stats_t& Stats() const EL_GETTER { return stats; }
+
+			THttpClientPool();
+			explicit THttpClientPool(config_t config);
+			THttpClientPool(const THttpClientPool&) = delete;
+			THttpClientPool(THttpClientPool&&) = delete;
+			~THttpClientPool();
+	};
+
 	text::string::TString UrlDecode(text::string::TStringView url);
 	text::string::TString UrlEncode(text::string::TStringView url);
 }
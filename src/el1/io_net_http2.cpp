@@ -1,6 +1,7 @@
 #include "io_net_http.hpp"
 #include "io_collection_list.hpp"
 #include "system_task.hpp"
+#include "system_time.hpp"
 
 #include <nghttp2/nghttp2.h>
 #include <string.h>
@@ -12,6 +13,7 @@ namespace el1::io::net::http
 	using namespace io::stream;
 	using namespace io::text::string;
 	using namespace system::task;
+	using namespace system::time;
 	using namespace system::waitable;
 
 	namespace
@@ -63,6 +65,35 @@ namespace el1::io::net::http
 			request.url = UrlDecode(std::move(request.url));
 		}
 
+		// keeps the name/value bytes alive for as long as nghttp2 reads the nv array
+		class THttp2Fields
+		{
+			TList<nghttp2_nv> fields;
+			TList<TList<byte_t>> storage;
+
+			public:
+				explicit THttp2Fields(const usys_t n_fields) : fields(n_fields), storage(n_fields * 2U) {}
+
+				void Add(const TStringView name, const TStringView value)
+				{
+					auto name_cstr = name.MakeCStr();
+					auto value_cstr = value.MakeCStr();
+					TList<byte_t> name_data;
+					name_data.Append(reinterpret_cast<const byte_t*>(name_cstr.get()), strlen(name_cstr.get()));
+					TList<byte_t> value_data;
+					value_data.Append(reinterpret_cast<const byte_t*>(value_cstr.get()), strlen(value_cstr.get()));
+					storage.MoveAppend(std::move(name_data));
+					storage.MoveAppend(std::move(value_data));
+					const auto& n = storage[storage.Count() - 2U];
+					const auto& v = storage[storage.Count() - 1U];
+					nghttp2_nv field = { const_cast<u8_t*>(reinterpret_cast<const u8_t*>(n.ItemPtr(0))), const_cast<u8_t*>(reinterpret_cast<const u8_t*>(v.ItemPtr(0))), n.Count(), v.Count(), NGHTTP2_NV_FLAG_NONE };
+					fields.Append(field);
+				}
+
+				const nghttp2_nv* Data() const EL_GETTER { return fields.ItemPtr(0); }
+				usys_t Count() const EL_GETTER { return fields.Count(); }
+		};
+
 		class THttp2RequestBody final : public IHttpRequestBody
 		{
 			class TInputWaitable final : public IWaitable
@@ -328,32 +359,15 @@ namespace el1::io::net::http
 					return;
 				stream.response_submitted = true;
 
-				TList<nghttp2_nv> fields(response.header_fields.Items().Count() + 1U);
-				TList<TList<byte_t>> storage(response.header_fields.Items().Count() * 2U + 2U);
-				auto add_field = [&fields, &storage](const TStringView name, const TStringView value)
-				{
-					auto name_cstr = name.MakeCStr();
-					auto value_cstr = value.MakeCStr();
-					TList<byte_t> name_data;
-					name_data.Append(reinterpret_cast<const byte_t*>(name_cstr.get()), strlen(name_cstr.get()));
-					TList<byte_t> value_data;
-					value_data.Append(reinterpret_cast<const byte_t*>(value_cstr.get()), strlen(value_cstr.get()));
-					storage.MoveAppend(std::move(name_data));
-					storage.MoveAppend(std::move(value_data));
-					const auto& n = storage[storage.Count() - 2U];
-					const auto& v = storage[storage.Count() - 1U];
-					nghttp2_nv field = { const_cast<u8_t*>(reinterpret_cast<const u8_t*>(n.ItemPtr(0))), const_cast<u8_t*>(reinterpret_cast<const u8_t*>(v.ItemPtr(0))), n.Count(), v.Count(), NGHTTP2_NV_FLAG_NONE };
-					fields.Append(field);
-				};
-
-				add_field(U":status", TString::Format(U"%d", static_cast<u16_t>(response.status)));
+				THttp2Fields fields(response.header_fields.Items().Count() + 1U);
+				fields.Add(U":status", TString::Format(U"%d", static_cast<u16_t>(response.status)));
 				for(const auto& field : response.header_fields.Items())
 				{
 					TString name = field.key;
 					name.ToLower();
 					if(name == U"connection" || name == U"transfer-encoding" || name == U"keep-alive" || name == U"upgrade")
 						continue;
-					add_field(name, field.value);
+					fields.Add(name, field.value);
 				}
 
 				const bool suppress_body = stream.request.method == EMethod::HEAD;
@@ -366,7 +380,7 @@ namespace el1::io::net::http
 					provider.read_callback = &ReadResponseData;
 					provider_ptr = &provider;
 				}
-				const int result = nghttp2_submit_response(session, stream.id, fields.ItemPtr(0), fields.Count(), provider_ptr);
+				const int result = nghttp2_submit_response(session, stream.id, fields.Data(), fields.Count(), provider_ptr);
 				EL_ERROR(result != 0, TException, U"nghttp2_submit_response failed");
 				wakeup = 1;
 			}
@@ -512,4 +526,412 @@ namespace el1::io::net::http
 		auto connection = el1::New<THttp2Connection>(source, sink, std::move(handler), remote_address);
 		connection->Run();
 	}
+
+	// client side of a pooled HTTP/2 connection
+	// a fiber runs the connection I/O, the requesting fibers submit their streams and wait for the response
+	// nghttp2 is only ever called from fibers of the owning thread and none of its callbacks blocks
+	struct THttpClientPool::http2_session_t
+	{
+		struct stream_t
+		{
+			const request_t& request;
+			s32_t id = -1;
+			response_t response;
+			TList<byte_t> body;	// received but not yet passed on to the sink
+			usys_t n_request_body_remaining;
+			usys_t header_size = 0;
+			u32_t error_code = NGHTTP2_NO_ERROR;
+			u32_t signal = 0;	// changes with every event the requesting fiber waits for
+			bool has_status = false;
+			bool request_body_deferred = false;
+			bool closed = false;
+
+			explicit stream_t(const request_t& request) : request(request), n_request_body_remaining(request.body == nullptr ? 0U : request.content_length) {}
+		};
+
+		static constexpr usys_t HEADER_LIMIT = 64U * 1024U;
+		static constexpr s32_t STREAM_WINDOW = 256 * 1024;
+		static constexpr s32_t CONNECTION_WINDOW = 4 * 1024 * 1024;
+
+		std::unique_ptr<IStreamClient> connection;
+		nghttp2_session* session = nullptr;
+		const usys_t max_streams;
+		u32_t* const generation;
+		TList<stream_t*> streams;	// active streams, owned by the requesting fibers
+		TList<byte_t> output;
+		TTime ts_idle;
+		u8_t wakeup = 0;
+		TMemoryWaitable<u8_t> wakeup_waitable;
+		bool failed = false;
+		TString failure;
+		std::unique_ptr<TFiber> fiber;
+
+		static stream_t* FindStream(nghttp2_session* const session, const s32_t stream_id)
+		{
+			return static_cast<stream_t*>(nghttp2_session_get_stream_user_data(session, stream_id));
+		}
+
+		static int OnHeader(nghttp2_session* const session, const nghttp2_frame* const frame, const u8_t* const name, const size_t name_len, const u8_t* const value, const size_t value_len, u8_t, void*)
+		{
+			stream_t* const stream = frame->hd.type == NGHTTP2_HEADERS ? FindStream(session, frame->hd.stream_id) : nullptr;
+			if(stream == nullptr)
+				return 0;
+
+			stream->header_size += name_len + value_len;
+			if(stream->header_size > HEADER_LIMIT)
+				return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+
+			try
+			{
+				TString str_name = Http2String(name, name_len);
+				TString str_value = Http2String(value, value_len);
+				if(str_name == U":status")
+				{
+					// informational (1xx) responses are followed by the final one
+					stream->response.status = static_cast<EStatus>((u16_t)str_value.ToInteger());
+					stream->response.header_fields.Clear();
+					stream->response.header_lines.Clear();
+					stream->has_status = true;
+				}
+				else if(str_name[0] != ':')
+					stream->response.AddHeader(std::move(str_name), std::move(str_value));	// includes the trailers
+			}
+			catch(const IException&)
+			{
+				return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+			}
+			return 0;
+		}
+
+		static int OnDataChunk(nghttp2_session* const session, u8_t, const s32_t stream_id, const u8_t* const data, const size_t len, void*)
+		{
+			stream_t* const stream = FindStream(session, stream_id);
+			if(stream != nullptr)
+			{
+				stream->body.Append(reinterpret_cast<const byte_t*>(data), len);
+				stream->signal++;
+			}
+			else
+				(void)nghttp2_session_consume(session, stream_id, len);	// a cancelled stream, keep the connection window open
+			return 0;
+		}
+
+		static int OnStreamClose(nghttp2_session* const session, const s32_t stream_id, const u32_t error_code, void*)
+		{
+			stream_t* const stream = FindStream(session, stream_id);
+			if(stream != nullptr)
+			{
+				stream->closed = true;
+				stream->error_code = error_code;
+				stream->signal++;
+			}
+			return 0;
+		}
+
+		static ssize_t ReadRequestData(nghttp2_session* const session, const s32_t stream_id, u8_t* const buffer, const size_t length, u32_t* const data_flags, nghttp2_data_source*, void*)
+		{
+			stream_t* const stream = FindStream(session, stream_id);
+			if(stream == nullptr)
+				return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+
+			ISource<byte_t>& body = *stream->request.body;
+			const usys_t n_max = util::Min((usys_t)length, stream->n_request_body_remaining);
+			if(n_max != 0)
+			{
+				try
+				{
+					const usys_t n = body.Read(reinterpret_cast<byte_t*>(buffer), n_max);
+					if(n != 0)
+					{
+						if(stream->n_request_body_remaining != NEG1)
+							stream->n_request_body_remaining -= n;
+						return static_cast<ssize_t>(n);
+					}
+				}
+				catch(const IException&)
+				{
+					return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+				}
+
+				if(body.OnInputReady() != nullptr)
+				{
+					stream->request_body_deferred = true;
+					return NGHTTP2_ERR_DEFERRED;
+				}
+
+				// the body ended before content_length bytes
+				if(stream->n_request_body_remaining != NEG1)
+					return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+			}
+
+			*data_flags |= NGHTTP2_DATA_FLAG_EOF;
+			return 0;
+		}
+
+		void ResumeDeferredBodies()
+		{
+			for(stream_t* const stream : streams)
+			{
+				if(!stream->request_body_deferred)
+					continue;
+				const IWaitable* const waitable = stream->request.body->OnInputReady();
+				if(waitable == nullptr || waitable->IsReady())
+				{
+					stream->request_body_deferred = false;
+					const int result = nghttp2_session_resume_data(session, stream->id);
+					EL_ERROR(result != 0, TException, U"nghttp2_session_resume_data failed");
+				}
+			}
+		}
+
+		void FlushOutput(bool& progress)
+		{
+			if(output.Count() == 0)
+			{
+				const u8_t* data = nullptr;
+				const ssize_t size = nghttp2_session_mem_send(session, &data);
+				EL_ERROR(size < 0, TException, U"nghttp2_session_mem_send failed");
+				if(size > 0)
+					output.Append(reinterpret_cast<const byte_t*>(data), size);
+			}
+			if(output.Count() != 0)
+			{
+				const usys_t n = connection->Write(output.ItemPtr(0), output.Count());
+				if(n != 0)
+				{
+					output.Remove(0, n);
+					progress = true;
+				}
+			}
+		}
+
+		void Run()
+		{
+			byte_t input[16U * 1024U];
+			for(;;)
+			{
+				bool progress = false;
+				ResumeDeferredBodies();
+				FlushOutput(progress);
+
+				if(nghttp2_session_want_read(session))
+				{
+					const usys_t n = connection->Read(input, sizeof(input));
+					if(n != 0)
+					{
+						const ssize_t consumed = nghttp2_session_mem_recv(session, reinterpret_cast<const u8_t*>(input), n);
+						EL_ERROR(consumed < 0 || static_cast<usys_t>(consumed) != n, TException, U"invalid HTTP/2 input");
+						progress = true;
+					}
+					else if(connection->OnInputReady() == nullptr)
+						return;
+				}
+
+				FlushOutput(progress);
+				if(!nghttp2_session_want_read(session) && !nghttp2_session_want_write(session) && output.Count() == 0)
+					return;
+				if(progress)
+					continue;
+
+				wakeup = 0;
+				TList<const IWaitable*> waitables;
+				waitables.Append(&wakeup_waitable);
+				if(nghttp2_session_want_read(session))
+					if(const IWaitable* const waitable = connection->OnInputReady(); waitable != nullptr)
+						waitables.Append(waitable);
+				if(output.Count() != 0)
+					if(const IWaitable* const waitable = connection->OnOutputReady(); waitable != nullptr)
+						waitables.Append(waitable);
+				for(stream_t* const stream : streams)
+					if(stream->request_body_deferred)
+						if(const IWaitable* const waitable = stream->request.body->OnInputReady(); waitable != nullptr)
+							waitables.Append(waitable);
+				TFiber::WaitForMany(waitables);
+			}
+		}
+
+		// the connection is gone, all active streams fail
+		void Fail(TString reason)
+		{
+			failed = true;
+			failure = std::move(reason);
+			for(stream_t* const stream : streams)
+				if(!stream->closed)
+				{
+					stream->closed = true;
+					stream->error_code = NGHTTP2_CONNECT_ERROR;
+					stream->signal++;
+				}
+			(*generation)++;
+		}
+
+		void Main()
+		{
+			try
+			{
+				Run();
+				Fail(U"HTTP/2 connection was closed");
+			}
+			catch(shutdown_t)
+			{
+			}
+			catch(const IException& exception)
+			{
+				Fail(exception.Message());
+			}
+		}
+
+		void Attach(stream_t& stream)
+		{
+			streams.Append(&stream);
+			wakeup = 1;
+		}
+
+		// cancels the stream if it is still open (the requesting fiber gave up)
+		void Detach(stream_t& stream)
+		{
+			if(!stream.closed && !failed)
+			{
+				nghttp2_session_set_stream_user_data(session, stream.id, nullptr);
+				(void)nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, stream.id, NGHTTP2_CANCEL);
+				wakeup = 1;
+			}
+			streams.RemoveItem(&stream);
+			if(streams.Count() == 0)
+				ts_idle = TTime::Now(EClock::MONOTONIC);
+			(*generation)++;
+		}
+
+		bool Usable() const
+		{
+			return !failed && nghttp2_session_check_request_allowed(session) != 0;
+		}
+
+		bool HasCapacity() const
+		{
+			const usys_t remote_limit = nghttp2_session_get_remote_settings(session, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+			return streams.Count() < util::Min(max_streams, remote_limit);
+		}
+
+		http2_session_t(std::unique_ptr<IStreamClient> connection, const usys_t max_streams, u32_t* const generation) :
+			connection(std::move(connection)), max_streams(max_streams), generation(generation),
+			ts_idle(TTime::Now(EClock::MONOTONIC)), wakeup_waitable(&wakeup, nullptr, 0xff)
+		{
+			nghttp2_session_callbacks* callbacks = nullptr;
+			EL_ERROR(nghttp2_session_callbacks_new(&callbacks) != 0, TException, U"failed to allocate nghttp2 callbacks");
+			nghttp2_session_callbacks_set_on_header_callback(callbacks, &OnHeader);
+			nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &OnDataChunk);
+			nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &OnStreamClose);
+			nghttp2_option* options = nullptr;
+			EL_ERROR(nghttp2_option_new(&options) != 0, TException, U"failed to allocate nghttp2 options");
+			// the window only opens again once the requesting fiber took the data, a slow sink throttles its stream
+			nghttp2_option_set_no_auto_window_update(options, 1);
+			const int create_result = nghttp2_session_client_new2(&session, callbacks, this, options);
+			nghttp2_option_del(options);
+			nghttp2_session_callbacks_del(callbacks);
+			EL_ERROR(create_result != 0, TException, U"failed to create nghttp2 client session");
+
+			const nghttp2_settings_entry settings[] = {
+				{ NGHTTP2_SETTINGS_ENABLE_PUSH, 0U },
+				{ NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, (u32_t)STREAM_WINDOW },
+				{ NGHTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, (u32_t)HEADER_LIMIT },
+			};
+			EL_ERROR(nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, sizeof(settings) / sizeof(settings[0])) != 0, TException, U"failed to submit HTTP/2 SETTINGS");
+			EL_ERROR(nghttp2_session_set_local_window_size(session, NGHTTP2_FLAG_NONE, 0, CONNECTION_WINDOW) != 0, TException, U"failed to set the HTTP/2 connection window");
+
+			fiber = el1::New<TFiber>([this]() { Main(); });
+		}
+
+		~http2_session_t()
+		{
+			if(fiber != nullptr)
+			{
+				fiber->Shutdown();
+				(void)fiber->Join();
+			}
+			nghttp2_session_del(session);
+		}
+	};
+
+	std::shared_ptr<THttpClientPool::http2_session_t> THttpClientPool::StartHttp2(std::unique_ptr<IStreamClient> connection, const usys_t max_streams, u32_t* const generation)
+	{
+		return el1::New<http2_session_t>(std::move(connection), max_streams, generation);
+	}
+
+	bool THttpClientPool::Http2Usable(const http2_session_t& session)
+	{
+		return session.Usable();
+	}
+
+	bool THttpClientPool::Http2HasCapacity(const http2_session_t& session)
+	{
+		return session.HasCapacity();
+	}
+
+	bool THttpClientPool::Http2Idle(const http2_session_t& session, TTime& ts_idle)
+	{
+		ts_idle = session.ts_idle;
+		return session.streams.Count() == 0;
+	}
+
+	THttpClientPool::response_t THttpClientPool::RequestHttp2(http2_session_t& session, const request_t& request, const THttpHeaderFields& headers, ISink<byte_t>* const response_body_sink, const usys_t body_limit)
+	{
+		THttp2Fields fields(headers.Items().Count());
+		for(const auto& field : headers.Items())
+			fields.Add(field.key, field.value);
+
+		http2_session_t::stream_t stream(request);
+		nghttp2_data_provider provider{};
+		provider.read_callback = &http2_session_t::ReadRequestData;
+		stream.id = nghttp2_submit_request(session.session, nullptr, fields.Data(), fields.Count(), request.body == nullptr ? nullptr : &provider, &stream);
+		EL_ERROR(stream.id < 0, TException, U"nghttp2_submit_request failed");
+		session.Attach(stream);
+
+		try
+		{
+			TListSink<byte_t> buffer_sink(&stream.response.body);
+			ISink<byte_t>* const body_sink = response_body_sink == nullptr ? static_cast<ISink<byte_t>*>(&buffer_sink) : response_body_sink;
+			usys_t n_body = 0;
+			for(;;)
+			{
+				if(stream.body.Count() != 0)
+				{
+					// the I/O fiber keeps appending while the sink blocks
+					TList<byte_t> chunk = std::move(stream.body);
+					stream.body.Clear();
+					n_body += chunk.Count();
+					EL_ERROR(body_limit != NEG1 && n_body > body_limit, TException, U"HTTP response body exceeds configured limit");
+					body_sink->WriteAll(chunk.ItemPtr(0), chunk.Count());
+					if(!session.failed)
+					{
+						(void)nghttp2_session_consume(session.session, stream.id, chunk.Count());
+						session.wakeup = 1;
+					}
+					continue;
+				}
+
+				if(stream.closed)
+					break;
+
+				const u32_t signal = stream.signal;
+				TMemoryWaitable<u32_t>(&stream.signal, &signal, ~0U).WaitFor();
+			}
+
+			if(stream.error_code != NGHTTP2_NO_ERROR)
+			{
+				EL_ERROR(session.failed, TException, session.failure);
+				EL_THROW(TException, TString::Format(U"HTTP/2 stream was reset (error code %d)", stream.error_code));
+			}
+			EL_ERROR(!stream.has_status, TException, U"HTTP/2 response without :status");
+		}
+		catch(...)
+		{
+			session.Detach(stream);
+			throw;
+		}
+		session.Detach(stream);
+
+		stream.response.version = EVersion::HTTP20;
+		return std::move(stream.response);
+	}
 }
@@ -103,6 +103,42 @@ namespace el1::io::net::ip
 		io::collection::list::TList<byte_t> data;
 	};
 
+	// one entry of a batched TUdpSocket::Receive()/Send()
+	// with segmentation offload (GSO/GRO) data carries a train of datagrams which are all segment_size bytes long,
+	// except for the last one which may be shorter
+	struct udp_message_t
+	{
+		ipport_t remote_address;
+		io::collection::list::array_t<const byte_t> data;
+		usys_t segment_size = 0;	// 0 => data is a single datagram
+		bool truncated = false;	// receive: the datagram did not fit into the arena slot
+
+		usys_t CountSegments() const EL_GETTER { return segment_size == 0 ? 1U : (data.Count() + segment_size - 1U) / segment_size; }
+		io::collection::list::array_t<const byte_t> Segment(const usys_t index) const EL_GETTER { return segment_size == 0 ? data : data.Slice(index * segment_size, util::Min(segment_size, data.Count() - index * segment_size)); }
+	};
+
+	// caller-owned memory for TUdpSocket::Receive(TUdpReceiveArena&), allocated once and reused by every batch
+	// every slot takes one datagram, or one GRO train (up to 64 KiB)
+	class TUdpReceiveArena
+	{
+		friend class TUdpSocket;
+
+		protected:
+			io::collection::list::TList<byte_t> memory;
+			io::collection::list::TList<udp_message_t> messages;
+			usys_t n_messages;
+
+		public:
+			const usys_t n_slots;
+			const usys_t slot_size;
+
+			// the datagrams of the last Receive(), valid until the next one
+			io::collection::list::array_t<const udp_message_t> Messages() const EL_GETTER { return messages.Head(n_messages); }
+
+			TUdpReceiveArena(const usys_t n_slots = 64, const usys_t slot_size = 2048);
+			TUdpReceiveArena(const TUdpReceiveArena&) = delete;
+	};
+
 	io::collection::list::TList<ipaddr_t> EnumMyIpAddresses();
 	io::collection::list::TList<ipaddr_t> ResolveHostname(const text::string::TStringView);
 
@@ -137,6 +173,10 @@ namespace el1::io::net::ip
 			ipport_t LocalAddress() const final override EL_GETTER;
 			ipport_t RemoteAddress() const final override EL_GETTER;
 
+			// disables Nagle's algorithm, for writers which collect their output themselves
+			// and would otherwise wait for the peer's delayed ACK after every partial segment
+			void NoDelay(const bool no_delay);
+
 			TTcpClient(const io::text::string::TStringView remote_host, const port_t remote_port);
 			TTcpClient(const io::text::string::TStringView remote_host, const port_t remote_port, const system::time::TTime connect_timeout);
 			TTcpClient(const ipaddr_t remote_ip, const port_t remote_port);
@@ -149,6 +189,10 @@ namespace el1::io::net::ip
 			usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
 			usys_t Write(const byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
 
+			// these go through the io_uring of the calling thread when its IoBackend() is IO_URING
+			usys_t BlockingRead(byte_t* const arr_items, const usys_t n_items_max, system::time::TTime timeout = -1, const bool absolute_time = false) final override EL_WARN_UNUSED_RESULT;
+			void WriteAll(const byte_t* const arr_items, const usys_t n_items) final override;
+
 			const system::waitable::THandleWaitable* OnInputReady() const final override;
 			const system::waitable::THandleWaitable* OnOutputReady() const final override;
 
@@ -173,9 +217,19 @@ namespace el1::io::net::ip
 
 			ipport_t LocalAddress() const EL_GETTER;
 
+			// only for servers constructed with reuse_port: the kernel hands a new connection to the socket
+			// (CPU % n_sockets) of the group, by the order in which the sockets were bound, instead of by hash
+			// returns false if the kernel does not support it
+			bool SteerByCpu(const usys_t n_sockets);
+
+			// like above, but socket j of the group receives the connections which arrive on CPU cpus[j]
+			// connections arriving on any other CPU go to socket (CPU % cpus.Count()), at most 2046 CPUs can be listed
+			bool SteerByCpu(const io::collection::list::array_t<const usys_t> cpus);
+
 			// if port == 0 => random free port
+			// with reuse_port several servers can listen on the same address (SO_REUSEPORT), the kernel distributes the connections among them
 			TTcpServer(const port_t port = 0, const EIP version = EIP::ANY);
-			TTcpServer(const ipaddr_t bind_ip, const port_t port);
+			TTcpServer(const ipaddr_t bind_ip, const port_t port, const bool reuse_port = false);
 
 			TTcpServer(TTcpServer&&) = default;
 			TTcpServer(const TTcpServer&) = delete;
@@ -187,6 +241,7 @@ namespace el1::io::net::ip
 			system::handle::THandle handle;
 			system::waitable::THandleWaitable on_rx_msg;
 			system::waitable::THandleWaitable on_tx_ready;
+			int receive_error = 0;	// errno of a batch receive which failed after earlier datagrams were returned, reported by the next call
 
 		public:
 			system::handle::handle_t Handle() EL_GETTER;
@@ -201,6 +256,11 @@ namespace el1::io::net::ip
 			bool Receive(udp_datagram_t& datagram);
 			std::optional<udp_datagram_t> Receive();
 
+			// Non-blocking batch receive (recvmmsg() on Linux) into the slots of the arena.
+			// Returns the number of messages in arena.Messages(), 0 if no datagram is currently queued.
+			// An error after some datagrams were received ends the batch, it is thrown by the next call.
+			usys_t Receive(TUdpReceiveArena& arena);
+
 			// Compatibility overload. msg_buffer is resized to the exact datagram size.
 			bool Receive(collection::list::TList<byte_t>& msg_buffer, ipport_t& remote_address);
 			bool Receive(collection::list::TList<byte_t>& msg_buffer, ipaddr_t* const remote_ip = nullptr, port_t* const remote_port = nullptr);
@@ -213,6 +273,14 @@ namespace el1::io::net::ip
 			bool Send(const ipaddr_t remote_ip, const port_t remote_port, const void* const buffer, const usys_t sz_buffer) EL_WARN_UNUSED_RESULT;
 			bool Send(const io::text::string::TStringView remote_host, const port_t remote_port, collection::list::array_t<const byte_t> msg_buffer) EL_WARN_UNUSED_RESULT;
 
+			// Non-blocking batch send (sendmmsg() on Linux), messages with a segment_size use UDP_SEGMENT (GSO).
+			// Returns how many of the messages were submitted, fewer than messages.Count() if the socket buffer is full.
+			usys_t Send(collection::list::array_t<const udp_message_t> messages) EL_WARN_UNUSED_RESULT;
+
+			// lets the kernel coalesce consecutive datagrams of the same flow into one message (UDP_GRO), see udp_message_t::segment_size
+			// the slots of the TUdpReceiveArena should then hold 64 KiB; returns false if the kernel does not support it
+			bool ReceiveOffload(const bool enable);
+
 			TUdpSocket(const port_t local_port = 0, const EIP version = EIP::ANY);
 			TUdpSocket(const ipaddr_t bind_ip, const port_t local_port = 0);
 
@@ -1,4 +1,5 @@
 #include "io_net_ip.hpp"
+#include "system_task.hpp"
 #include <arpa/inet.h>
 #include <cstring>
 #include <fcntl.h>
@@ -15,11 +16,16 @@
 #include <unistd.h>
 #include <vector>
 
+#ifdef EL_OS_LINUX
+#include <linux/filter.h>
+#endif
+
 namespace el1::io::net::ip
 {
 	using namespace system::handle;
 	using namespace system::waitable;
 	using namespace system::time;
+	using namespace system::task;
 	using namespace collection::list;
 	using namespace text::string;
 
@@ -99,6 +105,27 @@ namespace el1::io::net::ip
 		return domain;
 	}
 
+	// fills addr with remote_address in the representation of the socket's domain, returns the size of the sockaddr
+	static socklen_t ConvertToPosix(const int domain, const ipport_t remote_address, sockaddr_storage& addr)
+	{
+		switch(domain)
+		{
+			case AF_INET:
+				EL_ERROR(!remote_address.ip.IsV4(), TInvalidArgumentException, "remote_address", "an IPv4 UDP socket cannot send to an IPv6 address");
+				reinterpret_cast<sockaddr_in&>(addr) = ConvertToPosixV4(remote_address.ip, remote_address.port);
+				return sizeof(sockaddr_in);
+
+			case AF_INET6:
+				// ipaddr_t stores IPv4 as IPv4-mapped IPv6, therefore the same
+				// sockaddr_in6 representation works for native IPv6 and dual-stack IPv4.
+				reinterpret_cast<sockaddr_in6&>(addr) = ConvertToPosixV6(remote_address.ip, remote_address.port);
+				return sizeof(sockaddr_in6);
+
+			default:
+				EL_THROW(TLogicException); // LCOV_EXCL_LINE
+		}
+	}
+
 	static ipport_t AddressFromSocket(handle_t handle)
 	{
 		socklen_t len = 0;
@@ -175,7 +202,7 @@ namespace el1::io::net::ip
 			EL_THROW(TLogicException); // LCOV_EXCL_LINE
 	}
 
-	static THandle CreateSocket(const int type, const ipaddr_t bind_ip, const port_t local_port)
+	static THandle CreateSocket(const int type, const ipaddr_t bind_ip, const port_t local_port, const bool reuse_port = false)
 	{
 		const int v1 = 1;
 		THandle handle;
@@ -184,6 +211,8 @@ namespace el1::io::net::ip
 		{
 			handle = EL_SYSERR(socket(AF_INET, type | SOCK_CLOEXEC, 0));
 			EL_SYSERR(setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &v1, sizeof(v1)));
+			if(reuse_port)
+				EL_SYSERR(setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &v1, sizeof(v1)));
 			const auto addr = ConvertToPosixV4(bind_ip, local_port);
 			EL_SYSERR(bind(handle, (const sockaddr*)&addr, sizeof(addr)));
 		}
@@ -191,6 +220,8 @@ namespace el1::io::net::ip
 		{
 			handle = EL_SYSERR(socket(AF_INET6, type | SOCK_CLOEXEC, 0));
 			EL_SYSERR(setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &v1, sizeof(v1)));
+			if(reuse_port)
+				EL_SYSERR(setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &v1, sizeof(v1)));
 			const auto addr = ConvertToPosixV6(bind_ip, local_port);
 			EL_SYSERR(bind(handle, (const sockaddr*)&addr, sizeof(addr)));
 		}
@@ -292,6 +323,12 @@ namespace el1::io::net::ip
 		return this->handle;
 	}
 
+	void TTcpClient::NoDelay(const bool no_delay)
+	{
+		const int value = no_delay ? 1 : 0;
+		EL_SYSERR(setsockopt(this->handle, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)));
+	}
+
 	ipport_t TTcpClient::LocalAddress() const
 	{
 		return AddressFromSocket(this->handle);
@@ -403,6 +440,48 @@ namespace el1::io::net::ip
 		}
 	}
 
+	usys_t TTcpClient::BlockingRead(byte_t* const arr_items, const usys_t n_items_max, TTime timeout, const bool absolute_time)
+	{
+		if(TThread::Self()->IoBackend() != EIoBackend::IO_URING)
+			return IStreamClient::BlockingRead(arr_items, n_items_max, timeout, absolute_time);
+
+		if(!absolute_time && timeout > 0)
+			timeout += TTime::Now(EClock::MONOTONIC);
+
+		usys_t n_read = 0;
+		while(n_read < n_items_max && this->on_rx_ready.Handle() != -1)
+		{
+			const ssys_t r = TFiber::RingRead(this->handle, arr_items + n_read, n_items_max - n_read, -1, true, timeout);
+			if(r < 0)
+				break;
+
+			if(r == 0)
+			{
+				// EOF
+				CloseInput();
+				break;
+			}
+
+			n_read += r;
+		}
+		return n_read;
+	}
+
+	void TTcpClient::WriteAll(const byte_t* const arr_items, const usys_t n_items)
+	{
+		if(TThread::Self()->IoBackend() != EIoBackend::IO_URING)
+			return IStreamClient::WriteAll(arr_items, n_items);
+
+		usys_t w = 0;
+		while(w < n_items)
+		{
+			EL_ERROR(this->on_tx_ready.Handle() == -1, stream::TSinkFloodedException);
+			const ssys_t r = TFiber::RingWrite(this->handle, arr_items + w, n_items - w);
+			EL_ERROR(r <= 0, stream::TSinkFloodedException);
+			w += r;
+		}
+	}
+
 	const THandleWaitable* TTcpClient::OnInputReady() const
 	{
 		return this->on_rx_ready.Handle() >= 0 ? &this->on_rx_ready : nullptr;
@@ -417,7 +496,9 @@ namespace el1::io::net::ip
 	{
 		if(this->on_tx_ready.Handle() != -1)
 		{
-			EL_SYSERR(shutdown(this->handle, SHUT_WR));
+			// ENOTCONN: the connection is already gone completely
+			if(shutdown(this->handle, SHUT_WR) < 0)
+				EL_ERROR(errno != ENOTCONN, TSyscallException, errno);
 			this->on_tx_ready.Handle(-1);
 		}
 
@@ -428,7 +509,9 @@ namespace el1::io::net::ip
 	{
 		if(this->on_rx_ready.Handle() != -1)
 		{
-			EL_SYSERR(shutdown(this->handle, SHUT_RD));
+			// ENOTCONN: the connection is already gone completely
+			if(shutdown(this->handle, SHUT_RD) < 0)
+				EL_ERROR(errno != ENOTCONN, TSyscallException, errno);
 			this->on_rx_ready.Handle(-1);
 		}
 
@@ -487,6 +570,54 @@ namespace el1::io::net::ip
 		return AddressFromSocket(this->handle);
 	}
 
+	#ifdef EL_OS_LINUX
+		static bool AttachReusePortProgram(const handle_t handle, sock_filter* const arr_code, const usys_t n_code)
+		{
+			const sock_fprog program = { (unsigned short)n_code, arr_code };
+			if(setsockopt(handle, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0)
+				return true;
+			EL_ERROR(errno != ENOPROTOOPT && errno != EINVAL, TSyscallException, errno);
+			return false;
+		}
+	#endif
+
+	bool TTcpServer::SteerByCpu(const usys_t n_sockets)
+	{
+		EL_ERROR(n_sockets == 0 || n_sockets > 0xffffffffU, TInvalidArgumentException, "n_sockets", "n_sockets must be between 1 and 2^32-1");
+		#ifdef EL_OS_LINUX
+			// A = cpu % n_sockets; return A
+			sock_filter code[] = {
+				{ BPF_LD | BPF_W | BPF_ABS, 0, 0, (u32_t)(SKF_AD_OFF + SKF_AD_CPU) },
+				{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, (u32_t)n_sockets },
+				{ BPF_RET | BPF_A, 0, 0, 0 },
+			};
+			return AttachReusePortProgram(this->handle, code, sizeof(code) / sizeof(code[0]));
+		#else
+			return false;
+		#endif
+	}
+
+	bool TTcpServer::SteerByCpu(const array_t<const usys_t> cpus)
+	{
+		// two instructions per CPU plus three must stay within BPF_MAXINSNS (4096)
+		EL_ERROR(cpus.Count() == 0 || cpus.Count() > 2046, TInvalidArgumentException, "cpus", "between 1 and 2046 CPUs must be listed");
+		#ifdef EL_OS_LINUX
+			// A = cpu; if(A == cpus[0]) return 0; if(A == cpus[1]) return 1; ...; A %= cpus.Count(); return A
+			TList<sock_filter> code;
+			code.Append({ BPF_LD | BPF_W | BPF_ABS, 0, 0, (u32_t)(SKF_AD_OFF + SKF_AD_CPU) });
+			for(usys_t j = 0; j < cpus.Count(); j++)
+			{
+				code.Append({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, (u32_t)cpus[j] });
+				code.Append({ BPF_RET | BPF_K, 0, 0, (u32_t)j });
+			}
+			code.Append({ BPF_ALU | BPF_MOD | BPF_K, 0, 0, (u32_t)cpus.Count() });
+			code.Append({ BPF_RET | BPF_A, 0, 0, 0 });
+			return AttachReusePortProgram(this->handle, code.ItemPtr(0), code.Count());
+		#else
+			return false;
+		#endif
+	}
+
 	TTcpServer::TTcpServer(const port_t port, const EIP version) : on_client_connect({ .read = true, .write = false, .other = false })
 	{
 		this->handle = CreateSocket(SOCK_STREAM | SOCK_NONBLOCK, port, version);
@@ -494,9 +625,9 @@ namespace el1::io::net::ip
 		on_client_connect.Handle(this->handle);
 	}
 
-	TTcpServer::TTcpServer(const ipaddr_t bind_ip, const port_t port) : on_client_connect({ .read = true, .write = false, .other = false })
+	TTcpServer::TTcpServer(const ipaddr_t bind_ip, const port_t port, const bool reuse_port) : on_client_connect({ .read = true, .write = false, .other = false })
 	{
-		this->handle = CreateSocket(SOCK_STREAM | SOCK_NONBLOCK, bind_ip, port);
+		this->handle = CreateSocket(SOCK_STREAM | SOCK_NONBLOCK, bind_ip, port, reuse_port);
 		EL_SYSERR(listen(this->handle, 64));
 		on_client_connect.Handle(this->handle);
 	}
@@ -585,29 +716,9 @@ namespace el1::io::net::ip
 
 	bool TUdpSocket::Send(const ipport_t remote_address, const array_t<const byte_t> msg_buffer)
 	{
-		ssize_t result = -1;
-		switch(SocketDomain(this->handle))
-		{
-			case AF_INET:
-			{
-				EL_ERROR(!remote_address.ip.IsV4(), TInvalidArgumentException, "remote_address", "an IPv4 UDP socket cannot send to an IPv6 address");
-				const sockaddr_in addr = ConvertToPosixV4(remote_address.ip, remote_address.port);
-				result = sendto(this->handle, msg_buffer.ItemPtr(0), msg_buffer.Count(), 0, (const sockaddr*)&addr, sizeof(addr));
-				break;
-			}
-
-			case AF_INET6:
-			{
-				// ipaddr_t stores IPv4 as IPv4-mapped IPv6, therefore the same
-				// sockaddr_in6 representation works for native IPv6 and dual-stack IPv4.
-				const sockaddr_in6 addr = ConvertToPosixV6(remote_address.ip, remote_address.port);
-				result = sendto(this->handle, msg_buffer.ItemPtr(0), msg_buffer.Count(), 0, (const sockaddr*)&addr, sizeof(addr));
-				break;
-			}
-
-			default:
-				EL_THROW(TLogicException); // LCOV_EXCL_LINE
-		}
+		sockaddr_storage addr = {};
+		const socklen_t addr_size = ConvertToPosix(SocketDomain(this->handle), remote_address, addr);
+		const ssize_t result = sendto(this->handle, msg_buffer.ItemPtr(0), msg_buffer.Count(), 0, (const sockaddr*)&addr, addr_size);
 
 		if(result < 0)
 		{
@@ -647,6 +758,209 @@ namespace el1::io::net::ip
 		EL_THROW(TException, TString::Format(U"hostname %q did not resolve to an address compatible with this UDP socket", remote_host));
 	}
 
+#ifdef EL_OS_LINUX
+	// recvmmsg()/sendmmsg() work through a batch in chunks of this many messages, with all bookkeeping on the stack
+	static const usys_t UDP_BATCH_MAX = 64;
+
+	usys_t TUdpSocket::Receive(TUdpReceiveArena& arena)
+	{
+		arena.n_messages = 0;
+		if(receive_error != 0)
+		{
+			const int error = receive_error;
+			receive_error = 0;
+			EL_THROW(TSyscallException, error);
+		}
+
+		while(arena.n_messages < arena.n_slots)
+		{
+			const usys_t n_chunk = util::Min(arena.n_slots - arena.n_messages, UDP_BATCH_MAX);
+			mmsghdr msgs[UDP_BATCH_MAX];
+			iovec iovs[UDP_BATCH_MAX];
+			sockaddr_storage addrs[UDP_BATCH_MAX];
+			alignas(cmsghdr) byte_t controls[UDP_BATCH_MAX][CMSG_SPACE(sizeof(int))];
+
+			for(usys_t i = 0; i < n_chunk; i++)
+			{
+				iovs[i].iov_base = arena.memory.ItemPtr((arena.n_messages + i) * arena.slot_size);
+				iovs[i].iov_len = arena.slot_size;
+				msgs[i].msg_hdr = {};
+				msgs[i].msg_hdr.msg_name = &addrs[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				msgs[i].msg_hdr.msg_control = controls[i];
+				msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+				msgs[i].msg_len = 0;
+			}
+
+			const int n_received = recvmmsg(this->handle, msgs, (unsigned)n_chunk, MSG_DONTWAIT, nullptr);
+			if(n_received < 0)
+			{
+				// the datagrams of the earlier chunks already left the kernel queue and must not be lost
+				if(errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					EL_ERROR(arena.n_messages == 0, TSyscallException, errno);
+					receive_error = errno;
+				}
+				break;
+			}
+
+			for(usys_t i = 0; i < (usys_t)n_received; i++)
+			{
+				udp_message_t& message = arena.messages[arena.n_messages + i];
+				message.remote_address = ConvertFromPosix(*(const sockaddr*)&addrs[i]);
+				message.truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+				message.data = array_t<const byte_t>::FromUnsafePointer((const byte_t*)iovs[i].iov_base, util::Min((usys_t)msgs[i].msg_len, arena.slot_size));
+				message.segment_size = 0;
+
+				for(const cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, (cmsghdr*)cmsg))
+					if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+					{
+						int segment_size = 0;
+						memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+						// a train of a single datagram is reported as a plain datagram
+						if((usys_t)segment_size < message.data.Count())
+							message.segment_size = (usys_t)segment_size;
+					}
+			}
+
+			arena.n_messages += (usys_t)n_received;
+			if((usys_t)n_received < n_chunk)
+				break;
+		}
+
+		return arena.n_messages;
+	}
+
+	usys_t TUdpSocket::Send(const array_t<const udp_message_t> messages)
+	{
+		const int domain = SocketDomain(this->handle);
+		usys_t n_sent = 0;
+		while(n_sent < messages.Count())
+		{
+			const usys_t n_chunk = util::Min(messages.Count() - n_sent, UDP_BATCH_MAX);
+			mmsghdr msgs[UDP_BATCH_MAX];
+			iovec iovs[UDP_BATCH_MAX];
+			sockaddr_storage addrs[UDP_BATCH_MAX];
+			alignas(cmsghdr) byte_t controls[UDP_BATCH_MAX][CMSG_SPACE(sizeof(u16_t))];
+
+			for(usys_t i = 0; i < n_chunk; i++)
+			{
+				const udp_message_t& message = messages[n_sent + i];
+				iovs[i].iov_base = (void*)message.data.ItemPtr(0);
+				iovs[i].iov_len = message.data.Count();
+				msgs[i].msg_hdr = {};
+				msgs[i].msg_hdr.msg_name = &addrs[i];
+				msgs[i].msg_hdr.msg_namelen = ConvertToPosix(domain, message.remote_address, addrs[i]);
+				msgs[i].msg_hdr.msg_iov = &iovs[i];
+				msgs[i].msg_hdr.msg_iovlen = 1;
+				msgs[i].msg_len = 0;
+
+				if(message.segment_size != 0)
+				{
+					EL_ERROR(message.segment_size > 0xffff, TInvalidArgumentException, "segment_size", "segment_size must fit into 16 bits");
+					msgs[i].msg_hdr.msg_control = controls[i];
+					msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+					cmsghdr* const cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+					cmsg->cmsg_level = SOL_UDP;
+					cmsg->cmsg_type = UDP_SEGMENT;
+					cmsg->cmsg_len = CMSG_LEN(sizeof(u16_t));
+					const u16_t segment_size = (u16_t)message.segment_size;
+					memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+				}
+			}
+
+			const int n_submitted = sendmmsg(this->handle, msgs, (unsigned)n_chunk, MSG_DONTWAIT);
+			if(n_submitted < 0)
+			{
+				EL_ERROR(errno != EAGAIN && errno != EWOULDBLOCK, TSyscallException, errno);
+				break;
+			}
+
+			for(usys_t i = 0; i < (usys_t)n_submitted; i++)
+				EL_ERROR(msgs[i].msg_len != iovs[i].iov_len, TException, TString::Format(U"UDP datagram truncated to %d bytes (out of %d bytes)", msgs[i].msg_len, iovs[i].iov_len));
+
+			n_sent += (usys_t)n_submitted;
+			if((usys_t)n_submitted < n_chunk)
+				break;
+		}
+
+		return n_sent;
+	}
+
+	bool TUdpSocket::ReceiveOffload(const bool enable)
+	{
+		const int value = enable ? 1 : 0;
+		if(setsockopt(this->handle, SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0)
+			return true;
+		EL_ERROR(errno != ENOPROTOOPT && errno != EINVAL, TSyscallException, errno);
+		return false;
+	}
+#else
+	// one syscall per datagram, without segmentation offload
+	usys_t TUdpSocket::Receive(TUdpReceiveArena& arena)
+	{
+		arena.n_messages = 0;
+		if(receive_error != 0)
+		{
+			const int error = receive_error;
+			receive_error = 0;
+			EL_THROW(TSyscallException, error);
+		}
+
+		while(arena.n_messages < arena.n_slots)
+		{
+			byte_t* const slot = arena.memory.ItemPtr(arena.n_messages * arena.slot_size);
+			sockaddr_storage addr = {};
+			socklen_t addr_size = sizeof(addr);
+			const ssize_t size = recvfrom(this->handle, slot, arena.slot_size, MSG_TRUNC, (sockaddr*)&addr, &addr_size);
+			if(size < 0)
+			{
+				if(errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					EL_ERROR(arena.n_messages == 0, TSyscallException, errno);
+					receive_error = errno;
+				}
+				break;
+			}
+
+			udp_message_t& message = arena.messages[arena.n_messages++];
+			message.remote_address = ConvertFromPosix(*(const sockaddr*)&addr);
+			message.truncated = (usys_t)size > arena.slot_size;
+			message.data = array_t<const byte_t>::FromUnsafePointer(slot, util::Min((usys_t)size, arena.slot_size));
+			message.segment_size = 0;
+		}
+		return arena.n_messages;
+	}
+
+	usys_t TUdpSocket::Send(const array_t<const udp_message_t> messages)
+	{
+		usys_t n_sent = 0;
+		for(const udp_message_t& message : messages)
+		{
+			EL_ERROR(message.segment_size != 0, TNotImplementedException);
+			if(!Send(message.remote_address, message.data))
+				break;
+			n_sent++;
+		}
+		return n_sent;
+	}
+
+	bool TUdpSocket::ReceiveOffload(const bool)
+	{
+		return false;
+	}
+#endif
+
+	TUdpReceiveArena::TUdpReceiveArena(const usys_t n_slots, const usys_t slot_size) : n_messages(0), n_slots(n_slots), slot_size(slot_size)
+	{
+		EL_ERROR(n_slots == 0, TInvalidArgumentException, "n_slots", "at least one slot is required");
+		EL_ERROR(slot_size == 0, TInvalidArgumentException, "slot_size", "slot_size must not be zero");
+		memory.SetCount(n_slots * slot_size);
+		messages.SetCount(n_slots);
+	}
+
 	TUdpSocket::TUdpSocket(const port_t local_port, const EIP version) : on_rx_msg({ .read = true, .write = false, .other = false }), on_tx_ready({ .read = false, .write = true, .other = false })
 	{
 		this->handle = CreateSocket(SOCK_DGRAM | SOCK_NONBLOCK, local_port, version);
@@ -1,7 +1,10 @@
 #include "io_net_tls.hpp"
 
+#include <openssl/core_names.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/pem.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <openssl/x509err.h>
@@ -15,6 +18,8 @@ namespace el1::io::net::tls
 	using namespace io::stream;
 	using namespace io::collection::list;
 	using namespace io::text::string;
+	using namespace system::task;
+	using namespace system::time;
 	using namespace system::waitable;
 
 	TPemSource::TPemSource() : type(EType::NONE)
@@ -71,6 +76,22 @@ namespace el1::io::net::tls
 			return result;
 		}
 
+		// sessions are only resumed with the settings their handshake ran with, so a session of an unverified connection
+		// or one checked against other CA certificates never lets a verifying connection skip the certificate check
+		static TString SessionKey(const client_config_t& config, const ip::port_t remote_port)
+		{
+			TString key = TString::Format(U"%s:%d alpn=%s", config.server_name, remote_port, TString::Join(config.application_protocols, U","));
+			if(!config.verify_peer)
+				key += U" verify=none";
+			else if(config.ca_certificates.Type() == TPemSource::EType::FILE)
+				key += TString::Format(U" verify=%s", (TString)config.ca_certificates.Path());
+			else if(config.ca_certificates.Type() == TPemSource::EType::MEMORY)
+				key += TString::Format(U" verify=%x", collection::map::HashBytes(config.ca_certificates.Data().ItemPtr(0), config.ca_certificates.Data().Count()));
+			else
+				key += U" verify=default";
+			return key;
+		}
+
 		static int SelectAlpn(SSL*, const unsigned char** const output, unsigned char* const output_size, const unsigned char* const input, const unsigned int input_size, void* const arg)
 		{
 			auto* const protocols = static_cast<TList<byte_t>*>(arg);
@@ -291,6 +312,10 @@ namespace el1::io::net::tls
 		std::unique_ptr<ip::TTcpClient> tcp_client;
 		SSL_CTX* owned_ssl_context;
 		SSL* ssl;
+		std::shared_ptr<handshake_counters_t> counters;
+		std::shared_ptr<TSessionCache> session_cache;
+		TString session_key;
+		bool handshake_counted;
 		const TInputWaitable on_input_ready;
 		byte_t write_buffer[WRITE_BUFFER_SIZE];
 		usys_t write_offset;
@@ -305,6 +330,7 @@ namespace el1::io::net::tls
 			tcp_client(std::move(tcp_client)),
 			owned_ssl_context(owned_ssl_context),
 			ssl(nullptr),
+			handshake_counted(false),
 			on_input_ready(this),
 			write_offset(0),
 			write_count(0),
@@ -317,6 +343,7 @@ namespace el1::io::net::tls
 			ERR_clear_error();
 			ssl = SSL_new(static_cast<SSL_CTX*>(ssl_context));
 			EL_ERROR(ssl == nullptr, TTlsException, OpenSslError("SSL_new() failed"));
+			SSL_set_app_data(ssl, this);
 
 			if(SSL_set_fd(ssl, this->tcp_client->Handle()) != 1)
 			{
@@ -342,6 +369,46 @@ namespace el1::io::net::tls
 				SSL_CTX_free(owned_ssl_context);
 		}
 
+		// TLS 1.3 reports every post-handshake message (like a session ticket) as SSL_CB_HANDSHAKE_DONE, only the first one counts
+		static void OnInfo(const SSL* const ssl, const int where, const int)
+		{
+			if((where & SSL_CB_HANDSHAKE_DONE) == 0)
+				return;
+
+			data_t* const data = static_cast<data_t*>(SSL_get_app_data(ssl));
+			if(data == nullptr || data->counters == nullptr || data->handshake_counted)
+				return;
+
+			data->handshake_counted = true;
+			if(SSL_session_reused(ssl))
+				data->counters->n_resumed++;
+			else
+				data->counters->n_full++;
+		}
+
+		// called on the client side for every session ticket the server sends
+		// the cache gets a copy, OpenSSL marks the original as not resumable when the connection ends without close_notify
+		static int OnNewSession(SSL* const ssl, SSL_SESSION* const session)
+		{
+			data_t* const data = static_cast<data_t*>(SSL_get_app_data(ssl));
+			if(data == nullptr || data->session_cache == nullptr || !SSL_SESSION_is_resumable(session))
+				return 0;
+
+			SSL_SESSION* const copy = SSL_SESSION_dup(session);
+			if(copy == nullptr)
+				return 0;
+
+			try
+			{
+				data->session_cache->Store(data->session_key, copy);
+			}
+			catch(...)
+			{
+				SSL_SESSION_free(copy);
+			}
+			return 0;
+		}
+
 		const IWaitable* Waitable(const EWaitDirection direction) const
 		{
 			switch(direction)
@@ -398,6 +465,80 @@ namespace el1::io::net::tls
 		return msg;
 	}
 
+	handshake_stats_t handshake_counters_t::Stats() const
+	{
+		return handshake_stats_t{ .n_full = n_full.load(), .n_resumed = n_resumed.load() };
+	}
+
+	void TSessionCache::Store(const TString& key, void* const session)
+	{
+		const TMutexAutoLock lock(&mutex);
+		if(entry_t* const entry = sessions.Get(key))
+		{
+			SSL_SESSION_free(static_cast<SSL_SESSION*>(entry->session));
+			entry->session = session;
+			entry->last_use = ++n_uses;
+			return;
+		}
+
+		if(sessions.Count() >= max_sessions)
+		{
+			const TString* victim = nullptr;
+			u64_t last_use = NEG1;
+			for(const auto& entry : sessions)
+				if(entry.value.last_use < last_use)
+				{
+					victim = &entry.key;
+					last_use = entry.value.last_use;
+				}
+
+			if(victim != nullptr)
+			{
+				const TString victim_key = *victim;
+				SSL_SESSION_free(static_cast<SSL_SESSION*>(sessions.Get(victim_key)->session));
+				sessions.Remove(victim_key);
+			}
+		}
+
+		sessions.Set(key, entry_t{ .session = session, .last_use = ++n_uses });
+	}
+
+	void* TSessionCache::Load(const TString& key)
+	{
+		const TMutexAutoLock lock(&mutex);
+		entry_t* const entry = sessions.Get(key);
+		if(entry == nullptr)
+			return nullptr;
+
+		// a copy again, the connection marks its session as not resumable if it ends without close_notify
+		entry->last_use = ++n_uses;
+		return SSL_SESSION_dup(static_cast<SSL_SESSION*>(entry->session));
+	}
+
+	usys_t TSessionCache::Count() const
+	{
+		const TMutexAutoLock lock(&mutex);
+		return sessions.Count();
+	}
+
+	void TSessionCache::Clear()
+	{
+		const TMutexAutoLock lock(&mutex);
+		for(const auto& entry : sessions)
+			SSL_SESSION_free(static_cast<SSL_SESSION*>(entry.value.session));
+		sessions.Clear();
+	}
+
+	TSessionCache::TSessionCache(const usys_t max_sessions) : n_uses(0), counters(New<handshake_counters_t>()), max_sessions(max_sessions)
+	{
+		EL_ERROR(max_sessions == 0, TInvalidArgumentException, "max_sessions", "max_sessions must not be zero");
+	}
+
+	TSessionCache::~TSessionCache()
+	{
+		Clear();
+	}
+
 	IException* TTlsException::Clone() const
 	{
 		return new TTlsException(*this);
@@ -421,6 +562,16 @@ namespace el1::io::net::tls
 		{
 			EL_ERROR(SSL_CTX_set_min_proto_version(context, NativeVersion(config.min_version)) != 1, TTlsException, OpenSslError("SSL_CTX_set_min_proto_version() failed"));
 			SSL_CTX_set_options(context, SSL_OP_NO_COMPRESSION);
+			if(config.kernel_tls)
+				SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+
+			if(config.session_cache != nullptr)
+			{
+				// the sessions are kept by the cache, not by this short-lived context
+				SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+				SSL_CTX_sess_set_new_cb(context, &data_t::OnNewSession);
+				SSL_CTX_set_info_callback(context, &data_t::OnInfo);
+			}
 
 			if(config.verify_peer)
 			{
@@ -447,6 +598,21 @@ namespace el1::io::net::tls
 			const TList<byte_t> alpn = AlpnWire(config.application_protocols);
 			if(alpn.Count() != 0)
 				EL_ERROR(SSL_set_alpn_protos(data->ssl, alpn.ItemPtr(0), alpn.Count()) != 0, TTlsException, OpenSslError("failed to configure TLS ALPN protocols"));
+
+			if(config.session_cache != nullptr)
+			{
+				data->counters = config.session_cache->counters;
+				data->session_cache = config.session_cache;
+				data->session_key = SessionKey(config, remote_port);
+
+				// OpenSSL falls back to a full handshake by itself if the server does not accept the session anymore
+				if(SSL_SESSION* const session = static_cast<SSL_SESSION*>(data->session_cache->Load(data->session_key)))
+				{
+					const int result = SSL_set_session(data->ssl, session);
+					SSL_SESSION_free(session);
+					EL_ERROR(result != 1, TTlsException, OpenSslError("SSL_set_session() failed"));
+				}
+			}
 		}
 		catch(...)
 		{
@@ -461,10 +627,15 @@ namespace el1::io::net::tls
 
 	system::handle::handle_t TClient::Handle()
 	{
-		// The TCP file descriptor carries encrypted TLS records, not the plaintext
-		// represented by this stream. Returning it would allow optimizations such
-		// as sendfile() to bypass TLS entirely.
-		return system::handle::INVALID_HANDLE;
+		// The TCP file descriptor carries the plaintext of this stream only when the
+		// kernel processes the TLS records in both directions (kTLS) - otherwise
+		// optimizations such as sendfile() or splice() would bypass TLS entirely.
+		// Data still buffered by us or by OpenSSL would be skipped, so the handle
+		// is only exposed while both buffers are empty.
+		if(data->closed || data->write_count != 0 || SSL_has_pending(data->ssl) || !KernelTlsSend() || !KernelTlsReceive())
+			return system::handle::INVALID_HANDLE;
+
+		return data->tcp_client->Handle();
 	}
 
 	ip::ipport_t TClient::LocalAddress() const
@@ -505,6 +676,21 @@ namespace el1::io::net::tls
 		return TString(str.ItemPtr(0));
 	}
 
+	bool TClient::KernelTlsSend() const
+	{
+		return BIO_get_ktls_send(SSL_get_wbio(data->ssl));
+	}
+
+	bool TClient::KernelTlsReceive() const
+	{
+		return BIO_get_ktls_recv(SSL_get_rbio(data->ssl));
+	}
+
+	void TClient::NoDelay(const bool no_delay)
+	{
+		data->tcp_client->NoDelay(no_delay);
+	}
+
 	usys_t TClient::Read(byte_t* const arr_items, const usys_t n_items_max)
 	{
 		if(data->closed || data->input_closed || n_items_max == 0)
@@ -628,6 +814,109 @@ namespace el1::io::net::tls
 		data->tcp_client->Close();
 	}
 
+	// session tickets are encrypted with AES-256-CBC and authenticated with HMAC-SHA256 (like OpenSSL does with its own keys)
+	// the keys exist only in memory, so the tickets of one server instance are useless to any other
+	struct TServer::ticket_keys_t
+	{
+		struct key_t
+		{
+			byte_t name[16];
+			byte_t aes_key[32];
+			byte_t hmac_key[32];
+		};
+
+		TSimpleMutex mutex;
+		key_t current;
+		key_t previous;
+		bool has_previous;
+		TTime ts_rotated;
+		const TTime rotation;
+
+		static void Generate(key_t& key)
+		{
+			EL_ERROR(RAND_bytes(reinterpret_cast<unsigned char*>(&key), sizeof(key)) != 1, TTlsException, OpenSslError("RAND_bytes() failed"));
+		}
+
+		void Rotate()
+		{
+			key_t next;
+			Generate(next);
+			previous = current;
+			current = next;
+			has_previous = true;
+			ts_rotated = TTime::Now(EClock::MONOTONIC);
+		}
+
+		// rotation happens lazily when a ticket is issued or presented, the previous key
+		// is only kept if the current one was in use for less than two periods
+		void Update()
+		{
+			const TTime age = TTime::Now(EClock::MONOTONIC) - ts_rotated;
+			if(age < rotation)
+				return;
+			Rotate();
+			if(age >= rotation * (s64_t)2)
+				has_previous = false;
+		}
+
+		// returns 1 if the ticket was set up for encryption, 2 if it was set up for decryption and shall be renewed, 0 if the key is unknown and -1 on errors
+		// presented tickets are always renewed: without a new ticket a TLS 1.3 client has none to resume with next time
+		// (clients should use every ticket only once, and OpenSSL sends none after a resumption unless asked to)
+		static int Callback(SSL* const ssl, unsigned char* const key_name, unsigned char* const iv, EVP_CIPHER_CTX* const cipher_ctx, EVP_MAC_CTX* const mac_ctx, const int encrypt)
+		{
+			auto* const keys = static_cast<ticket_keys_t*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+			if(keys == nullptr)
+				return 0;
+
+			key_t key;
+			try
+			{
+				const TMutexAutoLock lock(&keys->mutex);
+				keys->Update();
+				if(encrypt || memcmp(key_name, keys->current.name, sizeof(key.name)) == 0)
+					key = keys->current;
+				else if(keys->has_previous && memcmp(key_name, keys->previous.name, sizeof(key.name)) == 0)
+					key = keys->previous;
+				else
+					return 0;
+			}
+			catch(...)
+			{
+				return -1;
+			}
+
+			if(encrypt)
+			{
+				memcpy(key_name, key.name, sizeof(key.name));
+				if(RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) != 1)
+					return -1;
+			}
+
+			char digest[] = "SHA256";
+			const OSSL_PARAM params[] = {
+				OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac_key, sizeof(key.hmac_key)),
+				OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+				OSSL_PARAM_construct_end(),
+			};
+
+			if(EVP_CipherInit_ex(cipher_ctx, EVP_aes_256_cbc(), nullptr, key.aes_key, iv, encrypt) != 1 || EVP_MAC_CTX_set_params(mac_ctx, params) != 1)
+				return -1;
+
+			return encrypt ? 1 : 2;
+		}
+
+		explicit ticket_keys_t(const TTime rotation) : has_previous(false), ts_rotated(TTime::Now(EClock::MONOTONIC)), rotation(rotation)
+		{
+			Generate(current);
+		}
+	};
+
+	void TServer::RotateTicketKeys()
+	{
+		const TMutexAutoLock lock(&ticket_keys->mutex);
+		ticket_keys->Rotate();
+	}
+
 	const THandleWaitable& TServer::OnClientConnect() const
 	{
 		return tcp_server->OnClientConnect();
@@ -644,7 +933,9 @@ namespace el1::io::net::tls
 		if(tcp_client == nullptr)
 			return nullptr;
 
-		return std::unique_ptr<TClient>(new TClient(ssl_context, std::move(tcp_client)));
+		std::unique_ptr<TClient> client(new TClient(ssl_context, std::move(tcp_client)));
+		client->data->counters = counters;
+		return client;
 	}
 
 	ip::ipport_t TServer::LocalAddress() const
@@ -655,9 +946,11 @@ namespace el1::io::net::tls
 	TServer::TServer(ip::TTcpServer* const tcp_server, server_config_t config) :
 		tcp_server(tcp_server),
 		alpn_protocols(AlpnWire(config.application_protocols)),
-		ssl_context(nullptr)
+		ssl_context(nullptr),
+		counters(New<handshake_counters_t>())
 	{
 		EL_ERROR(tcp_server == nullptr, TInvalidArgumentException, "tcp_server", "tcp_server must not be null");
+		EL_ERROR(config.ticket_key_rotation <= TTime(0), TInvalidArgumentException, "ticket_key_rotation", "ticket_key_rotation must be positive");
 		EL_ERROR(config.certificate_chain.IsEmpty(), TInvalidArgumentException, "certificate_chain", "certificate chain source must not be empty");
 		EL_ERROR(config.private_key.IsEmpty(), TInvalidArgumentException, "private_key", "private key source must not be empty");
 
@@ -670,9 +963,18 @@ namespace el1::io::net::tls
 		{
 			EL_ERROR(SSL_CTX_set_min_proto_version(context, NativeVersion(config.min_version)) != 1, TTlsException, OpenSslError("SSL_CTX_set_min_proto_version() failed"));
 			SSL_CTX_set_options(context, SSL_OP_NO_COMPRESSION);
+			if(config.kernel_tls)
+				SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
 			if(alpn_protocols.Count() != 0)
 				SSL_CTX_set_alpn_select_cb(context, &SelectAlpn, &alpn_protocols);
 
+			// a ticket is accepted for up to two rotation periods, see ticket_keys_t::Update()
+			ticket_keys = std::make_unique<ticket_keys_t>(config.ticket_key_rotation);
+			SSL_CTX_set_app_data(context, ticket_keys.get());
+			EL_ERROR(SSL_CTX_set_tlsext_ticket_key_evp_cb(context, &ticket_keys_t::Callback) != 1, TTlsException, OpenSslError("failed to install the TLS session ticket key callback"));
+			SSL_CTX_set_timeout(context, (long)(config.ticket_key_rotation * (s64_t)2).ConvertToI(EUnit::SECONDS));
+			SSL_CTX_set_info_callback(context, &TClient::data_t::OnInfo);
+
 			LoadCertificateChain(context, config.certificate_chain);
 			LoadPrivateKey(context, config.private_key);
 			EL_ERROR(SSL_CTX_check_private_key(context) != 1, TTlsException, OpenSslError("TLS private key does not match certificate"));
@@ -702,7 +1004,11 @@ namespace el1::io::net::tls
 
 	TServer::~TServer()
 	{
+		// accepted connections keep the context alive, but the keys go away with the server
 		if(ssl_context != nullptr)
+		{
+			SSL_CTX_set_app_data(static_cast<SSL_CTX*>(ssl_context), nullptr);
 			SSL_CTX_free(static_cast<SSL_CTX*>(ssl_context));
+		}
 	}
 }
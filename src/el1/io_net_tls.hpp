@@ -5,9 +5,13 @@
 #include "io_net_ip.hpp"
 #include "io_file.hpp"
 #include "io_collection_list.hpp"
+#include "io_collection_map.hpp"
 #include "io_stream.hpp"
 #include "io_text_string.hpp"
+#include "system_task.hpp"
+#include "system_time.hpp"
 
+#include <atomic>
 #include <memory>
 
 namespace el1::io::net::tls
@@ -47,12 +51,66 @@ namespace el1::io::net::tls
 			explicit TPemSource(collection::list::TList<byte_t> data);
 	};
 
+	struct handshake_stats_t
+	{
+		u64_t n_full = 0;	// handshakes with certificate exchange and key agreement
+		u64_t n_resumed = 0;	// handshakes which resumed an earlier session (TLS 1.3 PSK, TLS 1.2 ticket or session id)
+	};
+
+	// counted by the connections when their handshake completes, they may run on other threads and outlive their server/cache
+	struct handshake_counters_t
+	{
+		std::atomic<u64_t> n_full = 0;
+		std::atomic<u64_t> n_resumed = 0;
+
+		handshake_stats_t Stats() const EL_GETTER;
+	};
+
+	// remembers the last session ticket per server name, port, ALPN protocols and certificate verification settings, so the next connection resumes instead of doing a full handshake
+	// a cache can be shared by any number of clients (and threads) through client_config_t::session_cache
+	class TSessionCache
+	{
+		friend class TClient;
+
+		protected:
+			struct entry_t
+			{
+				void* session;	// SSL_SESSION, owned
+				u64_t last_use;
+			};
+
+			mutable system::task::TSimpleMutex mutex;
+			collection::map::THashMap<text::string::TString, entry_t> sessions;
+			u64_t n_uses;
+			const std::shared_ptr<handshake_counters_t> counters;
+
+			// takes ownership of session, replaces the previous session of key and evicts the least recently used one when full
+			void Store(const text::string::TString& key, void* const session);
+
+			// returns a copy of the session of key, which the caller has to free, or nullptr
+			void* Load(const text::string::TString& key);
+
+		public:
+			const usys_t max_sessions;
+
+			handshake_stats_t HandshakeStats() const EL_GETTER { return counters->Stats(); }
+			usys_t Count() const EL_GETTER;
+			void Clear();
+
+			explicit TSessionCache(const usys_t max_sessions = 256);
+			TSessionCache(const TSessionCache&) = delete;
+			TSessionCache(TSessionCache&&) = delete;
+			~TSessionCache();
+	};
+
 	struct server_config_t
 	{
 		TPemSource certificate_chain;
 		TPemSource private_key;
 		collection::list::TList<text::string::TString> application_protocols;
 		EVersion min_version = EVersion::TLS12;
+		bool kernel_tls = true;	// let the kernel encrypt/decrypt the records after the handshake if it supports the cipher (kTLS)
+		system::time::TTime ticket_key_rotation = 3600;	// a new session ticket key is used after this time, tickets of the previous key are still accepted (and renewed)
 	};
 
 	struct client_config_t
@@ -62,6 +120,8 @@ namespace el1::io::net::tls
 		collection::list::TList<text::string::TString> application_protocols;
 		EVersion min_version = EVersion::TLS12;
 		bool verify_peer = true;
+		bool kernel_tls = true;
+		std::shared_ptr<TSessionCache> session_cache;	// resume sessions with the servers of earlier connections, nullptr to always do a full handshake
 	};
 
 	struct TTlsException : error::IException
@@ -96,6 +156,13 @@ namespace el1::io::net::tls
 			void Negotiate();
 			text::string::TString ApplicationProtocol() const EL_GETTER;
 
+			// whether the kernel took over the encryption of outgoing and the decryption of incoming records (kTLS)
+			bool KernelTlsSend() const EL_GETTER;
+			bool KernelTlsReceive() const EL_GETTER;
+
+			// see ip::TTcpClient::NoDelay(), TLS records are complete writes already
+			void NoDelay(const bool no_delay);
+
 			usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
 			usys_t Write(const byte_t* const arr_items, const usys_t n_items_max) final override EL_WARN_UNUSED_RESULT;
 
@@ -111,11 +178,20 @@ namespace el1::io::net::tls
 	class TServer final : public ip::IStreamServer
 	{
 		protected:
+			struct ticket_keys_t;
+
 			ip::TTcpServer* const tcp_server;
 			collection::list::TList<byte_t> alpn_protocols;
 			void* ssl_context;
+			std::unique_ptr<ticket_keys_t> ticket_keys;
+			const std::shared_ptr<handshake_counters_t> counters;
 
 		public:
+			handshake_stats_t HandshakeStats() const EL_GETTER { return counters->Stats(); }
+
+			// replaces the session ticket key now, tickets of the previous key are accepted until the next rotation
+			void RotateTicketKeys();
+
 			const system::waitable::THandleWaitable& OnClientConnect() const final override EL_GETTER;
 			std::unique_ptr<ip::IStreamClient> AcceptStreamClient() final override;
 			std::unique_ptr<TClient> AcceptClient();
@@ -77,6 +77,7 @@ namespace el1::io::serialization
 		u32_t since_version;
 		u32_t until_version;
 		EFieldFlags flags;
+		u32_t name_id;	// FieldId() of the name, text formats match keys by it even when id was chosen explicitly
 
 		constexpr bool Active(const u32_t version) const noexcept
 		{
@@ -128,7 +129,7 @@ namespace el1::io::serialization
 		const u32_t id = 0)
 	{
 		return TMember<TObject, TValue>{
-			TFieldInfo{id == 0 ? FieldId(name) : id, name, since_version, until_version, EFieldFlags::NONE},
+			TFieldInfo{id == 0 ? FieldId(name) : id, name, since_version, until_version, EFieldFlags::NONE, FieldId(name)},
 			pointer
 		};
 	}
@@ -177,6 +178,15 @@ namespace el1::io::serialization
 		{
 			TCodec<T>::Deserialize(archive, value);
 		};
+
+		// readers which cannot know the number of items up front (e.g. streaming ones) announce every item instead
+		// BeginArray()/BeginMap() return nothing, NextElement()/NextMapEntry() return false after the last item
+		template<typename TArchive>
+		concept CStreamingArchive = requires(TArchive& archive, const usys_t index)
+		{
+			{ archive.NextElement(index) } -> std::same_as<bool>;
+			{ archive.NextMapEntry(index) } -> std::same_as<bool>;
+		};
 	}
 
 	template<typename TArchive, typename T>
@@ -302,29 +312,55 @@ namespace el1::io::serialization
 		}
 		else if constexpr(detail::TIsStringMap<U>::value)
 		{
-			const usys_t count = archive.BeginMap();
-			value.Clear();
-			for(usys_t i = 0; i < count; i++)
+			auto entry = [&](const usys_t i)
 			{
 				const TString key = archive.BeginMapEntry(i);
 				typename detail::TIsStringMap<U>::value_t item{};
 				Deserialize(archive, item);
 				archive.EndMapEntry();
 				value.Add(key, std::move(item));
+			};
+
+			if constexpr(detail::CStreamingArchive<TArchive>)
+			{
+				archive.BeginMap();
+				value.Clear();
+				for(usys_t i = 0; archive.NextMapEntry(i); i++)
+					entry(i);
+			}
+			else
+			{
+				const usys_t count = archive.BeginMap();
+				value.Clear();
+				for(usys_t i = 0; i < count; i++)
+					entry(i);
 			}
 			archive.EndMap();
 		}
 		else if constexpr(detail::TIsList<U>::value)
 		{
-			const usys_t count = archive.BeginArray();
-			value.Clear(count);
-			for(usys_t i = 0; i < count; i++)
+			auto element = [&](const usys_t i)
 			{
 				archive.BeginElement(i);
 				typename detail::TIsList<U>::value_t item{};
 				Deserialize(archive, item);
 				value.Append(std::move(item));
 				archive.EndElement();
+			};
+
+			if constexpr(detail::CStreamingArchive<TArchive>)
+			{
+				archive.BeginArray();
+				value.Clear();
+				for(usys_t i = 0; archive.NextElement(i); i++)
+					element(i);
+			}
+			else
+			{
+				const usys_t count = archive.BeginArray();
+				value.Clear(count);
+				for(usys_t i = 0; i < count; i++)
+					element(i);
 			}
 			archive.EndArray();
 		}
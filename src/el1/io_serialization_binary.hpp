@@ -16,38 +16,91 @@ namespace el1::io::serialization::binary::packed
 
 	inline constexpr u32_t FORMAT_VERSION = 1;
 
+	// output goes through an internal buffer, which is passed on to the sink when it is full, by Flush() or on destruction
 	class TWriter
 	{
 		IBinarySink* sink;
+		usys_t n_buffered = 0;
+		byte_t buffer[4096];
 
-		void Byte(const byte_t value) { sink->WriteAll(&value, 1); }
+		void Drain()
+		{
+			if(n_buffered == 0)
+				return;
+			sink->WriteAll(buffer, n_buffered);
+			n_buffered = 0;
+		}
+
+		void Reserve(const usys_t n_bytes)
+		{
+			if(n_buffered + n_bytes > sizeof(buffer))
+				Drain();
+		}
 
-		void VarUInt(u64_t value)
+		static constexpr usys_t VarUIntSize(u64_t value)
 		{
+			usys_t n_bytes = 1;
+			for(; value >= 0x80; value >>= 7)
+				n_bytes++;
+			return n_bytes;
+		}
+
+		static usys_t EncodeVarUInt(byte_t* const out, u64_t value)
+		{
+			usys_t n_bytes = 0;
 			while(value >= 0x80)
 			{
-				Byte((byte_t)(value | 0x80));
+				out[n_bytes++] = (byte_t)(value | 0x80);
 				value >>= 7;
 			}
-			Byte((byte_t)value);
+			out[n_bytes++] = (byte_t)value;
+			return n_bytes;
+		}
+
+		void Byte(const byte_t value)
+		{
+			Reserve(1);
+			buffer[n_buffered++] = value;
+		}
+
+		void VarUInt(const u64_t value)
+		{
+			Reserve(10);
+			n_buffered += EncodeVarUInt(buffer + n_buffered, value);
 		}
 
-		void Fixed64(u64_t value)
+		void Fixed64(const u64_t value)
 		{
-			byte_t data[8];
+			Reserve(8);
 			for(unsigned i = 0; i < 8; i++)
-				data[i] = (byte_t)(value >> (i * 8));
-			sink->WriteAll(data, 8);
+				buffer[n_buffered++] = (byte_t)(value >> (i * 8));
 		}
 
 	public:
 		explicit TWriter(IBinarySink* const sink EL_LIFETIME_BOUND) : sink(sink)
 		{
 			static constexpr byte_t MAGIC[] = {'E', 'L', '1', 'S'};
-			sink->WriteAll(MAGIC, sizeof(MAGIC));
+			memcpy(buffer, MAGIC, sizeof(MAGIC));
+			n_buffered = sizeof(MAGIC);
 			VarUInt(FORMAT_VERSION);
 		}
 
+		~TWriter()
+		{
+			// destructors cannot report output errors, call Flush() to observe them
+			try { Drain(); }
+			catch(...) {}
+		}
+
+		TWriter(const TWriter&) = delete;
+
+		// passes the buffered output on to the sink and flushes it
+		void Flush()
+		{
+			Drain();
+			sink->Flush();
+		}
+
 		void BeginOptional(const bool present) { Byte(present ? 1 : 0); }
 		void EndOptional() {}
 		void Boolean(const bool value) { Byte(value ? 1 : 0); }
@@ -59,13 +112,38 @@ namespace el1::io::serialization::binary::packed
 		void Unsigned(const u64_t value) { VarUInt(value); }
 		void Floating(const double value) { Fixed64(std::bit_cast<u64_t>(value)); }
 
+		// UTF-8 is encoded straight into the buffer
 		void String(const TStringView value)
 		{
-			TString copy(value);
-			TList<byte_t> bytes = copy.chars.Pipe().Transform(TUTF8Encoder()).Collect();
-			VarUInt(bytes.Count());
-			if(bytes.Count() != 0)
-				sink->WriteAll(bytes.Data(), bytes.Count());
+			const usys_t n_chars = value.Count();
+			const char32_t* const arr_chars = value.ItemPtr(0);
+			if(10 + 4 * n_chars <= sizeof(buffer))
+			{
+				// the characters go behind room for the longest possible length prefix, the gap is closed if the prefix turns out shorter
+				Reserve(10 + 4 * n_chars);
+				const usys_t n_prefix_max = VarUIntSize(4 * n_chars);
+				byte_t* const data = buffer + n_buffered + n_prefix_max;
+				const usys_t n_bytes = n_chars == 0 ? 0 : EncodeUTF8(arr_chars, n_chars, data);
+				const usys_t n_prefix = EncodeVarUInt(buffer + n_buffered, n_bytes);
+				if(n_prefix != n_prefix_max)
+					memmove(buffer + n_buffered + n_prefix, data, n_bytes);
+				n_buffered += n_prefix + n_bytes;
+			}
+			else
+			{
+				usys_t n_bytes = 0;
+				for(usys_t i = 0; i < n_chars; i++)
+					n_bytes += GetEncodedSequenceLength(arr_chars[i]);
+				VarUInt(n_bytes);
+
+				for(usys_t i = 0; i < n_chars; )
+				{
+					const usys_t n = util::Min<usys_t>(n_chars - i, sizeof(buffer) / 4);
+					Reserve(4 * n);
+					n_buffered += EncodeUTF8(arr_chars + i, n, buffer + n_buffered);
+					i += n;
+				}
+			}
 		}
 
 		void BeginObject(const TTypeInfo& info)
@@ -87,42 +165,113 @@ namespace el1::io::serialization::binary::packed
 		void EndMap() {}
 	};
 
+	// reads in place from memory (e.g. a TMapping), from the window of a buffered source or byte-exact from any other source
+	// no source gets bytes consumed which follow the serialized value, so several values can be read one after the other
+	// plain sources are read in small pieces, wrap them in a TPullBuffer when they carry more than a single value
 	class TReader
 	{
-		IBinarySource* source;
+		IBinarySource* source;	// nullptr unless reading from a plain source
+		IBufferedSource<byte_t>* buffered;	// nullptr unless reading from a buffered source
+		TList<byte_t> buffer;
+		const byte_t* base;	// start of the window of the buffered source
+		const byte_t* p;
+		const byte_t* end;
 		TDeserializeOptions options;
 		usys_t depth = 0;
 
+		// makes at least n_bytes available at p
+		void Refill(const usys_t n_bytes)
+		{
+			if(buffered != nullptr)
+			{
+				// only the decoded bytes are consumed, the rest of the window stays in the source
+				buffered->Shift((usys_t)(p - base));
+				base = p;
+				EL_ERROR(!buffered->Ensure(n_bytes), TStreamDryException);
+				const auto head = buffered->Head();
+				base = p = head.Data();
+				end = p + head.Count();
+				return;
+			}
+
+			EL_ERROR(source == nullptr, TStreamDryException);
+
+			const usys_t n_keep = (usys_t)(end - p);
+			if(buffer.Count() < n_bytes)
+			{
+				TList<byte_t> larger;
+				larger.SetCount(util::Max<usys_t>(n_bytes, 2 * buffer.Count()));
+				if(n_keep != 0)
+					memcpy(larger.Data(), p, n_keep);
+				buffer = std::move(larger);
+			}
+			else if(n_keep != 0)
+				memmove(buffer.Data(), p, n_keep);
+
+			// reads no further than required, a plain source cannot take bytes back
+			source->ReadAll(buffer.Data() + n_keep, n_bytes - n_keep);
+			p = buffer.Data();
+			end = p + n_bytes;
+		}
+
+		void Need(const usys_t n_bytes)
+		{
+			if((usys_t)(end - p) < n_bytes)
+				Refill(n_bytes);
+		}
+
 		byte_t Byte()
 		{
-			byte_t value;
-			source->ReadAll(&value, 1);
-			return value;
+			if(p == end)
+				Refill(1);
+			return *p++;
 		}
 
 		u64_t VarUInt()
 		{
 			u64_t value = 0;
-			for(unsigned shift = 0; shift < 64; shift += 7)
+			if(end - p >= 10)
 			{
-				const byte_t byte = Byte();
-				value |= (u64_t)(byte & 0x7f) << shift;
-				if((byte & 0x80) == 0)
-					return value;
+				// no varint runs past the end, so the bytes need no checks
+				for(unsigned shift = 0; shift < 64; shift += 7)
+				{
+					const byte_t byte = *p++;
+					value |= (u64_t)(byte & 0x7f) << shift;
+					if((byte & 0x80) == 0)
+						return value;
+				}
+			}
+			else
+			{
+				for(unsigned shift = 0; shift < 64; shift += 7)
+				{
+					const byte_t byte = Byte();
+					value |= (u64_t)(byte & 0x7f) << shift;
+					if((byte & 0x80) == 0)
+						return value;
+				}
 			}
 			EL_THROW(TException, U"invalid packed serialization varint");
 		}
 
 		u64_t Fixed64()
 		{
-			byte_t data[8];
-			source->ReadAll(data, 8);
+			Need(8);
 			u64_t value = 0;
 			for(unsigned i = 0; i < 8; i++)
-				value |= (u64_t)data[i] << (i * 8);
+				value |= (u64_t)p[i] << (i * 8);
+			p += 8;
 			return value;
 		}
 
+		void ReadHeader()
+		{
+			Need(4);
+			EL_ERROR(p[0] != 'E' || p[1] != 'L' || p[2] != '1' || p[3] != 'S', TException, U"invalid packed serialization magic");
+			p += 4;
+			EL_ERROR(VarUInt() != FORMAT_VERSION, TException, U"unsupported packed serialization format version");
+		}
+
 		void Enter()
 		{
 			EL_ERROR(depth >= options.max_depth, TException, U"maximum serialization nesting depth exceeded");
@@ -135,14 +284,31 @@ namespace el1::io::serialization::binary::packed
 		}
 
 	public:
-		explicit TReader(IBinarySource* const source EL_LIFETIME_BOUND, const TDeserializeOptions& options = {}) : source(source), options(options)
+		explicit TReader(IBinarySource* const source EL_LIFETIME_BOUND, const TDeserializeOptions& options = {}) : source(source), buffered(nullptr), base(nullptr), p(nullptr), end(nullptr), options(options)
 		{
-			byte_t magic[4];
-			source->ReadAll(magic, 4);
-			EL_ERROR(magic[0] != 'E' || magic[1] != 'L' || magic[2] != '1' || magic[3] != 'S', TException, U"invalid packed serialization magic");
-			EL_ERROR(VarUInt() != FORMAT_VERSION, TException, U"unsupported packed serialization format version");
+			ReadHeader();
+		}
+
+		// decodes straight from the window of the source, the consumed bytes are shifted out of it at the latest on destruction
+		explicit TReader(IBufferedSource<byte_t>* const source EL_LIFETIME_BOUND, const TDeserializeOptions& options = {}) : source(nullptr), buffered(source), base(nullptr), p(nullptr), end(nullptr), options(options)
+		{
+			ReadHeader();
+		}
+
+		// the bytes must stay mapped while the reader is in use, strings are decoded straight from them
+		explicit TReader(const array_t<const byte_t> bytes EL_LIFETIME_BOUND, const TDeserializeOptions& options = {}) : source(nullptr), buffered(nullptr), base(bytes.Data()), p(bytes.Data()), end(bytes.Data() + bytes.Count()), options(options)
+		{
+			ReadHeader();
 		}
 
+		~TReader()
+		{
+			if(buffered != nullptr)
+				buffered->Shift((usys_t)(p - base));
+		}
+
+		TReader(const TReader&) = delete;
+
 		bool BeginOptional()
 		{
 			const byte_t tag = Byte();
@@ -173,11 +339,18 @@ namespace el1::io::serialization::binary::packed
 			const u64_t count64 = VarUInt();
 			EL_ERROR(count64 > options.max_string_length || count64 > (u64_t)std::numeric_limits<usys_t>::max(), TException, U"maximum serialized string length exceeded");
 			const usys_t count = (usys_t)count64;
-			TList<byte_t> bytes;
-			bytes.SetCount(count);
+			TString text;
 			if(count != 0)
-				source->ReadAll(bytes.Data(), count);
-			return bytes.Pipe().Transform(TUTF8Decoder()).Collect();
+			{
+				Need(count);
+				// UTF-8 never has fewer bytes than characters
+				text.chars.SetCount(count);
+				usys_t n_chars;
+				EL_ERROR(DecodeUTF8(p, count, text.chars.Data(), n_chars) != count, TException, U"serialized string ends within a UTF-8 sequence");
+				text.chars.SetCount(n_chars);
+				p += count;
+			}
+			return text;
 		}
 
 		u32_t BeginObject(const TTypeInfo& expected)
@@ -220,8 +393,10 @@ namespace el1::io::serialization::binary::packed
 	{
 		TWriter writer(&sink);
 		serialization::Serialize(writer, value);
+		writer.Flush();
 	}
 
+	// reads exactly the bytes of one value, the next value can be deserialized from the same source
 	template<typename T>
 	T Deserialize(IBinarySource& source, const TDeserializeOptions& options = {})
 	{
@@ -231,6 +406,15 @@ namespace el1::io::serialization::binary::packed
 		return value;
 	}
 
+	template<typename T>
+	T Deserialize(IBufferedSource<byte_t>& source, const TDeserializeOptions& options = {})
+	{
+		TReader reader(&source, options);
+		T value{};
+		serialization::Deserialize(reader, value);
+		return value;
+	}
+
 	template<typename T>
 	TList<byte_t> ToBytes(const T& value)
 	{
@@ -240,10 +424,13 @@ namespace el1::io::serialization::binary::packed
 		return bytes;
 	}
 
+	// reads in place, bytes can be a TList or a TMapping
 	template<typename T>
-	T FromBytes(TList<byte_t> bytes, const TDeserializeOptions& options = {})
+	T FromBytes(const array_t<const byte_t> bytes, const TDeserializeOptions& options = {})
 	{
-		TListSource<byte_t> source(std::move(bytes));
-		return Deserialize<T>(source, options);
+		TReader reader(bytes, options);
+		T value{};
+		serialization::Deserialize(reader, value);
+		return value;
 	}
 }
@@ -0,0 +1,719 @@
+#pragma once
+
+#include "io_serialization.hpp"
+#include "io_stream.hpp"
+#include "io_text_encoding_utf8.hpp"
+#include "io_collection_list.hpp"
+
+#include <bit>
+#include <string.h>
+
+// random access binary format for memory mapped snapshots
+// every value is an 8 byte slot: booleans, integers and doubles are stored in the slot itself, everything else is the
+// file offset of a block which the slot refers to; blocks are 8 byte aligned and made of 8 byte words:
+//   string:    n_bytes, UTF-8 bytes (padded)
+//   list:      count, slot[count]
+//   map:       count, { key slot (a string), value slot }[count], sorted by key like TSortedMap
+//   optional:  the slot of the value, a slot of 0 means empty
+//   object:    type id high, type id low, version (u32) + n_fields (u32), field id (u32)[n_fields] (padded), slot[n_fields]
+// blocks are written after the blocks they refer to, so every offset points below the block holding it
+// the file starts with the magic "EL1M" and the format version, the footer at the end holds the root slot
+// opening a file only checks the header and footer, values are decoded where and when they are accessed
+
+namespace el1::io::serialization::binary::mapped
+{
+	using namespace io::stream;
+	using namespace io::collection::list;
+	using namespace io::text::encoding::utf8;
+
+	static_assert(std::endian::native == std::endian::little, "the mapped serialization format is accessed in place and is little endian");
+
+	inline constexpr u32_t FORMAT_VERSION = 1;
+	inline constexpr usys_t HEADER_SIZE = 16;	// magic, format version, reserved
+	inline constexpr usys_t FOOTER_SIZE = 24;	// root slot, offset of the footer, format version, magic
+
+	namespace detail
+	{
+		// TList shrinks its buffer when items are removed, the archives push and pop for every value
+		template<typename T>
+		struct stack_t
+		{
+			TList<T> items;
+			usys_t count = 0;
+
+			void Push(const T& item)
+			{
+				if(count == items.Count())
+					items.SetCount(util::Max<usys_t>(64, 2 * count));
+				items.Data()[count++] = item;
+			}
+
+			T& Top() EL_GETTER { return items.Data()[count - 1]; }
+			const T* ItemPtr(const usys_t index) const EL_GETTER { return items.ItemPtr(index); }
+		};
+	}
+
+	// the serialized bytes with validated header and footer, e.g. a TMapping of a snapshot file
+	class TImage
+	{
+		array_t<const byte_t> bytes;
+		u64_t root;
+		u64_t data_end;	// offset of the footer
+
+	public:
+		struct container_t
+		{
+			u64_t block;
+			u64_t count;
+			u64_t items;	// offset of the first slot
+		};
+
+		struct object_t
+		{
+			u64_t block;
+			u32_t version;
+			u32_t n_fields;
+			u64_t ids;
+			u64_t slots;
+		};
+
+		u64_t Root() const EL_GETTER { return root; }
+		u64_t DataEnd() const EL_GETTER { return data_end; }
+
+		u64_t Word(const u64_t offset) const EL_GETTER
+		{
+			u64_t value;
+			memcpy(&value, bytes.Data() + offset, sizeof(value));
+			return value;
+		}
+
+		u32_t HalfWord(const u64_t offset) const EL_GETTER
+		{
+			u32_t value;
+			memcpy(&value, bytes.Data() + offset, sizeof(value));
+			return value;
+		}
+
+		// a block of at least n_bytes at the offset in slot, which must end at or below limit
+		u64_t Block(const u64_t slot, const u64_t n_bytes, const u64_t limit) const
+		{
+			EL_ERROR(slot < HEADER_SIZE || slot % 8 != 0 || slot > limit || n_bytes > limit - slot, TException, U"mapped serialization refers to a block outside of its range");
+			return slot;
+		}
+
+		container_t Container(const u64_t slot, const u64_t limit, const u64_t slots_per_item) const
+		{
+			const u64_t block = Block(slot, 8, limit);
+			const u64_t count = Word(block);
+			EL_ERROR(count > (limit - block - 8) / (8 * slots_per_item), TException, U"mapped serialization container exceeds its range");
+			return { block, count, block + 8 };
+		}
+
+		array_t<const byte_t> Utf8(const u64_t slot, const u64_t limit) const
+		{
+			const u64_t block = Block(slot, 8, limit);
+			const u64_t n_bytes = Word(block);
+			EL_ERROR(n_bytes > limit - block - 8, TException, U"mapped serialization string exceeds its range");
+			return array_t<const byte_t>::FromUnsafePointer(bytes.Data() + block + 8, (usys_t)n_bytes);
+		}
+
+		object_t Object(const u64_t slot, const u64_t limit, const TTypeInfo& expected) const
+		{
+			const u64_t block = Block(slot, 24, limit);
+			EL_ERROR(Word(block) != expected.id.high || Word(block + 8) != expected.id.low, TException, U"serialized type does not match requested C++ type");
+			const u32_t version = HalfWord(block + 16);
+			const u32_t n_fields = HalfWord(block + 20);
+			EL_ERROR(version == 0 || version > expected.version, TException, U"serialized schema version is not supported by this C++ type");
+			const u64_t n_ids = ((u64_t)n_fields * 4 + 7) / 8 * 8;
+			EL_ERROR(n_ids + (u64_t)n_fields * 8 > limit - block - 24, TException, U"mapped serialization object exceeds its range");
+			return { block, version, n_fields, block + 24, block + 24 + n_ids };
+		}
+
+		// returns false if the object has no slot for the field id
+		bool Field(const object_t& object, const u32_t id, u64_t& slot) const
+		{
+			for(u32_t i = 0; i < object.n_fields; i++)
+				if(HalfWord(object.ids + 4 * i) == id)
+				{
+					slot = Word(object.slots + 8 * i);
+					return true;
+				}
+			return false;
+		}
+
+		explicit TImage(const array_t<const byte_t> bytes EL_LIFETIME_BOUND) : bytes(bytes)
+		{
+			const usys_t n_bytes = bytes.Count();
+			EL_ERROR(n_bytes < HEADER_SIZE + FOOTER_SIZE || n_bytes % 8 != 0, TException, U"mapped serialization is truncated");
+			const byte_t* const data = bytes.Data();
+			EL_ERROR(memcmp(data, "EL1M", 4) != 0 || memcmp(data + n_bytes - 4, "EL1M", 4) != 0, TException, U"invalid mapped serialization magic");
+			EL_ERROR(HalfWord(4) != FORMAT_VERSION || HalfWord(n_bytes - 8) != FORMAT_VERSION, TException, U"unsupported mapped serialization format version");
+			root = Word(n_bytes - FOOTER_SIZE);
+			data_end = Word(n_bytes - FOOTER_SIZE + 8);
+			EL_ERROR(data_end != n_bytes - FOOTER_SIZE, TException, U"mapped serialization is truncated");
+		}
+	};
+
+	class TWriter
+	{
+		enum class EFrame : u8_t
+		{
+			ROOT,
+			OBJECT,
+			LIST,
+			MAP,
+			OPTIONAL
+		};
+
+		struct frame_t
+		{
+			EFrame kind;
+			usys_t i_slots;	// first entry of slots[] which belongs to the frame
+			usys_t i_ids;
+			const TTypeInfo* info;
+		};
+
+		IBinarySink* sink;
+		u64_t pos = 0;	// offset of the next byte
+		detail::stack_t<frame_t> frames;
+		detail::stack_t<u64_t> slots;
+		detail::stack_t<u32_t> ids;
+		usys_t n_buffered = 0;
+		byte_t buffer[4096];
+
+		void Drain()
+		{
+			if(n_buffered == 0)
+				return;
+			sink->WriteAll(buffer, n_buffered);
+			n_buffered = 0;
+		}
+
+		void Reserve(const usys_t n_bytes)
+		{
+			if(n_buffered + n_bytes > sizeof(buffer))
+				Drain();
+		}
+
+		void Write(const void* const data, const usys_t n_bytes)
+		{
+			if(n_buffered + n_bytes <= sizeof(buffer))
+			{
+				memcpy(buffer + n_buffered, data, n_bytes);
+				n_buffered += n_bytes;
+				pos += n_bytes;
+				return;
+			}
+
+			for(usys_t i = 0; i < n_bytes; )
+			{
+				if(n_buffered == sizeof(buffer))
+					Drain();
+				const usys_t n = util::Min<usys_t>(n_bytes - i, sizeof(buffer) - n_buffered);
+				memcpy(buffer + n_buffered, (const byte_t*)data + i, n);
+				n_buffered += n;
+				i += n;
+			}
+			pos += n_bytes;
+		}
+
+		void Word(const u64_t value) { Write(&value, sizeof(value)); }
+
+		void Pad()
+		{
+			static const byte_t ZEROS[8] = {};
+			if(pos % 8 != 0)
+				Write(ZEROS, 8 - pos % 8);
+		}
+
+		void Push(const EFrame kind, const TTypeInfo* const info = nullptr)
+		{
+			frames.Push({ kind, slots.count, ids.count, info });
+		}
+
+		frame_t Pop(const EFrame kind)
+		{
+			EL_ERROR(frames.count < 2 || frames.Top().kind != kind, TLogicException);
+			frames.count--;
+			return *frames.ItemPtr(frames.count);
+		}
+
+		void Slot(const u64_t value)
+		{
+			slots.Push(value);
+		}
+
+		// writes the slots of the frame and removes them
+		void WriteSlots(const frame_t& frame)
+		{
+			const usys_t n_slots = slots.count - frame.i_slots;
+			if(n_slots != 0)
+				Write(slots.ItemPtr(frame.i_slots), n_slots * 8);
+			slots.count = frame.i_slots;
+		}
+
+		// UTF-8 is encoded straight into the buffer behind its length word
+		u64_t WriteString(const TStringView value)
+		{
+			const u64_t block = pos;
+			const usys_t n_chars = value.Count();
+			const char32_t* const arr_chars = value.ItemPtr(0);
+			if(8 + 4 * n_chars <= sizeof(buffer))
+			{
+				Reserve(8 + 4 * n_chars);
+				const u64_t n_bytes = n_chars == 0 ? 0 : EncodeUTF8(arr_chars, n_chars, buffer + n_buffered + 8);
+				memcpy(buffer + n_buffered, &n_bytes, 8);
+				n_buffered += 8 + n_bytes;
+				pos += 8 + n_bytes;
+			}
+			else
+			{
+				u64_t n_bytes = 0;
+				for(usys_t i = 0; i < n_chars; i++)
+					n_bytes += GetEncodedSequenceLength(arr_chars[i]);
+				Word(n_bytes);
+
+				for(usys_t i = 0; i < n_chars; )
+				{
+					const usys_t n = util::Min<usys_t>(n_chars - i, sizeof(buffer) / 4);
+					Reserve(4 * n);
+					const usys_t n_encoded = EncodeUTF8(arr_chars + i, n, buffer + n_buffered);
+					n_buffered += n_encoded;
+					pos += n_encoded;
+					i += n;
+				}
+			}
+			Pad();
+			return block;
+		}
+
+	public:
+		explicit TWriter(IBinarySink* const sink EL_LIFETIME_BOUND) : sink(sink)
+		{
+			const byte_t header[HEADER_SIZE] = { 'E', 'L', '1', 'M', (byte_t)FORMAT_VERSION, 0, 0, 0 };
+			Write(header, sizeof(header));
+			Push(EFrame::ROOT);
+		}
+
+		TWriter(const TWriter&) = delete;
+
+		void BeginOptional(const bool) { Push(EFrame::OPTIONAL); }
+		void EndOptional()
+		{
+			const frame_t frame = Pop(EFrame::OPTIONAL);
+			if(slots.count == frame.i_slots)
+				return Slot(0);
+			const u64_t block = pos;
+			WriteSlots(frame);
+			Slot(block);
+		}
+
+		void Boolean(const bool value) { Slot(value ? 1 : 0); }
+		void Signed(const s64_t value) { Slot((u64_t)value); }
+		void Unsigned(const u64_t value) { Slot(value); }
+		void Floating(const double value) { Slot(std::bit_cast<u64_t>(value)); }
+		void String(const TStringView value) { Slot(WriteString(value)); }
+
+		void BeginObject(const TTypeInfo& info) { Push(EFrame::OBJECT, &info); }
+		void EndObject()
+		{
+			const frame_t frame = Pop(EFrame::OBJECT);
+			const usys_t n_fields = ids.count - frame.i_ids;
+			EL_ERROR(slots.count - frame.i_slots != n_fields, TLogicException);
+
+			const u64_t block = pos;
+			Word(frame.info->id.high);
+			Word(frame.info->id.low);
+			const u32_t counts[2] = { frame.info->version, (u32_t)n_fields };
+			Write(counts, sizeof(counts));
+			if(n_fields != 0)
+				Write(ids.ItemPtr(frame.i_ids), n_fields * 4);
+			ids.count = frame.i_ids;
+			Pad();
+			WriteSlots(frame);
+			Slot(block);
+		}
+
+		void BeginField(const TFieldInfo& info) { ids.Push(info.id); }
+		void EndField() {}
+
+		void BeginArray(const usys_t) { Push(EFrame::LIST); }
+		void BeginElement(const usys_t) {}
+		void EndElement() {}
+		void EndArray()
+		{
+			const frame_t frame = Pop(EFrame::LIST);
+			const u64_t block = pos;
+			Word(slots.count - frame.i_slots);
+			WriteSlots(frame);
+			Slot(block);
+		}
+
+		void BeginMap(const usys_t) { Push(EFrame::MAP); }
+		void BeginMapEntry(const usys_t, const TStringView key) { Slot(WriteString(key)); }
+		void EndMapEntry() {}
+		void EndMap()
+		{
+			const frame_t frame = Pop(EFrame::MAP);
+			const u64_t block = pos;
+			Word((slots.count - frame.i_slots) / 2);
+			WriteSlots(frame);
+			Slot(block);
+		}
+
+		// writes the footer after the root value and flushes the sink
+		void Finish()
+		{
+			EL_ERROR(frames.count != 1 || slots.count != 1, TLogicException);
+			const u64_t data_end = pos;
+			Word(*slots.ItemPtr(0));
+			Word(data_end);
+			const byte_t tail[8] = { (byte_t)FORMAT_VERSION, 0, 0, 0, 'E', 'L', '1', 'M' };
+			Write(tail, sizeof(tail));
+			slots.count = 0;
+			Drain();
+			sink->Flush();
+		}
+	};
+
+	// deserializes the value in a slot, limit is the offset of the block holding the slot
+	class TReader
+	{
+		struct frame_t
+		{
+			u64_t block;
+			u64_t count;
+			u64_t items;
+			TImage::object_t object;
+		};
+
+		const TImage* image;
+		TDeserializeOptions options;
+		u64_t slot;
+		u64_t limit;
+		detail::stack_t<frame_t> frames;
+
+		void Enter()
+		{
+			EL_ERROR(frames.count >= options.max_depth, TException, U"maximum serialization nesting depth exceeded");
+		}
+		void Leave()
+		{
+			EL_ERROR(frames.count == 0, TLogicException);
+			frames.count--;
+		}
+
+		void Item(const u64_t offset)
+		{
+			slot = image->Word(offset);
+			limit = frames.Top().block;
+		}
+
+	public:
+		TReader(const TImage& image EL_LIFETIME_BOUND, const u64_t slot, const u64_t limit, const TDeserializeOptions& options = {}) : image(&image), options(options), slot(slot), limit(limit) {}
+		explicit TReader(const TImage& image EL_LIFETIME_BOUND, const TDeserializeOptions& options = {}) : TReader(image, image.Root(), image.DataEnd(), options) {}
+		TReader(const TReader&) = delete;
+
+		bool BeginOptional()
+		{
+			if(slot == 0)
+				return false;
+			const u64_t block = image->Block(slot, 8, limit);
+			slot = image->Word(block);
+			limit = block;
+			return true;
+		}
+		void EndOptional() {}
+
+		bool Boolean()
+		{
+			EL_ERROR(slot > 1, TException, U"invalid mapped boolean");
+			return slot != 0;
+		}
+		s64_t Signed() { return (s64_t)slot; }
+		u64_t Unsigned() { return slot; }
+		double Floating() { return std::bit_cast<double>(slot); }
+
+		TString String()
+		{
+			const array_t<const byte_t> bytes = image->Utf8(slot, limit);
+			EL_ERROR(bytes.Count() > options.max_string_length, TException, U"maximum serialized string length exceeded");
+			TString text;
+			if(bytes.Count() != 0)
+			{
+				// UTF-8 never has fewer bytes than characters
+				text.chars.SetCount(bytes.Count());
+				usys_t n_chars;
+				EL_ERROR(DecodeUTF8(bytes.Data(), bytes.Count(), text.chars.Data(), n_chars) != bytes.Count(), TException, U"serialized string ends within a UTF-8 sequence");
+				text.chars.SetCount(n_chars);
+			}
+			return text;
+		}
+
+		u32_t BeginObject(const TTypeInfo& expected)
+		{
+			Enter();
+			const TImage::object_t object = image->Object(slot, limit, expected);
+			frames.Push({ object.block, object.n_fields, object.slots, object });
+			return object.version;
+		}
+		void EndObject()
+		{
+			Leave();
+		}
+
+		bool BeginField(const TFieldInfo& info)
+		{
+			u64_t field_slot;
+			if(!image->Field(frames.Top().object, info.id, field_slot))
+				return false;
+			slot = field_slot;
+			limit = frames.Top().block;
+			return true;
+		}
+		void EndField() {}
+
+		usys_t BeginArray()
+		{
+			Enter();
+			const TImage::container_t list = image->Container(slot, limit, 1);
+			EL_ERROR(list.count > options.max_container_items, TException, U"maximum serialized container size exceeded");
+			frames.Push({ list.block, list.count, list.items, {} });
+			return (usys_t)list.count;
+		}
+		void BeginElement(const usys_t index) { Item(frames.Top().items + 8 * index); }
+		void EndElement() {}
+		void EndArray()
+		{
+			Leave();
+		}
+
+		usys_t BeginMap()
+		{
+			Enter();
+			const TImage::container_t map = image->Container(slot, limit, 2);
+			EL_ERROR(map.count > options.max_container_items, TException, U"maximum serialized map size exceeded");
+			frames.Push({ map.block, map.count, map.items, {} });
+			return (usys_t)map.count;
+		}
+		TString BeginMapEntry(const usys_t index)
+		{
+			Item(frames.Top().items + 16 * index);
+			TString key = String();
+			Item(frames.Top().items + 16 * index + 8);
+			return key;
+		}
+		void EndMapEntry() {}
+		void EndMap()
+		{
+			Leave();
+		}
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		struct TMemberPointer;
+
+		template<typename C, typename V>
+		struct TMemberPointer<V C::*>
+		{
+			using object_t = C;
+			using value_t = V;
+		};
+
+		// the item type for the declarations of TView, void where T has none
+		template<typename T> struct TItem { using value_t = void; };
+		template<typename T> struct TItem<TList<T>> { using value_t = T; };
+		template<typename V> struct TItem<io::collection::map::TSortedMap<TString, V>> { using value_t = V; };
+		template<typename V> struct TItem<std::optional<V>> { using value_t = V; };
+
+		struct field_lookup_t
+		{
+			TFieldInfo info;
+			bool found;
+		};
+
+		template<typename T, auto MEMBER>
+		consteval field_lookup_t FindMember()
+		{
+			field_lookup_t result{};
+			std::apply([&](const auto&... member)
+			{
+				([&]
+				{
+					if constexpr(std::same_as<decltype(member.pointer), decltype(MEMBER)>)
+						if(member.pointer == MEMBER)
+							result = { member.info, true };
+				}(), ...);
+			}, TSchema<T>::Members());
+			return result;
+		}
+	}
+
+	// typed access to a value in place, nothing is decoded before it is accessed
+	// Load() deserializes the value, the rest depends on T:
+	//   TList:            Count(), operator[]
+	//   TSortedMap:       Count(), Key(), Value(), Find() by binary search
+	//   TString:          Utf8() without copying
+	//   std::optional:    HasValue(), Value()
+	//   TSchema objects:  Version(), Has<&T::member>(), Field<&T::member>()
+	template<typename T>
+	class TView
+	{
+		const TImage* image;
+		u64_t slot;
+		u64_t limit;
+
+		template<auto MEMBER>
+		static constexpr TFieldInfo MemberInfo()
+		{
+			static_assert(std::same_as<typename detail::TMemberPointer<decltype(MEMBER)>::object_t, T>, "member pointer of a different type");
+			constexpr detail::field_lookup_t lookup = detail::FindMember<T, MEMBER>();
+			static_assert(lookup.found, "member is not part of the TSchema");
+			return lookup.info;
+		}
+
+		TImage::object_t Object() const requires CHasSchema<T>
+		{
+			static constexpr TTypeInfo INFO = TSchema<T>::Info();
+			return image->Object(slot, limit, INFO);
+		}
+
+		TImage::container_t Container() const
+		{
+			return image->Container(slot, limit, serialization::detail::TIsStringMap<T>::value ? 2 : 1);
+		}
+
+		TImage::container_t Item(const usys_t index) const
+		{
+			const TImage::container_t container = Container();
+			EL_ERROR(index >= container.count, TIndexOutOfBoundsException, 0, (ssys_t)container.count - 1, (ssys_t)index);
+			return container;
+		}
+
+	public:
+		T Load(const TDeserializeOptions& options = {}) const
+		{
+			TReader reader(*image, slot, limit, options);
+			T value{};
+			serialization::Deserialize(reader, value);
+			return value;
+		}
+
+		usys_t Count() const requires (serialization::detail::TIsList<T>::value || serialization::detail::TIsStringMap<T>::value)
+		{
+			return (usys_t)Container().count;
+		}
+
+		TView<typename detail::TItem<T>::value_t> operator[](const usys_t index) const requires serialization::detail::TIsList<T>::value
+		{
+			const TImage::container_t list = Item(index);
+			return TView<typename detail::TItem<T>::value_t>(*image, image->Word(list.items + 8 * index), list.block);
+		}
+
+		TView<TString> Key(const usys_t index) const requires serialization::detail::TIsStringMap<T>::value
+		{
+			const TImage::container_t map = Item(index);
+			return TView<TString>(*image, image->Word(map.items + 16 * index), map.block);
+		}
+
+		TView<typename detail::TItem<T>::value_t> Value(const usys_t index) const requires serialization::detail::TIsStringMap<T>::value
+		{
+			const TImage::container_t map = Item(index);
+			return TView<typename detail::TItem<T>::value_t>(*image, image->Word(map.items + 16 * index + 8), map.block);
+		}
+
+		// UTF-8 orders like the code points, so the sorted keys are searched as bytes
+		std::optional<TView<typename detail::TItem<T>::value_t>> Find(const TStringView key) const requires serialization::detail::TIsStringMap<T>::value
+		{
+			const TList<byte_t> needle = EncodeUTF8(key);
+			const TImage::container_t map = Container();
+			u64_t low = 0;
+			u64_t high = map.count;
+			while(low < high)
+			{
+				const u64_t mid = low + (high - low) / 2;
+				const array_t<const byte_t> candidate = image->Utf8(image->Word(map.items + 16 * mid), map.block);
+				const usys_t n_common = util::Min(candidate.Count(), needle.Count());
+				int cmp = n_common == 0 ? 0 : memcmp(candidate.Data(), needle.Data(), n_common);
+				if(cmp == 0)
+					cmp = candidate.Count() < needle.Count() ? -1 : (candidate.Count() > needle.Count() ? 1 : 0);
+				if(cmp == 0)
+					return TView<typename detail::TItem<T>::value_t>(*image, image->Word(map.items + 16 * mid + 8), map.block);
+				if(cmp < 0)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+			return std::nullopt;
+		}
+
+		array_t<const byte_t> Utf8() const requires std::same_as<T, TString>
+		{
+			return image->Utf8(slot, limit);
+		}
+
+		bool HasValue() const requires serialization::detail::TIsOptional<T>::value
+		{
+			return slot != 0;
+		}
+
+		TView<typename detail::TItem<T>::value_t> Value() const requires serialization::detail::TIsOptional<T>::value
+		{
+			EL_ERROR(slot == 0, TException, U"the serialized optional is empty");
+			const u64_t block = image->Block(slot, 8, limit);
+			return TView<typename detail::TItem<T>::value_t>(*image, image->Word(block), block);
+		}
+
+		u32_t Version() const requires CHasSchema<T>
+		{
+			return Object().version;
+		}
+
+		// false for fields which were not part of the schema version that wrote the object
+		template<auto MEMBER>
+		bool Has() const requires CHasSchema<T>
+		{
+			u64_t field_slot;
+			return image->Field(Object(), MemberInfo<MEMBER>().id, field_slot);
+		}
+
+		template<auto MEMBER>
+		TView<typename detail::TMemberPointer<decltype(MEMBER)>::value_t> Field() const requires CHasSchema<T>
+		{
+			const TImage::object_t object = Object();
+			u64_t field_slot;
+			EL_ERROR(!image->Field(object, MemberInfo<MEMBER>().id, field_slot), TException, U"the field is not part of the serialized object");
+			return TView<typename detail::TMemberPointer<decltype(MEMBER)>::value_t>(*image, field_slot, object.block);
+		}
+
+		TView(const TImage& image EL_LIFETIME_BOUND, const u64_t slot, const u64_t limit) : image(&image), slot(slot), limit(limit) {}
+		explicit TView(const TImage& image EL_LIFETIME_BOUND) : TView(image, image.Root(), image.DataEnd()) {}
+	};
+
+	template<typename T>
+	void Serialize(IBinarySink& sink, const T& value)
+	{
+		TWriter writer(&sink);
+		serialization::Serialize(writer, value);
+		writer.Finish();
+	}
+
+	template<typename T>
+	TList<byte_t> ToBytes(const T& value)
+	{
+		TList<byte_t> bytes;
+		TListSink<byte_t> sink(&bytes);
+		Serialize(sink, value);
+		return bytes;
+	}
+
+	// bytes can be a TList or a TMapping
+	template<typename T>
+	T FromBytes(const array_t<const byte_t> bytes, const TDeserializeOptions& options = {})
+	{
+		const TImage image(bytes);
+		return TView<T>(image).Load(options);
+	}
+}
@@ -2,10 +2,13 @@
 
 #include "io_serialization.hpp"
 #include "io_format_json.hpp"
+#include "io_text_encoding_utf8.hpp"
+#include <charconv>
 #include <cmath>
 
 namespace el1::io::serialization::json
 {
+	using format::json::EJsonToken;
 	using format::json::TJsonArray;
 	using format::json::TJsonMap;
 	using format::json::TJsonValue;
@@ -96,8 +99,16 @@ namespace el1::io::serialization::json
 
 	class TReader
 	{
+		// TSortedMap items are chunked and indexed access walks the chunks, so map entries are read through an iterator
+		struct map_cursor_t
+		{
+			io::collection::map::TChunkedList<format::json::TConstJsonMap::kv_pair_t>::const_iterator_t item;
+			usys_t index;
+		};
+
 		const TJsonValue* current;
 		io::collection::list::TList<const TJsonValue*> parents;
+		io::collection::list::TList<map_cursor_t> maps;
 		TDeserializeOptions options;
 		usys_t depth = 0;
 
@@ -215,18 +226,506 @@ namespace el1::io::serialization::json
 			EL_ERROR(!current->IsMap(), TException, U"expected JSON object/map during deserialization");
 			const usys_t count = current->Map().Items().Count();
 			EL_ERROR(count > options.max_container_items, TException, U"maximum serialized map size exceeded");
+			maps.Append({ current->Map().Items().begin(), 0 });
 			return count;
 		}
 		TString BeginMapEntry(const usys_t index)
 		{
-			EL_ERROR(!current->IsMap() || index >= current->Map().Items().Count(), TLogicException);
-			const auto& item = current->Map().Items()[index];
+			EL_ERROR(!current->IsMap() || index >= current->Map().Items().Count() || maps.Count() == 0, TLogicException);
+			map_cursor_t& cursor = maps[-1];
+			if(index < cursor.index)
+				cursor = { current->Map().Items().begin(), 0 };
+			for(; cursor.index < index; cursor.index++)
+				++cursor.item;
+			const auto& item = *cursor.item;
 			TString key = item.key;
 			Push(item.value);
 			return key;
 		}
 		void EndMapEntry() { Pop(); }
-		void EndMap() {}
+		void EndMap()
+		{
+			EL_ERROR(maps.Count() == 0, TLogicException);
+			maps.Remove(-1);
+		}
+	};
+
+	// writes compact UTF-8 JSON to the sink while the schema is traversed, no TJsonValue is built
+	// objects start with the $el1 metadata, their fields follow in schema order (TWriter sorts them by name)
+	// output is buffered, Flush() must be called after the last value
+	class TStreamWriter
+	{
+		stream::ISink<byte_t>* const sink;
+		usys_t n_buffered = 0;
+		byte_t buffer[4096];
+
+		void Drain()
+		{
+			sink->WriteAll(buffer, n_buffered);
+			n_buffered = 0;
+		}
+
+		void Reserve(const usys_t n_bytes)
+		{
+			if(n_buffered + n_bytes > sizeof(buffer))
+				Drain();
+		}
+
+		void Put(const char chr)
+		{
+			Reserve(1);
+			buffer[n_buffered++] = (byte_t)chr;
+		}
+
+		template<usys_t N>
+		void Put(const char (&text)[N])
+		{
+			static_assert(N - 1 <= sizeof(buffer));
+			Reserve(N - 1);
+			memcpy(buffer + n_buffered, text, N - 1);
+			n_buffered += N - 1;
+		}
+
+		template<typename T>
+		void PutNumber(const T value)
+		{
+			Reserve(32);
+			const auto result = std::to_chars((char*)buffer + n_buffered, (char*)buffer + sizeof(buffer), value);
+			n_buffered = (usys_t)(result.ptr - (char*)buffer);
+		}
+
+		void PutHex(const u64_t value)
+		{
+			static const char DIGITS[] = "0123456789abcdef";
+			Reserve(16);
+			for(unsigned i = 0; i < 16; i++)
+				buffer[n_buffered++] = (byte_t)DIGITS[(value >> (60 - 4 * i)) & 0xf];
+		}
+
+		static bool NeedsEscape(const char32_t chr)
+		{
+			return chr < 32 || chr == U'"' || chr == U'\\';
+		}
+
+		// same escapes as format::json::JsonQuote()
+		void Escape(const char32_t chr)
+		{
+			static const char DIGITS[] = "0123456789abcdef";
+			if(chr == U'\n')
+				Put("\\n");
+			else if(chr == U'\t')
+				Put("\\t");
+			else if(chr < 32)
+			{
+				Put("\\u00");
+				Put(DIGITS[chr >> 4]);
+				Put(DIGITS[chr & 0xf]);
+			}
+			else
+			{
+				Put('\\');
+				Put((char)chr);
+			}
+		}
+
+		void Quote(const TStringView text)
+		{
+			Put('"');
+			const usys_t n_chars = text.Count();
+			const char32_t* const arr_chars = text.ItemPtr(0);
+			for(usys_t i = 0; i < n_chars; )
+			{
+				// runs without escapes are transcoded in bulk
+				usys_t n_run = 0;
+				while(i + n_run < n_chars && !NeedsEscape(arr_chars[i + n_run]))
+					n_run++;
+
+				while(n_run > 0)
+				{
+					const usys_t n = util::Min<usys_t>(n_run, sizeof(buffer) / 4);
+					Reserve(4 * n);
+					n_buffered += text::encoding::utf8::EncodeUTF8(arr_chars + i, n, buffer + n_buffered);
+					i += n;
+					n_run -= n;
+				}
+
+				if(i < n_chars)
+					Escape(arr_chars[i++]);
+			}
+			Put('"');
+		}
+
+	public:
+		void BeginOptional(const bool present) { if(!present) Put("null"); }
+		void EndOptional() {}
+		void Boolean(const bool value) { if(value) Put("true"); else Put("false"); }
+		void Signed(const s64_t value) { PutNumber(value); }
+		void Unsigned(const u64_t value) { PutNumber(value); }
+		void Floating(const double value)
+		{
+			EL_ERROR(!std::isfinite(value), TException, U"JSON serialization does not support NaN or infinity");
+			// shortest representation which parses back to the same double
+			PutNumber(value);
+		}
+		void String(const TStringView value) { Quote(value); }
+
+		void BeginObject(const TTypeInfo& info)
+		{
+			Put("{\"$el1\":{\"format\":");
+			PutNumber(FORMAT_VERSION);
+			Put(",\"type\":");
+			Quote(info.name);
+			Put(",\"type_id\":\"");
+			PutHex(info.id.high);
+			PutHex(info.id.low);
+			Put("\",\"version\":");
+			PutNumber(info.version);
+			Put('}');
+		}
+		void EndObject() { Put('}'); }
+
+		void BeginField(const TFieldInfo& info)
+		{
+			Put(',');
+			Quote(info.name);
+			Put(':');
+		}
+		void EndField() {}
+
+		void BeginArray(const usys_t) { Put('['); }
+		void BeginElement(const usys_t index) { if(index != 0) Put(','); }
+		void EndElement() {}
+		void EndArray() { Put(']'); }
+
+		void BeginMap(const usys_t) { Put('{'); }
+		void BeginMapEntry(const usys_t index, const TStringView key)
+		{
+			if(index != 0)
+				Put(',');
+			Quote(key);
+			Put(':');
+		}
+		void EndMapEntry() {}
+		void EndMap() { Put('}'); }
+
+		// passes the buffered output on to the sink and flushes it
+		void Flush()
+		{
+			Drain();
+			sink->Flush();
+		}
+
+		explicit TStreamWriter(stream::ISink<byte_t>* const sink) : sink(sink) {}
+		TStreamWriter(const TStreamWriter&) = delete;
+	};
+
+	// deserializes straight from the tokens of a TJsonReader, which must be positioned on the first token of the value
+	// and is left on its last token
+	// object keys are matched against the precomputed TFieldInfo::name_id of the schema; keys which arrive before
+	// their field is asked for (e.g. from TWriter, which sorts them by name) are kept as TJsonValue and read through a TReader
+	class TStreamReader
+	{
+		struct deferred_t
+		{
+			u32_t name_id;
+			TString name;
+			TJsonValue value;
+		};
+
+		struct object_t
+		{
+			usys_t i_deferred;	// first entry of deferred[] which belongs to this object
+			bool ended;			// the END_MAP was consumed while looking for a field
+		};
+
+		format::json::TJsonReader* const json;
+		TDeserializeOptions options;
+		usys_t depth = 0;
+		io::collection::list::TList<object_t> objects;
+		io::collection::list::TList<deferred_t> deferred;
+
+		// active while a deferred field is read
+		std::optional<TReader> dom;
+		usys_t n_dom_fields = 0;	// fields entered below the deferred one
+		io::collection::list::TList<usys_t> dom_counts;	// item counts of the arrays and maps entered below it
+
+		void Enter()
+		{
+			EL_ERROR(depth >= options.max_depth, TException, U"maximum serialization nesting depth exceeded");
+			depth++;
+		}
+
+		void Leave()
+		{
+			EL_ERROR(depth == 0, TLogicException);
+			depth--;
+		}
+
+		// the current token is a key, its value is read and kept for a later BeginField()
+		void Defer()
+		{
+			TString name = json->String();
+			const u32_t name_id = FieldId(name);
+			json->Next();
+			deferred.MoveAppend({ name_id, std::move(name), json->ReadValue() });
+		}
+
+		// the same checks as TReader::BeginObject(), straight from the tokens of the $el1 value
+		u32_t ReadMetadata(const TTypeInfo& expected)
+		{
+			EL_ERROR(json->Token() != EJsonToken::BEGIN_MAP, TException, U"serialized $el1 metadata must be an object");
+			bool has_format = false;
+			bool has_type_id = false;
+			bool has_version = false;
+			s64_t version = 0;
+			while(json->Next() == EJsonToken::KEY)
+			{
+				if(json->String() == TStringView(U"format"))
+				{
+					json->Next();
+					EL_ERROR(json->ToInteger<s64_t>() != (s64_t)FORMAT_VERSION, TException, U"unsupported serialization JSON format version");
+					has_format = true;
+				}
+				else if(json->String() == TStringView(U"type_id"))
+				{
+					json->Next();
+					EL_ERROR(json->Token() != EJsonToken::STRING, TException, U"serialized type_id must be a string");
+					EL_ERROR(TTypeId::FromString(json->String()) != expected.id, TException, U"serialized type does not match requested C++ type");
+					has_type_id = true;
+				}
+				else if(json->String() == TStringView(U"version"))
+				{
+					json->Next();
+					version = json->ToInteger<s64_t>();
+					has_version = true;
+				}
+				else
+				{
+					json->Next();
+					json->Skip();
+				}
+			}
+			EL_ERROR(!has_format || !has_type_id || !has_version, TException, U"serialized object metadata is incomplete");
+			EL_ERROR(version <= 0 || (u64_t)version > expected.version, TException, U"serialized schema version is not supported by this C++ type");
+			return (u32_t)version;
+		}
+
+		void EnterDeferred(const TJsonValue& value)
+		{
+			TDeserializeOptions dom_options = options;
+			dom_options.max_depth -= depth;
+			dom.emplace(value, dom_options);
+		}
+
+	public:
+		bool BeginOptional() const
+		{
+			if(dom)
+				return dom->BeginOptional();
+			return json->Token() != EJsonToken::NULLVALUE;
+		}
+		void EndOptional() {}
+
+		bool Boolean()
+		{
+			if(dom)
+				return dom->Boolean();
+			EL_ERROR(json->Token() != EJsonToken::BOOLEAN, TException, U"expected JSON boolean during deserialization");
+			return json->Boolean();
+		}
+
+		s64_t Signed()
+		{
+			if(dom)
+				return dom->Signed();
+			return json->ToInteger<s64_t>();
+		}
+
+		u64_t Unsigned()
+		{
+			if(dom)
+				return dom->Unsigned();
+			return json->ToInteger<u64_t>();
+		}
+
+		double Floating()
+		{
+			if(dom)
+				return dom->Floating();
+			EL_ERROR(json->Token() != EJsonToken::NUMBER, TException, U"expected JSON number during deserialization");
+			return json->Number();
+		}
+
+		TString String()
+		{
+			if(dom)
+				return dom->String();
+			EL_ERROR(json->Token() != EJsonToken::STRING, TException, U"expected JSON string during deserialization");
+			EL_ERROR(json->String().Length() > options.max_string_length, TException, U"maximum serialized string length exceeded");
+			return json->String();
+		}
+
+		u32_t BeginObject(const TTypeInfo& expected)
+		{
+			if(dom)
+				return dom->BeginObject(expected);
+
+			EL_ERROR(json->Token() != EJsonToken::BEGIN_MAP, TException, U"expected JSON object during deserialization");
+			Enter();
+			const usys_t i_deferred = deferred.Count();
+			for(;;)
+			{
+				EL_ERROR(json->Next() != EJsonToken::KEY, TException, U"serialized object is missing $el1 metadata");
+				if(json->String() == METADATA_KEY)
+					break;
+				Defer();
+			}
+			json->Next();
+			const u32_t version = ReadMetadata(expected);
+			objects.Append({ i_deferred, false });
+			return version;
+		}
+
+		void EndObject()
+		{
+			if(dom)
+				return dom->EndObject();
+
+			const object_t object = objects[-1];
+			if(!object.ended)
+				while(json->Next() != EJsonToken::END_MAP)
+				{
+					json->Next();
+					json->Skip();
+				}
+			if(deferred.Count() > object.i_deferred)
+				deferred.Remove(object.i_deferred, deferred.Count() - object.i_deferred);
+			objects.Remove(-1);
+			Leave();
+		}
+
+		bool BeginField(const TFieldInfo& info)
+		{
+			if(dom)
+			{
+				if(!dom->BeginField(info))
+					return false;
+				n_dom_fields++;
+				return true;
+			}
+
+			object_t& object = objects[-1];
+			for(usys_t i = object.i_deferred; i < deferred.Count(); i++)
+				if(deferred[i].name_id == info.name_id && deferred[i].name == info.name)
+				{
+					EnterDeferred(deferred[i].value);
+					return true;
+				}
+
+			// keys of other fields on the way are deferred, the END_MAP means the field is missing
+			while(!object.ended)
+			{
+				if(json->Next() == EJsonToken::END_MAP)
+				{
+					object.ended = true;
+					break;
+				}
+
+				const TString& name = json->String();
+				if(FieldId(name) == info.name_id && name == info.name)
+				{
+					json->Next();
+					return true;
+				}
+				Defer();
+			}
+			return false;
+		}
+
+		void EndField()
+		{
+			if(!dom)
+				return;
+			if(n_dom_fields == 0)
+				dom.reset();
+			else
+			{
+				dom->EndField();
+				n_dom_fields--;
+			}
+		}
+
+		void BeginArray()
+		{
+			if(dom)
+			{
+				dom_counts.Append(dom->BeginArray());
+				return;
+			}
+			EL_ERROR(json->Token() != EJsonToken::BEGIN_ARRAY, TException, U"expected JSON array during deserialization");
+			Enter();
+		}
+		bool NextElement(const usys_t index)
+		{
+			if(dom)
+				return index < dom_counts[-1];
+			if(json->Next() == EJsonToken::END_ARRAY)
+				return false;
+			EL_ERROR(index >= options.max_container_items, TException, U"maximum serialized container size exceeded");
+			return true;
+		}
+		void BeginElement(const usys_t index) { if(dom) dom->BeginElement(index); }
+		void EndElement() { if(dom) dom->EndElement(); }
+		void EndArray()
+		{
+			if(dom)
+			{
+				dom_counts.Remove(-1);
+				return dom->EndArray();
+			}
+			Leave();
+		}
+
+		void BeginMap()
+		{
+			if(dom)
+			{
+				dom_counts.Append(dom->BeginMap());
+				return;
+			}
+			EL_ERROR(json->Token() != EJsonToken::BEGIN_MAP, TException, U"expected JSON object/map during deserialization");
+			Enter();
+		}
+		bool NextMapEntry(const usys_t index)
+		{
+			if(dom)
+				return index < dom_counts[-1];
+			if(json->Next() == EJsonToken::END_MAP)
+				return false;
+			EL_ERROR(index >= options.max_container_items, TException, U"maximum serialized map size exceeded");
+			return true;
+		}
+		TString BeginMapEntry(const usys_t index)
+		{
+			if(dom)
+				return dom->BeginMapEntry(index);
+			TString key = json->String();
+			json->Next();
+			return key;
+		}
+		void EndMapEntry() { if(dom) dom->EndMapEntry(); }
+		void EndMap()
+		{
+			if(dom)
+			{
+				dom_counts.Remove(-1);
+				return dom->EndMap();
+			}
+			Leave();
+		}
+
+		explicit TStreamReader(format::json::TJsonReader& json, const TDeserializeOptions& options = {}) : json(&json), options(options) {}
+		TStreamReader(const TStreamReader&) = delete;
 	};
 
 	template<typename T>
@@ -263,4 +762,32 @@ namespace el1::io::serialization::json
 	{
 		return FromValue<T>(TJsonValue::Parse(text), options);
 	}
+
+	// writes the JSON of value to the sink without building a TJsonValue and flushes the sink
+	template<typename T>
+	void ToStream(stream::ISink<byte_t>& sink, const T& value)
+	{
+		TStreamWriter writer(&sink);
+		serialization::Serialize(writer, value);
+		writer.Flush();
+	}
+
+	// reads one JSON value from the source into target without building a TJsonValue
+	// TJsonReader reads ahead, bytes which follow the value are consumed from the source
+	template<typename T>
+	void FromStream(stream::ISource<byte_t>& source, T& target, const TDeserializeOptions& options = {})
+	{
+		format::json::TJsonReader json(&source);
+		json.Next();
+		TStreamReader reader(json, options);
+		serialization::Deserialize(reader, target);
+	}
+
+	template<typename T>
+	T FromStream(stream::ISource<byte_t>& source, const TDeserializeOptions& options = {})
+	{
+		T target{};
+		FromStream(source, target, options);
+		return target;
+	}
 }
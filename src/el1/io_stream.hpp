@@ -365,6 +365,10 @@ namespace el1::io::stream
 	template<typename T>
 	using borrow_or_own_t = std::conditional_t<std::is_lvalue_reference_v<T>, T, std::decay_t<T>>;
 
+	// items which the consumers of a pipe collect in temporary stack buffers and fetch through NextBatch()
+	template<typename T>
+	inline constexpr bool IS_BATCHABLE = std::is_trivially_copyable_v<std::remove_const_t<T>> && std::is_default_constructible_v<std::remove_const_t<T>>;
+
 	template<typename TPipe, typename _TOut>
 	struct IPipe : public TPipeSource<TPipe, _TOut, std::is_copy_constructible_v<_TOut> >
 	{
@@ -375,6 +379,14 @@ namespace el1::io::stream
 		// the returned item pointer needs only to be valid until the next call
 		virtual TOut* NextItem() EL_LIFETIME_BOUND = 0;
 
+		// fetches up to n_items_max items at once, points batch at them and returns their number
+		// batch is either arr_buffer (which must be able to hold n_items_max items) or memory owned by the pipe, in both cases it is only valid until the next call
+		// "next call" includes NextItem(): a transformer which pulls more items from its source must copy what it still needs from the batch first
+		// returning 0 means the same as NextItem() returning nullptr; n_items_max must not be 0
+		// the default implementation copies the items from NextItem() into arr_buffer, pipes which hold their items in memory or can process many at once override it
+		// NextItem() and NextBatch() can be mixed freely
+		virtual usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch) EL_WARN_UNUSED_RESULT;
+
 		template<typename L>
 		auto Filter(L&& callable) & EL_LIFETIME_BOUND -> TFilterPipe<TPipe&, std::decay_t<L>>;
 
@@ -443,6 +455,18 @@ namespace el1::io::stream
 		{
 			return reinterpret_cast<const TOut*>(source->NextItem());
 		}
+
+		// passes whole batches through when the item types have the same layout
+		template<typename TSourceStream, typename TBatchItem>
+			requires (sizeof(typename TSourceStream::TOut) == sizeof(TOut) && alignof(typename TSourceStream::TOut) == alignof(TOut) && (std::is_const_v<TBatchItem> || !std::is_const_v<typename TSourceStream::TOut>))
+		usys_t NextBatch(TSourceStream* const source, std::remove_const_t<TBatchItem>* const arr_buffer, const usys_t n_items_max, TBatchItem*& batch)
+		{
+			using TIn = typename TSourceStream::TOut;
+			TIn* in_batch;
+			const usys_t n = source->NextBatch(reinterpret_cast<std::remove_const_t<TIn>*>(arr_buffer), n_items_max, in_batch);
+			batch = reinterpret_cast<TBatchItem*>(in_batch);
+			return n;
+		}
 	};
 
 	class TKernelStream : public ISink<byte_t>, public ISource<byte_t>
@@ -466,6 +490,10 @@ namespace el1::io::stream
 
 			void Flush() final override;
 
+			// these go through the io_uring of the calling thread when its IoBackend() is IO_URING
+			usys_t BlockingRead(byte_t* const arr_items, const usys_t n_items_max, system::time::TTime timeout = -1, const bool absolute_time = false) override EL_WARN_UNUSED_RESULT;
+			void WriteAll(const byte_t* const arr_items, const usys_t n_items) override;
+
 			TKernelStream(system::handle::THandle handle);
 			TKernelStream(const file::TPath& path);
 	};
@@ -510,6 +538,43 @@ namespace el1::io::stream
 				}
 			}
 
+			usys_t NextBatch(T* const arr_buffer, const usys_t n_items_max, T*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				for(;;)
+				{
+					if(index < n_items)
+					{
+						const usys_t n = util::Min(n_items - index, n_items_max);
+						batch = buffer.get() + index;
+						index += n;
+						return n;
+					}
+
+					// large requests are read directly into the callers buffer
+					usys_t r;
+					if(n_items_max >= N_ITEMS_BUFFER)
+					{
+						r = source->Read(arr_buffer, n_items_max);
+						batch = arr_buffer;
+						if(r > 0)
+							return r;
+					}
+					else
+					{
+						index = 0;
+						r = n_items = source->Read(buffer.get(), N_ITEMS_BUFFER);
+					}
+
+					if(r == 0)
+					{
+						const system::waitable::IWaitable* const on_input_ready = source->OnInputReady();
+						if(on_input_ready == nullptr)
+							return 0;
+						on_input_ready->WaitFor();
+					}
+				}
+			}
+
 			TSourcePipe(ISource<T>* const source EL_LIFETIME_BOUND) : source(source), buffer(std::unique_ptr<T[]>(new T[N_ITEMS_BUFFER])), index(0), n_items(0) {}
 			TSourcePipe(const TSourcePipe&) = delete;
 			TSourcePipe(TSourcePipe&&) = default;
@@ -546,6 +611,34 @@ namespace el1::io::stream
 				}
 			}
 
+			usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				if constexpr(std::is_copy_assignable_v<std::remove_const_t<TOut>>)
+				{
+					for(;;)
+					{
+						TIn* in_batch;
+						const usys_t n_in = source.NextBatch(arr_buffer, n_items_max, in_batch);
+						if(n_in == 0)
+							return 0;
+
+						// in_batch may be arr_buffer itself, the items are only ever moved towards the front
+						usys_t n_out = 0;
+						for(usys_t i = 0; i < n_in; i++)
+							if(callable(in_batch[i]))
+								arr_buffer[n_out++] = in_batch[i];
+
+						if(n_out > 0)
+						{
+							batch = arr_buffer;
+							return n_out;
+						}
+					}
+				}
+				else
+					return IPipe<TFilterPipe<TSource, L>, TOut>::NextBatch(arr_buffer, n_items_max, batch);
+			}
+
 			TFilterPipe(TSource source EL_LIFETIME_BOUND, L callable) requires std::is_reference_v<TSource> : source(source), callable(std::move(callable)) {}
 			TFilterPipe(TSource source, L callable) requires (!std::is_reference_v<TSource>) : source(std::move(source)), callable(std::move(callable)) {}
 	};
@@ -570,6 +663,15 @@ namespace el1::io::stream
 				return source.NextItem();
 			}
 
+			usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				if(EL_UNLIKELY(n_remaining == 0))
+					return 0;
+				const usys_t n = source.NextBatch(arr_buffer, (usys_t)util::Min<iosize_t>(n_remaining, n_items_max), batch);
+				n_remaining -= n;
+				return n;
+			}
+
 			TLimitPipe(TSource source EL_LIFETIME_BOUND, const iosize_t n_items_limit) requires std::is_reference_v<TSource> : source(source), n_remaining(n_items_limit) {}
 			TLimitPipe(TSource source, const iosize_t n_items_limit) requires (!std::is_reference_v<TSource>) : source(std::move(source)), n_remaining(n_items_limit) {}
 	};
@@ -656,6 +758,25 @@ namespace el1::io::stream
 				return &out;
 			}
 
+			usys_t NextBatch(TOut* const arr_buffer, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				if constexpr(IS_BATCHABLE<TIn> && std::is_copy_assignable_v<TOut>)
+				{
+					static const usys_t N_ITEMS_INPUT = util::Max<usys_t>(1, 1024U / sizeof(TIn));
+					std::remove_const_t<TIn> in_buffer[N_ITEMS_INPUT];
+
+					TIn* in_batch;
+					const usys_t n = source.NextBatch(in_buffer, util::Min(n_items_max, N_ITEMS_INPUT), in_batch);
+					for(usys_t i = 0; i < n; i++)
+						arr_buffer[i] = callable(in_batch[i]);
+
+					batch = arr_buffer;
+					return n;
+				}
+				else
+					return IPipe<TMapPipe<TSource, L>, TOut>::NextBatch(arr_buffer, n_items_max, batch);
+			}
+
 			TMapPipe(TSource source EL_LIFETIME_BOUND, L callable) requires std::is_reference_v<TSource> : source(source), callable(std::move(callable)), out() {}
 			TMapPipe(TSource source, L callable) requires (!std::is_reference_v<TSource>) : source(std::move(source)), callable(std::move(callable)), out() {}
 	};
@@ -685,12 +806,32 @@ namespace el1::io::stream
 				return item;
 			}
 
+			template<std::size_t... Is>
+			usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch, std::index_sequence<Is...>)
+			{
+				usys_t n = 0;
+				#ifdef EL_CC_CLANG
+					#pragma clang diagnostic push
+					#pragma clang diagnostic ignored "-Wunused-value"
+				#endif
+				( ((n = std::get<Is>(streams).NextBatch(arr_buffer, n_items_max, batch)) != 0) || ... );
+				#ifdef EL_CC_CLANG
+					#pragma clang diagnostic pop
+				#endif
+				return n;
+			}
+
 		public:
 			TOut* NextItem() EL_LIFETIME_BOUND final override
 			{
 				return NextItem(std::make_index_sequence<std::tuple_size<decltype(streams)>::value>{});
 			}
 
+			usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				return NextBatch(arr_buffer, n_items_max, batch, std::make_index_sequence<std::tuple_size<decltype(streams)>::value>{});
+			}
+
 			TConcatPipe(TPipes ... streams) : streams(std::move(streams) ...) {}
 	};
 
@@ -713,6 +854,15 @@ namespace el1::io::stream
 				return transformator.NextItem(&source);
 			}
 
+			// transformators can optionally process whole batches, otherwise NextItem() is called for every item
+			usys_t NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				if constexpr(requires { transformator.NextBatch(&source, arr_buffer, n_items_max, batch); })
+					return transformator.NextBatch(&source, arr_buffer, n_items_max, batch);
+				else
+					return IPipe<TTransformPipe<TSource, TTransformator>, TOut>::NextBatch(arr_buffer, n_items_max, batch);
+			}
+
 			TTransformPipe(TSource source EL_LIFETIME_BOUND, TTransformator transformator EL_LIFETIME_BOUND)
 				requires std::is_reference_v<TSource> && std::is_reference_v<TTransformator>
 				: source(source), transformator(transformator) {}
@@ -844,43 +994,66 @@ namespace el1::io::stream
 	usys_t TPipeSource<TPipe, TOut, true>::Read(TOutBase* const arr_items, const usys_t n_items_max)
 	{
 		TPipe* source = static_cast<TPipe*>(this);
-		for(usys_t i = 0; i < n_items_max; i++)
+		usys_t n_read = 0;
+		while(n_read < n_items_max)
 		{
-			auto item = source->NextItem();
-			if(item == nullptr)
-				return i;
-			arr_items[i] = *item;
+			TOut* batch;
+			const usys_t n = source->NextBatch(arr_items + n_read, n_items_max - n_read, batch);
+			if(n == 0)
+				break;
+
+			if(batch != arr_items + n_read)
+				for(usys_t i = 0; i < n; i++)
+					arr_items[n_read + i] = batch[i];
+
+			n_read += n;
 		}
-		return n_items_max;
+		return n_read;
 	}
 
 	template<typename TPipe, typename TOut>
-	iosize_t IPipe<TPipe, TOut>::ToStream(ISink<std::remove_const_t<TOut>>& sink)
+	usys_t IPipe<TPipe, TOut>::NextBatch(std::remove_const_t<TOut>* const arr_buffer, const usys_t n_items_max, TOut*& batch)
 	{
 		TPipe* source = static_cast<TPipe*>(this);
-		iosize_t n_total = 0;
-
-		const usys_t sz_buffer = util::Max<usys_t>(1, 4096 / sizeof(TOut));
-		std::remove_const_t<TOut> buffer[sz_buffer];
-
-		for(;;)
+		if constexpr(std::is_copy_assignable_v<std::remove_const_t<TOut>>)
 		{
-			usys_t n_read = 0;
-			for(; n_read < sz_buffer; n_read++)
+			usys_t n = 0;
+			for(; n < n_items_max; n++)
 			{
 				auto item = source->NextItem();
 				if(item == nullptr)
 					break;
-
-				buffer[n_read] = *item;
+				arr_buffer[n] = *item;
 			}
+			batch = arr_buffer;
+			return n;
+		}
+		else
+		{
+			// items which cannot be copied are handed out one at a time
+			batch = source->NextItem();
+			return batch == nullptr ? 0 : 1;
+		}
+	}
 
-			sink.WriteAll(buffer, n_read);
+	template<typename TPipe, typename TOut>
+	iosize_t IPipe<TPipe, TOut>::ToStream(ISink<std::remove_const_t<TOut>>& sink)
+	{
+		TPipe* source = static_cast<TPipe*>(this);
+		iosize_t n_total = 0;
 
-			n_total += n_read;
+		const usys_t sz_buffer = util::Max<usys_t>(1, 4096 / sizeof(TOut));
+		std::remove_const_t<TOut> buffer[sz_buffer];
 
-			if(n_read < sz_buffer)
+		for(;;)
+		{
+			TOut* batch;
+			const usys_t n_read = source->NextBatch(buffer, sz_buffer, batch);
+			if(n_read == 0)
 				return n_total;
+
+			sink.WriteAll(batch, n_read);
+			n_total += n_read;
 		}
 	}
 
@@ -889,13 +1062,32 @@ namespace el1::io::stream
 	{
 		TPipe* source = static_cast<TPipe*>(this);
 		usys_t i = 0;
-		for(;;)
+
+		if constexpr(IS_BATCHABLE<TOut>)
 		{
-			auto item = source->NextItem();
-			if(item == nullptr)
-				return i;
-			list.Append(*item);
-			i++;
+			const usys_t sz_buffer = util::Max<usys_t>(1, 4096 / sizeof(TOut));
+			std::remove_const_t<TOut> buffer[sz_buffer];
+
+			for(;;)
+			{
+				TOut* batch;
+				const usys_t n = source->NextBatch(buffer, sz_buffer, batch);
+				if(n == 0)
+					return i;
+				list.Append(batch, n);
+				i += n;
+			}
+		}
+		else
+		{
+			for(;;)
+			{
+				auto item = source->NextItem();
+				if(item == nullptr)
+					return i;
+				list.Append(*item);
+				i++;
+			}
 		}
 		return i;
 	}
@@ -939,8 +1131,19 @@ namespace el1::io::stream
 		iosize_t count = 0;
 		TPipe* source = static_cast<TPipe*>(this);
 
-		for(const TOut* item = source->NextItem(); item != nullptr; item = source->NextItem())
-			count++;
+		if constexpr(IS_BATCHABLE<TOut>)
+		{
+			const usys_t sz_buffer = util::Max<usys_t>(1, 4096 / sizeof(TOut));
+			std::remove_const_t<TOut> buffer[sz_buffer];
+			TOut* batch;
+			for(usys_t n = source->NextBatch(buffer, sz_buffer, batch); n != 0; n = source->NextBatch(buffer, sz_buffer, batch))
+				count += n;
+		}
+		else
+		{
+			for(const TOut* item = source->NextItem(); item != nullptr; item = source->NextItem())
+				count++;
+		}
 
 		return count;
 	}
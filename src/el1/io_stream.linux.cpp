@@ -16,50 +16,134 @@ namespace el1::io::stream
 	using namespace system::handle;
 	using namespace system::waitable;
 	using namespace system::task;
+	using namespace system::time;
 
-	template<>
-	iosize_t Pump<byte_t>(ISource<byte_t>& source, ISink<byte_t>& sink, const iosize_t n_items_max, const bool blocking)
+	// the most sendfile() and splice() transfer in one call
+	static const iosize_t KERNEL_COPY_MAX = 0x7ffff000U;
+
+	// waits for the sink unless the caller does not want to block, returns false if the transfer has to stop
+	static bool WaitForSink(ISink<byte_t>& sink, const bool blocking)
+	{
+		if(!blocking)
+			return false;
+		const IWaitable* const waitable = sink.OnOutputReady();
+		if(waitable == nullptr)
+			return false;
+		waitable->WaitFor();
+		return true;
+	}
+
+	// sendfile() needs a source which can be mapped (a regular file or a block device)
+	// returns NEG1 if the kernel does not support the pair of handles and nothing was transferred yet
+	static iosize_t PumpSendfile(const handle_t h_source, ISink<byte_t>& sink, const handle_t h_sink, const iosize_t n_items_max, const bool blocking)
+	{
+		iosize_t n_pumped = 0;
+		while(n_pumped < n_items_max)
+		{
+			const ssize_t r = sendfile(h_sink, h_source, nullptr, util::Min(n_items_max - n_pumped, KERNEL_COPY_MAX));
+			if(r > 0)
+			{
+				n_pumped += r;
+				continue;
+			}
+
+			if(r == 0)
+				break;
+
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				if(!WaitForSink(sink, blocking))
+					break;
+				continue;
+			}
+
+			if((errno == EINVAL || errno == ENOSYS) && n_pumped == 0)
+				return NEG1;
+
+			EL_THROW(TSyscallException, errno);
+		}
+		return n_pumped;
+	}
+
+	// moves the data through a pipe with splice(), which works for any source the kernel can splice from (sockets, pipes, ...)
+	// what was taken from the source is always delivered to the sink, even if this means waiting for the sink
+	// sets unsupported if the kernel refused the source, the caller has to continue with Read() then
+	// (this also happens mid-stream on kTLS sockets when a non-data record like an alert arrives)
+	static iosize_t PumpSplice(ISource<byte_t>& source, const handle_t h_source, ISink<byte_t>& sink, const handle_t h_sink, const iosize_t n_items_max, const bool blocking, bool& unsupported)
 	{
-		if(source.Handle() != INVALID_HANDLE && sink.Handle() != INVALID_HANDLE)
+		unsupported = false;
+		int fds[2] = { -1, -1 };
+		EL_SYSERR(pipe2(fds, O_CLOEXEC | O_NONBLOCK));
+		const THandle pipe_rx(fds[0], true);
+		const THandle pipe_tx(fds[1], true);
+
+		iosize_t n_pumped = 0;
+		while(n_pumped < n_items_max)
 		{
-			// const int f_source = EL_SYSERR(fcntl(source.Handle(), F_GETFL));
-			// const int f_sink = EL_SYSERR(fcntl(sink.Handle(), F_GETFL));
-			// EL_SYSERR(fcntl(source.Handle(), F_SETFL, f_source & (~O_NONBLOCK)));
-			// EL_SYSERR(fcntl(sink.Handle(), F_SETFL, f_sink & (~O_NONBLOCK)));
-			// EL_SYSERR(fcntl(source.Handle(), F_SETFL, f_source));
-			// EL_SYSERR(fcntl(sink.Handle(), F_SETFL, f_sink));
-
-			if(blocking)
+			ssize_t n_in = splice(h_source, nullptr, pipe_tx, nullptr, util::Min(n_items_max - n_pumped, KERNEL_COPY_MAX), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			if(n_in == 0)
+				break;
+
+			if(n_in < 0)
 			{
-				iosize_t n_pumped = 0;
-				while(n_pumped < n_items_max)
+				if(errno == EAGAIN || errno == EWOULDBLOCK)
 				{
-					const ssize_t r = sendfile(sink.Handle(), source.Handle(), nullptr, n_items_max);
-					if(r < 0)
-					{
-						EL_ERROR(errno != EAGAIN && errno != EWOULDBLOCK, TSyscallException, errno);
-						const IWaitable* w_in = source.OnInputReady();
-						const IWaitable* w_out = sink.OnOutputReady();
-
-						if(w_in && w_out)
-							TFiber::WaitForMany({ w_in, w_out });
-						else
-							break;
-					}
-
-					n_pumped += r;
+					const IWaitable* const waitable = blocking ? source.OnInputReady() : nullptr;
+					if(waitable == nullptr)
+						break;
+					waitable->WaitFor();
+					continue;
 				}
-				return n_pumped;
+
+				if(errno == EINVAL || errno == ENOSYS)
+				{
+					unsupported = true;
+					break;
+				}
+
+				EL_THROW(TSyscallException, errno);
 			}
-			else
+
+			while(n_in > 0)
 			{
-				return EL_SYSERR(sendfile(sink.Handle(), source.Handle(), nullptr, n_items_max));
+				const ssize_t n_out = splice(pipe_rx, nullptr, h_sink, nullptr, n_in, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+				if(n_out > 0)
+				{
+					n_in -= n_out;
+					n_pumped += n_out;
+					continue;
+				}
+
+				if(n_out < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+					EL_THROW(TSyscallException, errno);
+				const IWaitable* const waitable = sink.OnOutputReady();
+				EL_ERROR(waitable == nullptr, TSinkFloodedException);
+				waitable->WaitFor();
 			}
 		}
-		else
+		return n_pumped;
+	}
+
+	// when both sides are kernel objects the data does not pass through user-space
+	template<>
+	iosize_t Pump<byte_t>(ISource<byte_t>& source, ISink<byte_t>& sink, const iosize_t n_items_max, const bool blocking)
+	{
+		const handle_t h_source = source.Handle();
+		const handle_t h_sink = sink.Handle();
+		if(h_source != INVALID_HANDLE && h_sink != INVALID_HANDLE)
 		{
-			return _Pump<byte_t>(source, sink, n_items_max, blocking);
+			const iosize_t n_sent = PumpSendfile(h_source, sink, h_sink, n_items_max, blocking);
+			if(n_sent != NEG1)
+				return n_sent;
+
+			bool unsupported;
+			const iosize_t n_spliced = PumpSplice(source, h_source, sink, h_sink, n_items_max, blocking, unsupported);
+			if(!unsupported || n_spliced == n_items_max)
+				return n_spliced;
+			return n_spliced + _Pump<byte_t>(source, sink, n_items_max - n_spliced, blocking);
 		}
+
+		return _Pump<byte_t>(source, sink, n_items_max, blocking);
 	}
 
 	/*********************************************/
@@ -124,6 +208,48 @@ namespace el1::io::stream
 		return true;
 	}
 
+	usys_t TKernelStream::BlockingRead(byte_t* const arr_items, const usys_t n_items_max, TTime timeout, const bool absolute_time)
+	{
+		if(TThread::Self()->IoBackend() != EIoBackend::IO_URING)
+			return ISource<byte_t>::BlockingRead(arr_items, n_items_max, timeout, absolute_time);
+
+		if(!absolute_time && timeout > 0)
+			timeout += TTime::Now(EClock::MONOTONIC);
+
+		usys_t n_read = 0;
+		while(n_read < n_items_max && this->w_input.Handle() != -1)
+		{
+			const ssys_t r = TFiber::RingRead(this->handle, arr_items + n_read, n_items_max - n_read, -1, true, timeout);
+			if(r < 0)
+				break;
+
+			if(r == 0)
+			{
+				// EOF
+				this->CloseInput();
+				break;
+			}
+
+			n_read += r;
+		}
+		return n_read;
+	}
+
+	void TKernelStream::WriteAll(const byte_t* const arr_items, const usys_t n_items)
+	{
+		if(TThread::Self()->IoBackend() != EIoBackend::IO_URING)
+			return ISink<byte_t>::WriteAll(arr_items, n_items);
+
+		usys_t w = 0;
+		while(w < n_items)
+		{
+			EL_ERROR(this->w_output.Handle() == -1, TSinkFloodedException);
+			const ssys_t r = TFiber::RingWrite(this->handle, arr_items + w, n_items - w);
+			EL_ERROR(r <= 0, TSinkFloodedException);
+			w += r;
+		}
+	}
+
 	void TKernelStream::Flush()
 	{
 		EL_SYSERR(fdatasync(this->handle));
@@ -26,30 +26,50 @@ namespace el1::io::stream::producer
 				producer(fifo);
 			}
 
-		public:
-			TOut* NextItem()
+			// returns false once the producer has finished and all items were consumed
+			bool Refill()
 			{
 				if(idx_head >= head_buffer.Count())
 				{
 					fifo.Shift(idx_head);
+					idx_head = 0;
 					head_buffer = fifo.HeadMutable();
 					while(head_buffer.Count() == 0)
 					{
 						const auto* waitable = fifo.OnInputReady();
 						if(waitable == nullptr)
-							return nullptr;
+							return false;
 
 						waitable->WaitFor();
 						head_buffer = fifo.HeadMutable();
 					}
-					idx_head = 0;
 				}
 
+				return true;
+			}
+
+		public:
+			TOut* NextItem()
+			{
+				if(!Refill())
+					return nullptr;
+
 				return head_buffer.ItemPtr(idx_head++);
 			}
 
+			usys_t NextBatch(T* const, const usys_t n_items_max, T*& batch) final override EL_WARN_UNUSED_RESULT
+			{
+				if(!Refill())
+					return 0;
+
+				const usys_t n = util::Min(head_buffer.Count() - idx_head, n_items_max);
+				batch = head_buffer.ItemPtr(idx_head);
+				idx_head += n;
+				return n;
+			}
+
 			TProducerPipe(TProducerFunction producer) :
-				producer(producer),
+				producer(std::move(producer)),
 				fifo(&fiber, system::task::TFiber::Self()),
 				head_buffer(),
 				idx_head(0)
@@ -61,7 +81,7 @@ namespace el1::io::stream::producer
 	template<typename T>
 	TProducerPipe<T> Produce(util::function::TFunction<void, ISink<T>&> producer)
 	{
-		return TProducerPipe<T>(producer);
+		return TProducerPipe<T>(std::move(producer));
 	}
 
 	template<typename T>
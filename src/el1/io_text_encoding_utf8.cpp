@@ -2,14 +2,26 @@
 #include "io_types.hpp"
 #include "io_text_encoding_utf8.hpp"
 #include "io_text_string.hpp"
+#include "io_collection_array.hpp"
+#include "io_collection_list.hpp"
 #include "util.hpp"
 #include <string.h>
 
+#if defined(__x86_64__) && (defined(EL_CC_GCC) || defined(EL_CC_CLANG))
+	#include <immintrin.h>
+	#define EL_UTF8_X86_KERNELS
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define EL_UTF8_NEON_KERNELS
+#endif
+
 namespace el1::io::text::encoding::utf8
 {
 	using namespace io::types;
 	using namespace io::text::encoding;
 	using namespace io::text::string;
+	using namespace io::collection::array;
+	using namespace io::collection::list;
 
 	ESequenceType IdentifyByteType(const byte_t byte)
 	{
@@ -67,6 +79,635 @@ namespace el1::io::text::encoding::utf8
 
 	/*********************************/
 
+	u8_t GetDecodedSequenceLength(const byte_t start_byte)
+	{
+		if(start_byte < 0x80)
+			return 1;
+		if(start_byte < 0xC2)
+			return 0;
+		if(start_byte < 0xE0)
+			return 2;
+		if(start_byte < 0xF0)
+			return 3;
+		if(start_byte < 0xF5)
+			return 4;
+		return 0;
+	}
+
+	unsigned ValidateSequence(const byte_t* const arr_sequence, const unsigned n_bytes)
+	{
+		const unsigned n_sequence = n_bytes == 0 ? 0 : GetDecodedSequenceLength(arr_sequence[0]);
+		if(n_sequence == 0)
+			return 0;
+
+		// the range of the second byte rules out overlong encodings, surrogates and code points above U+10FFFF
+		byte_t min = 0x80, max = 0xBF;
+		switch(arr_sequence[0])
+		{
+			case 0xE0: min = 0xA0; break;
+			case 0xED: max = 0x9F; break;
+			case 0xF0: min = 0x90; break;
+			case 0xF4: max = 0x8F; break;
+		}
+
+		const unsigned n_check = util::Min(n_bytes, n_sequence);
+		for(unsigned i = 1; i < n_check; i++)
+		{
+			if(arr_sequence[i] < min || arr_sequence[i] > max)
+				return i;
+			min = 0x80;
+			max = 0xBF;
+		}
+		return n_check;
+	}
+
+	void ThrowInvalidSequence(const iosize_t index, const byte_t* const arr_sequence, const unsigned n_bytes_processed)
+	{
+		const ESequenceType type = n_bytes_processed == 0 ? ESequenceType::NONE : IdentifyByteType(arr_sequence[0]);
+		EL_THROW(TInvalidUtf8SequenceException, index, EDirection::DECODING, n_bytes_processed + 1, n_bytes_processed, type, arr_sequence);
+	}
+
+	// returns the length of the longest prefix which consists of complete and valid sequences
+	static usys_t ValidPrefixScalar(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		usys_t i = 0;
+		while(i < n_bytes)
+		{
+			if(arr_bytes[i] < 0x80)
+			{
+				i++;
+				continue;
+			}
+
+			const unsigned n_sequence = GetDecodedSequenceLength(arr_bytes[i]);
+			if(n_sequence == 0 || n_sequence > n_bytes - i || ValidateSequence(arr_bytes + i, n_sequence) < n_sequence)
+				break;
+			i += n_sequence;
+		}
+		return i;
+	}
+
+	/*********************************/
+
+	// the validation kernels return whether arr_bytes consists of complete and valid sequences only
+	// they follow Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte": the high and the low
+	// nibble of a byte and the high nibble of its successor each look up a set of error classes, the pair is
+	// invalid when all three sets share a class; a 3rd or 4th byte has to be a follow byte, which is checked separately
+
+	static bool ValidateScalar(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		return ValidPrefixScalar(arr_bytes, n_bytes) == n_bytes;
+	}
+
+#if defined(EL_UTF8_X86_KERNELS) || defined(EL_UTF8_NEON_KERNELS)
+	static const byte_t TOO_SHORT = 1 << 0;		// 11______ 0_______ or 11______ 11______
+	static const byte_t TOO_LONG = 1 << 1;		// 0_______ 10______
+	static const byte_t OVERLONG_3 = 1 << 2;	// 11100000 100_____
+	static const byte_t TOO_LARGE = 1 << 3;		// 11110100 1001____ and above
+	static const byte_t SURROGATE = 1 << 4;		// 11101101 101_____
+	static const byte_t OVERLONG_2 = 1 << 5;	// 1100000_ 10______
+	static const byte_t TOO_LARGE_1000 = 1 << 6;	// 11110101 1000____ and above
+	static const byte_t OVERLONG_4 = 1 << 6;	// 11110000 1000____
+	static const byte_t TWO_CONTS = 1 << 7;		// 10______ 10______
+	static const byte_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+	alignas(16) static const byte_t TABLE_BYTE_1_HIGH[16] = {
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+		TOO_SHORT | OVERLONG_2,
+		TOO_SHORT,
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+	};
+
+	alignas(16) static const byte_t TABLE_BYTE_1_LOW[16] = {
+		CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+		CARRY | OVERLONG_2,
+		CARRY,
+		CARRY,
+		CARRY | TOO_LARGE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000
+	};
+
+	alignas(16) static const byte_t TABLE_BYTE_2_HIGH[16] = {
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+	};
+
+	// a block which ends in one of these bytes leaves a sequence open: 0b1111____, 0b111_____, 0b11______
+	alignas(16) static const byte_t TABLE_INCOMPLETE[16] = {
+		0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+	};
+#endif
+
+	// the ASCII kernels convert the longest prefix of ASCII characters and return its length
+
+	static usys_t WidenAsciiScalar(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars)
+	{
+		usys_t i = 0;
+		for(; i + 8 <= n_bytes; i += 8)
+		{
+			u64_t word;
+			memcpy(&word, arr_bytes + i, 8);
+			if((word & 0x8080808080808080ULL) != 0)
+				break;
+			for(unsigned k = 0; k < 8; k++)
+				arr_chars[i + k] = arr_bytes[i + k];
+		}
+
+		for(; i < n_bytes && arr_bytes[i] < 0x80; i++)
+			arr_chars[i] = arr_bytes[i];
+
+		return i;
+	}
+
+	static usys_t NarrowAsciiScalar(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes)
+	{
+		usys_t i = 0;
+		for(; i < n_chars && arr_chars[i] <= 127; i++)
+			arr_bytes[i] = (byte_t)arr_chars[i];
+		return i;
+	}
+
+#if defined(EL_UTF8_X86_KERNELS)
+	__attribute__((target("sse4.1")))
+	static usys_t WidenAsciiSSE41(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars)
+	{
+		usys_t i = 0;
+		for(; i + 16 <= n_bytes; i += 16)
+		{
+			const __m128i v = _mm_loadu_si128((const __m128i*)(arr_bytes + i));
+			if(_mm_movemask_epi8(v) != 0)
+				break;
+			_mm_storeu_si128((__m128i*)(arr_chars + i +  0), _mm_cvtepu8_epi32(v));
+			_mm_storeu_si128((__m128i*)(arr_chars + i +  4), _mm_cvtepu8_epi32(_mm_srli_si128(v,  4)));
+			_mm_storeu_si128((__m128i*)(arr_chars + i +  8), _mm_cvtepu8_epi32(_mm_srli_si128(v,  8)));
+			_mm_storeu_si128((__m128i*)(arr_chars + i + 12), _mm_cvtepu8_epi32(_mm_srli_si128(v, 12)));
+		}
+		return i + WidenAsciiScalar(arr_bytes + i, n_bytes - i, arr_chars + i);
+	}
+
+	__attribute__((target("sse4.1")))
+	static usys_t NarrowAsciiSSE41(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes)
+	{
+		const __m128i non_ascii = _mm_set1_epi32(~0x7F);
+		usys_t i = 0;
+		for(; i + 16 <= n_chars; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(arr_chars + i +  0));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(arr_chars + i +  4));
+			const __m128i c = _mm_loadu_si128((const __m128i*)(arr_chars + i +  8));
+			const __m128i d = _mm_loadu_si128((const __m128i*)(arr_chars + i + 12));
+			if(!_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), non_ascii))
+				break;
+			const __m128i r = _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d));
+			_mm_storeu_si128((__m128i*)(arr_bytes + i), r);
+		}
+		return i + NarrowAsciiScalar(arr_chars + i, n_chars - i, arr_bytes + i);
+	}
+
+	__attribute__((target("sse4.1")))
+	static inline __m128i BlockErrorsSSE41(const __m128i input, const __m128i prev_input)
+	{
+		const __m128i nibble = _mm_set1_epi8(0x0F);
+		const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+		const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+		const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+
+		const __m128i byte_1_high = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)TABLE_BYTE_1_HIGH), _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+		const __m128i byte_1_low = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)TABLE_BYTE_1_LOW), _mm_and_si128(prev1, nibble));
+		const __m128i byte_2_high = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)TABLE_BYTE_2_HIGH), _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+		const __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+		// only bytes two or three places behind 0b111_____ or 0b1111____ reach 0x80
+		const __m128i must_follow = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)), _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80)));
+		return _mm_xor_si128(_mm_and_si128(must_follow, _mm_set1_epi8((char)0x80)), special);
+	}
+
+	__attribute__((target("sse4.1")))
+	static bool ValidateSSE41(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		const __m128i incomplete = _mm_load_si128((const __m128i*)TABLE_INCOMPLETE);
+		__m128i error = _mm_setzero_si128();
+		__m128i prev_input = _mm_setzero_si128();
+		__m128i prev_incomplete = _mm_setzero_si128();
+
+		// the last partial block is padded with zeros, which close no sequence
+		byte_t tail[16] = {};
+		for(usys_t i = 0; i < n_bytes; i += 16)
+		{
+			const byte_t* block = arr_bytes + i;
+			if(i + 16 > n_bytes)
+			{
+				memcpy(tail, block, n_bytes - i);
+				block = tail;
+			}
+
+			const __m128i input = _mm_loadu_si128((const __m128i*)block);
+			if(_mm_movemask_epi8(input) == 0)
+			{
+				error = _mm_or_si128(error, prev_incomplete);
+				prev_incomplete = _mm_setzero_si128();
+			}
+			else
+			{
+				error = _mm_or_si128(error, BlockErrorsSSE41(input, prev_input));
+				prev_incomplete = _mm_subs_epu8(input, incomplete);
+			}
+			prev_input = input;
+		}
+
+		error = _mm_or_si128(error, prev_incomplete);
+		return _mm_testz_si128(error, error);
+	}
+
+	__attribute__((target("avx2")))
+	static usys_t WidenAsciiAVX2(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars)
+	{
+		usys_t i = 0;
+		for(; i + 32 <= n_bytes; i += 32)
+		{
+			const __m256i v = _mm256_loadu_si256((const __m256i*)(arr_bytes + i));
+			if(_mm256_movemask_epi8(v) != 0)
+				break;
+			for(unsigned k = 0; k < 32; k += 8)
+				_mm256_storeu_si256((__m256i*)(arr_chars + i + k), _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(arr_bytes + i + k))));
+		}
+		return i + WidenAsciiScalar(arr_bytes + i, n_bytes - i, arr_chars + i);
+	}
+
+	__attribute__((target("avx2")))
+	static usys_t NarrowAsciiAVX2(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes)
+	{
+		const __m256i non_ascii = _mm256_set1_epi32(~0x7F);
+		// the packs work within the 128 bit lanes, this puts the 32 bit groups back in order
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		usys_t i = 0;
+		for(; i + 32 <= n_chars; i += 32)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(arr_chars + i +  0));
+			const __m256i b = _mm256_loadu_si256((const __m256i*)(arr_chars + i +  8));
+			const __m256i c = _mm256_loadu_si256((const __m256i*)(arr_chars + i + 16));
+			const __m256i d = _mm256_loadu_si256((const __m256i*)(arr_chars + i + 24));
+			if(!_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d)), non_ascii))
+				break;
+			const __m256i r = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+			_mm256_storeu_si256((__m256i*)(arr_bytes + i), _mm256_permutevar8x32_epi32(r, order));
+		}
+		// not handed to NarrowAsciiSSE41(), mixing its legacy SSE encoding with the dirty upper halves stalls
+		const __m128i non_ascii_128 = _mm_set1_epi32(~0x7F);
+		for(; i + 8 <= n_chars; i += 8)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(arr_chars + i + 0));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(arr_chars + i + 4));
+			if(!_mm_testz_si128(_mm_or_si128(a, b), non_ascii_128))
+				break;
+			const __m128i ab = _mm_packus_epi32(a, b);
+			_mm_storel_epi64((__m128i*)(arr_bytes + i), _mm_packus_epi16(ab, ab));
+		}
+		return i + NarrowAsciiScalar(arr_chars + i, n_chars - i, arr_bytes + i);
+	}
+
+	__attribute__((target("avx2")))
+	static inline __m256i BlockErrorsAVX2(const __m256i input, const __m256i prev_input)
+	{
+		// alignr works within the 128 bit lanes, its second operand supplies the bytes from before each lane
+		const __m256i before = _mm256_permute2x128_si256(prev_input, input, 0x21);
+		const __m256i prev1 = _mm256_alignr_epi8(input, before, 15);
+		const __m256i prev2 = _mm256_alignr_epi8(input, before, 14);
+		const __m256i prev3 = _mm256_alignr_epi8(input, before, 13);
+
+		const __m256i nibble = _mm256_set1_epi8(0x0F);
+		const __m256i byte_1_high = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)TABLE_BYTE_1_HIGH)), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+		const __m256i byte_1_low = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)TABLE_BYTE_1_LOW)), _mm256_and_si256(prev1, nibble));
+		const __m256i byte_2_high = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)TABLE_BYTE_2_HIGH)), _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+		const __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+		const __m256i must_follow = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)), _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80)));
+		return _mm256_xor_si256(_mm256_and_si256(must_follow, _mm256_set1_epi8((char)0x80)), special);
+	}
+
+	__attribute__((target("avx2")))
+	static bool ValidateAVX2(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		// TABLE_INCOMPLETE applies to the upper lane, the lower lane never leaves a sequence open
+		const __m256i incomplete = _mm256_inserti128_si256(_mm256_set1_epi8((char)0xFF), _mm_load_si128((const __m128i*)TABLE_INCOMPLETE), 1);
+		__m256i error = _mm256_setzero_si256();
+		__m256i prev_input = _mm256_setzero_si256();
+		__m256i prev_incomplete = _mm256_setzero_si256();
+
+		byte_t tail[32] = {};
+		for(usys_t i = 0; i < n_bytes; i += 32)
+		{
+			const byte_t* block = arr_bytes + i;
+			if(i + 32 > n_bytes)
+			{
+				memcpy(tail, block, n_bytes - i);
+				block = tail;
+			}
+
+			const __m256i input = _mm256_loadu_si256((const __m256i*)block);
+			if(_mm256_movemask_epi8(input) == 0)
+			{
+				error = _mm256_or_si256(error, prev_incomplete);
+				prev_incomplete = _mm256_setzero_si256();
+			}
+			else
+			{
+				error = _mm256_or_si256(error, BlockErrorsAVX2(input, prev_input));
+				prev_incomplete = _mm256_subs_epu8(input, incomplete);
+			}
+			prev_input = input;
+		}
+
+		error = _mm256_or_si256(error, prev_incomplete);
+		return _mm256_testz_si256(error, error);
+	}
+#elif defined(EL_UTF8_NEON_KERNELS)
+	static usys_t WidenAsciiNEON(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars)
+	{
+		usys_t i = 0;
+		for(; i + 16 <= n_bytes; i += 16)
+		{
+			const uint8x16_t v = vld1q_u8(arr_bytes + i);
+			if(vmaxvq_u8(v) >= 0x80)
+				break;
+			const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+			const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+			vst1q_u32((u32_t*)(arr_chars + i +  0), vmovl_u16(vget_low_u16(lo)));
+			vst1q_u32((u32_t*)(arr_chars + i +  4), vmovl_u16(vget_high_u16(lo)));
+			vst1q_u32((u32_t*)(arr_chars + i +  8), vmovl_u16(vget_low_u16(hi)));
+			vst1q_u32((u32_t*)(arr_chars + i + 12), vmovl_u16(vget_high_u16(hi)));
+		}
+		return i + WidenAsciiScalar(arr_bytes + i, n_bytes - i, arr_chars + i);
+	}
+
+	static usys_t NarrowAsciiNEON(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes)
+	{
+		usys_t i = 0;
+		for(; i + 16 <= n_chars; i += 16)
+		{
+			const uint32x4_t a = vld1q_u32((const u32_t*)(arr_chars + i +  0));
+			const uint32x4_t b = vld1q_u32((const u32_t*)(arr_chars + i +  4));
+			const uint32x4_t c = vld1q_u32((const u32_t*)(arr_chars + i +  8));
+			const uint32x4_t d = vld1q_u32((const u32_t*)(arr_chars + i + 12));
+			if(vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) > 0x7F)
+				break;
+			const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+			const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+			vst1q_u8(arr_bytes + i, vcombine_u8(vmovn_u16(ab), vmovn_u16(cd)));
+		}
+		return i + NarrowAsciiScalar(arr_chars + i, n_chars - i, arr_bytes + i);
+	}
+
+	static inline uint8x16_t BlockErrorsNEON(const uint8x16_t input, const uint8x16_t prev_input)
+	{
+		const uint8x16_t prev1 = vextq_u8(prev_input, input, 15);
+		const uint8x16_t prev2 = vextq_u8(prev_input, input, 14);
+		const uint8x16_t prev3 = vextq_u8(prev_input, input, 13);
+
+		const uint8x16_t byte_1_high = vqtbl1q_u8(vld1q_u8(TABLE_BYTE_1_HIGH), vshrq_n_u8(prev1, 4));
+		const uint8x16_t byte_1_low = vqtbl1q_u8(vld1q_u8(TABLE_BYTE_1_LOW), vandq_u8(prev1, vdupq_n_u8(0x0F)));
+		const uint8x16_t byte_2_high = vqtbl1q_u8(vld1q_u8(TABLE_BYTE_2_HIGH), vshrq_n_u8(input, 4));
+		const uint8x16_t special = vandq_u8(vandq_u8(byte_1_high, byte_1_low), byte_2_high);
+
+		const uint8x16_t must_follow = vorrq_u8(vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80)), vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80)));
+		return veorq_u8(vandq_u8(must_follow, vdupq_n_u8(0x80)), special);
+	}
+
+	static bool ValidateNEON(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		const uint8x16_t incomplete = vld1q_u8(TABLE_INCOMPLETE);
+		uint8x16_t error = vdupq_n_u8(0);
+		uint8x16_t prev_input = vdupq_n_u8(0);
+		uint8x16_t prev_incomplete = vdupq_n_u8(0);
+
+		byte_t tail[16] = {};
+		for(usys_t i = 0; i < n_bytes; i += 16)
+		{
+			const byte_t* block = arr_bytes + i;
+			if(i + 16 > n_bytes)
+			{
+				memcpy(tail, block, n_bytes - i);
+				block = tail;
+			}
+
+			const uint8x16_t input = vld1q_u8(block);
+			if(vmaxvq_u8(input) < 0x80)
+			{
+				error = vorrq_u8(error, prev_incomplete);
+				prev_incomplete = vdupq_n_u8(0);
+			}
+			else
+			{
+				error = vorrq_u8(error, BlockErrorsNEON(input, prev_input));
+				prev_incomplete = vqsubq_u8(input, incomplete);
+			}
+			prev_input = input;
+		}
+
+		error = vorrq_u8(error, prev_incomplete);
+		return vmaxvq_u8(error) == 0;
+	}
+#endif
+
+	struct kernels_t
+	{
+		bool (*validate)(const byte_t* const arr_bytes, const usys_t n_bytes);
+		usys_t (*widen_ascii)(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars);
+		usys_t (*narrow_ascii)(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes);
+	};
+
+	static kernels_t SelectKernels()
+	{
+	#if defined(EL_UTF8_X86_KERNELS)
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2"))
+			return { &ValidateAVX2, &WidenAsciiAVX2, &NarrowAsciiAVX2 };
+		if(__builtin_cpu_supports("sse4.1"))
+			return { &ValidateSSE41, &WidenAsciiSSE41, &NarrowAsciiSSE41 };
+	#elif defined(EL_UTF8_NEON_KERNELS)
+		return { &ValidateNEON, &WidenAsciiNEON, &NarrowAsciiNEON };
+	#endif
+		return { &ValidateScalar, &WidenAsciiScalar, &NarrowAsciiScalar };
+	}
+
+	static const kernels_t& Kernels()
+	{
+		static const kernels_t kernels = SelectKernels();
+		return kernels;
+	}
+
+	static const usys_t N_BYTES_CHUNK = 4096;
+
+	// the length of arr_bytes without a sequence which is cut off at its end
+	static usys_t CompleteLength(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		for(usys_t j = 1; j <= 3 && j <= n_bytes; j++)
+		{
+			const byte_t byte = arr_bytes[n_bytes - j];
+			if(byte < 0x80)
+				break;
+			if(byte >= 0xC0)
+				return GetDecodedSequenceLength(byte) > j ? n_bytes - j : n_bytes;
+		}
+		return n_bytes;
+	}
+
+	usys_t DecodeUTF8(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars, usys_t& n_chars, const iosize_t index_base)
+	{
+		const kernels_t& kernels = Kernels();
+		const usys_t n_complete = CompleteLength(arr_bytes, n_bytes);
+
+		usys_t i = 0;
+		usys_t n_out = 0;
+		while(i < n_complete)
+		{
+			// each chunk ends on a sequence boundary and is decoded right after its validation, while it is still in the cache
+			const usys_t n_chunk = n_complete - i > N_BYTES_CHUNK ? CompleteLength(arr_bytes + i, N_BYTES_CHUNK) : n_complete - i;
+			const usys_t i_end = i + n_chunk;
+
+			if(!kernels.validate(arr_bytes + i, n_chunk))
+			{
+				// the kernels only tell that there is an error, the scalar code finds it
+				const usys_t i_error = i + ValidPrefixScalar(arr_bytes + i, n_chunk);
+				EL_ERROR(i_error >= i_end, TLogicException);
+				const unsigned k = ValidateSequence(arr_bytes + i_error, (unsigned)util::Min<usys_t>(4, i_end - i_error));
+				ThrowInvalidSequence(index_base + i_error + k, arr_bytes + i_error, k);
+			}
+
+			while(i < i_end)
+			{
+				if(arr_bytes[i] < 0x80)
+				{
+					const usys_t n_ascii = kernels.widen_ascii(arr_bytes + i, i_end - i, arr_chars + n_out);
+					i += n_ascii;
+					n_out += n_ascii;
+					continue;
+				}
+
+				const unsigned n_sequence = GetDecodedSequenceLength(arr_bytes[i]);
+				arr_chars[n_out++] = DecodeSequence(arr_bytes + i, n_sequence);
+				i += n_sequence;
+			}
+		}
+
+		const unsigned n_tail = (unsigned)(n_bytes - n_complete);
+		if(n_tail > 0)
+		{
+			const unsigned k = ValidateSequence(arr_bytes + n_complete, n_tail);
+			if(k < n_tail)
+				ThrowInvalidSequence(index_base + n_complete + k, arr_bytes + n_complete, k);
+		}
+
+		n_chars = n_out;
+		return n_complete;
+	}
+
+	usys_t EncodeUTF8(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes, const iosize_t index_base)
+	{
+		const kernels_t& kernels = Kernels();
+		usys_t i = 0;
+		usys_t n_out = 0;
+
+		while(i < n_chars)
+		{
+			const char32_t chr = arr_chars[i];
+			if(chr <= 127)
+			{
+				const usys_t n_ascii = kernels.narrow_ascii(arr_chars + i, n_chars - i, arr_bytes + n_out);
+				i += n_ascii;
+				n_out += n_ascii;
+				continue;
+			}
+
+			byte_t* const out = arr_bytes + n_out;
+			if(chr < 2048)
+			{
+				out[0] = 0b11000000 | ((chr >>  6) & 0b00011111);
+				out[1] = 0b10000000 | ((chr >>  0) & 0b00111111);
+				n_out += 2;
+			}
+			else if(chr < 65536)
+			{
+				out[0] = 0b11100000 | ((chr >> 12) & 0b00001111);
+				out[1] = 0b10000000 | ((chr >>  6) & 0b00111111);
+				out[2] = 0b10000000 | ((chr >>  0) & 0b00111111);
+				n_out += 3;
+			}
+			else if(chr < 4194304)
+			{
+				out[0] = 0b11110000 | ((chr >> 18) & 0b00001111);
+				out[1] = 0b10000000 | ((chr >> 12) & 0b00111111);
+				out[2] = 0b10000000 | ((chr >>  6) & 0b00111111);
+				out[3] = 0b10000000 | ((chr >>  0) & 0b00111111);
+				n_out += 4;
+			}
+			else
+				EL_THROW(TInvalidUtf8SequenceException, index_base + i, EDirection::ENCODING, 4, 0, ESequenceType::NONE, (const byte_t*)(arr_chars + i));
+
+			i++;
+		}
+
+		return n_out;
+	}
+
+	usys_t DecodeUTF8(array_t<const byte_t> bytes, TList<char32_t>& chars)
+	{
+		const usys_t n_before = chars.Count();
+		chars.SetCount(n_before + bytes.Count());
+
+		usys_t n_chars;
+		const usys_t n_used = DecodeUTF8(bytes.ItemPtr(0), bytes.Count(), chars.ItemPtr(n_before), n_chars);
+		chars.SetCount(n_before + n_chars);
+		EL_ERROR(n_used < bytes.Count(), stream::TStreamDryException);
+		return n_chars;
+	}
+
+	usys_t EncodeUTF8(array_t<const char32_t> chars, TList<byte_t>& bytes)
+	{
+		const usys_t n_before = bytes.Count();
+		byte_t buffer[4096];
+		for(usys_t i = 0; i < chars.Count(); i += sizeof(buffer) / 4)
+		{
+			const usys_t n_chars = util::Min<usys_t>(chars.Count() - i, sizeof(buffer) / 4);
+			const usys_t n_bytes = EncodeUTF8(chars.ItemPtr(i), n_chars, buffer, i);
+			bytes.Append(buffer, n_bytes);
+		}
+		return bytes.Count() - n_before;
+	}
+
+	TList<char32_t> DecodeUTF8(array_t<const byte_t> bytes)
+	{
+		TList<char32_t> chars;
+		DecodeUTF8(bytes, chars);
+		return chars;
+	}
+
+	TList<byte_t> EncodeUTF8(array_t<const char32_t> chars)
+	{
+		TList<byte_t> bytes;
+		bytes.Prealloc(chars.Count());
+		EncodeUTF8(chars, bytes);
+		return bytes;
+	}
+
+	/*********************************/
+
 	TInvalidUtf8SequenceException::TInvalidUtf8SequenceException(const iosize_t index, const EDirection dir, const usys_t n_bytes_buffer, const usys_t n_bytes_processed, const ESequenceType seqtype_current, const byte_t* const buffer) : index(index), dir(dir)
 	{
 		this->n_bytes_buffer = util::Min((usys_t)sizeof(this->buffer), n_bytes_buffer);
@@ -32,7 +32,7 @@ namespace el1::io::text::encoding::utf8
 
 	struct TInvalidUtf8SequenceException : error::IException
 	{
-		iosize_t index;					// index of the first byte of the buffer[] into the overall processed data stream / the number of bytes that have already been processed before
+		iosize_t index;					// index of the offending byte buffer[n_bytes_processed] into the overall processed data stream
 		EDirection dir;
 		u8_t	n_bytes_buffer : 3,		// number of bytes in buffer[]
 				n_bytes_processed : 2,	// number of bytes in buffer[] successfully processed / position of the error byte in the buffer[]
@@ -47,10 +47,52 @@ namespace el1::io::text::encoding::utf8
 		TInvalidUtf8SequenceException(const iosize_t index, const EDirection dir, const usys_t n_bytes_buffer, const usys_t n_bytes_processed, const ESequenceType seqtype_current, const byte_t* const buffer);
 	};
 
+	// bulk transcoders with the same semantics and exceptions as TUTF8Decoder and TUTF8Encoder
+	// the input is validated and runs of ASCII are converted with AVX2 or SSE4.1 on x86-64 (chosen at runtime) and with NEON on ARM
+	// index_base is the stream position of the first item, it only serves the exceptions
+	// the decoders reject overlong encodings, surrogates and code points above U+10FFFF
+
+	// decodes the complete sequences at the start of arr_bytes into arr_chars, which must be able to hold n_bytes characters
+	// a sequence which is cut off at the end of arr_bytes is validated as far as possible but not decoded
+	// returns the number of bytes consumed, n_chars receives the number of characters
+	usys_t DecodeUTF8(const byte_t* const arr_bytes, const usys_t n_bytes, char32_t* const arr_chars, usys_t& n_chars, const iosize_t index_base = 0);
+
+	// arr_bytes must be able to hold 4 * n_chars bytes; returns the number of bytes written
+	usys_t EncodeUTF8(const char32_t* const arr_chars, const usys_t n_chars, byte_t* const arr_bytes, const iosize_t index_base = 0);
+
+	// append to the list and return the number of items appended; a sequence which is cut off at the end throws TStreamDryException
+	usys_t DecodeUTF8(collection::array::array_t<const byte_t> bytes, collection::list::TList<char32_t>& chars);
+	usys_t EncodeUTF8(collection::array::array_t<const char32_t> chars, collection::list::TList<byte_t>& bytes);
+
+	collection::list::TList<char32_t> DecodeUTF8(collection::array::array_t<const byte_t> bytes);
+	collection::list::TList<byte_t> EncodeUTF8(collection::array::array_t<const char32_t> chars);
+
+	// length of the sequence started by start_byte (1-4), 0 for a byte which cannot start a sequence
+	u8_t GetDecodedSequenceLength(const byte_t start_byte) EL_GETTER;
+
+	// returns the position of the first invalid byte in arr_sequence[0..n_bytes), the bytes are
+	// valid (but maybe incomplete) if this is n_bytes or the length of the sequence, whichever is less
+	unsigned ValidateSequence(const byte_t* const arr_sequence, const unsigned n_bytes) EL_GETTER;
+
+	// arr_sequence[n_bytes_processed] is the offending byte, index is its position
+	[[noreturn]] void ThrowInvalidSequence(const iosize_t index, const byte_t* const arr_sequence, const unsigned n_bytes_processed);
+
+	// arr_sequence must hold a complete and valid sequence of n_bytes
+	inline char32_t DecodeSequence(const byte_t* const arr_sequence, const unsigned n_bytes)
+	{
+		static const byte_t MASKS[5] = { 0, 0b01111111, 0b00111111, 0b00011111, 0b00001111 };
+		char32_t chr = arr_sequence[0] & MASKS[n_bytes];
+		for(unsigned i = 1; i < n_bytes; i++)
+			chr = (chr << 6) | (arr_sequence[i] & 0b00111111);
+		return chr;
+	}
+
 	class TUTF8Decoder
 	{
 		protected:
-			u32_t index;
+			static const usys_t N_BYTES_BATCH = 1024;
+
+			u32_t index;	// position of the last byte consumed
 			char32_t buffer;
 
 			template<typename TSourceStream>
@@ -62,6 +104,20 @@ namespace el1::io::text::encoding::utf8
 				return *item;
 			}
 
+			// reads the missing bytes of a sequence of which arr_sequence already holds the first n_have (validated) bytes
+			template<typename TSourceStream>
+			char32_t CompleteSequence(TSourceStream* const source, byte_t* const arr_sequence, const unsigned n_have)
+			{
+				const unsigned n_bytes = GetDecodedSequenceLength(arr_sequence[0]);
+				for(unsigned i = n_have; i < n_bytes; i++)
+				{
+					arr_sequence[i] = NextByte(source);
+					if(ValidateSequence(arr_sequence, i + 1) == i)
+						ThrowInvalidSequence(index, arr_sequence, i);
+				}
+				return DecodeSequence(arr_sequence, n_bytes);
+			}
+
 		public:
 			using TIn = byte_t;
 			using TOut = char32_t;
@@ -72,49 +128,47 @@ namespace el1::io::text::encoding::utf8
 				const byte_t* const start_byte = source->NextItem();
 				if(start_byte == nullptr)
 					return nullptr;
+				index++;
 
-				const ESequenceType type = IdentifyByteType(*start_byte);
-				unsigned n_need = 0;
-
-				switch(type)
+				if(*start_byte < 0x80)
 				{
-					case ESequenceType::SINGLE_BYTE:
-						buffer = *start_byte;
-						return &buffer;
-
-					case ESequenceType::START_BYTE_2:
-						buffer = *start_byte & 0b00111111;
-						n_need = 1;
-						break;
-
-					case ESequenceType::START_BYTE_3:
-						buffer = *start_byte & 0b00011111;
-						n_need = 2;
-						break;
-
-					case ESequenceType::START_BYTE_4:
-						buffer = *start_byte & 0b00001111;
-						n_need = 3;
-						break;
-
-					case ESequenceType::FOLLOW_BYTE:
-						EL_THROW(TInvalidUtf8SequenceException, index, EDirection::DECODING, 4, 0, type, (const byte_t*)&buffer);
-
-					// LCOV_EXCL_START
-					case ESequenceType::NONE:
-						EL_THROW(TLogicException);
-					// LCOV_EXCL_STOP
+					buffer = *start_byte;
+					return &buffer;
 				}
 
-				for(unsigned i = 0; i < n_need; i++)
+				byte_t sequence[4] = { *start_byte };
+				if(ValidateSequence(sequence, 1) == 0)
+					ThrowInvalidSequence(index, sequence, 0);
+				buffer = CompleteSequence(source, sequence, 1);
+				return &buffer;
+			}
+
+			// decodes a whole batch of bytes at once with DecodeUTF8()
+			// a sequence which is cut off at the end of the batch is completed from NextItem() of the source
+			template<typename TSourceStream>
+			usys_t NextBatch(TSourceStream* const source, char32_t* const arr_buffer, const usys_t n_items_max, char32_t*& batch)
+			{
+				using TIn = typename TSourceStream::TOut;
+				byte_t in_buffer[N_BYTES_BATCH];
+				TIn* in;
+				const usys_t n_in = source->NextBatch(in_buffer, util::Min(n_items_max, N_BYTES_BATCH), in);
+				if(n_in == 0)
+					return 0;
+
+				usys_t n_out;
+				const usys_t n_used = DecodeUTF8(in, n_in, arr_buffer, n_out, index + 1);
+				index += (u32_t)n_in;
+
+				if(n_used < n_in)
 				{
-					const byte_t next = NextByte(source);
-					EL_ERROR(IdentifyByteType(next) != ESequenceType::FOLLOW_BYTE, TInvalidUtf8SequenceException, index, EDirection::DECODING, 4, 1+i, type, (const byte_t*)&buffer);
-					buffer <<= 6;
-					buffer |= (next & 0b00111111);
+					byte_t sequence[4];
+					const unsigned n_have = (unsigned)(n_in - n_used);
+					memcpy(sequence, in + n_used, n_have);
+					arr_buffer[n_out++] = CompleteSequence(source, sequence, n_have);
 				}
 
-				return &buffer;
+				batch = arr_buffer;
+				return n_out;
 			}
 
 			TUTF8Decoder() : index((u32_t)-1), buffer(0U) {}
@@ -123,7 +177,9 @@ namespace el1::io::text::encoding::utf8
 	class TUTF8Encoder
 	{
 		protected:
-			u32_t index;
+			static const usys_t N_CHARS_BATCH = 1024;
+
+			u32_t index;	// position of the last character consumed
 
 			union
 			{
@@ -177,6 +233,45 @@ namespace el1::io::text::encoding::utf8
 				return buffer + 0;
 			}
 
+			// encodes a whole batch of characters at once with EncodeUTF8()
+			template<typename TSourceStream>
+			usys_t NextBatch(TSourceStream* const source, byte_t* const arr_buffer, const usys_t n_items_max, byte_t*& batch)
+			{
+				batch = arr_buffer;
+				usys_t n_out = 0;
+
+				// bytes left over from a character encoded by NextItem(), the byte returned last stays in buffer[0]
+				while(n_out < n_items_max)
+				{
+					buffer_value >>= 8;
+					if(buffer[0] == 0)
+						break;
+					arr_buffer[n_out++] = buffer[0];
+				}
+
+				// every character needs up to 4 bytes
+				const usys_t n_chars_max = util::Min((n_items_max - n_out) / 4, N_CHARS_BATCH);
+				if(n_chars_max == 0)
+				{
+					for(; n_out < n_items_max; n_out++)
+					{
+						const byte_t* const b = NextItem(source);
+						if(b == nullptr)
+							break;
+						arr_buffer[n_out] = *b;
+					}
+					return n_out;
+				}
+
+				using TIn = typename TSourceStream::TOut;
+				char32_t in_buffer[N_CHARS_BATCH];
+				TIn* in;
+				const usys_t n_in = source->NextBatch(in_buffer, n_chars_max, in);
+				n_out += EncodeUTF8(in, n_in, arr_buffer + n_out, index + 1);
+				index += (u32_t)n_in;
+				return n_out;
+			}
+
 			TUTF8Encoder() : index((u32_t)-1), buffer_value(0)
 			{
 			}
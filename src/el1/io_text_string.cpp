@@ -7,6 +7,175 @@
 
 namespace el1::io::text::string
 {
+	void TStringChars::Reserve(const usys_t n_chars_total)
+	{
+		const usys_t n_capacity_now = arr_heap == nullptr ? N_INLINE : n_capacity;
+		if(n_chars_total <= n_capacity_now)
+			return;
+
+		// growing by half keeps appending one character at a time amortized O(1)
+		const usys_t n_capacity_new = util::Max(n_chars_total, n_capacity_now + n_capacity_now / 2);
+		const usys_t sz_new = n_capacity_new * sizeof(char32_t);
+		char32_t* const arr_new = (char32_t*)realloc(arr_heap, sz_new);
+		EL_ERROR(arr_new == nullptr, TOutOfMemoryException, sz_new);
+
+		// n_capacity shares its memory with arr_inline
+		if(arr_heap == nullptr && n_chars != 0)
+			memcpy(arr_new, arr_inline, n_chars * sizeof(char32_t));
+		arr_heap = arr_new;
+		n_capacity = n_capacity_new;
+	}
+
+	void TStringChars::Release() noexcept
+	{
+		free(arr_heap);
+		arr_heap = nullptr;
+	}
+
+	char32_t* TStringChars::Open(const usys_t index, const usys_t n_insert)
+	{
+		Reserve(n_chars + n_insert);
+		char32_t* const arr_chars = Data();
+		memmove(arr_chars + index + n_insert, arr_chars + index, (n_chars - index) * sizeof(char32_t));
+		n_chars += n_insert;
+		return arr_chars + index;
+	}
+
+	void TStringChars::SetCount(const usys_t new_count)
+	{
+		if(new_count > n_chars)
+		{
+			Reserve(new_count);
+			memset(Data() + n_chars, 0, (new_count - n_chars) * sizeof(char32_t));
+		}
+		n_chars = new_count;
+	}
+
+	void TStringChars::Append(const char32_t* const arr_chars, const usys_t n_append)
+	{
+		if(n_append == 0)
+			return;
+
+		// the source might be part of this string and move when the buffer grows
+		if(arr_chars >= Data() && arr_chars < Data() + n_chars)
+		{
+			const TStringChars copy(arr_chars, n_append);
+			Append(copy.Data(), n_append);
+			return;
+		}
+
+		Reserve(n_chars + n_append);
+		memcpy(Data() + n_chars, arr_chars, n_append * sizeof(char32_t));
+		n_chars += n_append;
+	}
+
+	void TStringChars::Insert(const ssys_t index, const char32_t* const arr_chars, const usys_t n_insert)
+	{
+		const usys_t abs_index = AbsoluteIndex(index, true);
+		if(n_insert == 0)
+			return;
+
+		if(arr_chars >= Data() && arr_chars < Data() + n_chars)
+		{
+			const TStringChars copy(arr_chars, n_insert);
+			Insert(abs_index, copy.Data(), n_insert);
+			return;
+		}
+
+		memcpy(Open(abs_index, n_insert), arr_chars, n_insert * sizeof(char32_t));
+	}
+
+	void TStringChars::FillInsert(const ssys_t index, const char32_t chr, const usys_t n_insert)
+	{
+		char32_t* const arr_chars = Open(AbsoluteIndex(index, true), n_insert);
+		for(usys_t i = 0; i < n_insert; i++)
+			arr_chars[i] = chr;
+	}
+
+	void TStringChars::Remove(const ssys_t index_start, const usys_t n_remove)
+	{
+		const usys_t index = AbsoluteIndex(index_start, false);
+		EL_ERROR(index + n_remove > n_chars, TIndexOutOfBoundsException, -(ssys_t)n_chars, (ssys_t)n_chars - 1, index + n_remove);
+		char32_t* const arr_chars = Data();
+		memmove(arr_chars + index, arr_chars + index + n_remove, (n_chars - index - n_remove) * sizeof(char32_t));
+		n_chars -= n_remove;
+	}
+
+	void TStringChars::Cut(const usys_t n_start, const usys_t n_end)
+	{
+		const usys_t n_cut = n_start + n_end;
+		EL_ERROR(n_cut > n_chars, TIndexOutOfBoundsException, -(ssys_t)n_chars, (ssys_t)n_chars - 1, n_cut);
+		char32_t* const arr_chars = Data();
+		memmove(arr_chars, arr_chars + n_start, (n_chars - n_cut) * sizeof(char32_t));
+		n_chars -= n_cut;
+	}
+
+	void TStringChars::Clear() noexcept
+	{
+		Release();
+		n_chars = 0;
+	}
+
+	void TStringChars::Clear(const usys_t n_prealloc)
+	{
+		n_chars = 0;
+		if(n_prealloc == 0)
+			Release();
+		else if(n_prealloc != NEG1)
+			Reserve(n_prealloc);
+	}
+
+	TStringChars::TStringChars(const char32_t* const arr_chars, const usys_t n_chars) : arr_heap(nullptr), n_chars(0), n_capacity(0)
+	{
+		// exact size, a copy is rarely appended to
+		if(n_chars > N_INLINE)
+		{
+			arr_heap = (char32_t*)malloc(n_chars * sizeof(char32_t));
+			EL_ERROR(arr_heap == nullptr, TOutOfMemoryException, n_chars * sizeof(char32_t));
+			n_capacity = n_chars;
+		}
+
+		if(n_chars != 0)
+			memcpy(Data(), arr_chars, n_chars * sizeof(char32_t));
+		this->n_chars = n_chars;
+	}
+
+	TStringChars::TStringChars(TStringChars&& other) noexcept : arr_heap(other.arr_heap), n_chars(other.n_chars)
+	{
+		memcpy((void*)arr_inline, (const void*)other.arr_inline, sizeof(arr_inline));
+		other.arr_heap = nullptr;
+		other.n_chars = 0;
+	}
+
+	TStringChars& TStringChars::operator=(const TStringChars& rhs)
+	{
+		if(this != &rhs)
+		{
+			n_chars = 0;
+			Reserve(rhs.n_chars);
+			if(rhs.n_chars != 0)
+				memcpy(Data(), rhs.Data(), rhs.n_chars * sizeof(char32_t));
+			n_chars = rhs.n_chars;
+		}
+		return *this;
+	}
+
+	TStringChars& TStringChars::operator=(TStringChars&& rhs) noexcept
+	{
+		if(this != &rhs)
+		{
+			Release();
+			arr_heap = rhs.arr_heap;
+			n_chars = rhs.n_chars;
+			memcpy((void*)arr_inline, (const void*)rhs.arr_inline, sizeof(arr_inline));
+			rhs.arr_heap = nullptr;
+			rhs.n_chars = 0;
+		}
+		return *this;
+	}
+
+	/*********************************************************************************/
+
 	bool TStringView::Contains(const TStringView needle) const
 	{
 		if(needle.Length() == 0)
@@ -28,26 +197,22 @@ namespace el1::io::text::string
 		if(Length() == 0 || needle.Length() > Length())
 			return NEG1;
 
+		// compare the first character before calling memcmp()
+		const char32_t* const arr_chars = Data();
+		const char32_t first = needle[0];
+		const usys_t sz_needle = needle.Length() * sizeof(char32_t);
 		if(reverse)
 		{
 			for(ssys_t i = static_cast<ssys_t>(AbsoluteIndex(start, false)) - static_cast<ssys_t>(needle.Length()) + 1; i >= 0; i--)
-			{
-				usys_t j = 0;
-				for(; j < needle.Length() && (*this)[i + j] == needle[j]; j++);
-				if(j == needle.Length())
+				if(arr_chars[i] == first && memcmp(arr_chars + i, needle.Data(), sz_needle) == 0)
 					return static_cast<usys_t>(i);
-			}
 		}
 		else
 		{
 			const usys_t end = Count() - needle.Length() + 1;
 			for(usys_t i = AbsoluteIndex(start, false); i < end; i++)
-			{
-				usys_t j = 0;
-				for(; j < needle.Length() && (*this)[i + j] == needle[j]; j++);
-				if(j == needle.Length())
+				if(arr_chars[i] == first && memcmp(arr_chars + i, needle.Data(), sz_needle) == 0)
 					return i;
-			}
 		}
 
 		return NEG1;
@@ -58,16 +223,18 @@ namespace el1::io::text::string
 		if(Length() == 0)
 			return NEG1;
 
+		const char32_t* const arr_chars = Data();
 		if(reverse)
 		{
 			for(ssys_t i = static_cast<ssys_t>(AbsoluteIndex(start, false)); i >= 0; i--)
-				if((*this)[i] == needle)
+				if(arr_chars[i] == needle)
 					return static_cast<usys_t>(i);
 		}
 		else
 		{
-			for(usys_t i = AbsoluteIndex(start, false); i < Count(); i++)
-				if((*this)[i] == needle)
+			const usys_t n_chars = Count();
+			for(usys_t i = AbsoluteIndex(start, false); i < n_chars; i++)
+				if(arr_chars[i] == needle)
 					return i;
 		}
 
@@ -243,26 +410,22 @@ namespace el1::io::text::string
 	bool TStringView::operator>(const TStringView rhs) const
 	{
 		const usys_t n = util::Min(Count(), rhs.Count());
+		const char32_t* const lhs_chars = Data();
+		const char32_t* const rhs_chars = rhs.Data();
 		for(usys_t i = 0; i < n; i++)
-		{
-			if((*this)[i] > rhs[i])
-				return true;
-			if((*this)[i] < rhs[i])
-				return false;
-		}
+			if(lhs_chars[i] != rhs_chars[i])
+				return lhs_chars[i] > rhs_chars[i];
 		return Count() > rhs.Count();
 	}
 
 	bool TStringView::operator<(const TStringView rhs) const
 	{
 		const usys_t n = util::Min(Count(), rhs.Count());
+		const char32_t* const lhs_chars = Data();
+		const char32_t* const rhs_chars = rhs.Data();
 		for(usys_t i = 0; i < n; i++)
-		{
-			if((*this)[i] < rhs[i])
-				return true;
-			if((*this)[i] > rhs[i])
-				return false;
-		}
+			if(lhs_chars[i] != rhs_chars[i])
+				return lhs_chars[i] < rhs_chars[i];
 		return Count() < rhs.Count();
 	}
 
@@ -282,7 +445,16 @@ namespace el1::io::text::string
 	{
 		const size_t len = str != nullptr ? (maxlen == NEG1 ? strlen(str) : strnlen(str, maxlen)) : 0;
 		const array_t<const byte_t> array = array_t<const byte_t>::FromUnsafePointer((const byte_t*)str, len);
-		chars = array.Pipe().Transform(TCharDecoder()).Collect();
+		#ifdef EL_CHAR_IS_UTF8
+			// decode straight into the string, short strings never touch the heap
+			chars.SetCount(len);
+			usys_t n_chars;
+			const usys_t n_used = encoding::utf8::DecodeUTF8(array.ItemPtr(0), len, chars.Data(), n_chars);
+			chars.SetCount(n_chars);
+			EL_ERROR(n_used < len, stream::TStreamDryException);
+		#else
+			chars = TStringChars(array.Pipe().Transform(TCharDecoder()).Collect());
+		#endif
 	}
 
 	#ifdef EL_WCHAR_IS_UTF32
@@ -510,10 +682,11 @@ namespace el1::io::text::string
 	{
 		usys_t start = 0;
 		TList<TString> list;
+		const char32_t* const arr_chars = chars.Data();
 
 		for(usys_t i = 0; i < this->Length() && list.Count() + 1 < n_max; i++)
 		{
-			if(this->chars[i] == delimiter)
+			if(arr_chars[i] == delimiter)
 			{
 				if(!(skip_empty && start == i))
 					list.Append(this->SliceBE(start, i));
@@ -532,10 +705,11 @@ namespace el1::io::text::string
 	{
 		usys_t start = 0;
 		TList<TString> list;
+		const char32_t* const arr_chars = chars.Data();
 
 		for(usys_t i = 0; i < this->Length() && list.Count() + 1 < n_max; i++)
 		{
-			if(split_chars.Contains(this->chars[i]))
+			if(split_chars.Contains(arr_chars[i]))
 			{
 				if(!(skip_empty && start == i))
 					list.Append(this->SliceBE(start, i));
@@ -681,14 +855,13 @@ namespace el1::io::text::string
 
 	void TString::Translate(const array_t<const symbol_map_t> map, const bool reverse)
 	{
-		chars.Apply([&](char32_t& current_char) {
+		for(char32_t& current_char : chars)
 			for(usys_t i = 0; i < map.Count(); i++)
 				if(map[i].arr[reverse ? 1 : 0] == current_char)
 				{
 					current_char = map[i].arr[reverse ? 0 : 1];
 					break;
 				}
-		});
 	}
 
 	usys_t TString::ReplaceChars(array_t<const char32_t> list, const char32_t replacement, const bool whitelist)
@@ -731,9 +904,19 @@ namespace el1::io::text::string
 
 	std::unique_ptr<char[]> TStringView::MakeCStr() const
 	{
-		const usys_t n_bytes = Pipe().Transform(TCharEncoder()).Count();
-		auto p = std::unique_ptr<char[]>(new char[n_bytes + 1]);
-		Pipe().Transform(TCharEncoder()).ReadAll((byte_t*)p.get(), n_bytes);
+		#ifdef EL_CHAR_IS_UTF8
+			// size the buffer exactly and encode straight into it, no intermediate list
+			usys_t n_bytes = 0;
+			for(const char32_t chr : *this)
+				n_bytes += chr < 128 ? 1 : (chr < 2048 ? 2 : (chr < 65536 ? 3 : 4));
+			auto p = std::unique_ptr<char[]>(new char[n_bytes + 1]);
+			if(n_bytes != 0)
+				encoding::utf8::EncodeUTF8(ItemPtr(0), Count(), (byte_t*)p.get());
+		#else
+			const usys_t n_bytes = Pipe().Transform(TCharEncoder()).Count();
+			auto p = std::unique_ptr<char[]>(new char[n_bytes + 1]);
+			Pipe().Transform(TCharEncoder()).ReadAll((byte_t*)p.get(), n_bytes);
+		#endif
 		p.get()[n_bytes] = 0;
 		return p;
 	}
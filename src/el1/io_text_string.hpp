@@ -107,10 +107,106 @@ namespace el1::io::text::string
 	inline constexpr TStringView WHITESPACE_CHARS = U"\x09\x0A\x0B\x0C\x0D\x20\x85\xA0\x1680\x2000\x2001\x2002\x2003\x2004\x2005\x2006\x2007\x2008\x2009\x200A\x2028\x2029\x202F\x205F\x3000";
 	array_t<const symbol_map_t> LetterCaseMap();	// [0] = lower; [1] = upper
 
+	/**
+	 * Character storage of TString with the part of the TList interface that strings need.
+	 *
+	 * Up to N_INLINE characters are stored inside the object itself, longer strings
+	 * live on the heap. The data pointer is computed on every access instead of
+	 * pointing into the object, so a TString can still be relocated with memmove()
+	 * like every other TList item. Views into inline characters move along with
+	 * the string and do not survive a move of the TString. This includes the
+	 * relocation of a TString inside a container, e.g. when a TList<TString>
+	 * grows or a map inserts or removes items. Views into heap characters
+	 * survive a move, but only as long as the string is not modified.
+	 */
+	class EL_LIFETIME_OWNER TStringChars
+	{
+		public:
+			static constexpr usys_t N_INLINE = 8;
+
+		protected:
+			char32_t* arr_heap;	// nullptr => the characters are stored in arr_inline
+			usys_t n_chars;
+			union
+			{
+				usys_t n_capacity;	// only while arr_heap != nullptr
+				char32_t arr_inline[N_INLINE];
+			};
+
+			// makes room for at least n_chars_total characters, growing geometrically
+			void Reserve(const usys_t n_chars_total);
+			void Release() noexcept;
+			char32_t* Open(const usys_t index, const usys_t n_insert);
+
+		public:
+			usys_t Count() const noexcept EL_GETTER { return n_chars; }
+			usys_t CountPreallocated() const noexcept EL_GETTER { return (arr_heap == nullptr ? N_INLINE : n_capacity) - n_chars; }
+			bool IsInline() const noexcept EL_GETTER { return arr_heap == nullptr; }
+
+			char32_t* Data() noexcept EL_LIFETIME_BOUND EL_GETTER { return arr_heap == nullptr ? arr_inline : arr_heap; }
+			const char32_t* Data() const noexcept EL_LIFETIME_BOUND EL_GETTER { return arr_heap == nullptr ? arr_inline : arr_heap; }
+
+			array_t<char32_t> View() & noexcept EL_LIFETIME_BOUND { return array_t<char32_t>::FromUnsafePointer(Data(), n_chars); }
+			array_t<const char32_t> View() const & noexcept EL_LIFETIME_BOUND { return array_t<const char32_t>::FromUnsafePointer(Data(), n_chars); }
+			array_t<char32_t> View() && = delete;
+			array_t<const char32_t> View() const && = delete;
+			operator array_t<char32_t>() & noexcept EL_LIFETIME_BOUND { return View(); }
+			operator array_t<const char32_t>() const & noexcept EL_LIFETIME_BOUND { return View(); }
+
+			usys_t AbsoluteIndex(const ssys_t index, const bool allow_tail) const { return View().AbsoluteIndex(index, allow_tail); }
+			char32_t* ItemPtr(const usys_t index) noexcept EL_LIFETIME_BOUND EL_GETTER { return index < n_chars ? Data() + index : nullptr; }
+			const char32_t* ItemPtr(const usys_t index) const noexcept EL_LIFETIME_BOUND EL_GETTER { return index < n_chars ? Data() + index : nullptr; }
+			char32_t& operator[](const ssys_t index) EL_LIFETIME_BOUND { return Data()[AbsoluteIndex(index, false)]; }
+			const char32_t& operator[](const ssys_t index) const EL_LIFETIME_BOUND EL_GETTER { return Data()[AbsoluteIndex(index, false)]; }
+
+			char32_t* begin() noexcept EL_LIFETIME_BOUND { return Data(); }
+			char32_t* end() noexcept EL_LIFETIME_BOUND { return Data() + n_chars; }
+			const char32_t* begin() const noexcept EL_LIFETIME_BOUND { return Data(); }
+			const char32_t* end() const noexcept EL_LIFETIME_BOUND { return Data() + n_chars; }
+
+			TArrayPipe<char32_t> Pipe() & noexcept EL_LIFETIME_BOUND { return View().Pipe(); }
+			TArrayPipe<const char32_t> Pipe() const & noexcept EL_LIFETIME_BOUND { return View().Pipe(); }
+
+			bool Contains(const char32_t chr) const EL_GETTER { return View().Contains(chr); }
+
+			void Prealloc(const usys_t n_chars_need) { Reserve(n_chars + n_chars_need); }
+			void SetCount(const usys_t new_count);	// new characters are U'\0'
+			void Append(const char32_t chr)
+			{
+				if(n_chars == (arr_heap == nullptr ? N_INLINE : n_capacity))
+					Reserve(n_chars + 1);
+				Data()[n_chars++] = chr;
+			}
+
+			void Append(const array_t<const char32_t> chars) { Append(chars.Data(), chars.Count()); }
+			void Append(const char32_t* const arr_chars, const usys_t n_append);
+			void Insert(const ssys_t index, const char32_t chr) { Insert(index, &chr, 1); }
+			void Insert(const ssys_t index, const array_t<const char32_t> chars) { Insert(index, chars.Data(), chars.Count()); }
+			void Insert(const ssys_t index, const char32_t* const arr_chars, const usys_t n_insert);
+			void FillInsert(const ssys_t index, const char32_t chr, const usys_t n_insert);
+			void Remove(const ssys_t index, const usys_t n_remove = 1);
+			void Cut(const usys_t n_start, const usys_t n_end);
+			void Reverse() noexcept { View().Reverse(); }
+
+			void Truncate() noexcept { n_chars = 0; }
+			void Clear() noexcept;
+			void Clear(const usys_t n_prealloc); // n_prealloc == NEG1 => keep existing buffer
+
+			constexpr TStringChars() noexcept : arr_heap(nullptr), n_chars(0), n_capacity(0) {}
+			TStringChars(const char32_t* const arr_chars, const usys_t n_chars);
+			TStringChars(const array_t<const char32_t> chars) : TStringChars(chars.Data(), chars.Count()) {}
+			TStringChars(const TStringChars& other) : TStringChars(other.Data(), other.n_chars) {}
+			TStringChars(TStringChars&& other) noexcept;
+			~TStringChars() { Release(); }
+
+			TStringChars& operator=(const TStringChars& rhs);
+			TStringChars& operator=(TStringChars&& rhs) noexcept;
+	};
+
 	class EL_LIFETIME_OWNER TString
 	{
 		public:
-			TList<char32_t> chars;
+			TStringChars chars;
 
 			template<typename ... A>
 			static TString Format(const format::TFormatString<std::type_identity_t<std::decay_t<const A>>...>& format, A const& ...args);
@@ -216,7 +312,7 @@ namespace el1::io::text::string
 			TString(const char* const str, const usys_t maxlen = NEG1);
 			TString(const wchar_t* const str, const usys_t maxlen = NEG1);
 			TString(const char32_t* const str, const usys_t maxlen = NEG1);
-			TString(TList<char32_t> chars) : chars(std::move(chars)) {}
+			TString(const TList<char32_t>& chars) : chars(chars.View()) {}
 			TString(array_t<const char32_t> chars) : chars(chars) {}
 			TString(const TStringView chars) : chars(static_cast<const array_t<const char32_t>&>(chars)) {}
 
@@ -258,6 +354,20 @@ namespace el1::io::text::string
 		}
 	};
 
+	/** Appends everything written to it to a TString. */
+	struct TStringSink final : stream::ISink<char32_t>
+	{
+		TString* string;
+
+		usys_t Write(const char32_t* const arr_chars, const usys_t n_chars_max) final override EL_WARN_UNUSED_RESULT
+		{
+			string->chars.Append(arr_chars, n_chars_max);
+			return n_chars_max;
+		}
+
+		constexpr explicit TStringSink(TString* const string) : string(string) {}
+	};
+
 	class TLineReader
 	{
 		public:
@@ -45,12 +45,12 @@ namespace el1::security::jwt
 
 	static TList<byte_t> ToBytes(const TStringView text)
 	{
-		return text.Pipe().Transform(TUTF8Encoder()).Collect();
+		return EncodeUTF8(text);
 	}
 
 	static TString FromBytes(const TList<byte_t>& bytes)
 	{
-		return TString(bytes.Pipe().Transform(TUTF8Decoder()).Collect());
+		return TString(DecodeUTF8(bytes));
 	}
 
 
@@ -22,4 +22,8 @@ namespace el1::system::memory
 	void VirtualAllocAt(void* const p_mem, const usys_t sz_bytes, const bool readable, const bool writeable, const bool executable, const bool shared, const bool overwrite);
 	void* VirtualRealloc(void* const p_mem, const usys_t sz_bytes_old, const usys_t sz_bytes_new, const bool readable, const bool writeable, const bool executable, const bool shared, const bool allow_move);
 	void VirtualFree(void* p_mem, const usys_t sz_bytes);
+
+	// hands the physical pages of a private mapping back to the kernel, the address range stays mapped and accessible
+	// the content of the discarded pages is undefined afterwards (it either survives or reads back as zero)
+	void VirtualDiscard(void* const p_mem, const usys_t sz_bytes);
 }
@@ -7,6 +7,7 @@
 #include <malloc.h>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <errno.h>
 
 namespace el1::system::memory
 {
@@ -34,6 +35,21 @@ namespace el1::system::memory
 	{
 		EL_SYSERR(munmap(p_mem, sz_bytes));
 	}
+
+	void VirtualDiscard(void* const p_mem, const usys_t sz_bytes)
+	{
+		// MADV_FREE only reclaims the pages under memory pressure, touching them again before that is free of charge
+		// kernels older than 4.5 do not know MADV_FREE and fail with EINVAL
+		static volatile bool madv_free_supported = true;
+		if(madv_free_supported)
+		{
+			if(madvise(p_mem, sz_bytes, MADV_FREE) == 0)
+				return;
+			EL_ERROR(errno != EINVAL, TSyscallException, errno);
+			madv_free_supported = false;
+		}
+		EL_SYSERR(madvise(p_mem, sz_bytes, MADV_DONTNEED));
+	}
 }
 
 #endif
@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <thread>
 
 #ifdef EL1_WITH_VALGRIND
 #include <valgrind/valgrind.h>
@@ -16,6 +17,7 @@
 
 #ifdef __SANITIZE_ADDRESS__
 #include <sanitizer/common_interface_defs.h>
+#include <sanitizer/asan_interface.h>
 #endif
 
 #define IF_DEBUG_PRINTF(...) if(EL_UNLIKELY(DEBUG)) fprintf(stderr, __VA_ARGS__)
@@ -115,18 +117,206 @@ namespace el1::system::task
 
 	/***************************************************/
 
-	TThread::TThread(const TString name, TFunction<void> main_func, const bool autostart) : name(name), mutex(), on_state_change(&this->mutex), thread_handle(nullptr), constructor_pid(TThread::Self()->ThreadPID()), thread_pid(-1), starter_pid(-1), terminator_pid(-1), state(EChildState::CONSTRUCTED), main_fiber(this)
+	TThread::TThread(const TString name, TUniqueFunction<void> main_func, const bool autostart) : name(name), mutex(), on_state_change(&this->mutex), scheduler_backend(TFiber::DEFAULT_SCHEDULER_BACKEND), io_backend(TFiber::DEFAULT_IO_BACKEND), thread_handle(nullptr), constructor_pid(TThread::Self()->ThreadPID()), thread_pid(-1), starter_pid(-1), terminator_pid(-1), state(EChildState::CONSTRUCTED), main_fiber(this)
 	{
 		this->active_fiber = &this->main_fiber;
 		this->previous_fiber = &this->main_fiber;
-		this->main_fiber.main_func = main_func;
+		this->main_fiber.main_func = std::move(main_func);
 		this->main_fiber.exception = nullptr;
 		this->main_fiber.state = EFiberState::ACTIVE;
-		this->fibers.Append(&this->main_fiber);
+		this->AddFiber(&this->main_fiber);
 		if(autostart)
 			this->Start();
 	}
 
+	void TThread::AddFiber(TFiber* const fiber)
+	{
+		EL_ERROR(fiber->fibers_index != NEG1, TLogicException);
+		fiber->fibers_index = this->fibers.Count();
+		this->fibers.Append(fiber);
+	}
+
+	void TThread::RemoveFiber(TFiber* const fiber)
+	{
+		EL_ERROR(fiber->fibers_index == NEG1, TLogicException);
+
+		// the last fiber takes over the slot, the order of the list is irrelevant
+		TFiber* const last = this->fibers[this->fibers.Count() - 1];
+		this->fibers[fiber->fibers_index] = last;
+		last->fibers_index = fiber->fibers_index;
+		this->fibers.Remove(-1);
+		fiber->fibers_index = NEG1;
+	}
+
+	/***************************************************/
+
+	void TFiberQueue::Append(TFiber* const fiber)
+	{
+		EL_ERROR(fiber->queue != nullptr, TLogicException);
+		fiber->queue = this;
+		fiber->queue_prev = this->tail;
+		fiber->queue_next = nullptr;
+
+		if(this->tail != nullptr)
+			this->tail->queue_next = fiber;
+		else
+			this->head = fiber;
+
+		this->tail = fiber;
+		this->count++;
+	}
+
+	void TFiberQueue::Prepend(TFiber* const fiber)
+	{
+		EL_ERROR(fiber->queue != nullptr, TLogicException);
+		fiber->queue = this;
+		fiber->queue_prev = nullptr;
+		fiber->queue_next = this->head;
+
+		if(this->head != nullptr)
+			this->head->queue_prev = fiber;
+		else
+			this->tail = fiber;
+
+		this->head = fiber;
+		this->count++;
+	}
+
+	void TFiberQueue::Remove(TFiber* const fiber)
+	{
+		EL_ERROR(fiber->queue != this, TLogicException);
+
+		if(fiber->queue_prev != nullptr)
+			fiber->queue_prev->queue_next = fiber->queue_next;
+		else
+			this->head = fiber->queue_next;
+
+		if(fiber->queue_next != nullptr)
+			fiber->queue_next->queue_prev = fiber->queue_prev;
+		else
+			this->tail = fiber->queue_prev;
+
+		fiber->queue = nullptr;
+		fiber->queue_prev = nullptr;
+		fiber->queue_next = nullptr;
+		this->count--;
+	}
+
+	TFiber* TFiberQueue::PopHead()
+	{
+		TFiber* const fiber = this->head;
+		if(fiber != nullptr)
+			this->Remove(fiber);
+		return fiber;
+	}
+
+	/***************************************************/
+
+	struct pooled_stack_t
+	{
+		void* p_mapping;
+		usys_t sz_mapping;
+		usys_t sz_guard;
+		bool discarded;	// the cold pages were already handed back to the kernel
+	};
+
+	// stacks are kept per size class, the class of a stack is log2 of its size in pages
+	// the mapping including both guard pages is reused as is, nothing but the stack pages themselves is ever touched
+	// every class is a LIFO, the few stacks on top are hot and recycled without any system call, the cold pages of all stacks below get discarded
+	class TStackPool
+	{
+		public:
+			static const unsigned N_CLASSES = 19;	// 1 page up to 1GiB on 4k pages
+			static const usys_t N_HOT_STACKS = 4;	// per class
+
+			TList<pooled_stack_t> classes[N_CLASSES];
+			stack_pool_stats_t stats = {};
+
+			// returns N_CLASSES if the stack is too large to be pooled
+			static unsigned SizeClass(const usys_t sz_stack)
+			{
+				const usys_t n_pages = (sz_stack + PAGE_SIZE - 1) / PAGE_SIZE;
+				unsigned size_class = 0;
+				while(size_class < N_CLASSES && ((usys_t)1 << size_class) < n_pages)
+					size_class++;
+				return size_class;
+			}
+
+			static usys_t ClassSize(const unsigned size_class)
+			{
+				return ((usys_t)1 << size_class) * PAGE_SIZE;
+			}
+
+			static void Discard(pooled_stack_t& stack)
+			{
+				// the stack grows downwards, the cold pages are at the low end
+				const usys_t sz_stack = stack.sz_mapping - 2 * stack.sz_guard;
+				const usys_t sz_hot = util::ModCeil<usys_t>(TFiber::STACK_POOL_HOT_BYTES, PAGE_SIZE);
+				if(sz_stack > sz_hot)
+					VirtualDiscard(reinterpret_cast<byte_t*>(stack.p_mapping) + stack.sz_guard, sz_stack - sz_hot);
+				stack.discarded = true;
+			}
+
+			bool Acquire(const unsigned size_class, const usys_t sz_guard, pooled_stack_t& stack)
+			{
+				// the guard size only changes when TFiber::DEBUG is toggled, the most recently parked stack usually fits
+				TList<pooled_stack_t>& list = classes[size_class];
+				for(ssys_t i = (ssys_t)list.Count() - 1; i >= 0; i--)
+					if(list[i].sz_guard == sz_guard)
+					{
+						stack = list[i];
+						list.Remove(i);
+						stats.n_cached--;
+						stats.sz_cached -= stack.sz_mapping;
+						stats.n_hits++;
+						return true;
+					}
+
+				stats.n_misses++;
+				return false;
+			}
+
+			bool Release(const unsigned size_class, const pooled_stack_t& stack)
+			{
+				if(stats.sz_cached + stack.sz_mapping > TFiber::STACK_POOL_MAX_BYTES)
+					return false;
+
+				TList<pooled_stack_t>& list = classes[size_class];
+				list.Append(stack);
+				stats.n_cached++;
+				stats.sz_cached += stack.sz_mapping;
+
+				// the stack which just dropped out of the hot set will probably not be needed for a while
+				if(list.Count() > N_HOT_STACKS)
+				{
+					pooled_stack_t& cold = list[list.Count() - 1 - N_HOT_STACKS];
+					if(!cold.discarded)
+						Discard(cold);
+				}
+
+				return true;
+			}
+
+			~TStackPool()
+			{
+				for(auto& list : classes)
+					for(const pooled_stack_t& stack : list)
+						VirtualFree(stack.p_mapping, stack.sz_mapping);
+			}
+	};
+
+	void TThread::FreeStackPool()
+	{
+		delete this->stack_pool;
+		this->stack_pool = nullptr;
+	}
+
+	stack_pool_stats_t TThread::StackPoolStats() const
+	{
+		EL_ERROR(TThread::Self() != this, TLogicException);
+		return this->stack_pool != nullptr ? this->stack_pool->stats : stack_pool_stats_t {};
+	}
+
 	/***************************************************/
 
 	bool TFiber::TShutdownWaitable::IsReady() const
@@ -159,10 +349,14 @@ namespace el1::system::task
 
 	bool TFiber::DEBUG = false;
 	EStackAllocator TFiber::DEFAULT_STACK_ALLOCATOR = EStackAllocator::VIRTUAL_ALLOC;
+	ESchedulerBackend TFiber::DEFAULT_SCHEDULER_BACKEND = ESchedulerBackend::EPOLL;
+	EIoBackend TFiber::DEFAULT_IO_BACKEND = EIoBackend::READINESS;
 	usys_t TFiber::FIBER_DEFAULT_STACK_SIZE_BYTES = 1024 * 1024;
 	usys_t TFiber::VIRTUAL_STACK_GUARD_SIZE_BYTES = PAGE_SIZE;
 	usys_t TFiber::DEBUG_STACK_GUARD_SIZE_BYTES = 512 * 1024;
 	usys_t TFiber::SIGNAL_STACK_SIZE_BYTES = 64 * 1024;
+	usys_t TFiber::STACK_POOL_MAX_BYTES = 64 * 1024 * 1024;
+	usys_t TFiber::STACK_POOL_HOT_BYTES = 16 * 1024;
 
 	usys_t TFiber::StackFree() const
 	{
@@ -245,7 +439,41 @@ namespace el1::system::task
 
 		self->blocked_by = waitables;
 		self->state = EFiberState::BLOCKED;
-		TFiber::Schedule();
+
+		// only fibers waiting on something the kernel can not report are checked by the scheduler on every pass
+		// all others stay untouched until TEpollSet::Wake(), TIoRing::Reap() or the POLL backend marks them READY
+		// stale readiness flags from an earlier wakeup are cleared, kernel-side state (e.g. a raised TIpcSignal) is left alone
+		bool requires_polling = false;
+		for(auto* waitable : waitables)
+			if(waitable != nullptr)
+			{
+				for(const THandleWaitable* const handle_waitable : waitable->HandleWaitables())
+					handle_waitable->Reset();
+				if(waitable->RequiresPolling())
+					requires_polling = true;
+			}
+
+		if(requires_polling)
+			self->thread->polled.Append(self);
+
+		if(self->thread->scheduler_backend == ESchedulerBackend::EPOLL)
+			self->KernelRegisterWaitables();
+
+		try
+		{
+			TFiber::Schedule();
+		}
+		catch(...)
+		{
+			self->Unqueue();
+			if(self->state == EFiberState::BLOCKED)
+				self->state = EFiberState::ACTIVE;
+			self->KernelUnregisterWaitables();
+			self->blocked_by = array_t<const IWaitable*>();
+			throw;
+		}
+
+		self->KernelUnregisterWaitables();
 		self->blocked_by = array_t<const IWaitable*>();
 	}
 
@@ -282,6 +510,7 @@ namespace el1::system::task
 		EL_ERROR(allocator == EStackAllocator::USER, TInvalidArgumentException, "allocator", "allocator can not be set to USER - USER is only used internally when p_stack and sz_stack are set");
 
 		this->p_stack_mapping = nullptr;
+		this->p_stack = nullptr;
 		this->sz_stack_mapping = 0;
 		this->sz_stack_guard = 0;
 		this->stack_watermark_enabled = false;
@@ -299,28 +528,56 @@ namespace el1::system::task
 			const usys_t sz_guard_min = DEBUG && DEBUG_STACK_GUARD_SIZE_BYTES > VIRTUAL_STACK_GUARD_SIZE_BYTES ? DEBUG_STACK_GUARD_SIZE_BYTES : VIRTUAL_STACK_GUARD_SIZE_BYTES;
 			const usys_t sz_guard_requested = sz_guard_min < PAGE_SIZE ? PAGE_SIZE : sz_guard_min;
 			const usys_t sz_guard = util::ModCeil<usys_t>(sz_guard_requested, PAGE_SIZE);
-			const usys_t sz_stack = util::ModCeil<usys_t>(sz_stack_input, PAGE_SIZE);
-			const usys_t sz_mapping = sz_guard + sz_stack + sz_guard;
 
-			void* const p_mapping = VirtualAlloc(sz_mapping, false, false, false, false);
-			void* const p_stack = reinterpret_cast<byte_t*>(p_mapping) + sz_guard;
+			// poolable stacks are rounded up to their size class, the additional pages are never committed unless used
+			const unsigned size_class = TStackPool::SizeClass(sz_stack_input);
+			const usys_t sz_stack = size_class < TStackPool::N_CLASSES ? TStackPool::ClassSize(size_class) : util::ModCeil<usys_t>(sz_stack_input, PAGE_SIZE);
+			const usys_t sz_mapping = sz_guard + sz_stack + sz_guard;
 
-			try
+			pooled_stack_t pooled;
+			if(size_class < TStackPool::N_CLASSES && TFiber::STACK_POOL_MAX_BYTES > 0)
 			{
-				VirtualAllocAt(p_stack, sz_stack, true, true, false, false, true);
+				if(this->thread->stack_pool == nullptr)
+					this->thread->stack_pool = new TStackPool();
+
+				if(this->thread->stack_pool->Acquire(size_class, sz_guard, pooled))
+				{
+					this->stack_allocator = EStackAllocator::VIRTUAL_ALLOC;
+					this->sz_stack = sz_stack;
+					this->p_stack = reinterpret_cast<byte_t*>(pooled.p_mapping) + sz_guard;
+					this->p_stack_mapping = pooled.p_mapping;
+					this->sz_stack_mapping = sz_mapping;
+					this->sz_stack_guard = sz_guard;
+
+					// frames of the previous owner may still be poisoned
+					#ifdef __SANITIZE_ADDRESS__
+						ASAN_UNPOISON_MEMORY_REGION(this->p_stack, this->sz_stack);
+					#endif
+				}
 			}
-			catch(...)
+
+			if(this->p_stack == nullptr)
 			{
-				VirtualFree(p_mapping, sz_mapping);
-				throw;
-			}
+				void* const p_mapping = VirtualAlloc(sz_mapping, false, false, false, false);
+				void* const p_stack = reinterpret_cast<byte_t*>(p_mapping) + sz_guard;
+
+				try
+				{
+					VirtualAllocAt(p_stack, sz_stack, true, true, false, false, true);
+				}
+				catch(...)
+				{
+					VirtualFree(p_mapping, sz_mapping);
+					throw;
+				}
 
-			this->stack_allocator = EStackAllocator::VIRTUAL_ALLOC;
-			this->sz_stack = sz_stack;
-			this->p_stack = p_stack;
-			this->p_stack_mapping = p_mapping;
-			this->sz_stack_mapping = sz_mapping;
-			this->sz_stack_guard = sz_guard;
+				this->stack_allocator = EStackAllocator::VIRTUAL_ALLOC;
+				this->sz_stack = sz_stack;
+				this->p_stack = p_stack;
+				this->p_stack_mapping = p_mapping;
+				this->sz_stack_mapping = sz_mapping;
+				this->sz_stack_guard = sz_guard;
+			}
 		}
 		else if(allocator == EStackAllocator::MALLOC)
 		{
@@ -340,31 +597,51 @@ namespace el1::system::task
 		}
 	}
 
-	void TFiber::FreeStack()
+	TFiber::detached_stack_t TFiber::DetachStack()
+	{
+		const detached_stack_t stack = { this->stack_allocator, this->p_stack, this->sz_stack, this->p_stack_mapping, this->sz_stack_mapping, this->sz_stack_guard };
+
+		this->p_stack = nullptr;
+		this->sz_stack = 0;
+		this->p_stack_mapping = nullptr;
+		this->sz_stack_mapping = 0;
+		this->sz_stack_guard = 0;
+		this->stack_watermark_enabled = false;
+		this->stack_allocator = EStackAllocator::USER;
+
+		return stack;
+	}
+
+	void TFiber::FreeStack(const detached_stack_t& stack)
 	{
-		switch(this->stack_allocator)
+		switch(stack.allocator)
 		{
 			case EStackAllocator::USER:
 				break;
 			case EStackAllocator::MALLOC:
-				free(this->p_stack);
+				free(stack.p_stack);
 				break;
 			case EStackAllocator::VIRTUAL_ALLOC:
-				if(this->p_stack_mapping != nullptr)
-					VirtualFree(this->p_stack_mapping, this->sz_stack_mapping);
+				if(stack.p_stack_mapping != nullptr)
+				{
+					// the stack goes to the pool of the thread that releases it, there is no need to synchronize with the owner
+					TThread* const thread = TThread::Self();
+					const unsigned size_class = TStackPool::SizeClass(stack.sz_stack);
+					const bool pooled = thread != nullptr && thread->stack_pool != nullptr && size_class < TStackPool::N_CLASSES && TStackPool::ClassSize(size_class) == stack.sz_stack &&
+						thread->stack_pool->Release(size_class, { stack.p_stack_mapping, stack.sz_stack_mapping, stack.sz_stack_guard, false });
+					if(!pooled)
+						VirtualFree(stack.p_stack_mapping, stack.sz_stack_mapping);
+				}
 				break;
 		}
+	}
 
-		this->p_stack = nullptr;
-		this->sz_stack = 0;
-		this->p_stack_mapping = nullptr;
-		this->sz_stack_mapping = 0;
-		this->sz_stack_guard = 0;
-		this->stack_watermark_enabled = false;
-		this->stack_allocator = EStackAllocator::USER;
+	void TFiber::FreeStack()
+	{
+		FreeStack(DetachStack());
 	}
 
-	TFiber::TFiber(TFunction<void> main_func, const bool autostart, const usys_t sz_stack, void* const p_stack, const EStackAllocator allocator) : thread(TThread::Self()), main_func(main_func), sz_stack(0), p_stack(nullptr), blocked_by(), state(EFiberState::CONSTRUCTED), shutdown(false), block_shutdown(0)
+	TFiber::TFiber(TUniqueFunction<void> main_func, const bool autostart, const usys_t sz_stack, void* const p_stack, const EStackAllocator allocator) : thread(TThread::Self()), main_func(std::move(main_func)), sz_stack(0), p_stack(nullptr), blocked_by(), state(EFiberState::CONSTRUCTED), shutdown(false), block_shutdown(0)
 	{
 		IF_DEBUG_PRINTF("TFiber@%p::TFiber(main_func=?, autostart=%s, sz_stack=%zu, p_stack=%p, allocator=%u)\n", this, autostart ? "true":"false", (size_t)sz_stack, p_stack, (unsigned)allocator);
 		AllocateStack(p_stack, sz_stack, allocator);
@@ -440,17 +717,31 @@ namespace el1::system::task
 		}
 
 		self->shutdown = false;
-		self->thread->fibers.RemoveItem(self, NEG1);
+		self->thread->RemoveFiber(self);
 		IF_DEBUG_PRINTF("TFiber@%p::Boot(): terminating, calling scheduler\n", self);
 		TFiber::Schedule();
 	}
 
+	// the fiber which called Schedule() runs after the other fibers that were woken by the same kernel wait
+	// e.g. a sleep which expired together with a pipe does not overtake the reader of that pipe
+	TFiber* TFiber::QueueBehindWoken(TFiber* const next_fiber)
+	{
+		if(next_fiber != this || this->state != EFiberState::READY)
+			return next_fiber;
+
+		// EPOLL leaves the fiber it returns in the ready queue, POLL already popped it
+		if(this->thread->ready.Count() == (this->queue == &this->thread->ready ? 1U : 0U))
+			return next_fiber;
+
+		this->MarkReady();
+		return this->thread->ready.PopHead();
+	}
+
 	void TFiber::Schedule()
 	{
 		TThread* const thread = TThread::Self();
 		EL_ERROR(thread->active_fiber == nullptr, TLogicException);
 		TFiber* const self = thread->active_fiber;
-		auto& fibers = thread->fibers;
 		TFiber* next_fiber = nullptr;
 		IF_DEBUG_PRINTF("TFiber@%p::Schedule(): ENTER\n", self);
 
@@ -460,59 +751,60 @@ namespace el1::system::task
 			throw shutdown_t();
 		}
 
-		// find another ready fiber
+		// fibers whose io_uring transfers completed become READY here without another trip through the kernel
+		KernelReapCompletions();
+
+		// take the next ready fiber
+		// this can be the active fiber itself if KernelReapCompletions() just woke it up
+		next_fiber = thread->ready.PopHead();
+
+		// check-unblock blocked fibers
+		// this only targets fibers blocked on waitables which require polling
 		if(next_fiber == nullptr)
 		{
-			for(TFiber* fiber : fibers)
+			for(TFiber* fiber = thread->polled.Head(); fiber != nullptr; fiber = fiber->queue_next)
 			{
 				EL_ERROR(thread != fiber->thread, TLogicException);
 
-				if(fiber == self)
-					continue;
+				bool is_ready = false;
+				for(const IWaitable* waitable : fiber->blocked_by)
+					if(waitable != nullptr)
+					{
+						waitable->Reset();
+						if(waitable->IsReady())
+							is_ready = true;
+					}
 
-				if(fiber->state == EFiberState::READY)
+				if(is_ready)
 				{
+					thread->polled.Remove(fiber);
+					fiber->state = EFiberState::READY;
 					next_fiber = fiber;
 					break;
 				}
 			}
 		}
 
-		// check-unblock blocked fibers
-		// this will target all non-THandleWaitables
-		if(next_fiber == nullptr)
+		// check THandleWaitables
+		if(next_fiber == nullptr && thread->scheduler_backend == ESchedulerBackend::EPOLL)
 		{
-			for(TFiber* fiber : fibers)
-			{
-				if(fiber->state == EFiberState::BLOCKED)
-				{
-					for(const IWaitable* waitable : fiber->blocked_by)
-						if(waitable != nullptr)
-						{
-							waitable->Reset();
-							if(waitable->IsReady())
-							{
-								fiber->state = EFiberState::READY;
-							}
-						}
-
-					if(fiber->state == EFiberState::READY)
-					{
-						next_fiber = fiber;
-						break;
-					}
-				}
-			}
+			// the epoll set already knows which fiber waits on which handle
+			// only the fibers whose handles fired are touched
+			IF_DEBUG_PRINTF("TFiber@%p::Schedule(): calling KernelWaitForEvents()\n", self);
+			next_fiber = KernelWaitForEvents();
+			EL_ERROR(next_fiber == nullptr, TLogicException);
+			next_fiber = self->QueueBehindWoken(next_fiber);
 		}
-
-		// check THandleWaitables
-		if(next_fiber == nullptr)
+		else if(next_fiber == nullptr)
 		{
+			auto& fibers = thread->fibers;
+
 			// this function only returns after some waitable became ready or a shutdown signal was received
 			IF_DEBUG_PRINTF("TFiber@%p::Schedule(): calling KernelWaitForMany(fibers=%zu)\n", self, (size_t)fibers.Count());
 			KernelWaitForMany(fibers);
 			IF_DEBUG_PRINTF("TFiber@%p::Schedule(): returned from KernelWaitForMany(fibers=%zu)\n", self, (size_t)fibers.Count());
 
+			// we process all waitables and update all fibers to process all information gained from the expensive kernel call
 			for(TFiber* fiber : fibers)
 			{
 				if(fiber->state == EFiberState::BLOCKED)
@@ -523,28 +815,35 @@ namespace el1::system::task
 							if(waitable->IsReady())
 							{
 								IF_DEBUG_PRINTF("TFiber@%p::Schedule(): fiber=%p is now READY\n", self, fiber);
-								fiber->state = EFiberState::READY;
+								fiber->MarkReady();
 								break;
 							}
 						}
 				}
-
-				if(fiber->state == EFiberState::READY || fiber->state == EFiberState::ACTIVE)
-				{
-					next_fiber = fiber;
-					// we do not break here - we want to process all waitables and update all fibers
-					// to process all information gained from the expensive kernel call
-				}
 			}
 
+			next_fiber = thread->ready.PopHead();
+
+			// a shutdown request for the active fiber itself
+			if(next_fiber == nullptr && self->state == EFiberState::ACTIVE)
+				next_fiber = self;
+
 			// this can only happen if KernelWaitForMany() has a waitable has a bug
 			EL_ERROR(next_fiber == nullptr, TLogicException);
+			next_fiber = self->QueueBehindWoken(next_fiber);
 		}
 
 		IF_DEBUG_PRINTF("TFiber@%p::Schedule(): next_fiber=%p\n", self, next_fiber);
 
 		if(next_fiber != self)
+		{
+			// a yielding fiber goes to the end of the ready queue
+			if(self->state == EFiberState::ACTIVE)
+				self->MarkReady();
 			next_fiber->SwitchTo();
+		}
+		else
+			self->Unqueue();
 
 		self->state = EFiberState::ACTIVE;
 		thread->active_fiber = self;
@@ -559,6 +858,22 @@ namespace el1::system::task
 		return;
 	}
 
+	void TFiber::MarkReady(const bool front)
+	{
+		this->Unqueue();
+		this->state = EFiberState::READY;
+		if(front)
+			this->thread->ready.Prepend(this);
+		else
+			this->thread->ready.Append(this);
+	}
+
+	void TFiber::Unqueue()
+	{
+		if(this->queue != nullptr)
+			this->queue->Remove(this);
+	}
+
 	void TFiber::Yield()
 	{
 		IF_DEBUG_PRINTF("TFiber@%p::Yield()\n", Self());
@@ -581,12 +896,13 @@ namespace el1::system::task
 		this->thread->previous_fiber = self;
 
 		if(this->state == EFiberState::STOPPED)
-			this->thread->fibers.Append(this);
+			this->thread->AddFiber(this);
 
+		this->Unqueue();
 		this->state = EFiberState::ACTIVE;
 
 		if(self->state == EFiberState::ACTIVE)
-			self->state = EFiberState::READY;
+			self->MarkReady(true);
 
 		#ifdef __SANITIZE_ADDRESS__
 			void* fake_stack_save = nullptr;
@@ -628,11 +944,11 @@ namespace el1::system::task
 		EL_ERROR(TThread::Self() != this->thread, TLogicException);
 		EL_ERROR(this->state != EFiberState::CONSTRUCTED, TLogicException);	// TODO better exception
 		this->InitRegisters();
-		this->state = EFiberState::READY;
-		this->thread->fibers.Append(this);
+		this->thread->AddFiber(this);
+		this->MarkReady();
 	}
 
-	void TFiber::Start(TFunction<void> new_main_func, const usys_t sz_stack_input, void* const p_stack_input, const EStackAllocator allocator)
+	void TFiber::Start(TUniqueFunction<void> new_main_func, const usys_t sz_stack_input, void* const p_stack_input, const EStackAllocator allocator)
 	{
 		IF_DEBUG_PRINTF("TFiber@%p::Start(main_func=?, sz_stack_input=%zu, p_stack_input=%p, allocator=%u)\n", this, (size_t)sz_stack_input, p_stack_input, (unsigned)allocator);
 		EL_ERROR(TThread::Self() != this->thread, TLogicException);
@@ -644,7 +960,7 @@ namespace el1::system::task
 			AllocateStack(p_stack_input, sz_stack_input, allocator);
 		}
 
-		this->main_func = new_main_func;
+		this->main_func = std::move(new_main_func);
 		this->Start();
 	}
 
@@ -657,7 +973,8 @@ namespace el1::system::task
 
 		if(this->state != EFiberState::STOPPED)
 		{
-			EL_ERROR(this->thread->fibers.RemoveItem(this, NEG1) != 1, TLogicException);
+			this->thread->RemoveFiber(this);
+			this->Unqueue();
 			this->state = EFiberState::STOPPED;
 		}
 
@@ -678,8 +995,8 @@ namespace el1::system::task
 		{
 			// we put the fiber in READY state even though it might have been BLOCKED earlier when it was stopped
 			// the scheduler will activate the fiber, but the WaitFor() function will put it back to BLOCKED if needed
-			this->state = EFiberState::READY;
-			this->thread->fibers.Append(this);
+			this->thread->AddFiber(this);
+			this->MarkReady();
 		}
 	}
 
@@ -693,8 +1010,15 @@ namespace el1::system::task
 			return false;
 
 		if(this->state == EFiberState::BLOCKED || this->state == EFiberState::READY)
-			EL_ERROR(this->thread->fibers.RemoveItem(this, NEG1) != 1, TLogicException);
+		{
+			this->thread->RemoveFiber(this);
+			this->Unqueue();
+		}
 
+		// the killed fiber never returns from WaitForMany() - drop its epoll registrations here
+		this->KernelUnregisterWaitables();
+		if(this->ring_op != 0)
+			this->KernelAbandonTransfer();
 		this->state = EFiberState::KILLED;
 
 		return true;
@@ -711,12 +1035,20 @@ namespace el1::system::task
 
 		if(this->state == EFiberState::STOPPED)
 		{
-			this->thread->fibers.Append(this);
+			this->thread->AddFiber(this);
 		}
 
 		// unblock / resume any fiber marked for shutdown
 		if(this->state != EFiberState::ACTIVE)
-			this->state = (self == this) ? EFiberState::ACTIVE : EFiberState::READY;
+		{
+			if(self == this)
+			{
+				this->Unqueue();
+				this->state = EFiberState::ACTIVE;
+			}
+			else
+				this->MarkReady();
+		}
 
 		this->shutdown = true;
 
@@ -798,6 +1130,182 @@ namespace el1::system::task
 
 	/////////////////////////////////////////////////////////////
 
+	TFiberPool::worker_t::worker_t(TFiberPool* const pool, const usys_t index) : pool(pool), index(index), idle(false)
+	{
+	}
+
+	void TFiberPool::worker_t::Main()
+	{
+		// the counters outlive the fibers, which still finish while the list gets destroyed on shutdown
+		usys_t n_fibers = 0;
+		usys_t n_finished = 0;
+		TList<std::unique_ptr<TFiber>> fibers;
+		TList<TUniqueFunction<void>> jobs;
+
+		auto on_finish = [this, &n_fibers, &n_finished]()
+		{
+			n_finished++;
+			if(--pool->n_pending == 0)
+				pool->on_idle.Raise();
+
+			// enough dead fibers piled up, let the loop below free their stacks
+			if(n_finished * 2 > n_fibers)
+				on_work.Raise();
+		};
+
+		for(;;)
+		{
+			// Reset() before looking at the queues - a Spawn() racing with us raises the signal again
+			on_work.Reset();
+
+			{
+				const TMutexAutoLock lock(&mutex);
+				jobs = std::move(queue);
+			}
+
+			if(jobs.Count() == 0)
+			{
+				// announce that we are idle before looking at the other queues,
+				// so a Spawn() onto a busy worker either sees the flag or Steal() sees its fiber
+				idle = true;
+				pool->Steal(this, jobs);
+			}
+
+			if(n_finished * 2 > n_fibers)
+			{
+				for(usys_t i = fibers.Count(); i > 0; i--)
+					if(fibers[i - 1]->IsJoinable())
+					{
+						if(auto e = fibers[i - 1]->Join())
+							e->Print("TFiberPool: fiber terminated with exception");
+
+						if(i < fibers.Count())
+							fibers[i - 1] = std::move(fibers[fibers.Count() - 1]);
+						fibers.Remove(-1);
+						n_fibers--;
+						n_finished--;
+					}
+			}
+
+			if(jobs.Count() == 0)
+			{
+				on_work.WaitFor();
+				idle = false;
+				continue;
+			}
+
+			idle = false;
+
+			n_fibers += jobs.Count();
+			for(TUniqueFunction<void>& job : jobs)
+				fibers.MoveAppend(std::make_unique<TFiber>([job = std::move(job), on_finish](){
+					try
+					{
+						job();
+					}
+					catch(...)
+					{
+						on_finish();
+						throw;
+					}
+					on_finish();
+				}, true, pool->sz_stack));
+
+			jobs.Clear();
+
+			// the new fibers are READY - let them (and everybody else) run before we look for more work
+			TFiber::Yield();
+		}
+	}
+
+	void TFiberPool::Steal(const worker_t* const thief, TList<TUniqueFunction<void>>& stolen)
+	{
+		const usys_t n_workers = workers.Count();
+		for(usys_t i = 1; i < n_workers; i++)
+		{
+			worker_t& victim = *workers[(thief->index + i) % n_workers];
+			const TMutexAutoLock lock(&victim.mutex);
+			const usys_t n_queued = victim.queue.Count();
+			if(n_queued == 0)
+				continue;
+
+			// the victim starts its queue from the front, we take the newer half from the back
+			const usys_t n_steal = (n_queued + 1) / 2;
+			const usys_t index = n_queued - n_steal;
+			for(usys_t j = index; j < n_queued; j++)
+				stolen.MoveAppend(std::move(victim.queue[j]));
+			victim.queue.Remove(index, n_steal);
+
+			n_stolen += n_steal;
+			return;
+		}
+	}
+
+	void TFiberPool::Spawn(TUniqueFunction<void> main_func)
+	{
+		worker_t& worker = *workers[next_worker++ % workers.Count()];
+		n_pending++;
+
+		{
+			const TMutexAutoLock lock(&worker.mutex);
+			worker.queue.MoveAppend(std::move(main_func));
+		}
+
+		worker.on_work.Raise();
+
+		// the worker might be busy for a while, wake up an idle worker to steal the fiber
+		if(!worker.idle)
+			for(auto& other : workers)
+				if(other->idle)
+				{
+					other->on_work.Raise();
+					break;
+				}
+	}
+
+	bool TFiberPool::WaitIdle(const TTime timeout)
+	{
+		const TTime ts_deadline = timeout < 0 ? TTime(-1) : TTime::Now(EClock::MONOTONIC) + timeout;
+
+		for(;;)
+		{
+			on_idle.Reset();
+			if(n_pending == 0)
+				return true;
+
+			if(timeout < 0)
+				on_idle.WaitFor();
+			else if(!on_idle.WaitFor(ts_deadline, true))
+				return n_pending == 0;
+		}
+	}
+
+	TFiberPool::TFiberPool(const usys_t n_workers, const usys_t sz_stack) : sz_stack(sz_stack), next_worker(0), n_pending(0), n_stolen(0)
+	{
+		const usys_t n = n_workers != 0 ? n_workers : util::Max<usys_t>(1, std::thread::hardware_concurrency());
+
+		// all workers have to exist before the first one starts stealing
+		for(usys_t i = 0; i < n; i++)
+			workers.MoveAppend(std::make_unique<worker_t>(this, i));
+
+		for(auto& worker : workers)
+			worker->thread = std::make_unique<TThread>(TString::Format(U"fiber-pool/%d", (int)worker->index), TUniqueFunction<void>(worker.get(), &worker_t::Main));
+	}
+
+	TFiberPool::~TFiberPool()
+	{
+		// a worker which did not receive its shutdown request yet might still steal from the others,
+		// so the worker objects are only destroyed after all threads were joined
+		for(auto& worker : workers)
+			if(worker->thread != nullptr)
+				worker->thread->Shutdown();
+
+		for(auto& worker : workers)
+			worker->thread.reset();
+	}
+
+	/////////////////////////////////////////////////////////////
+
 	TSortedMap<fd_t, TProcess::EFDIO> TProcess::StdioStreams()
 	{
 		TSortedMap<fd_t, TProcess::EFDIO> map;
@@ -863,7 +1371,8 @@ namespace el1::system::task
 	static const auto STREAM_READER_FUNC = [](TProcess::TSource* const src, TString* const dst) {
 		EL_ERROR(src == nullptr, TInvalidArgumentException, "src", "src must not be nullptr");
 		EL_ERROR(dst == nullptr, TInvalidArgumentException, "dst", "dst must not be nullptr");
-		src->Pipe().Transform(io::text::encoding::TCharDecoder()).AppendTo(dst->chars);
+		io::text::string::TStringSink sink(dst);
+		src->Pipe().Transform(io::text::encoding::TCharDecoder()).ToStream(sink);
 		if(!src->CloseInput())
 			src->Close();
 	};
@@ -11,6 +11,7 @@
 #include "io_text_string.hpp"
 #include "util_function.hpp"
 #include "error.hpp"
+#include <atomic>
 #include <optional>
 
 namespace el1::system::task
@@ -26,6 +27,10 @@ namespace el1::system::task
 
 	class TThread;
 	class TFiber;
+	class TFiberQueue;
+	class TEpollSet;
+	class TIoRing;
+	class TStackPool;
 
 	using process_id_t = s32_t;
 
@@ -174,6 +179,8 @@ namespace el1::system::task
 	// Kernel-backed signal that can be used as an IWaitable by fibers and raised
 	// from another thread. Multiple Raise() calls may be coalesced; users must
 	// keep the actual state separately and use the signal only as a wake-up hint.
+	// The waiting side calls Reset() before it checks the state and WaitFor() after,
+	// a Raise() in between is then never lost. The scheduler itself never drains the signal.
 	class TIpcSignal : public ISignal, public IWaitable
 	{
 		protected:
@@ -187,6 +194,7 @@ namespace el1::system::task
 			void Raise() final override;
 			bool IsReady() const final override { return handle_waitable.IsReady(); }
 			void Reset() const final override;
+			bool RequiresPolling() const final override { return false; }
 			io::collection::array::array_t<const THandleWaitable*> HandleWaitables() const final override EL_GETTER;
 
 			TIpcSignal(TIpcSignal&&) = delete;
@@ -412,20 +420,76 @@ namespace el1::system::task
 	{
 		USER, // DO NOT USE - this is only used internally when p_stack and sz_stack were specified
 		MALLOC, // fastest allocator; no guard-page protection, intended for very large fiber populations
-		VIRTUAL_ALLOC // mmap-backed stack with inaccessible guard pages on both sides
+		VIRTUAL_ALLOC // mmap-backed stack with inaccessible guard pages on both sides, recycled through the stack pool of the thread (see TThread::StackPoolStats())
+	};
+
+	struct stack_pool_stats_t
+	{
+		u64_t n_hits;		// VIRTUAL_ALLOC stacks that were taken from the pool
+		u64_t n_misses;		// VIRTUAL_ALLOC stacks that had to be mapped
+		usys_t n_cached;	// stacks currently parked in the pool
+		usys_t sz_cached;	// address space currently parked in the pool (including guard pages)
+	};
+
+	enum class ESchedulerBackend : u8_t
+	{
+		POLL,	// rebuilds a pollfd array from all BLOCKED fibers on every kernel wait - O(n) per wakeup
+		EPOLL	// persistent per-thread epoll set, updated incrementally as fibers block and unblock - O(1) per wakeup
+	};
+
+	enum class EIoBackend : u8_t
+	{
+		READINESS,	// non-blocking syscall, the fiber blocks on a THandleWaitable until the scheduler reports readiness
+		IO_URING	// blocking transfers are queued on a per-thread io_uring, the scheduler reaps the completions and resumes the fiber directly
+	};
+
+	// intrusive FIFO of fibers, linking and unlinking is O(1) and never allocates
+	// a fiber is linked into at most one queue at a time (see TFiber::queue)
+	class TFiberQueue
+	{
+		friend class TFiber;
+		private:
+			TFiber* head = nullptr;
+			TFiber* tail = nullptr;
+			usys_t count = 0;
+
+		public:
+			void Append(TFiber* const fiber);
+			void Prepend(TFiber* const fiber);
+			void Remove(TFiber* const fiber);
+			TFiber* PopHead();
+
+			TFiber* Head() const EL_GETTER { return head; }
+			usys_t Count() const EL_GETTER { return count; }
 	};
 
 	// fibers are "lightweight threads" that are based on cooperative multitasking
 	// they strictly belong to the thread that constructed them and must not be manipulated by other threads
+	// to spread work over several cores use TFiberPool, it decides on which thread a fiber gets constructed
 	// any TThread always runs exactly one fiber at a time, the active fiber decides by itself when to switch to a different fiber
 	// the scheduler is only used when the active fiber blocks or diliberately calls the scheduler, there is no time-slicing or other forced switching
 	// switching fibers is a very lightweight process and does not require any system calls
 	class TFiber : public IChildTask
 	{
 		friend class TThread;
+		friend class TFiberQueue;
+		friend class TEpollSet;
+		friend class TIoRing;
+		friend struct io_ring_op_t;
 		protected:
+			// a stack which was taken away from its fiber and is freed later by someone else (see DetachStack())
+			struct detached_stack_t
+			{
+				EStackAllocator allocator = EStackAllocator::USER;
+				void* p_stack = nullptr;
+				usys_t sz_stack = 0;
+				void* p_stack_mapping = nullptr;
+				usys_t sz_stack_mapping = 0;
+				usys_t sz_stack_guard = 0;
+			};
+
 			TThread* const thread;
-			TFunction<void> main_func;
+			TUniqueFunction<void> main_func;
 			usys_t sz_stack;
 			void* p_stack;
 			void* p_stack_mapping = nullptr;
@@ -434,6 +498,12 @@ namespace el1::system::task
 			bool stack_watermark_enabled = false;
 			std::unique_ptr<const IException> exception;
 			array_t<const IWaitable*> blocked_by;
+			TList<handle_t> kernel_wait_handles;	// handles this fiber is currently registered for in the thread's epoll set
+			u32_t ring_op = 0;	// slot of the io_uring transfer this fiber is waiting for (index + 1), 0 if none
+			TFiberQueue* queue = nullptr;	// ready queue or poll set of the thread this fiber is linked into, nullptr if none
+			TFiber* queue_prev = nullptr;
+			TFiber* queue_next = nullptr;
+			usys_t fibers_index = NEG1;	// position in TThread::fibers, NEG1 while not listed
 			EFiberState state;
 			EStackAllocator stack_allocator;
 			bool shutdown;
@@ -442,15 +512,36 @@ namespace el1::system::task
 
 			static void Boot();
 			static void Schedule();
+			TFiber* QueueBehindWoken(TFiber* const next_fiber);	// see Schedule()
 			void InitRegisters();
 			void AllocateStack(void* const p_stack_input, const usys_t sz_stack_input, const EStackAllocator allocator);
 			void FreeStack();
+			detached_stack_t DetachStack();	// leaves the fiber without a stack
+			static void FreeStack(const detached_stack_t& stack);
+
+			// puts the fiber in READY state and appends (or prepends) it to the ready queue of its thread
+			void MarkReady(const bool front = false);
+
+			// unlinks the fiber from the ready queue or poll set (if any)
+			void Unqueue();
 
 			TFiber(TThread* const thread);
 
 		private:
 			static void KernelWaitForMany(const TList<TFiber*>& fibers);
 
+			// EPOLL backend: (un)registers the THandleWaitables of blocked_by with the thread's epoll set
+			// KernelWaitForEvents() waits until at least one registered handle fires (or a shutdown was delivered)
+			// and returns a fiber that became READY - only the fibers waiting on the fired handles are touched
+			void KernelRegisterWaitables();
+			void KernelUnregisterWaitables();
+			static TFiber* KernelWaitForEvents();
+
+			// IO_URING backend: collects the completions the kernel posted so far and marks their fibers READY
+			// queued submissions are flushed as well once they waited for a few scheduler passes
+			static void KernelReapCompletions();
+			void KernelAbandonTransfer();	// the fiber got killed while its transfer was in flight
+
 		public:
 			class TShutdownWaitable : public IWaitable
 			{
@@ -468,10 +559,14 @@ namespace el1::system::task
 
 			static bool DEBUG;
 			static EStackAllocator DEFAULT_STACK_ALLOCATOR;
+			static ESchedulerBackend DEFAULT_SCHEDULER_BACKEND;	// applies to threads constructed afterwards, see TThread::SchedulerBackend()
+			static EIoBackend DEFAULT_IO_BACKEND;	// applies to threads constructed afterwards, see TThread::IoBackend()
 			static usys_t FIBER_DEFAULT_STACK_SIZE_BYTES;
 			static usys_t VIRTUAL_STACK_GUARD_SIZE_BYTES;
 			static usys_t DEBUG_STACK_GUARD_SIZE_BYTES;
 			static usys_t SIGNAL_STACK_SIZE_BYTES;
+			static usys_t STACK_POOL_MAX_BYTES;	// address space each thread may keep in its stack pool, 0 disables the pool
+			static usys_t STACK_POOL_HOT_BYTES;	// top-most part of a pooled stack which stays committed once the stack turned cold, the pages below are discarded
 
 			TFiber(const TFiber&) = delete;
 			TFiber(TFiber&&) = delete;
@@ -480,7 +575,7 @@ namespace el1::system::task
 			virtual ~TFiber();
 
 			TFiber(); // won't start fiber
-			TFiber(TFunction<void> main_func, const bool autostart = true, const usys_t sz_stack = FIBER_DEFAULT_STACK_SIZE_BYTES, void* const p_stack = nullptr, const EStackAllocator allocator = DEFAULT_STACK_ALLOCATOR);
+			TFiber(TUniqueFunction<void> main_func, const bool autostart = true, const usys_t sz_stack = FIBER_DEFAULT_STACK_SIZE_BYTES, void* const p_stack = nullptr, const EStackAllocator allocator = DEFAULT_STACK_ALLOCATOR);
 
 			TShutdownWaitable OnShutdown() EL_GETTER { return TShutdownWaitable(this); }
 
@@ -520,11 +615,12 @@ namespace el1::system::task
 			bool IsJoinable() const { return this->state == EFiberState::FINISHED || this->state == EFiberState::CRASHED || this->state == EFiberState::KILLED; }
 
 			// switches to this fiber, fails if the fiber is not alive
+			// the calling fiber is put at the front of the ready queue, so it continues as soon as this fiber blocks or yields
 			void SwitchTo();
 
 			// starts a fiber - fails if the fiber is not in CONSTRUCTED state
 			void Start();
-			void Start(TFunction<void> main_func, const usys_t sz_stack = FIBER_DEFAULT_STACK_SIZE_BYTES, void* const p_stack = nullptr, const EStackAllocator allocator = DEFAULT_STACK_ALLOCATOR);
+			void Start(TUniqueFunction<void> main_func, const usys_t sz_stack = FIBER_DEFAULT_STACK_SIZE_BYTES, void* const p_stack = nullptr, const EStackAllocator allocator = DEFAULT_STACK_ALLOCATOR);
 
 			// stops the selected fiber - it will no longer be picked up by the scheduler
 			// the fiber remains alive and can be the target of SwitchTo(), at which point
@@ -550,6 +646,14 @@ namespace el1::system::task
 
 			static void Sleep(const TTime time, const EClock clock = EClock::MONOTONIC);
 
+			// IO_URING backend only (see TThread::IoBackend())
+			// queues a read(2)/write(2) on the io_uring of the calling thread and blocks the calling fiber until the kernel completed it
+			// offset -1 uses (and advances) the file position of the handle
+			// poll_first arms a readiness poll in front of the transfer - the kernel fails O_NONBLOCK handles with EAGAIN otherwise
+			// returns the number of bytes transferred (0 on EOF) or -1 if the monotonic deadline passed before the transfer completed
+			static ssys_t RingRead(const handle_t handle, void* const buffer, const usys_t sz_buffer, const s64_t offset = -1, const bool poll_first = true, const TTime deadline = -1) EL_WARN_UNUSED_RESULT;
+			static ssys_t RingWrite(const handle_t handle, const void* const buffer, const usys_t sz_buffer, const s64_t offset = -1, const bool poll_first = true, const TTime deadline = -1) EL_WARN_UNUSED_RESULT;
+
 			// merges with a fiber in FINISHED, CRASHED or KILLED state and returns it into CONSTRUCTED state
 			// this will repeatetly call SwitchTo() while target fiber is not joinable
 			std::unique_ptr<const IException> Join() final override EL_WARN_UNUSED_RESULT;
@@ -584,7 +688,16 @@ namespace el1::system::task
 				usys_t sz_signal_stack_mapping = 0;
 				void SetupSignalStack();
 				void FreeSignalStack();
+				TEpollSet* epoll_set = nullptr;
+				void FreeEpollSet();
+				TIoRing* io_ring = nullptr;
+				TIoRing& IoRing();
+				void FreeIoRing();
 			#endif
+			TStackPool* stack_pool = nullptr;
+			void FreeStackPool();
+			ESchedulerBackend scheduler_backend;
+			EIoBackend io_backend;
 			void* thread_handle;
 			const process_id_t constructor_pid;
 			volatile process_id_t thread_pid;
@@ -592,19 +705,24 @@ namespace el1::system::task
 			volatile process_id_t terminator_pid;
 			volatile process_id_t joiner_pid;
 			volatile EChildState state;
-			TList<TFiber*> fibers;	// list of fibers in READY, BLOCKED or SHUTDOWN states
+			TList<TFiber*> fibers;	// list of fibers in READY, BLOCKED or SHUTDOWN states (unordered)
+			TFiberQueue ready;	// READY fibers in the order the scheduler will activate them
+			TFiberQueue polled;	// BLOCKED fibers with at least one waitable which has to be polled (see IWaitable::RequiresPolling())
 			TFiber main_fiber;
 			TFiber* volatile active_fiber;
 			TFiber* volatile previous_fiber;
 
 			TThread();
 
+			void AddFiber(TFiber* const fiber);
+			void RemoveFiber(TFiber* const fiber);
+
 			#ifdef EL_OS_CLASS_POSIX
 				static void* PthreadMain(void*);
 			#endif
 
 		public:
-			TThread(const TString name, TFunction<void> main_func, const bool autostart = true);
+			TThread(const TString name, TUniqueFunction<void> main_func, const bool autostart = true);
 
 			process_id_t ThreadPID() const EL_GETTER { return this->thread_pid; }
 			const TString& Name() const { return name; }
@@ -625,6 +743,29 @@ namespace el1::system::task
 
 			const TList<TFiber*>& Fibers() { return fibers; }
 
+			// selects how the scheduler waits for THandleWaitables when all fibers are blocked
+			// can be changed at any time, but only by the thread itself
+			ESchedulerBackend SchedulerBackend() const EL_GETTER { return scheduler_backend; }
+			void SchedulerBackend(const ESchedulerBackend new_backend) EL_SETTER;
+
+			// selects how blocking stream transfers (BlockingRead(), WriteAll(), ...) of this thread talk to the kernel
+			// the io_uring is created on first use - switching back to READINESS is only possible while no transfer is in flight
+			// can be changed at any time, but only by the thread itself
+			EIoBackend IoBackend() const EL_GETTER { return io_backend; }
+			void IoBackend(const EIoBackend new_backend) EL_SETTER;
+
+			// restricts the thread to run only on the given CPU, only by the thread itself
+			// throws if the CPU is not part of the thread's affinity mask (e.g. excluded by a cpuset)
+			void PinToCpu(const usys_t cpu);
+
+			// the CPUs the calling thread may run on (its affinity mask) in ascending order
+			// new threads inherit the mask of the thread which creates them
+			static TList<usys_t> AllowedCpus();
+
+			// VIRTUAL_ALLOC stacks of finished fibers are parked here instead of being unmapped
+			// stacks are grouped in power-of-two size classes, the pool is created by the first fiber constructed on the thread
+			stack_pool_stats_t StackPoolStats() const EL_GETTER;
+
 			TSimpleMutex& Mutex() const final override { return mutex; }
 			const TSimpleSignal& OnStateChange() const { return on_state_change; }
 
@@ -637,6 +778,60 @@ namespace el1::system::task
 			static TThread& MainThread();
 	};
 
+	// runs fibers on a fixed set of worker threads (one per CPU by default)
+	// every worker has its own queue of fibers which were not started yet, idle workers steal half of the queue of a busy worker
+	// once started a fiber stays on its worker - its waitables are registered with the epoll set and io_uring of that thread
+	// Spawn() can be called from any thread, main_func must not touch fibers or other thread-local state of the spawning thread
+	class TFiberPool
+	{
+		protected:
+			struct worker_t
+			{
+				TFiberPool* const pool;
+				const usys_t index;
+				TSimpleMutex mutex;
+				TList<TUniqueFunction<void>> queue;	// protected by mutex
+				TIpcSignal on_work;
+				std::atomic<bool> idle;	// the worker is waiting for on_work and will steal once woken up
+				std::unique_ptr<TThread> thread;
+
+				void Main();
+
+				worker_t(TFiberPool* const pool, const usys_t index);
+			};
+
+			const usys_t sz_stack;
+			TList<std::unique_ptr<worker_t>> workers;
+			std::atomic<usys_t> next_worker;
+			std::atomic<usys_t> n_pending;	// spawned fibers which did not finish yet
+			std::atomic<u64_t> n_stolen;
+			TIpcSignal on_idle;
+
+			// moves half of the queue of the first worker with queued fibers into stolen
+			void Steal(const worker_t* const thief, TList<TUniqueFunction<void>>& stolen);
+
+		public:
+			// queues main_func to be run as a fiber on one of the workers
+			void Spawn(TUniqueFunction<void> main_func);
+
+			// blocks the calling fiber until all spawned fibers finished
+			// must not be called from a fiber of the pool itself and only by one fiber at a time
+			// returns false if the timeout expired first
+			bool WaitIdle(const TTime timeout = -1) EL_WARN_UNUSED_RESULT;
+
+			usys_t CountWorkers() const EL_GETTER { return workers.Count(); }
+			usys_t CountPending() const EL_GETTER { return n_pending; }
+			u64_t CountStolen() const EL_GETTER { return n_stolen; }
+
+			// n_workers = 0 starts one worker per CPU
+			TFiberPool(const usys_t n_workers = 0, const usys_t sz_stack = TFiber::FIBER_DEFAULT_STACK_SIZE_BYTES);
+			TFiberPool(TFiberPool&&) = delete;
+			TFiberPool(const TFiberPool&) = delete;
+
+			// shuts down all worker threads - running fibers receive a shutdown request, queued fibers are discarded
+			~TFiberPool();
+	};
+
 	io::collection::map::TSortedMap<io::text::string::TString, io::text::string::TString>& EnvironmentVariables();
 
 	io::collection::list::TList<fd_t> EnumOpenFileDescriptors();
@@ -15,7 +15,12 @@
 #include <signal.h>
 #include <sys/signalfd.h>
 #include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
 #include <poll.h>
+#include <sched.h>
 #include <errno.h>
 #include <string.h>
 
@@ -234,13 +239,13 @@ namespace el1::system::task
 	}
 
 	// main thread self-constructor
-	TThread::TThread() : name("main"), mutex(), on_state_change(&this->mutex), thread_handle(new pthread_t(pthread_self())), constructor_pid(gettid()), thread_pid(gettid()), starter_pid(getppid()), terminator_pid(-1), state(EChildState::ALIVE), main_fiber(this)
+	TThread::TThread() : name("main"), mutex(), on_state_change(&this->mutex), scheduler_backend(TFiber::DEFAULT_SCHEDULER_BACKEND), io_backend(TFiber::DEFAULT_IO_BACKEND), thread_handle(new pthread_t(pthread_self())), constructor_pid(gettid()), thread_pid(gettid()), starter_pid(getppid()), terminator_pid(-1), state(EChildState::ALIVE), main_fiber(this)
 	{
 		this->active_fiber = &this->main_fiber;
 		this->previous_fiber = &this->main_fiber;
 		this->main_fiber.exception = nullptr;
 		this->main_fiber.state = EFiberState::ACTIVE;
-		this->fibers.Append(&this->main_fiber);
+		this->AddFiber(&this->main_fiber);
 	}
 
 	ETaskState TThread::TaskState() const
@@ -271,7 +276,10 @@ namespace el1::system::task
 
 		auto finish = [&](void* const result) -> void*
 		{
+			myself->FreeIoRing();
+			myself->FreeEpollSet();
 			myself->FreeSignalStack();
+			myself->FreeStackPool();
 			return result;
 		};
 
@@ -321,8 +329,472 @@ namespace el1::system::task
 
 	/////////////////////////////////////////////////////////////
 
+	// drains the signalfd of the calling thread
+	// returns true if a shutdown was delivered to the main fiber of the calling thread
+	static bool ProcessThreadSignals(TThread* const thread, const fd_t signal_handle)
+	{
+		signalfd_siginfo buffer[4];
+		bool shutdown = false;
+
+		for(;;)
+		{
+			const ssize_t r = read(signal_handle, buffer, sizeof(buffer));
+			if(r < 0)
+			{
+				if(errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
+				else
+					EL_THROW(TSyscallException, errno);
+			}
+			else
+			{
+				// process signals
+				const unsigned n = r / sizeof(buffer[0]);
+				for(unsigned i = 0; i < n; i++)
+				{
+					switch(buffer[i].ssi_signo)
+					{
+						case SIGTERM:
+						case SIGINT:
+						case SIGQUIT:
+						case SIGHUP:
+						{
+							const bool thread_directed = static_cast<s32_t>(buffer[i].ssi_code) == SI_TKILL;
+
+							if(thread_directed || thread == &TThread::MainThread())
+							{
+								thread->MainFiber().Shutdown();
+								shutdown = true;
+							}
+							else
+							{
+								TThread::MainThread().Shutdown();
+							}
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		return shutdown;
+	}
+
+	/////////////////////////////////////////////////////////////
+
+	// IO_URING backend
+	// every thread that uses it owns one io_uring instance
+	// a fiber puts its transfer into the submission queue and blocks, the queue is handed to the kernel with a single
+	// io_uring_enter() once the scheduler runs out of READY fibers (or when the queue is full or aged a few passes)
+	// completions are read from the shared completion queue without a syscall and resume the owning fiber directly
+
+	struct io_ring_op_t
+	{
+		TFiber* fiber;	// nullptr if the fiber was killed while the transfer was in flight
+		s32_t result;
+		bool pending;
+		TFiber::detached_stack_t stack;	// stack of the killed fiber, the buffer may live on it - freed once the kernel let go of the transfer
+	};
+
+	class TIoRing
+	{
+		public:
+			static const u64_t EPOLL_TAG = (u64_t)-2;
+			static const u64_t POLL_FLAG = (u64_t)1 << 63;	// marks the readiness poll linked in front of a transfer
+			static const u32_t N_SQ_ENTRIES = 256;
+			static const u32_t N_CQ_ENTRIES = 4096;	// the kernel buffers completions beyond that (IORING_FEAT_NODROP)
+			static const unsigned MAX_SUBMIT_DELAY_PASSES = 16;
+
+			THandle handle;
+			void* p_sq_mapping = MAP_FAILED;
+			usys_t sz_sq_mapping = 0;
+			void* p_cq_mapping = MAP_FAILED;
+			usys_t sz_cq_mapping = 0;
+			io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+			usys_t sz_sqes = 0;
+
+			u32_t* sq_head;
+			u32_t* sq_tail;
+			u32_t* sq_flags;
+			u32_t sq_mask;
+			u32_t sq_entries;
+			u32_t* cq_head;
+			u32_t* cq_tail;
+			io_uring_cqe* cqes;
+			u32_t cq_mask;
+
+			u32_t n_queued = 0;	// SQEs not handed to the kernel yet
+			unsigned n_passes = 0;	// scheduler passes since the queue was last flushed
+			u32_t n_in_flight = 0;
+			TList<io_ring_op_t> ops;
+			TList<u32_t> free_ops;
+
+			// makes sure the next n SQEs fit into the submission queue, linked SQEs must not be split across submissions
+			void Reserve(const u32_t n);
+			io_uring_sqe& NextSqe();
+			u32_t Enqueue(const u8_t opcode, const fd_t fd, void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, TFiber* const fiber);
+			void Cancel(const u32_t index);
+			void Abort(const u32_t index, const IWaitable& waitable);	// cancels the transfer and waits until the kernel let go of it
+			void Release(const u32_t index);
+
+			// hands all queued SQEs to the kernel
+			void Submit();
+
+			// consumes all posted completions and marks their fibers READY
+			// returns the first fiber that was woken up by this call
+			TFiber* Reap();
+
+			ssys_t Transfer(const u8_t opcode, const fd_t fd, void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, const TTime deadline);
+
+			TIoRing();
+			~TIoRing();
+	};
+
+	class TIoRingWaitable : public IWaitable
+	{
+		protected:
+			const TIoRing* const ring;
+			const u32_t index;
+
+		public:
+			bool IsReady() const final override { return !ring->ops[index].pending; }
+			bool RequiresPolling() const final override { return false; }	// Reap() wakes the fiber
+
+			TIoRingWaitable(const TIoRing* const ring, const u32_t index) : ring(ring), index(index) {}
+	};
+
+	static int IoUringEnter(const fd_t fd, const u32_t to_submit, const u32_t min_complete, const u32_t flags)
+	{
+		return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+	}
+
+	TIoRing::TIoRing()
+	{
+		struct io_uring_params params = {};
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = N_CQ_ENTRIES;
+		handle = THandle(EL_SYSERR((fd_t)syscall(__NR_io_uring_setup, N_SQ_ENTRIES, &params)), true);
+
+		// offset -1 (current file position) and lossless completion queues are required
+		EL_ERROR((params.features & (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS)) != (IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS), TException, U"the io_uring of the running kernel is too old (IORING_FEAT_NODROP and IORING_FEAT_RW_CUR_POS are required)");
+
+		sz_sq_mapping = params.sq_off.array + params.sq_entries * sizeof(u32_t);
+		sz_cq_mapping = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if(params.features & IORING_FEAT_SINGLE_MMAP)
+			sz_sq_mapping = sz_cq_mapping = util::Max(sz_sq_mapping, sz_cq_mapping);
+
+		p_sq_mapping = mmap(nullptr, sz_sq_mapping, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, handle, IORING_OFF_SQ_RING);
+		EL_ERROR(p_sq_mapping == MAP_FAILED, TSyscallException, errno);
+
+		if(params.features & IORING_FEAT_SINGLE_MMAP)
+		{
+			p_cq_mapping = p_sq_mapping;
+		}
+		else
+		{
+			p_cq_mapping = mmap(nullptr, sz_cq_mapping, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, handle, IORING_OFF_CQ_RING);
+			EL_ERROR(p_cq_mapping == MAP_FAILED, TSyscallException, errno);
+		}
+
+		sz_sqes = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = (io_uring_sqe*)mmap(nullptr, sz_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, handle, IORING_OFF_SQES);
+		EL_ERROR(sqes == MAP_FAILED, TSyscallException, errno);
+
+		byte_t* const sq = (byte_t*)p_sq_mapping;
+		sq_head = (u32_t*)(sq + params.sq_off.head);
+		sq_tail = (u32_t*)(sq + params.sq_off.tail);
+		sq_flags = (u32_t*)(sq + params.sq_off.flags);
+		sq_mask = *(u32_t*)(sq + params.sq_off.ring_mask);
+		sq_entries = *(u32_t*)(sq + params.sq_off.ring_entries);
+
+		// SQE slots are used in ring order, so the indirection array is an identity mapping
+		u32_t* const sq_array = (u32_t*)(sq + params.sq_off.array);
+		for(u32_t i = 0; i < sq_entries; i++)
+			sq_array[i] = i;
+
+		byte_t* const cq = (byte_t*)p_cq_mapping;
+		cq_head = (u32_t*)(cq + params.cq_off.head);
+		cq_tail = (u32_t*)(cq + params.cq_off.tail);
+		cq_mask = *(u32_t*)(cq + params.cq_off.ring_mask);
+		cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+	}
+
+	TIoRing::~TIoRing()
+	{
+		// abandoned transfers still own the stacks of their killed fibers, wait until the kernel completed the cancellations
+		// if that fails the stacks are leaked rather than handed back while the kernel might still write into them
+		try
+		{
+			for(;;)
+			{
+				bool abandoned = false;
+				for(const io_ring_op_t& op : ops)
+					if(op.pending && op.fiber == nullptr)
+						abandoned = true;
+
+				if(!abandoned)
+					break;
+
+				Submit();
+				if(IoUringEnter(handle, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+					break;
+				Reap();
+			}
+		}
+		catch(...) {}
+
+		if(sqes != MAP_FAILED)
+			munmap(sqes, sz_sqes);
+		if(p_cq_mapping != MAP_FAILED && p_cq_mapping != p_sq_mapping)
+			munmap(p_cq_mapping, sz_cq_mapping);
+		if(p_sq_mapping != MAP_FAILED)
+			munmap(p_sq_mapping, sz_sq_mapping);
+	}
+
+	void TIoRing::Reserve(const u32_t n)
+	{
+		if(sq_entries - n_queued < n)
+			Submit();
+	}
+
+	io_uring_sqe& TIoRing::NextSqe()
+	{
+		const u32_t tail = *sq_tail;
+		io_uring_sqe& sqe = sqes[tail & sq_mask];
+		memset(&sqe, 0, sizeof(sqe));
+		n_queued++;
+		return sqe;
+	}
+
+	u32_t TIoRing::Enqueue(const u8_t opcode, const fd_t fd, void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, TFiber* const fiber)
+	{
+		Reserve(poll_first ? 2 : 1);
+
+		u32_t index;
+		if(free_ops.Count() > 0)
+		{
+			index = free_ops[-1];
+			free_ops.Remove(-1);
+		}
+		else
+		{
+			index = ops.Count();
+			ops.SetCount(index + 1);
+		}
+
+		ops[index] = { fiber, 0, true, {} };
+		n_in_flight++;
+
+		if(poll_first)
+		{
+			io_uring_sqe& sqe = NextSqe();
+			sqe.opcode = IORING_OP_POLL_ADD;
+			sqe.fd = fd;
+			sqe.poll32_events = opcode == IORING_OP_READ ? (POLLIN | POLLRDHUP) : POLLOUT;
+			sqe.flags = IOSQE_IO_LINK;	// no IOSQE_CQE_SKIP_SUCCESS - it would also suppress the completion of the transfer if the poll fails
+			sqe.user_data = POLL_FLAG | (index + 1);
+			__atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+		}
+
+		io_uring_sqe& sqe = NextSqe();
+		sqe.opcode = opcode;
+		sqe.fd = fd;
+		sqe.addr = (u64_t)buffer;
+		sqe.len = (u32_t)util::Min<usys_t>(sz_buffer, 0x7ffff000U);	// the most read(2)/write(2) transfer at once
+		sqe.off = (u64_t)offset;
+		sqe.user_data = index + 1;
+		__atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+
+		return index;
+	}
+
+	void TIoRing::Cancel(const u32_t index)
+	{
+		Reserve(2);
+
+		// cancelling the poll also cancels the transfer linked to it
+		const u64_t targets[2] = { POLL_FLAG | (index + 1), (u64_t)index + 1 };
+		for(const u64_t target : targets)
+		{
+			io_uring_sqe& sqe = NextSqe();
+			sqe.opcode = IORING_OP_ASYNC_CANCEL;
+			sqe.fd = -1;
+			sqe.addr = target;
+			sqe.user_data = 0;
+			__atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+		}
+
+		Submit();
+	}
+
+	void TIoRing::Abort(const u32_t index, const IWaitable& waitable)
+	{
+		if(!ops[index].pending)
+			return;
+
+		// the buffer belongs to the caller - the kernel has to be done with it before the transfer is given up
+		Cancel(index);
+
+		TFiber* const self = TFiber::Self();
+		self->block_shutdown++;
+		while(ops[index].pending)
+			waitable.WaitFor();
+		self->block_shutdown--;
+	}
+
+	void TIoRing::Release(const u32_t index)
+	{
+		free_ops.Append(index);
+	}
+
+	void TIoRing::Submit()
+	{
+		while(n_queued > 0)
+		{
+			const int r = IoUringEnter(handle, n_queued, 0, 0);
+			if(r < 0)
+			{
+				if(errno == EINTR)
+					continue;
+
+				// the completion queue overflowed, make room before the kernel accepts more work
+				EL_ERROR(errno != EBUSY && errno != EAGAIN, TSyscallException, errno);
+				Reap();
+				continue;
+			}
+
+			n_queued -= (u32_t)r;
+		}
+
+		n_passes = 0;
+	}
+
+	TFiber* TIoRing::Reap()
+	{
+		TFiber* next_fiber = nullptr;
+
+		for(;;)
+		{
+			u32_t head = *cq_head;
+			const u32_t tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+			for(; head != tail; head++)
+			{
+				const io_uring_cqe& cqe = cqes[head & cq_mask];
+
+				// cancellation requests and polls in front of transfers - the transfer reports the outcome
+				if(cqe.user_data == 0 || (cqe.user_data & POLL_FLAG) != 0)
+					continue;
+
+				const u32_t index = (u32_t)cqe.user_data - 1;
+				io_ring_op_t& op = ops[index];
+				op.result = cqe.res;
+				op.pending = false;
+				n_in_flight--;
+
+				if(op.fiber == nullptr)
+				{
+					TFiber::FreeStack(op.stack);
+					op.stack = {};
+					Release(index);
+				}
+				else if(op.fiber->state == EFiberState::BLOCKED)
+				{
+					op.fiber->MarkReady();
+					if(next_fiber == nullptr)
+						next_fiber = op.fiber;
+				}
+			}
+
+			__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+			if((__atomic_load_n(sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) == 0)
+				break;
+
+			// let the kernel move its overflow backlog into the now empty completion queue
+			if(IoUringEnter(handle, 0, 0, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+				EL_THROW(TSyscallException, errno);
+		}
+
+		return next_fiber;
+	}
+
+	ssys_t TIoRing::Transfer(const u8_t opcode, const fd_t fd, void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, const TTime deadline)
+	{
+		TFiber* const self = TFiber::Self();
+		EL_ERROR(self->ring_op != 0, TLogicException);
+
+		for(;;)
+		{
+			const u32_t index = Enqueue(opcode, fd, buffer, sz_buffer, offset, poll_first, self);
+			const TIoRingWaitable waitable(this, index);
+			self->ring_op = index + 1;
+			bool timed_out = false;
+
+			try
+			{
+				// a shutdown request can resume the fiber before the transfer completed
+				while(ops[index].pending && !timed_out)
+				{
+					if(deadline < 0)
+						waitable.WaitFor();
+					else
+						timed_out = !waitable.WaitFor(deadline, true) && TTime::Now(EClock::MONOTONIC) >= deadline;
+				}
+			}
+			catch(...)
+			{
+				Abort(index, waitable);
+				Release(index);
+				self->ring_op = 0;
+				throw;
+			}
+
+			if(timed_out)
+				Abort(index, waitable);
+
+			const s32_t result = ops[index].result;
+			Release(index);
+			self->ring_op = 0;
+
+			if(result >= 0)
+				return result;
+
+			if(result == -ECANCELED || result == -EINTR)
+			{
+				if(timed_out)
+					return -1;
+
+				// the linked poll failed - repeat the transfer as plain syscall to learn why
+				const ssize_t r = opcode == IORING_OP_READ ? (offset < 0 ? read(fd, buffer, sz_buffer) : pread(fd, buffer, sz_buffer, offset)) : (offset < 0 ? write(fd, buffer, sz_buffer) : pwrite(fd, buffer, sz_buffer, offset));
+				if(r >= 0)
+					return r;
+				EL_ERROR(errno != EAGAIN && errno != EWOULDBLOCK, TSyscallException, errno);
+				continue;
+			}
+
+			// readiness can be spurious, just wait once more
+			if(result == -EAGAIN && poll_first)
+				continue;
+
+			EL_THROW(TSyscallException, -result);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+
 	void TFiber::KernelWaitForMany(const TList<TFiber*>& fibers)
 	{
+		TThread* const thread = TThread::Self();
+		TIoRing* const ring = thread->io_ring;
+		if(ring != nullptr)
+		{
+			// transfers which complete right away during submission do not need a poll() at all
+			ring->Submit();
+			if(ring->n_in_flight > 0 && ring->Reap() != nullptr)
+				return;
+		}
+
 		TList<struct ::pollfd> pfds;
 		TList<const THandleWaitable*> handle_waitables;
 
@@ -350,7 +822,13 @@ namespace el1::system::task
 			}
 		}
 
-		TThread* const thread = TThread::Self();
+		if(ring != nullptr)
+			pfds.Append({
+				.fd = ring->handle,
+				.events = POLLIN,
+				.revents = 0
+			});
+
 		pfds.Append({
 			.fd = thread->signal_handle,
 			.events = POLLIN,
@@ -375,52 +853,441 @@ namespace el1::system::task
 					loop = false;
 				}
 
-			if(pfds[-1].revents)
+			if(ring != nullptr && pfds[handle_waitables.Count()].revents && ring->Reap() != nullptr)
+				loop = false;
+
+			if(pfds[-1].revents && ProcessThreadSignals(thread, thread->signal_handle))
+				loop = false;
+		}
+	}
+
+	/////////////////////////////////////////////////////////////
+
+	// EPOLL scheduler backend
+	// every fd a fiber of this thread ever waited on stays registered with the thread's epoll instance
+	// registrations use EPOLLONESHOT, so after an event fired (or after all waiters left) the interest
+	// mask is only re-armed with a single EPOLL_CTL_MOD once a fiber blocks on the fd again
+	// re-arming is deferred until the scheduler actually has to wait in the kernel, so fibers that get
+	// unblocked by other means before that cost no syscalls at all
+
+	struct epoll_waiter_t
+	{
+		TFiber* fiber;
+		const THandleWaitable* waitable;
+	};
+
+	struct epoll_entry_t
+	{
+		TList<epoll_waiter_t> waiters;
+		u32_t generation = 0;	// changes on every EPOLL_CTL_ADD - events of stale registrations (closed and reused fds) are ignored
+		u32_t events_armed = 0;	// interest mask the kernel is known to have armed, 0 if disarmed or unknown
+		bool registered = false;
+		bool dirty = false;	// queued for (re-)arming before the next epoll_wait()
+	};
+
+	class TEpollSet
+	{
+		public:
+			static const u64_t SIGNAL_TAG = (u64_t)-1;
+
+			THandle handle;
+			TList<epoll_entry_t> entries;	// indexed by fd
+			TList<fd_t> dirty;
+			u32_t generation = 0;
+			bool ring_registered = false;	// the io_uring of the thread is part of the set (see TIoRing::EPOLL_TAG)
+
+			epoll_entry_t& Entry(const fd_t fd)
+			{
+				if((usys_t)fd >= entries.Count())
+					entries.SetCount(fd + 1);
+				return entries[fd];
+			}
+
+			void MarkDirty(const fd_t fd, epoll_entry_t& entry)
+			{
+				if(!entry.dirty)
+				{
+					entry.dirty = true;
+					dirty.Append(fd);
+				}
+			}
+
+			// marks the waitable as ready and the waiting fiber as READY (unless it was stopped or already woken up)
+			// returns the fiber if it was woken up by this call
+			static TFiber* Wake(const epoll_waiter_t& waiter);
+
+			// (re-)arms the interest mask of fd for all its current waiters
+			// fds which epoll cannot monitor (regular files) or which are no longer open are reported as ready
+			// immediately, the same way poll() would report them
+			void Arm(const fd_t fd, TFiber*& next_fiber);
+
+			TEpollSet(const fd_t signal_handle) : handle(EL_SYSERR(epoll_create1(EPOLL_CLOEXEC)), true)
 			{
-				signalfd_siginfo buffer[4];
+				struct epoll_event ev = {};
+				ev.events = EPOLLIN;
+				ev.data.u64 = SIGNAL_TAG;
+				EL_SYSERR(epoll_ctl(handle, EPOLL_CTL_ADD, signal_handle, &ev));
+			}
+	};
+
+	static u32_t EpollEvents(const THandleWaitable::wait_t wait)
+	{
+		return (wait.read ? (u32_t)(EPOLLIN | EPOLLRDHUP) : 0U) | (wait.write ? (u32_t)EPOLLOUT : 0U) | (wait.other ? (u32_t)EPOLLPRI : 0U);
+	}
+
+	TFiber* TEpollSet::Wake(const epoll_waiter_t& waiter)
+	{
+		waiter.waitable->is_ready = true;
+		if(waiter.fiber->state != EFiberState::BLOCKED)
+			return nullptr;
+		waiter.fiber->MarkReady();
+		return waiter.fiber;
+	}
 
-				for(;;)
+	void TEpollSet::Arm(const fd_t fd, TFiber*& next_fiber)
+	{
+		epoll_entry_t& entry = entries[fd];
+		entry.dirty = false;
+
+		u32_t events = 0;
+		for(const epoll_waiter_t& waiter : entry.waiters)
+			events |= EpollEvents(waiter.waitable->Wait());
+
+		if(entry.waiters.Count() == 0 || (entry.events_armed != 0 && (entry.events_armed & events) == events))
+			return;
+
+		struct epoll_event ev = {};
+		ev.events = events | EPOLLONESHOT;
+		ev.data.u64 = ((u64_t)entry.generation << 32) | (u32_t)fd;
+
+		int r = -1;
+		if(entry.registered)
+			r = epoll_ctl(handle, EPOLL_CTL_MOD, fd, &ev);
+
+		if(!entry.registered || (r < 0 && errno == ENOENT))
+		{
+			// the fd was closed (and possibly reused) since it was last armed, the kernel dropped the old registration
+			entry.generation = ++generation;
+			ev.data.u64 = ((u64_t)entry.generation << 32) | (u32_t)fd;
+			r = epoll_ctl(handle, EPOLL_CTL_ADD, fd, &ev);
+			if(r < 0 && errno == EEXIST)
+				r = epoll_ctl(handle, EPOLL_CTL_MOD, fd, &ev);
+		}
+
+		if(r < 0)
+		{
+			if(errno != EPERM && errno != EBADF)
+				EL_THROW(TSyscallException, errno);
+
+			entry.registered = false;
+			entry.events_armed = 0;
+			for(const epoll_waiter_t& waiter : entry.waiters)
+			{
+				TFiber* const fiber = Wake(waiter);
+				if(next_fiber == nullptr)
+					next_fiber = fiber;
+			}
+			return;
+		}
+
+		entry.registered = true;
+		entry.events_armed = events;
+	}
+
+	void TThread::FreeEpollSet()
+	{
+		delete this->epoll_set;
+		this->epoll_set = nullptr;
+	}
+
+	void TThread::SchedulerBackend(const ESchedulerBackend new_backend)
+	{
+		EL_ERROR(TThread::Self() != this, TLogicException);
+
+		if(new_backend == this->scheduler_backend)
+			return;
+
+		this->scheduler_backend = new_backend;
+		this->FreeEpollSet();
+
+		// fibers that are blocked right now have to be known to the new epoll set
+		if(new_backend == ESchedulerBackend::EPOLL)
+			for(TFiber* fiber : this->fibers)
+				if(fiber->state == EFiberState::BLOCKED)
+					fiber->KernelRegisterWaitables();
+	}
+
+	void TFiber::KernelRegisterWaitables()
+	{
+		TThread* const thread = this->thread;
+		if(thread->epoll_set == nullptr)
+			thread->epoll_set = new TEpollSet(thread->signal_handle);
+
+		TEpollSet& set = *thread->epoll_set;
+		this->kernel_wait_handles.Truncate();
+
+		for(const IWaitable* waitable : this->blocked_by)
+		{
+			if(waitable == nullptr)
+				continue;
+
+			for(const THandleWaitable* const handle_waitable : waitable->HandleWaitables())
+			{
+				const fd_t fd = handle_waitable->Handle();
+				if(fd < 0)
+					continue;	// poll() ignores negative fds as well
+
+				epoll_entry_t& entry = set.Entry(fd);
+				entry.waiters.Append({ this, handle_waitable });
+				this->kernel_wait_handles.Append(fd);
+
+				const u32_t events = EpollEvents(handle_waitable->Wait());
+				if(entry.events_armed == 0 || (entry.events_armed & events) != events)
+					set.MarkDirty(fd, entry);
+			}
+		}
+	}
+
+	void TFiber::KernelUnregisterWaitables()
+	{
+		if(this->kernel_wait_handles.Count() == 0)
+			return;
+
+		TEpollSet* const set = this->thread->epoll_set;
+		if(set != nullptr)
+		{
+			for(const fd_t fd : this->kernel_wait_handles)
+			{
+				if((usys_t)fd >= set->entries.Count())
+					continue;
+
+				epoll_entry_t& entry = set->entries[fd];
+				for(usys_t i = entry.waiters.Count(); i > 0; i--)
+					if(entry.waiters[i - 1].fiber == this)
+						entry.waiters.Remove(i - 1);
+
+				// the fd might get closed and its number reused before the next fiber blocks on it,
+				// so the kernel state is unknown from now on and has to be re-armed on the next block
+				if(entry.waiters.Count() == 0)
+					entry.events_armed = 0;
+			}
+		}
+
+		this->kernel_wait_handles.Truncate();
+	}
+
+	TFiber* TFiber::KernelWaitForEvents()
+	{
+		TThread* const thread = TThread::Self();
+		if(thread->epoll_set == nullptr)
+			thread->epoll_set = new TEpollSet(thread->signal_handle);
+
+		TEpollSet& set = *thread->epoll_set;
+		TFiber* next_fiber = nullptr;
+		bool shutdown = false;
+		struct epoll_event events[64];
+
+		TIoRing* const ring = thread->io_ring;
+		if(ring != nullptr)
+		{
+			if(!set.ring_registered)
+			{
+				struct epoll_event ev = {};
+				ev.events = EPOLLIN;
+				ev.data.u64 = TIoRing::EPOLL_TAG;
+				EL_SYSERR(epoll_ctl(set.handle, EPOLL_CTL_ADD, ring->handle, &ev));
+				set.ring_registered = true;
+			}
+
+			// transfers which complete right away during submission do not need an epoll_wait() at all
+			ring->Submit();
+			if(ring->n_in_flight > 0)
+				next_fiber = ring->Reap();
+		}
+
+		while(next_fiber == nullptr && !shutdown)
+		{
+			// (re-)arm all fds which got new waiters since the last kernel wait
+			for(const fd_t fd : set.dirty)
+				set.Arm(fd, next_fiber);
+			set.dirty.Truncate();
+
+			// Arm() might have found fds which are always ready - do not block in this case
+			const int n = epoll_wait(set.handle, events, sizeof(events) / sizeof(events[0]), next_fiber == nullptr ? -1 : 0);
+			if(n < 0)
+			{
+				if(errno == EINTR)
+					continue;
+				EL_THROW(TSyscallException, errno);
+			}
+
+			for(int i = 0; i < n; i++)
+			{
+				if(events[i].data.u64 == TEpollSet::SIGNAL_TAG)
 				{
-					const ssize_t r = read(thread->signal_handle, buffer, sizeof(buffer));
-					if(r < 0)
-					{
-						if(errno == EAGAIN || errno == EWOULDBLOCK)
-							break;
-						else
-							EL_THROW(TSyscallException, errno);
-					}
-					else
+					if(ProcessThreadSignals(thread, thread->signal_handle))
+						shutdown = true;
+					continue;
+				}
+
+				if(events[i].data.u64 == TIoRing::EPOLL_TAG)
+				{
+					TFiber* const fiber = ring->Reap();
+					if(next_fiber == nullptr)
+						next_fiber = fiber;
+					continue;
+				}
+
+				const fd_t fd = (fd_t)(u32_t)events[i].data.u64;
+				const u32_t generation = (u32_t)(events[i].data.u64 >> 32);
+				if((usys_t)fd >= set.entries.Count())
+					continue;
+
+				epoll_entry_t& entry = set.entries[fd];
+				if(entry.generation != generation)
+					continue;
+
+				// EPOLLONESHOT disarmed the fd
+				entry.events_armed = 0;
+
+				const u32_t revents = events[i].events;
+				bool rearm = false;
+				for(const epoll_waiter_t& waiter : entry.waiters)
+				{
+					if((revents & (EpollEvents(waiter.waitable->Wait()) | EPOLLERR | EPOLLHUP)) != 0)
 					{
-						// process signals
-						const unsigned n = r / sizeof(buffer[0]);
-						for(unsigned i = 0; i < n; i++)
-						{
-							switch(buffer[i].ssi_signo)
-							{
-								case SIGTERM:
-								case SIGINT:
-								case SIGQUIT:
-								case SIGHUP:
-								{
-									const bool thread_directed = static_cast<s32_t>(buffer[i].ssi_code) == SI_TKILL;
-
-									if(thread_directed || thread == &TThread::MainThread())
-									{
-										thread->MainFiber().Shutdown();
-										loop = false;
-									}
-									else
-									{
-										TThread::MainThread().Shutdown();
-									}
-									break;
-								}
-							}
-						}
+						TFiber* const fiber = TEpollSet::Wake(waiter);
+						if(next_fiber == nullptr)
+							next_fiber = fiber;
 					}
+					else if(waiter.fiber->state == EFiberState::BLOCKED)
+						rearm = true;
 				}
+
+				if(rearm)
+					set.MarkDirty(fd, entry);
 			}
 		}
+
+		if(next_fiber == nullptr)
+		{
+			// a shutdown request was delivered to the main fiber (see ProcessThreadSignals())
+			TFiber* const self = thread->active_fiber;
+			if(thread->main_fiber.state == EFiberState::READY || thread->main_fiber.state == EFiberState::ACTIVE)
+				next_fiber = &thread->main_fiber;
+			else if(self->state == EFiberState::ACTIVE)
+				next_fiber = self;
+		}
+
+		return next_fiber;
+	}
+
+	// IO_URING backend (thread and fiber side)
+
+	TIoRing& TThread::IoRing()
+	{
+		if(this->io_ring == nullptr)
+			this->io_ring = new TIoRing();
+		return *this->io_ring;
+	}
+
+	void TThread::FreeIoRing()
+	{
+		if(this->io_ring == nullptr)
+			return;
+
+		if(this->epoll_set != nullptr && this->epoll_set->ring_registered)
+		{
+			epoll_ctl(this->epoll_set->handle, EPOLL_CTL_DEL, this->io_ring->handle, nullptr);
+			this->epoll_set->ring_registered = false;
+		}
+
+		delete this->io_ring;
+		this->io_ring = nullptr;
+	}
+
+	void TThread::PinToCpu(const usys_t cpu)
+	{
+		EL_ERROR(TThread::Self() != this, TLogicException);
+		EL_ERROR(cpu >= CPU_SETSIZE, TInvalidArgumentException, "cpu", "cpu exceeds CPU_SETSIZE");
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		EL_SYSERR(sched_setaffinity(0, sizeof(set), &set));
+	}
+
+	TList<usys_t> TThread::AllowedCpus()
+	{
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		EL_SYSERR(sched_getaffinity(0, sizeof(set), &set));
+
+		TList<usys_t> cpus;
+		for(usys_t cpu = 0; cpu < CPU_SETSIZE; cpu++)
+			if(CPU_ISSET(cpu, &set))
+				cpus.Append(cpu);
+		return cpus;
+	}
+
+	void TThread::IoBackend(const EIoBackend new_backend)
+	{
+		EL_ERROR(TThread::Self() != this, TLogicException);
+
+		if(new_backend == EIoBackend::IO_URING)
+		{
+			// fail here rather than in the middle of the first transfer if the kernel refuses io_uring
+			this->IoRing();
+		}
+		else if(this->io_ring != nullptr)
+		{
+			EL_ERROR(this->io_ring->n_in_flight > 0, TLogicException);
+			this->FreeIoRing();
+		}
+
+		this->io_backend = new_backend;
+	}
+
+	void TFiber::KernelReapCompletions()
+	{
+		TIoRing* const ring = TThread::Self()->io_ring;
+		if(ring == nullptr)
+			return;
+
+		if(ring->n_queued > 0 && ++ring->n_passes >= TIoRing::MAX_SUBMIT_DELAY_PASSES)
+			ring->Submit();
+
+		if(ring->n_in_flight > 0)
+			ring->Reap();
+	}
+
+	void TFiber::KernelAbandonTransfer()
+	{
+		TIoRing* const ring = this->thread->io_ring;
+		io_ring_op_t& op = ring->ops[this->ring_op - 1];
+
+		op.fiber = nullptr;
+		if(op.pending)
+		{
+			// the kernel might still write into the buffer, which can be on the stack of the killed fiber
+			// the stack is kept until the cancelled transfer completed, Reap() frees it together with the slot
+			op.stack = this->DetachStack();
+			ring->Cancel(this->ring_op - 1);
+		}
+		else
+			ring->Release(this->ring_op - 1);
+
+		this->ring_op = 0;
+	}
+
+	ssys_t TFiber::RingRead(const handle_t handle, void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, const TTime deadline)
+	{
+		return TThread::Self()->IoRing().Transfer(IORING_OP_READ, handle, buffer, sz_buffer, offset, poll_first, deadline);
+	}
+
+	ssys_t TFiber::RingWrite(const handle_t handle, const void* const buffer, const usys_t sz_buffer, const s64_t offset, const bool poll_first, const TTime deadline)
+	{
+		return TThread::Self()->IoRing().Transfer(IORING_OP_WRITE, handle, const_cast<void*>(buffer), sz_buffer, offset, poll_first, deadline);
 	}
 
 	/////////////////////////////////////////////////////////////
@@ -40,6 +40,7 @@ namespace el1::system::time::timer
 		mutable std::unique_ptr<TTimer> timer;
 
 		bool IsReady() const final override;
+		bool RequiresPolling() const final override { return false; }
 		io::collection::array::array_t<const system::waitable::THandleWaitable*> HandleWaitables() const final override EL_GETTER;
 
 		TTimeWaitable(const EClock clock, const TTime ts_wait_until) : clock(clock), ts_wait_until(ts_wait_until) {}
@@ -8,6 +8,7 @@
 namespace el1::system::task
 {
 	class TFiber;
+	class TEpollSet;
 }
 
 namespace el1::io::collection::array
@@ -35,12 +36,18 @@ namespace el1::system::waitable
 		bool WaitFor(const time::TTime timeout, const bool absolute_time = false) const EL_WARN_UNUSED_RESULT;
 		virtual bool IsReady() const = 0;
 		virtual void Reset() const {}
+
+		// false if the waitable only becomes ready when one of its HandleWaitables() fires (or the scheduler wakes the fiber by other means)
+		// the scheduler then does not check it on every pass - fibers blocked on such waitables cost nothing until they are woken up
+		virtual bool RequiresPolling() const { return true; }
+
 		virtual io::collection::array::array_t<const THandleWaitable*> HandleWaitables() const EL_GETTER;
 	};
 
 	class THandleWaitable : public IWaitable
 	{
 		friend class task::TFiber;
+		friend class task::TEpollSet;
 
 		public:
 			struct wait_t
@@ -70,6 +77,7 @@ namespace el1::system::waitable
 
 			bool IsReady() const final override { return is_ready; }
 			void Reset() const final override { is_ready = false; }
+			bool RequiresPolling() const final override { return false; }
 
 			io::collection::array::array_t<const THandleWaitable*> HandleWaitables() const final override EL_GETTER;
 	};
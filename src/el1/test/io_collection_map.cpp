@@ -202,4 +202,256 @@ namespace
 			EXPECT_FALSE(map.Remove(3));
 		}
 	}
+
+	TEST(io_collection_map, TSortedMap_Chunks)
+	{
+		// enough items for many chunks, inserted and removed in a scrambled order
+		const unsigned n_keys = 20000;
+		TList<bool> present;
+		present.SetCount(n_keys);
+		for(auto& p : present)
+			p = false;
+
+		TSortedMap<unsigned, unsigned> map;
+		unsigned n_present = 0;
+		for(unsigned i = 0; i < 3 * n_keys; i++)
+		{
+			const unsigned key = (i * 7919U) % n_keys;
+			if(i % 3 == 2)
+			{
+				EXPECT_EQ(map.Remove(key), present[key]);
+				n_present -= present[key] ? 1 : 0;
+				present[key] = false;
+			}
+			else
+			{
+				map.Set(key, key * 2);
+				n_present += present[key] ? 0 : 1;
+				present[key] = true;
+			}
+		}
+		ASSERT_EQ(map.Items().Count(), n_present);
+
+		unsigned n_iterated = 0;
+		unsigned key_prev = 0;
+		for(const auto& kv : map.Items())
+		{
+			EXPECT_TRUE(n_iterated == 0 || kv.key > key_prev);
+			EXPECT_TRUE(present[kv.key]);
+			EXPECT_EQ(kv.value, kv.key * 2);
+			key_prev = kv.key;
+			n_iterated++;
+		}
+		EXPECT_EQ(n_iterated, n_present);
+
+		for(unsigned key = 0; key < n_keys; key++)
+			EXPECT_EQ(map.Contains(key), present[key]);
+
+		EXPECT_EQ(map.Items()[n_present - 1].key, key_prev);
+		EXPECT_THROW(map.Items()[n_present], TIndexOutOfBoundsException);
+
+		// drain it again
+		for(unsigned key = 0; key < n_keys; key++)
+			map.Remove(key);
+		EXPECT_EQ(map.Items().Count(), 0U);
+		EXPECT_TRUE(map.Items().begin() == map.Items().end());
+	}
+
+	TEST(io_collection_map, TSortedMap_BulkLoad)
+	{
+		using map_t = TSortedMap<unsigned, unsigned>;
+		const unsigned n_items = 10000;
+
+		TList<map_t::kv_pair_t> items;
+		for(unsigned i = 0; i < n_items; i++)
+			items.Append({ i * 2, i });
+		const map_t::kv_pair_t* const storage = items.ItemPtr(0);
+
+		// sorted input is adopted as it is
+		map_t map(std::move(items), EInputOrder::ASSUME_SORTED);
+		EXPECT_EQ(map.Items().ItemPtr(0), storage);
+		EXPECT_EQ(map.Items().Count(), n_items);
+		EXPECT_EQ(map[2 * 1234], 1234U);
+		EXPECT_EQ(map.Get(2 * 1234 + 1), nullptr);
+
+		// the first modification cuts it into regular chunks
+		map.Add(2 * 5000 + 1, 1);
+		EXPECT_TRUE(map.Remove(0));
+		EXPECT_EQ(map.Items().Count(), n_items);
+		EXPECT_EQ(map.Items()[0].key, 2U);
+		for(unsigned i = 1; i < n_items; i++)
+			EXPECT_EQ(map[i * 2], i);
+		EXPECT_EQ(map[2 * 5000 + 1], 1U);
+
+		// copies keep the order
+		const map_t& original = map;
+		const map_t copy = map;
+		unsigned n_equal = 0;
+		for(auto it1 = original.Items().begin(), it2 = copy.Items().begin(); it1 != original.Items().end(); ++it1, ++it2)
+			n_equal += it1->key == it2->key ? 1 : 0;
+		EXPECT_EQ(n_equal, n_items);
+
+		TList<map_t::kv_pair_t> duplicates;
+		for(unsigned i = 0; i < n_items; i++)
+			duplicates.Append({ i / 2, i });
+		EXPECT_THROW((map_t(std::move(duplicates), EInputOrder::ASSUME_SORTED)), TKeyAlreadyExistsException<unsigned>);
+	}
+
+	TEST(io_collection_map, THashMap_Add)
+	{
+		{
+			THashMap<int, TString> map;
+			map.Add(100, U"100");
+			map.Add(101, U"101");
+			EXPECT_THROW(map.Add(100, U"100"), TKeyAlreadyExistsException<int>);
+			EXPECT_EQ(map.Count(), 2U);
+			EXPECT_THROW(map[102], TKeyNotFoundException<int>);
+		}
+
+		{
+			THashMap<int, int> map;
+
+			for(unsigned i = 0; i < n_insert; i++)
+			{
+				EXPECT_EQ(map.Count(), i);
+				map.Add(arr_insert[i], arr_insert[i]);
+
+				for(unsigned j = 0; j <= i; j++)
+				{
+					EXPECT_EQ(map[arr_insert[j]], arr_insert[j]);
+				}
+			}
+
+			EXPECT_EQ(map.Count(), n_insert);
+			EXPECT_FALSE(map.Contains(-1));
+		}
+	}
+
+	TEST(io_collection_map, THashMap_Set)
+	{
+		THashMap<int, TString> map;
+
+		map.Set(100, U"100");
+		EXPECT_EQ(map.Count(), 1U);
+		EXPECT_EQ(map[100], U"100");
+
+		map.Set(101, U"101");
+		map.Set(100, U"200");
+		EXPECT_EQ(map[100], U"200");
+		EXPECT_EQ(map[101], U"101");
+		EXPECT_EQ(map.Count(), 2U);
+
+		EXPECT_EQ(map.GetOrInsertDefault(102, U"default"), U"default");
+		EXPECT_EQ(map.GetOrInsertDefault(102, U"other"), U"default");
+		EXPECT_EQ(map.GetWithDefault(103, U"missing"), U"missing");
+		EXPECT_EQ(map.Count(), 3U);
+	}
+
+	TEST(io_collection_map, THashMap_Remove)
+	{
+		THashMap<int, TString> map;
+		map.Add(1, U"hello world");
+		map.Add(2, U"What's your name?");
+		map.Add(3, U"Nice to meet you");
+		EXPECT_EQ(map[3], U"Nice to meet you");
+		EXPECT_TRUE(map.Remove(3));
+		EXPECT_EQ(map.Get(3), nullptr);
+		EXPECT_FALSE(map.Remove(3));
+		EXPECT_EQ(map.Count(), 2U);
+	}
+
+	TEST(io_collection_map, THashMap_Churn)
+	{
+		// lots of removals leave tombstones behind, the map must stay consistent with a reference map while it grows and cleans up
+		THashMap<u32_t, u32_t> map;
+		TSortedMap<u32_t, u32_t> reference;
+		u32_t state = 12345;
+
+		for(unsigned i = 0; i < 20000; i++)
+		{
+			state = state * 1103515245U + 12345U;
+			const u32_t key = (state >> 8) % 3000;
+
+			if((state & 3) == 0)
+			{
+				EXPECT_EQ(map.Remove(key), reference.Remove(key));
+			}
+			else
+			{
+				map.Set(key, i);
+				reference.Set(key, i);
+			}
+		}
+
+		EXPECT_EQ(map.Count(), reference.Items().Count());
+		for(const auto& item : reference.Items())
+			EXPECT_EQ(map[item.key], item.value);
+
+		usys_t n_iterated = 0;
+		for(const auto& item : map)
+		{
+			EXPECT_EQ(reference[item.key], item.value);
+			n_iterated++;
+		}
+		EXPECT_EQ(n_iterated, map.Count());
+
+		map.Clear();
+		EXPECT_EQ(map.Count(), 0U);
+		EXPECT_EQ(map.Get(reference.Items()[0].key), nullptr);
+	}
+
+	TEST(io_collection_map, THashMap_StringView_Lookup)
+	{
+		THashMap<TString, int> map = { { U"alpha", 1 }, { U"beta", 2 }, { U"gamma", 3 } };
+		const TString text = U"alpha beta gamma delta";
+
+		EXPECT_EQ(map[text.View().SliceSL(0, 5)], 1);
+		EXPECT_EQ(*map.Get(text.View().SliceSL(6, 4)), 2);
+		EXPECT_TRUE(map.Contains(text.View().SliceSL(11, 5)));
+		EXPECT_EQ(map.Get(text.View().SliceSL(17, 5)), nullptr);
+		EXPECT_TRUE(map.Remove(text.View().SliceSL(6, 4)));
+		EXPECT_FALSE(map.Contains(TString(U"beta")));
+		EXPECT_EQ(map.Count(), 2U);
+	}
+
+	TEST(io_collection_map, THashMap_Integer_Lookup)
+	{
+		// integers of other types are converted to the key type before they are hashed
+		THashMap<u32_t, int> map = { { 0xffffffffU, 1 }, { 7U, 2 } };
+		EXPECT_EQ(map[-1], 1);
+		EXPECT_EQ(*map.Get(-1), 1);
+		EXPECT_TRUE(map.Contains((u64_t)7));
+		EXPECT_TRUE(map.Remove((s8_t)-1));
+		EXPECT_EQ(map.Count(), 1U);
+
+		THashMap<s32_t, int> signed_map = { { -2, 3 } };
+		EXPECT_EQ(signed_map[0xfffffffeU], 3);
+		EXPECT_TRUE(signed_map.Contains((s64_t)-2));
+	}
+
+	TEST(io_collection_map, THashMap_CopyMove)
+	{
+		THashMap<int, std::unique_ptr<int>> unique;
+		unique.Add(10, el1::New<int>(15));
+		EXPECT_EQ(*unique[10], 15);
+		THashMap<int, std::unique_ptr<int>> moved(std::move(unique));
+		EXPECT_EQ(unique.Count(), 0U);
+		EXPECT_EQ(*moved[10], 15);
+
+		THashMap<int, TString> map;
+		for(unsigned i = 0; i < n_insert; i++)
+			map.Add(arr_insert[i], TString::Format(U"%d", arr_insert[i]));
+		for(unsigned i = 0; i < n_insert; i += 2)
+			map.Remove(arr_insert[i]);
+
+		THashMap<int, TString> copy(map);
+		map.Set(arr_insert[1], U"changed");
+		EXPECT_EQ(copy.Count(), map.Count());
+		for(unsigned i = 0; i < n_insert; i++)
+			EXPECT_EQ(copy.Contains(arr_insert[i]), i % 2 == 1);
+		EXPECT_EQ(copy[arr_insert[1]], TString::Format(U"%d", arr_insert[1]));
+
+		copy = map;
+		EXPECT_EQ(copy[arr_insert[1]], U"changed");
+	}
 }
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <el1/io_file.hpp>
+#include <el1/system_task.hpp>
 #include <string.h>
 #include <fcntl.h>
 
@@ -163,6 +164,115 @@ namespace
 		}
 	}
 
+	TEST(io_file, TFile_ReadAt_WriteOutAt)
+	{
+		struct TMemorySink : el1::io::stream::ISink<byte_t>
+		{
+			TList<byte_t> data;
+
+			usys_t Write(const byte_t* const arr_items, const usys_t n_items_max) final override
+			{
+				data.Append(arr_items, n_items_max);
+				return n_items_max;
+			}
+		};
+
+		TFile file;
+		byte_t data[64 * 1024];
+		for(usys_t i = 0; i < sizeof(data); i++)
+			data[i] = (byte_t)(i * 7);
+		file.WriteAll(data, sizeof(data));
+		file.Offset(100, ESeekOrigin::START);
+
+		// the IO-offset is neither used nor moved
+		byte_t buffer[16];
+		EXPECT_EQ(file.ReadAt(1000, buffer, sizeof(buffer)), sizeof(buffer));
+		EXPECT_EQ(memcmp(buffer, data + 1000, sizeof(buffer)), 0);
+		EXPECT_EQ(file.ReadAt(sizeof(data) - 4, buffer, sizeof(buffer)), 4U);
+		EXPECT_EQ(file.ReadAt(sizeof(data), buffer, sizeof(buffer)), 0U);
+		EXPECT_EQ(file.Offset(), 100U);
+
+		// a sink without handle receives a copy
+		TMemorySink memory;
+		iosize_t pos = 5000;
+		while(pos < 45000)
+			pos += file.WriteOutAt(pos, memory, 45000 - pos);
+		ASSERT_EQ(memory.data.Count(), 40000U);
+		EXPECT_EQ(memcmp(memory.data.ItemPtr(0), data + 5000, 40000), 0);
+
+		// another file is written by the kernel
+		TFile copy;
+		pos = 0;
+		while(pos < sizeof(data))
+			pos += file.WriteOutAt(pos, copy, sizeof(data) - pos);
+		EXPECT_EQ(copy.Size(), sizeof(data));
+		EXPECT_EQ(copy.ReadAt(30000, buffer, sizeof(buffer)), sizeof(buffer));
+		EXPECT_EQ(memcmp(buffer, data + 30000, sizeof(buffer)), 0);
+		EXPECT_EQ(file.Offset(), 100U);
+
+		EXPECT_THROW((void)file.WriteOutAt(sizeof(data), memory, 1), el1::io::stream::TStreamDryException);
+
+		const direntry_t info = file.QueryInfo();
+		EXPECT_EQ(info.type, EObjectType::FILE);
+		EXPECT_EQ(info.size, sizeof(data));
+		EXPECT_EQ(info.obj_id, file.ObjectID());
+		EXPECT_GT(info.ts_write, 0);
+	}
+
+	TEST(io_file, TFile_io_uring_offset_and_concurrency)
+	{
+		using namespace el1::system::task;
+
+		TThread* const thread = TThread::Self();
+		const EIoBackend previous = thread->IoBackend();
+		thread->IoBackend(EIoBackend::IO_URING);
+
+		{
+			TFile file;
+			EXPECT_EQ(file.Write((const byte_t*)"hello world\n", 12U), 12U);
+			EXPECT_EQ(file.Offset(), 12U);
+			file.Offset(6, ESeekOrigin::START);
+
+			char buffer[16] = {};
+			EXPECT_EQ(file.Read((byte_t*)buffer, sizeof(buffer)), 6U);
+			EXPECT_EQ(strcmp(buffer, "world\n"), 0);
+			EXPECT_EQ(file.Read((byte_t*)buffer, sizeof(buffer)), 0U);
+		}
+
+		{
+			// every fiber gets its own file, the transfers of all of them are in flight at the same time
+			static const unsigned N_FIBERS = 8;
+			TList<std::unique_ptr<TFiber>> fibers;
+			unsigned n_ok = 0;
+
+			for(unsigned i = 0; i < N_FIBERS; i++)
+				fibers.MoveAppend(std::make_unique<TFiber>([&n_ok, i](){
+					TFile file;
+					byte_t data[4096];
+					for(unsigned j = 0; j < 16; j++)
+					{
+						memset(data, (int)(i * 16 + j), sizeof(data));
+						file.WriteAll(data, sizeof(data));
+					}
+
+					file.Offset(0, ESeekOrigin::START);
+					for(unsigned j = 0; j < 16; j++)
+					{
+						file.ReadAll(data, sizeof(data));
+						if(data[0] != (byte_t)(i * 16 + j) || data[sizeof(data) - 1] != (byte_t)(i * 16 + j))
+							return;
+					}
+					n_ok++;
+				}, true, 64 * 1024));
+
+			for(auto& fiber : fibers)
+				EXPECT_EQ(fiber->Join(), nullptr);
+			EXPECT_EQ(n_ok, N_FIBERS);
+		}
+
+		thread->IoBackend(previous);
+	}
+
 	TEST(io_file, TPath_Construct)
 	{
 		{
@@ -33,6 +33,30 @@ namespace
 		EXPECT_EQ(encoded, expected);
 	}
 
+	TEST(io_format_base64, Batches)
+	{
+		TList<byte_t> data;
+		for(usys_t i = 0; i < 10000; i++)
+			data.Append((byte_t)(i * 37 + i / 256));
+
+		for(const usys_t n : { 1U, 2U, 3U, 1000U, 1001U, 1002U, 10000U })
+		{
+			const array_t<const byte_t> input = array_t<const byte_t>::FromUnsafePointer(data.ItemPtr(0), n);
+
+			const TList<char32_t> encoded = input.Pipe().Transform(TBase64Encoder()).Collect();
+			TList<char32_t> encoded_single;
+			input.Pipe().Transform(TBase64Encoder()).ForEach([&encoded_single](const char32_t chr) { encoded_single.Append(chr); });
+			ASSERT_EQ(encoded.Count(), (n + 2) / 3 * 4);
+			ASSERT_EQ(encoded_single.Count(), encoded.Count());
+			for(usys_t i = 0; i < encoded.Count(); i++)
+				EXPECT_EQ(encoded[i], encoded_single[i]);
+
+			const TList<byte_t> decoded = encoded.Pipe().Transform(TBase64Decoder()).Collect();
+			ASSERT_EQ(decoded.Count(), n);
+			EXPECT_EQ(memcmp(decoded.ItemPtr(0), data.ItemPtr(0), n), 0);
+		}
+	}
+
 	TEST(io_format_base64, Base64Url)
 	{
 		const byte_t bytes[] = { 0xfb, 0xff, 0xef };
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <el1/io_format_json.hpp>
 #include <el1/io_file.hpp>
+#include <el1/system_task.hpp>
+#include <optional>
+#include <string.h>
 
 using namespace ::testing;
 
@@ -8,6 +11,7 @@ namespace
 {
 	using namespace el1::io::format::json;
 	using namespace el1::io::file;
+	using namespace el1::system::task;
 
 	TEST(io_format_json, TJsonValue_Parse)
 	{
@@ -227,6 +231,417 @@ namespace
 		}
 	}
 
+	static TJsonValue ParseUtf8(const char* const json, const bool tolerant = false)
+	{
+		return TJsonValue::Parse(array_t<const byte_t>::FromUnsafePointer((const byte_t*)json, strlen(json)), tolerant);
+	}
+
+	// both parsers must either throw or return equal values (duplicate keys throw from TSortedMap)
+	static void ExpectSameAsGrammar(const char* const json, const bool tolerant)
+	{
+		std::optional<TJsonValue> expected;
+		try
+		{
+			expected = TJsonValue::Parse(TString(json), tolerant);
+		}
+		catch(const IException&) {}
+
+		std::optional<TJsonValue> actual;
+		try
+		{
+			actual = ParseUtf8(json, tolerant);
+		}
+		catch(const IException&) {}
+
+		EXPECT_EQ(expected.has_value(), actual.has_value()) << json << (tolerant ? " (tolerant)" : "");
+		if(expected && actual)
+		{
+			EXPECT_TRUE(*expected == *actual) << json << (tolerant ? " (tolerant)" : "");
+		}
+	}
+
+	TEST(io_format_json, TJsonValue_ParseUtf8)
+	{
+		{
+			const TJsonValue json = ParseUtf8(" { \"b\": [1, -2, 3.5, 1e3, true, false, null, \"x\\u20ac\\ud83d\\ude00\"], \"a\": {} } ");
+			ASSERT_EQ(json.Type(), EType::MAP);
+			EXPECT_EQ(json["a"].Map().Items().Count(), 0U);
+			ASSERT_EQ(json["b"].Array().Count(), 8U);
+			EXPECT_EQ(json["b"][0].ToInteger<u64_t>(), 1U);
+			EXPECT_EQ(json["b"][1].ToInteger<s64_t>(), -2);
+			EXPECT_EQ(json["b"][2].Number(), 3.5);
+			EXPECT_EQ(json["b"][3].Number(), 1000.0);
+			EXPECT_EQ(json["b"][4].Boolean(), true);
+			EXPECT_EQ(json["b"][5].Boolean(), false);
+			EXPECT_TRUE(json["b"][6].IsNull());
+			EXPECT_EQ(json["b"][7].String(), TString(U"x€😀"));
+		}
+
+		{
+			EXPECT_EQ(ParseUtf8("\"äöü\"").String(), TString(U"äöü"));
+			EXPECT_EQ(ParseUtf8("\"\\u0000\"").String().Length(), 1U);
+			EXPECT_EQ(ParseUtf8("\"\n\"", true).String(), TString(U"\n"));
+			EXPECT_EQ(ParseUtf8("\"\\ä\\I\"", true).String(), TString(U"äI"));
+			EXPECT_EQ(ParseUtf8("-9223372036854775808").ToInteger<s64_t>(), std::numeric_limits<s64_t>::min());
+			EXPECT_EQ(ParseUtf8("18446744073709551615").ToInteger<u64_t>(), std::numeric_limits<u64_t>::max());
+			EXPECT_EQ(ParseUtf8("18446744073709551616").Number(), 18446744073709551616.0);
+			EXPECT_EQ(ParseUtf8("1e-400").Number(), 0.0);
+			EXPECT_THROW(ParseUtf8("1e400"), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8(""), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8(" "), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8("1,2"), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8("\"\n\""), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8("\"\\I\""), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8("\"abc"), TInvalidJsonException);
+			EXPECT_THROW(ParseUtf8("[\"\\ud800\"]"), TInvalidJsonException);
+		}
+
+		{
+			try
+			{
+				(void)ParseUtf8("{\"ä\":\n[1,]}");
+				FAIL() << "expected TInvalidJsonException";
+			}
+			catch(const TInvalidJsonException& error)
+			{
+				// characters, not bytes
+				EXPECT_EQ(error.pos, (iosize_t)9);
+				EXPECT_EQ(error.line, (iosize_t)2);
+				EXPECT_EQ(error.chr, U']');
+			}
+		}
+
+		{
+			// strings, escapes and backslash runs across the 64 byte blocks and the chunks of the structural index
+			TString expected;
+			TString json = U"[\"";
+			for(unsigned i = 0; i < 40000; i++)
+			{
+				const unsigned n_backslashes = i % 7;
+				for(unsigned k = 0; k < n_backslashes / 2; k++)
+				{
+					json += U"\\\\";
+					expected += U'\\';
+				}
+				if(i % 3 == 0)
+				{
+					json += U"\\\"";
+					expected += U'"';
+				}
+				else
+				{
+					json += U'a';
+					expected += U'a';
+				}
+				if(i % 1000 == 999)
+				{
+					json += U"\", \"";
+					expected += U'|';
+				}
+			}
+			json += U"\"]";
+
+			const TJsonValue fast = ParseUtf8(json.MakeCStr().get());
+			EXPECT_TRUE(TJsonValue::Parse(json) == fast);
+			TString joined;
+			for(const TJsonValue& part : fast.Array())
+			{
+				if(joined.Length() != 0)
+					joined += U'|';
+				joined += part.String();
+			}
+			EXPECT_EQ(joined, expected);
+		}
+
+		{
+			// deeper than the grammar manages on a fiber stack
+			TString deep;
+			for(unsigned i = 0; i < 2000; i++)
+				deep += U"[{\"k\":";
+			deep += U"1";
+			for(unsigned i = 0; i < 2000; i++)
+				deep += U"}]";
+			const TJsonValue json = ParseUtf8(deep.MakeCStr().get());
+			EXPECT_EQ(json[0]["k"][0]["k"].Type(), EType::ARRAY);
+		}
+
+		{
+			TFile file("testdata/test1.json");
+			TMapping map(&file, TAccess::RO);
+			const TString text((const char*)map.ItemPtr(0), map.Count());
+			EXPECT_TRUE(TJsonValue::Parse(file) == TJsonValue::Parse(text));
+		}
+	}
+
+	static const char* const JSON_CASES[] = {
+		"0", "-0", "-0.0", "01", "-", "1.", ".5", "1e", "1e+", "1E-2", "+1", "1.5e3x", "12ab", "1 2", "1\"x\"", "truex", "nul", "true false",
+		"[]", "[ ]", "[,]", "[1,]", "[1 2]", "[1:2]", "[[[]]]", "[\"a\"\"b\"]", "{}", "{ }", "{,}", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{\"a\":1 \"b\":2}",
+		"{\"a\"::1}", "{1:2}", "{\"a\":1,\"a\":2}", "{\"b\":[],\"a\":{\"c\":null}}", "\"\\\"\"", "\"\\\\\"", "\"\\\\\\\"\"", "\"\\/\\b\\f\\n\\r\\t\"",
+		"\"\\u12\"", "\"\\u12x4\"", "\"\\uD83D\\uDE00\"", "\"\\ud83d\"", "\"\\ud83d\\u0041\"", "\"\\udc00\"", "\"\\x\"", "\"\t\"", "\"\x01\"", "\x01",
+		"\"a\" ", " \r\n\t[1]\t\r\n ", "[1]]", "[[1]", "}", "]", ":", ",", "\"", "\"\\", "[\"\\\\\"]", "{\"\\\"\":\"\\\\\"}",
+	};
+
+	TEST(io_format_json, TJsonValue_ParseUtf8_same_as_grammar)
+	{
+		for(const char* const json : JSON_CASES)
+		{
+			ExpectSameAsGrammar(json, false);
+			ExpectSameAsGrammar(json, true);
+		}
+
+		// mutations of valid documents
+		const char* const seeds[] = {
+			"{\"id\": 17, \"tags\": [\"a\", \"b\\n\"], \"ok\": true, \"x\": -1.25e2, \"n\": null}",
+			"[[1, 2], {\"k\": \"v\\\"\\\\\"}, [], {}, \"\\u0041\", 0.5, false]",
+		};
+		const char alphabet[] = "{}[]:,\"\\ \n01-.eEtrufalsn\x01" "ab";
+		u64_t state = 1;
+		for(unsigned i = 0; i < 3000; i++)
+		{
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			TList<char> json;
+			const char* const seed = seeds[i % 2];
+			json.Append(seed, strlen(seed));
+			for(unsigned k = 0; k < 1 + (state >> 60) % 3; k++)
+			{
+				state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+				json[(state >> 33) % json.Count()] = alphabet[(state >> 20) % (sizeof(alphabet) - 1)];
+			}
+			json.Append('\0');
+			ExpectSameAsGrammar(json.ItemPtr(0), (state & 1) != 0);
+		}
+	}
+
+	// hands out at most n_chunk bytes per Read(), so tokens are split across reads
+	struct TChunkedSource : el1::io::stream::ISource<byte_t>
+	{
+		const byte_t* arr_bytes;
+		usys_t n_bytes;
+		const usys_t n_chunk;
+
+		usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override
+		{
+			const usys_t n = el1::util::Min(n_items_max, n_chunk, n_bytes);
+			memcpy(arr_items, arr_bytes, n);
+			arr_bytes += n;
+			n_bytes -= n;
+			return n;
+		}
+
+		TChunkedSource(const char* const json, const usys_t n_chunk) : arr_bytes((const byte_t*)json), n_bytes(strlen(json)), n_chunk(n_chunk) {}
+	};
+
+	static TJsonValue ReadJson(const char* const json, const usys_t n_chunk, const bool tolerant = false)
+	{
+		TChunkedSource source(json, n_chunk);
+		TJsonReader reader(&source, tolerant);
+		reader.Next();
+		TJsonValue value = reader.ReadValue();
+		EXPECT_EQ(reader.Next(), EJsonToken::END);
+		return value;
+	}
+
+	static void ExpectReaderSameAsParse(const char* const json, const bool tolerant)
+	{
+		std::optional<TJsonValue> expected;
+		try { expected = ParseUtf8(json, tolerant); }
+		catch(const IException&) {}
+
+		for(const usys_t n_chunk : { 1U, 3U, 4096U })
+		{
+			std::optional<TJsonValue> actual;
+			try { actual = ReadJson(json, n_chunk, tolerant); }
+			catch(const IException&) {}
+
+			EXPECT_EQ(expected.has_value(), actual.has_value()) << "input: " << json << " chunk: " << n_chunk;
+			if(expected && actual)
+			{
+				EXPECT_EQ(*expected, *actual) << "input: " << json << " chunk: " << n_chunk;
+			}
+		}
+	}
+
+	TEST(io_format_json, TJsonReader_Next)
+	{
+		{
+			TChunkedSource source(" {\"a\": [1, -2.5, \"x\\u20ac\", true, null], \"b\": {}}\n", 2);
+			TJsonReader reader(&source);
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			EXPECT_EQ(reader.Depth(), 1U);
+			EXPECT_EQ(reader.Next(), EJsonToken::KEY);
+			EXPECT_EQ(reader.String(), U"a");
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_ARRAY);
+			EXPECT_EQ(reader.Depth(), 2U);
+			EXPECT_EQ(reader.Next(), EJsonToken::NUMBER);
+			EXPECT_EQ(reader.ToInteger<int>(), 1);
+			EXPECT_EQ(reader.Next(), EJsonToken::NUMBER);
+			EXPECT_EQ(reader.Number(), -2.5);
+			EXPECT_EQ(reader.Next(), EJsonToken::STRING);
+			EXPECT_EQ(reader.String(), TString(U"x€"));
+			EXPECT_THROW((void)reader.Number(), TException);
+			EXPECT_EQ(reader.Next(), EJsonToken::BOOLEAN);
+			EXPECT_TRUE(reader.Boolean());
+			EXPECT_EQ(reader.Next(), EJsonToken::NULLVALUE);
+			EXPECT_TRUE(reader.Value().IsNull());
+			EXPECT_EQ(reader.Next(), EJsonToken::END_ARRAY);
+			EXPECT_EQ(reader.Next(), EJsonToken::KEY);
+			EXPECT_EQ(reader.String(), U"b");
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			EXPECT_EQ(reader.Next(), EJsonToken::END_MAP);
+			EXPECT_EQ(reader.Next(), EJsonToken::END_MAP);
+			EXPECT_EQ(reader.Depth(), 0U);
+			EXPECT_EQ(reader.Next(), EJsonToken::END);
+			EXPECT_EQ(reader.Next(), EJsonToken::END);
+		}
+
+		{
+			// newline delimited documents
+			TChunkedSource source("{\"id\": 1}\n{\"id\": 2}\n[3]\n\"x\" 4", 5);
+			TJsonReader reader(&source, false, true);
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			EXPECT_EQ(reader.ReadValue(), TJsonValue::Parse(U"{\"id\": 1}"));
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			EXPECT_EQ(reader.ReadValue(), TJsonValue::Parse(U"{\"id\": 2}"));
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_ARRAY);
+			reader.Skip();
+			EXPECT_EQ(reader.Token(), EJsonToken::END_ARRAY);
+			EXPECT_EQ(reader.Next(), EJsonToken::STRING);
+			EXPECT_EQ(reader.Next(), EJsonToken::NUMBER);
+			EXPECT_EQ(reader.Next(), EJsonToken::END);
+		}
+
+		{
+			// selected records of an array export
+			TChunkedSource source("[{\"skip\": [1, [2, {\"x\": \"]}\"}]]}, {\"id\": 7, \"tags\": [\"a\"]}, 3]", 4);
+			TJsonReader reader(&source);
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_ARRAY);
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			reader.Skip();
+			EXPECT_EQ(reader.Token(), EJsonToken::END_MAP);
+			EXPECT_EQ(reader.Depth(), 1U);
+			EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_MAP);
+			EXPECT_EQ(reader.ReadValue(), TJsonValue::Parse(U"{\"id\": 7, \"tags\": [\"a\"]}"));
+			EXPECT_EQ(reader.Depth(), 1U);
+			EXPECT_EQ(reader.Next(), EJsonToken::NUMBER);
+			EXPECT_EQ(reader.ReadValue(), TJsonValue(3U));
+			EXPECT_EQ(reader.Next(), EJsonToken::END_ARRAY);
+			EXPECT_EQ(reader.Next(), EJsonToken::END);
+		}
+
+		{
+			// same positions as the grammar, across chunks
+			TChunkedSource source("{\"ä\":\n[1,]}", 1);
+			TJsonReader reader(&source);
+			try
+			{
+				while(reader.Next() != EJsonToken::END);
+				FAIL();
+			}
+			catch(const TInvalidJsonException& e)
+			{
+				EXPECT_EQ(e.pos, 9U);
+				EXPECT_EQ(e.line, 2U);
+				EXPECT_EQ(e.chr, U']');
+			}
+		}
+
+		{
+			// only a token which does not fit makes the buffer grow, up to its limit
+			TString long_string = U"[\"";
+			for(unsigned i = 0; i < 1000; i++)
+				long_string += U'x';
+			long_string += U"\"]";
+			const auto json = long_string.MakeCStr();
+
+			TChunkedSource fits(json.get(), 100);
+			TJsonReader reader_fits(&fits, false, false, 1024);
+			EXPECT_EQ(reader_fits.Next(), EJsonToken::BEGIN_ARRAY);
+			EXPECT_EQ(reader_fits.Next(), EJsonToken::STRING);
+			EXPECT_EQ(reader_fits.String().Length(), 1000U);
+
+			TChunkedSource too_large(json.get(), 100);
+			TJsonReader reader_too_large(&too_large, false, false, 512);
+			EXPECT_EQ(reader_too_large.Next(), EJsonToken::BEGIN_ARRAY);
+			EXPECT_THROW(reader_too_large.Next(), TException);
+		}
+	}
+
+	TEST(io_format_json, TJsonReader_same_as_Parse)
+	{
+		for(const char* const json : JSON_CASES)
+		{
+			ExpectReaderSameAsParse(json, false);
+			ExpectReaderSameAsParse(json, true);
+		}
+		ExpectReaderSameAsParse("{\"id\": 17, \"tags\": [\"a\", \"b\\n\"], \"ok\": true, \"x\": -1.25e2, \"n\": null, \"u\": \"\\ud83d\\ude00\", \"deep\": [[[{}]]]}", false);
+	}
+
+	TEST(io_format_json, TJsonReader_TryNext)
+	{
+		TPipe pipe;
+		pipe.ReceiveSide().BlockingIO(false);
+		const auto write = [&pipe](const char* const str) { pipe.WriteAll((const byte_t*)str, strlen(str)); };
+
+		TJsonReader reader(&pipe);
+		EXPECT_FALSE(reader.TryNext().has_value());
+		write("[12");
+		EXPECT_EQ(reader.TryNext(), EJsonToken::BEGIN_ARRAY);
+		EXPECT_FALSE(reader.TryNext().has_value());
+		write("34, \"ab");
+		EXPECT_EQ(reader.TryNext(), EJsonToken::NUMBER);
+		EXPECT_EQ(reader.ToInteger<int>(), 1234);
+		EXPECT_FALSE(reader.TryNext().has_value());
+		write("\\\"c\", tr");
+		EXPECT_EQ(reader.TryNext(), EJsonToken::STRING);
+		EXPECT_EQ(reader.String(), U"ab\"c");
+		EXPECT_FALSE(reader.TryNext().has_value());
+		write("ue]");
+		EXPECT_EQ(reader.TryNext(), EJsonToken::BOOLEAN);
+		EXPECT_EQ(reader.TryNext(), EJsonToken::END_ARRAY);
+		// whether the document ends is only known once the source is dry
+		EXPECT_FALSE(reader.TryNext().has_value());
+		pipe.SendSide().Close();
+		EXPECT_EQ(reader.TryNext(), EJsonToken::END);
+	}
+
+	TEST(io_format_json, TJsonReader_fiber)
+	{
+		const unsigned n_records = 3000;
+		TPipe pipe;
+		pipe.ReceiveSide().BlockingIO(false);
+		pipe.SendSide().BlockingIO(false);
+
+		// the writer fills the pipe faster than one read drains it, both sides block in turn
+		TFiber writer([&pipe]() {
+			TString json = U"[";
+			for(unsigned i = 0; i < n_records; i++)
+				json += TString::Format(U"%s{\"id\": %d, \"name\": \"record %d\", \"payload\": [1.5, true, null, {\"k\": \"ä\"}]}", i == 0 ? U"" : U",\n", i, i);
+			json += U"]";
+			const auto c_str = json.MakeCStr();
+			const usys_t n_bytes = strlen(c_str.get());
+			for(usys_t i = 0; i < n_bytes; i += 777)
+				pipe.WriteAll((const byte_t*)c_str.get() + i, el1::util::Min<usys_t>(777, n_bytes - i));
+			pipe.SendSide().Close();
+		});
+
+		TJsonReader reader(&pipe);
+		u64_t sum = 0;
+		unsigned n_read = 0;
+		EXPECT_EQ(reader.Next(), EJsonToken::BEGIN_ARRAY);
+		while(reader.Next() == EJsonToken::BEGIN_MAP)
+		{
+			const TJsonValue record = reader.ReadValue();
+			sum += record["id"].ToInteger<u64_t>();
+			EXPECT_EQ(record["payload"][3]["k"].String(), TString(U"ä"));
+			n_read++;
+		}
+		EXPECT_EQ(reader.Token(), EJsonToken::END_ARRAY);
+		EXPECT_EQ(reader.Next(), EJsonToken::END);
+		EXPECT_EQ(n_read, n_records);
+		EXPECT_EQ(sum, (u64_t)n_records * (n_records - 1) / 2);
+		EXPECT_EQ(writer.Join(), nullptr);
+	}
+
 	TEST(io_format_json, JsonUnquote)
 	{
 		EXPECT_EQ(JsonUnquote(U"\" abc 123 \\b\\f\\n\\r\\t\\\"\\\\ \""), U" abc 123 \b\f\n\r\t\"\\ ");
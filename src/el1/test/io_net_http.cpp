@@ -559,6 +559,61 @@ namespace
 		EXPECT_EQ(str_response, U"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nstream\r\n0\r\n\r\n");
 	}
 
+	struct TWriteCountingSink : ISink<byte_t>
+	{
+		usys_t n_writes = 0;
+		TList<byte_t> data;
+
+		usys_t Write(const byte_t* const arr_items, const usys_t n_items_max) final override
+		{
+			n_writes++;
+			data.Append(arr_items, n_items_max);
+			return n_items_max;
+		}
+	};
+
+	TEST(io_net_http, THttpResponseEncoder_single_write)
+	{
+		{
+			TWriteCountingSink sink;
+			THttpResponseEncoder::response_t response;
+			response.status = EStatus::NOT_FOUND;
+			response.version = EVersion::HTTP11;
+			response.header_fields.Set(U"Content-Type", U"text/plain; charset=utf-8");
+			response.header_fields.Set(U"X-Name", U"gr\u00fc\u00dfe");
+			response.header_fields.ContentLength(5);
+			response.body = el1::New<TListSource<byte_t>>(TList<byte_t>(reinterpret_cast<const byte_t*>("hello"), 5));
+			THttpResponseEncoder(sink).WriteResponse(response);
+
+			EXPECT_EQ(sink.n_writes, 1U);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()), U"HTTP/1.1 404 Not Found\r\nContent-Length: 5\r\nContent-Type: text/plain; charset=utf-8\r\nX-Name: gr\u00fc\u00dfe\r\n\r\nhello");
+		}
+
+		{
+			TWriteCountingSink sink;
+			THttpResponseEncoder::response_t response;
+			response.status = EStatus::CREATED;
+			response.version = EVersion::HTTP10;
+			THttpResponseEncoder(sink).WriteResponse(response);
+
+			EXPECT_EQ(sink.n_writes, 1U);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()), U"HTTP/1.0 201 Created\r\nContent-Length: 0\r\n\r\n");
+		}
+
+		{
+			// the head, the only chunk and the terminating chunk
+			TWriteCountingSink sink;
+			THttpResponseEncoder::response_t response;
+			response.status = EStatus::OK;
+			response.version = EVersion::HTTP11;
+			response.body = el1::New<TListSource<byte_t>>(TList<byte_t>(reinterpret_cast<const byte_t*>("stream"), 6));
+			THttpResponseEncoder(sink).WriteResponse(response);
+
+			EXPECT_EQ(sink.n_writes, 1U);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()), U"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nstream\r\n0\r\n\r\n");
+		}
+	}
+
 	TEST(io_net_http, THttpRequestDecoder_streaming_body_blocks_next_request)
 	{
 		const char* str_src =
@@ -613,6 +668,354 @@ namespace
 		EXPECT_EQ(request.body->Trailers()[U"checksum"], U"ok");
 	}
 
+	TEST(io_net_http, THttpRequestDecoder_pipelined_requests)
+	{
+		const char* str_src =
+			"GET /one?a=1&b HTTP/1.1\r\nHost: example.org\r\nX-Test:  padded value \t\r\n\r\n"
+			"POST /two HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+			"GET /three%20x HTTP/1.0\r\nAccept: a\r\naccept: b\r\n\r\n";
+		TFifo<byte_t> source;
+		source.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+		source.CloseOutput();
+
+		THttpRequestDecoder decoder(source);
+		THttpRequest request;
+		ASSERT_EQ(decoder.Read(&request, 1), 1U);
+		EXPECT_EQ(request.method, EMethod::GET);
+		EXPECT_EQ(request.url, U"/one");
+		EXPECT_EQ(request.args[U"a"], U"1");
+		EXPECT_EQ(request.args[U"b"], U"");
+		EXPECT_EQ(request.header_fields[U"host"], U"example.org");
+		EXPECT_EQ(request.header_fields[U"x-test"], U"padded value");
+		EXPECT_EQ(request.body, nullptr);
+
+		// everything was received with the first read, the other requests wait in the decoder
+		EXPECT_NE(decoder.Buffered(), 0U);
+
+		ASSERT_EQ(decoder.Read(&request, 1), 1U);
+		EXPECT_EQ(request.method, EMethod::POST);
+		EXPECT_EQ(request.url, U"/two");
+		ASSERT_NE(request.body, nullptr);
+		byte_t body[3];
+		request.body->ReadAll(body, sizeof(body));
+		EXPECT_EQ(memcmp(body, "abc", 3), 0);
+
+		ASSERT_EQ(decoder.Read(&request, 1), 1U);
+		EXPECT_EQ(request.url, U"/three x");
+		EXPECT_EQ(request.version, EVersion::HTTP10);
+		EXPECT_EQ(request.header_fields[U"accept"], U"a, b");
+
+		EXPECT_EQ(decoder.Read(&request, 1), 0U);
+		EXPECT_EQ(decoder.OnInputReady(), nullptr);
+	}
+
+	TEST(io_net_http, THttpRequestDecoder_fragmented_input)
+	{
+		// the request arrives in pieces which split the lines at arbitrary positions
+		const char* str_src = "GET /fragmented HTTP/1.1\r\nHost: example.org\r\nContent-Length: 0\r\n\r\n";
+		const usys_t n_src = strlen(str_src);
+		TFifo<byte_t> source;
+		THttpRequestDecoder decoder(source);
+		THttpRequest request;
+
+		for(usys_t pos = 0; pos < n_src; pos += 7)
+		{
+			EXPECT_EQ(decoder.Read(&request, 1), 0U);
+			EXPECT_NE(decoder.OnInputReady(), nullptr);
+			source.WriteAll(reinterpret_cast<const byte_t*>(str_src) + pos, el1::util::Min<usys_t>(7, n_src - pos));
+		}
+
+		ASSERT_EQ(decoder.Read(&request, 1), 1U);
+		EXPECT_EQ(request.url, U"/fragmented");
+		EXPECT_EQ(request.header_fields[U"host"], U"example.org");
+	}
+
+	TEST(io_net_http, THttpRequestDecoder_header_limit)
+	{
+		TFifo<byte_t, 1024> source;
+		const char* str_request = "GET / HTTP/1.1\r\nX-Long: ";
+		source.WriteAll(reinterpret_cast<const byte_t*>(str_request), strlen(str_request));
+		TList<byte_t> filler;
+		for(usys_t i = 0; i < 300; i++)
+			filler.Append('x');
+		source.WriteAll(filler.ItemPtr(0), filler.Count());
+
+		THttpRequestDecoder decoder(source, {}, 256);
+		THttpRequest request;
+		try
+		{
+			(void)decoder.Read(&request, 1);
+			FAIL();
+		}
+		catch(const THttpProcessingException& e)
+		{
+			EXPECT_EQ(e.status, EStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
+		}
+	}
+
+	TEST(io_net_http, HandleSingleRequest_pipelined)
+	{
+		const char* str_src =
+			"GET /a HTTP/1.1\r\n\r\n"
+			"GET /b HTTP/1.1\r\n\r\n";
+		TFifo<byte_t> fifo_c2s;
+		TFifo<byte_t> fifo_s2c;
+		fifo_c2s.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+		fifo_c2s.CloseOutput();
+
+		TList<TString> urls;
+		THttpRequestDecoder decoder(fifo_c2s);
+		const auto handler = [&urls](const THttpServer::request_t& request, THttpServer::response_t& response) {
+			urls.Append(request.url);
+			response.status = EStatus::NO_CONTENT;
+		};
+
+		EXPECT_EQ(THttpServer::HandleSingleRequest(decoder, fifo_s2c, handler), EStatus::NO_CONTENT);
+		EXPECT_EQ(THttpServer::HandleSingleRequest(decoder, fifo_s2c, handler), EStatus::NO_CONTENT);
+		EXPECT_EQ(THttpServer::HandleSingleRequest(decoder, fifo_s2c, handler), EStatus::EOF);
+		ASSERT_EQ(urls.Count(), 2U);
+		EXPECT_EQ(urls[0], U"/a");
+		EXPECT_EQ(urls[1], U"/b");
+	}
+
+	TEST(io_net_http, HandleHttp1Connection_pipelined)
+	{
+		const char* str_src =
+			"GET /a HTTP/1.1\r\n\r\n"
+			"GET /b HTTP/1.1\r\n\r\n"
+			"GET /c HTTP/1.1\r\n\r\n";
+		TFifo<byte_t> fifo_c2s;
+		fifo_c2s.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+		fifo_c2s.CloseOutput();
+
+		TList<TString> urls;
+		const auto handler = [&urls](const THttpServer::request_t& request, THttpServer::response_t& response) {
+			urls.Append(request.url);
+			response.status = EStatus::NO_CONTENT;
+		};
+
+		// all responses go out with a single write
+		{
+			TWriteCountingSink sink;
+			THttpServer::HandleHttp1Connection(fifo_c2s, sink, handler);
+			ASSERT_EQ(urls.Count(), 3U);
+			EXPECT_EQ(urls[2], U"/c");
+			EXPECT_EQ(sink.n_writes, 1U);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()),
+				U"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n"
+				U"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n"
+				U"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+		}
+
+		// the second response closes the connection
+		{
+			TFifo<byte_t> fifo_limited;
+			fifo_limited.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+			fifo_limited.CloseOutput();
+
+			connection_limits_t limits;
+			limits.max_requests = 2;
+			TWriteCountingSink sink;
+			urls.Clear();
+			THttpServer::HandleHttp1Connection(fifo_limited, sink, handler, {}, limits);
+			EXPECT_EQ(urls.Count(), 2U);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()),
+				U"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n"
+				U"HTTP/1.1 204 No Content\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+		}
+	}
+
+	TEST(io_net_http, HandleHttp1Connection_timeouts)
+	{
+		const auto handler = [](const THttpServer::request_t&, THttpServer::response_t& response) {
+			response.status = EStatus::NO_CONTENT;
+		};
+
+		connection_limits_t limits;
+		limits.idle_timeout = 0.05;
+		limits.request_timeout = 0.05;
+
+		// the connection stays open after the request, nothing else arrives
+		{
+			const char* str_src = "GET / HTTP/1.1\r\n\r\n";
+			TFifo<byte_t> fifo_c2s;
+			fifo_c2s.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+			TWriteCountingSink sink;
+			THttpServer::HandleHttp1Connection(fifo_c2s, sink, handler, {}, limits);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()), U"HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+		}
+
+		// the request head is never completed
+		{
+			const char* str_src = "GET / HTTP/1.1\r\nHost: exa";
+			TFifo<byte_t> fifo_c2s;
+			fifo_c2s.WriteAll(reinterpret_cast<const byte_t*>(str_src), strlen(str_src));
+			TWriteCountingSink sink;
+			THttpServer::HandleHttp1Connection(fifo_c2s, sink, handler, {}, limits);
+			EXPECT_EQ(TString(sink.data.Pipe().Transform(TUTF8Decoder()).Collect()), U"HTTP/1.1 408 Request Timeout\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+		}
+	}
+
+	static TPath WriteTestFile(const TString& name, const usys_t size, const byte_t seed)
+	{
+		const TPath path = TPath(EL1_TEST_OUT_DIR) + name;
+		TFile file(path, TAccess::RW, ECreateMode::DELETE);
+		TList<byte_t> data;
+		data.SetCount(size);
+		for(usys_t i = 0; i < size; i++)
+			data[i] = (byte_t)('a' + (i + seed) % 26);
+		file.WriteAll(data.ItemPtr(0), size);
+		return path;
+	}
+
+	// sends a single request to HandleHttp1Connection() and returns what came back
+	static TString Exchange(THttpServer::request_handler_t handler, const TStringView request)
+	{
+		TFifo<byte_t, 4096> fifo_c2s;
+		auto str_request = request.MakeCStr();
+		fifo_c2s.WriteAll(reinterpret_cast<const byte_t*>(str_request.get()), strlen(str_request.get()));
+		fifo_c2s.CloseOutput();
+
+		TWriteCountingSink sink;
+		THttpServer::HandleHttp1Connection(fifo_c2s, sink, handler);
+		return sink.data.Pipe().Transform(TUTF8Decoder()).Collect();
+	}
+
+	TEST(io_net_http, THttpFileCache_conditional_and_range)
+	{
+		const TPath path = WriteTestFile(U"http_file_cache.txt", 40000, 0);
+		THttpFileCache cache;
+		const auto handler = [&cache, &path](const THttpServer::request_t&, THttpServer::response_t& response) {
+			cache.Respond(path, response);
+		};
+
+		const auto file = cache.Open(path);
+		ASSERT_NE(file, nullptr);
+		EXPECT_EQ(file->size, 40000U);
+
+		// Last-Modified is the IMF-fixdate of the modification time
+		char str_date[64];
+		struct tm tm_write = {};
+		const time_t ts_write = (time_t)file->ts_write.Seconds();
+		gmtime_r(&ts_write, &tm_write);
+		strftime(str_date, sizeof(str_date), "%a, %d %b %Y %H:%M:%S GMT", &tm_write);
+		EXPECT_EQ(file->last_modified, TString(str_date));
+
+		const TString etag = file->etag;
+		const TString last_modified = file->last_modified;
+
+		{
+			const TString response = Exchange(handler, U"GET / HTTP/1.1\r\n\r\n");
+			EXPECT_TRUE(response.BeginsWith(U"HTTP/1.1 200 OK\r\n"));
+			EXPECT_NE(response.Find(U"\r\nAccept-Ranges: bytes\r\n"), NEG1);
+			EXPECT_NE(response.Find(U"\r\nContent-Length: 40000\r\n"), NEG1);
+			EXPECT_NE(response.Find(TString(U"\r\nETag: ") + etag + U"\r\n"), NEG1);
+			EXPECT_NE(response.Find(TString(U"\r\nLast-Modified: ") + last_modified + U"\r\n"), NEG1);
+			const usys_t pos_body = response.Find(U"\r\n\r\n") + 4U;
+			ASSERT_EQ(response.Length() - pos_body, 40000U);
+			EXPECT_EQ(response.SliceSL(pos_body, 30), U"abcdefghijklmnopqrstuvwxyzabcd");
+		}
+
+		{
+			const TString response = Exchange(handler, U"GET / HTTP/1.1\r\nRange: bytes=26-29\r\n\r\n");
+			EXPECT_TRUE(response.BeginsWith(U"HTTP/1.1 206 Partial Content\r\n"));
+			EXPECT_NE(response.Find(U"\r\nContent-Range: bytes 26-29/40000\r\n"), NEG1);
+			EXPECT_NE(response.Find(U"\r\nContent-Length: 4\r\n"), NEG1);
+			EXPECT_TRUE(response.EndsWith(U"\r\n\r\nabcd"));
+		}
+
+		{
+			// the last bytes, larger than what is sent along with the head
+			const TString response = Exchange(handler, U"GET / HTTP/1.1\r\nRange: bytes=-20000\r\n\r\n");
+			EXPECT_NE(response.Find(U"\r\nContent-Range: bytes 20000-39999/40000\r\n"), NEG1);
+			const usys_t pos_body = response.Find(U"\r\n\r\n") + 4U;
+			ASSERT_EQ(response.Length() - pos_body, 20000U);
+			EXPECT_EQ(response.SliceSL(pos_body, 4), U"ghij");
+			EXPECT_TRUE(response.EndsWith(U"jkl"));
+		}
+
+		{
+			const TString response = Exchange(handler, U"GET / HTTP/1.1\r\nRange: bytes=40000-\r\n\r\n");
+			EXPECT_TRUE(response.BeginsWith(U"HTTP/1.1 416 Range Not Satisfiable\r\n"));
+			EXPECT_NE(response.Find(U"\r\nContent-Range: bytes */40000\r\n"), NEG1);
+			EXPECT_NE(response.Find(U"\r\nContent-Length: 0\r\n"), NEG1);
+		}
+
+		// multiple ranges and a failed If-Range get the whole file
+		for(const TString& request : { TString(U"GET / HTTP/1.1\r\nRange: bytes=0-1,5-6\r\n\r\n"), TString(U"GET / HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: \"other\"\r\n\r\n") })
+			EXPECT_TRUE(Exchange(handler, request).BeginsWith(U"HTTP/1.1 200 OK\r\n"));
+		EXPECT_TRUE(Exchange(handler, TString(U"GET / HTTP/1.1\r\nRange: bytes=0-1\r\nIf-Range: ") + etag + U"\r\n\r\n").BeginsWith(U"HTTP/1.1 206 Partial Content\r\n"));
+
+		// validators which still match give 304 without body or length
+		for(const TString& request : { TString(U"GET / HTTP/1.1\r\nIf-None-Match: \"x\", W/") + etag + U"\r\n\r\n", TString(U"HEAD / HTTP/1.1\r\nIf-Modified-Since: ") + last_modified + U"\r\n\r\n" })
+		{
+			const TString response = Exchange(handler, request);
+			EXPECT_TRUE(response.BeginsWith(U"HTTP/1.1 304 Not Modified\r\n"));
+			EXPECT_EQ(response.Find(U"Content-Length"), NEG1);
+			EXPECT_TRUE(response.EndsWith(TString(U"\r\nETag: ") + etag + U"\r\nLast-Modified: " + last_modified + U"\r\n\r\n"));
+		}
+		EXPECT_TRUE(Exchange(handler, U"GET / HTTP/1.1\r\nIf-None-Match: \"x\"\r\nIf-Modified-Since: Fri, 01 Jan 2100 00:00:00 GMT\r\n\r\n").BeginsWith(U"HTTP/1.1 200 OK\r\n"));
+	}
+
+	TEST(io_net_http, THttpFileCache_revalidate_and_evict)
+	{
+		const TPath path1 = WriteTestFile(U"http_file_cache1.txt", 100, 0);
+		const TPath path2 = WriteTestFile(U"http_file_cache2.txt", 200, 0);
+
+		{
+			THttpFileCache cache(1, 3600);
+			const auto file1 = cache.Open(path1);
+			ASSERT_NE(file1, nullptr);
+			EXPECT_EQ(cache.Open(path1), file1);
+			EXPECT_EQ(cache.Count(), 1U);
+
+			// the least recently used file is closed, responses in flight keep theirs open
+			const auto file2 = cache.Open(path2);
+			ASSERT_NE(file2, nullptr);
+			EXPECT_EQ(cache.Count(), 1U);
+			EXPECT_NE(cache.Open(path1), file1);
+			byte_t byte = 0;
+			EXPECT_EQ(file1->file.ReadAt(99, &byte, 1), 1U);
+
+			EXPECT_EQ(cache.Open(TPath(EL1_TEST_OUT_DIR) + U"http_file_cache_nx.txt"), nullptr);
+			EXPECT_EQ(cache.Open(TPath(EL1_TEST_OUT_DIR)), nullptr);
+
+			THttpServer::response_t response;
+			cache.Respond(TPath(EL1_TEST_OUT_DIR) + U"http_file_cache_nx.txt", response);
+			EXPECT_EQ(response.status, EStatus::NOT_FOUND);
+			EXPECT_EQ(response.body, nullptr);
+		}
+
+		{
+			// a replaced file is picked up once the interval is over
+			THttpFileCache cache(16, 0);
+			const auto file1 = cache.Open(path1);
+			ASSERT_NE(file1, nullptr);
+			WriteTestFile(U"http_file_cache1.txt", 150, 1);
+			const auto file1_new = cache.Open(path1);
+			ASSERT_NE(file1_new, nullptr);
+			EXPECT_EQ(file1_new->size, 150U);
+			EXPECT_NE(file1_new->etag, file1->etag);
+			EXPECT_EQ(cache.Open(path1), file1_new);
+		}
+	}
+
+	TEST(io_net_http, THttpServer_curl_file_cache)
+	{
+		const TPath path = WriteTestFile(U"http_file_cache_large.txt", 1000000, 3);
+		THttpFileCache cache;
+		TTcpServer tcp_server;
+		THttpServer http_server(&tcp_server, [&cache, &path](const THttpServer::request_t&, THttpServer::response_t& response) {
+			cache.Respond(path, response);
+		});
+
+		TFile reference_file(path);
+		const TString str_ref = reference_file.Pipe().Transform(TUTF8Decoder()).Collect();
+		const TString url = TString::Format(U"http://localhost:%d/", tcp_server.LocalAddress().port);
+		EXPECT_EQ(TProcess::Execute(U"/usr/bin/curl", { U"--silent", U"--fail", url }), str_ref);
+		EXPECT_EQ(TProcess::Execute(U"/usr/bin/curl", { U"--silent", U"--fail", U"--range", U"100000-599999", url }), str_ref.SliceSL(100000, 500000));
+	}
+
 	TEST(io_net_http, THttpServer_curl_simple)
 	{
 		TTcpServer tcp_server;
@@ -650,6 +1053,30 @@ namespace
 		EXPECT_EQ(str_curl, str_ref);
 	}
 
+	TEST(io_net_http, THttpServer_curl_https_file_cache)
+	{
+		// uses kTLS and sendfile() when the kernel supports it, otherwise OpenSSL and the copy path
+		const TPath path = WriteTestFile(U"https_file_cache.txt", 300000, 5);
+		THttpFileCache cache;
+		TTcpServer tcp_server;
+		tls::TServer tls_server(&tcp_server, U"support/tls-test-cert.pem", U"support/tls-test-key.pem");
+		THttpServer http_server(&tls_server, [&cache, &path](const THttpServer::request_t&, THttpServer::response_t& response) {
+			cache.Respond(path, response);
+		});
+
+		tls::TClient tls_client(U"localhost", tls_server.LocalAddress().port, tls::client_config_t{ .verify_peer = false });
+		tls_client.Negotiate();
+		// the socket only carries plaintext when the kernel handles both directions
+		EXPECT_EQ(tls_client.Handle() != el1::system::handle::INVALID_HANDLE, tls_client.KernelTlsSend() && tls_client.KernelTlsReceive());
+		tls_client.Close();
+
+		TFile reference_file(path);
+		const TString str_ref = reference_file.Pipe().Transform(TUTF8Decoder()).Collect();
+		const TString url = TString::Format(U"https://localhost:%d/", tls_server.LocalAddress().port);
+		EXPECT_EQ(TProcess::Execute(U"/usr/bin/curl", { U"--silent", U"--fail", U"--cacert", U"support/tls-test-cert.pem", url, url }), str_ref + str_ref);
+		EXPECT_EQ(TProcess::Execute(U"/usr/bin/curl", { U"--silent", U"--fail", U"--cacert", U"support/tls-test-cert.pem", U"--tlsv1.2", U"--tls-max", U"1.2", U"--range", U"1000-1999", url }), str_ref.SliceSL(1000, 1000));
+	}
+
 	TEST(io_net_http, THttpServer_curl_https_unknown_length)
 	{
 		TTcpServer tcp_server;
@@ -978,6 +1405,72 @@ namespace
 		EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
 	}
 
+	TEST(io_net_http, THttpClient_https_session_resumption)
+	{
+		TTcpServer tcp_server;
+		tls::TServer tls_server(&tcp_server, U"support/tls-test-cert.pem", U"support/tls-test-key.pem");
+		THttpServer http_server(&tls_server, [](const THttpServer::request_t&, THttpServer::response_t& response) {
+			response.status = EStatus::OK;
+		});
+
+		tls::client_config_t config;
+		config.ca_certificates = tls::TPemSource(TPath(U"support/tls-test-cert.pem"));
+		config.session_cache = el1::New<tls::TSessionCache>();
+		const auto cache = config.session_cache;
+		THttpClient client(U"localhost", tls_server.LocalAddress().port, std::move(config));
+
+		EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
+		EXPECT_EQ(cache->Count(), 1U);
+		client.Close();
+		EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
+		client.Close();
+
+		// the previous ticket key is still accepted after one rotation, but not after two
+		tls_server.RotateTicketKeys();
+		EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
+		client.Close();
+		tls_server.RotateTicketKeys();
+		tls_server.RotateTicketKeys();
+		EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
+		client.Close();
+
+		EXPECT_EQ(cache->HandshakeStats().n_full, 2U);
+		EXPECT_EQ(cache->HandshakeStats().n_resumed, 2U);
+		EXPECT_EQ(tls_server.HandshakeStats().n_full, 2U);
+		EXPECT_EQ(tls_server.HandshakeStats().n_resumed, 2U);
+	}
+
+	TEST(io_net_http, THttpClient_https_session_resumption_keeps_verification)
+	{
+		TTcpServer tcp_server;
+		tls::TServer tls_server(&tcp_server, U"support/tls-test-cert.pem", U"support/tls-test-key.pem");
+		THttpServer http_server(&tls_server, [](const THttpServer::request_t&, THttpServer::response_t& response) {
+			response.status = EStatus::OK;
+		});
+
+		const std::shared_ptr<tls::TSessionCache> cache = el1::New<tls::TSessionCache>();
+		const auto get = [&](const bool verify_peer) {
+			tls::client_config_t config;
+			config.verify_peer = verify_peer;
+			config.ca_certificates = tls::TPemSource(TPath(U"support/tls-test-cert.pem"));
+			config.session_cache = cache;
+			THttpClient client(U"localhost", tls_server.LocalAddress().port, std::move(config));
+			EXPECT_EQ(client.Get(U"/").status, EStatus::OK);
+		};
+
+		// a verifying connection must not resume the session of an unverified one, it would skip the certificate check
+		get(false);
+		get(true);
+		EXPECT_EQ(cache->Count(), 2U);
+		EXPECT_EQ(cache->HandshakeStats().n_full, 2U);
+		EXPECT_EQ(cache->HandshakeStats().n_resumed, 0U);
+
+		get(true);
+		get(false);
+		EXPECT_EQ(cache->HandshakeStats().n_full, 2U);
+		EXPECT_EQ(cache->HandshakeStats().n_resumed, 2U);
+	}
+
 	TEST(io_net_http, THttpClient_chunked_upload_download_and_trailer)
 	{
 		TTcpServer tcp_server;
@@ -1071,6 +1564,296 @@ namespace
 		EXPECT_EQ(raw_server.Join(), nullptr);
 	}
 
+	static void PoolTestResponse(THttpServer::response_t& response, const TStringView text)
+	{
+		const auto cstr = text.MakeCStr();
+		response.status = EStatus::OK;
+		response.body = el1::New<TListSource<byte_t>>(TList<byte_t>(reinterpret_cast<const byte_t*>(cstr.get()), strlen(cstr.get())));
+	}
+
+	static TString PoolTestBody(const TList<byte_t>& body)
+	{
+		return TString(std::string(reinterpret_cast<const char*>(body.ItemPtr(0)), body.Count()).c_str());
+	}
+
+	TEST(io_net_http, THttpClientPool_http1_reuse_and_cap)
+	{
+		TTcpServer tcp_server;
+		TList<port_t> client_ports;
+		usys_t n_active = 0;
+		usys_t max_active = 0;
+		THttpServer http_server(&tcp_server, [&](const THttpServer::request_t& request, THttpServer::response_t& response) {
+			EXPECT_EQ(request.version, EVersion::HTTP11);
+			if(!client_ports.Contains(request.remote_address.port))
+				client_ports.Append(request.remote_address.port);
+			max_active = el1::util::Max(max_active, ++n_active);
+			TFiber::Sleep(0.01);
+			n_active--;
+			PoolTestResponse(response, request.url);
+		}, THttpServer::EProtocol::HTTP1);
+
+		THttpClientPool::config_t config;
+		config.max_connections_per_origin = 2;
+		THttpClientPool pool(config);
+		const THttpClientPool::origin_t origin = { U"localhost", tcp_server.LocalAddress().port, false };
+
+		TList<std::unique_ptr<TFiber>> fibers;
+		for(usys_t i = 0; i < 6; i++)
+			fibers.MoveAppend(el1::New<TFiber>([&pool, &origin, i]() {
+				for(usys_t j = 0; j < 3; j++)
+				{
+					const TString url = TString::Format(U"/%d/%d", i, j);
+					const auto response = pool.Get(origin, url);
+					EXPECT_EQ(response.status, EStatus::OK);
+					EXPECT_EQ(PoolTestBody(response.body), url);
+				}
+			}));
+		for(auto& fiber : fibers)
+			EXPECT_EQ(fiber->Join(), nullptr);
+
+		EXPECT_EQ(client_ports.Count(), 2U);
+		EXPECT_EQ(max_active, 2U);
+		EXPECT_EQ(pool.CountConnections(), 2U);
+		EXPECT_EQ(pool.Stats().n_connects, 2U);
+		EXPECT_EQ(pool.Stats().n_reused, 16U);
+		EXPECT_GT(pool.Stats().n_waits, 0U);
+		EXPECT_EQ(pool.Stats().n_http2_requests, 0U);
+
+		// a connection the server closed while it was idle is replaced
+		THttpClientPool::request_t request;
+		request.url = U"/close";
+		request.header_fields.Set(U"Connection", U"close");
+		EXPECT_EQ(pool.Request(origin, request).status, EStatus::OK);
+		EXPECT_EQ(pool.CountConnections(), 1U);
+		EXPECT_EQ(pool.Get(origin, U"/again").status, EStatus::OK);
+		EXPECT_EQ(pool.Stats().n_connects, 2U);
+	}
+
+	TEST(io_net_http, THttpClientPool_https_http2_multiplexing)
+	{
+		TTcpServer tcp_server;
+		tls::server_config_t tls_config;
+		tls_config.certificate_chain = tls::TPemSource(TPath(U"support/tls-test-cert.pem"));
+		tls_config.private_key = tls::TPemSource(TPath(U"support/tls-test-key.pem"));
+		tls_config.application_protocols = { U"h2", U"http/1.1" };
+		tls::TServer tls_server(&tcp_server, std::move(tls_config));
+		usys_t n_active = 0;
+		usys_t max_active = 0;
+		THttpServer http_server(&tls_server, [&](const THttpServer::request_t& request, THttpServer::response_t& response) {
+			EXPECT_EQ(request.version, EVersion::HTTP20);
+			max_active = el1::util::Max(max_active, ++n_active);
+			usys_t n_body = 0;
+			if(request.body != nullptr)
+			{
+				byte_t buffer[4096];
+				while(!request.body->Complete())
+				{
+					const usys_t n = request.body->Read(buffer, sizeof(buffer));
+					if(n != 0)
+						n_body += n;
+					else if(const auto* const waitable = request.body->OnInputReady(); waitable != nullptr)
+						waitable->WaitFor();
+				}
+			}
+			TFiber::Sleep(0.02);
+			n_active--;
+			PoolTestResponse(response, n_body == 0 ? TString(request.url) : TString::Format(U"%d", n_body));
+		});
+
+		THttpClientPool::config_t config;
+		config.tls.ca_certificates = tls::TPemSource(TPath(U"support/tls-test-cert.pem"));
+		THttpClientPool pool(config);
+		const THttpClientPool::origin_t origin = { U"localhost", tls_server.LocalAddress().port, true };
+
+		TList<std::unique_ptr<TFiber>> fibers;
+		for(usys_t i = 0; i < 8; i++)
+			fibers.MoveAppend(el1::New<TFiber>([&pool, &origin, i]() {
+				const TString url = TString::Format(U"/stream/%d", i);
+				const auto response = pool.Get(origin, url);
+				EXPECT_EQ(response.status, EStatus::OK);
+				EXPECT_EQ(response.version, EVersion::HTTP20);
+				EXPECT_EQ(PoolTestBody(response.body), url);
+			}));
+		for(auto& fiber : fibers)
+			EXPECT_EQ(fiber->Join(), nullptr);
+
+		EXPECT_GT(max_active, 1U);
+		EXPECT_EQ(pool.CountConnections(), 1U);
+		EXPECT_EQ(pool.Stats().n_connects, 1U);
+		EXPECT_EQ(pool.Stats().n_http2_requests, 8U);
+
+		// the request body is larger than the initial HTTP/2 flow control window
+		TList<byte_t> upload;
+		upload.SetCount(200U * 1024U);
+		memset(upload.ItemPtr(0), 'u', upload.Count());
+		TArraySource<byte_t> upload_source(upload);
+		THttpClientPool::request_t request;
+		request.method = EMethod::POST;
+		request.url = U"/upload";
+		request.body = &upload_source;
+		request.content_length = upload.Count();
+		const auto response = pool.Request(origin, request);
+		EXPECT_EQ(PoolTestBody(response.body), U"204800");
+
+		// the limit cancels the stream, but not the connection
+		EXPECT_THROW(pool.Get(origin, U"/limited", nullptr, 4), IException);
+		EXPECT_EQ(pool.Get(origin, U"/after").status, EStatus::OK);
+		EXPECT_EQ(pool.Stats().n_connects, 1U);
+	}
+
+	TEST(io_net_http, THttpClientPool_idle_eviction)
+	{
+		// HTTP/1.1 and HTTP/2 with prior knowledge
+		for(const bool http2 : { false, true })
+		{
+			TTcpServer tcp_server;
+			THttpServer http_server(&tcp_server, [](const THttpServer::request_t& request, THttpServer::response_t& response) {
+				PoolTestResponse(response, request.url);
+			}, http2 ? THttpServer::EProtocol::HTTP2 : THttpServer::EProtocol::HTTP1);
+
+			THttpClientPool::config_t config;
+			config.idle_timeout = 0.05;
+			config.http2_prior_knowledge = http2;
+			THttpClientPool pool(config);
+			const THttpClientPool::origin_t origin = { U"localhost", tcp_server.LocalAddress().port, false };
+
+			const auto response = pool.Get(origin, U"/idle");
+			EXPECT_EQ(response.version, http2 ? EVersion::HTTP20 : EVersion::HTTP11);
+			EXPECT_EQ(pool.CountConnections(), 1U);
+			pool.EvictIdle();
+			EXPECT_EQ(pool.CountConnections(), 1U);
+
+			TFiber::Sleep(0.1);
+			pool.EvictIdle();
+			EXPECT_EQ(pool.CountConnections(), 0U);
+			EXPECT_EQ(pool.Stats().n_evicted, 1U);
+
+			EXPECT_EQ(pool.Get(origin, U"/idle").status, EStatus::OK);
+			EXPECT_EQ(pool.Stats().n_connects, 2U);
+			pool.Clear();
+			EXPECT_EQ(pool.CountConnections(), 0U);
+		}
+	}
+
+	TEST(io_net_http, THttpShardedServer_distributes_connections)
+	{
+		THttpShardedServer::config_t config;
+		config.n_shards = 4;
+		config.protocol = THttpServer::EProtocol::HTTP1;
+		THttpShardedServer server(ipaddr_t(U"127.0.0.1"), 0, [](const THttpServer::request_t& request, THttpServer::response_t& response) {
+			// the response tells which shard answered
+			PoolTestResponse(response, TString::Format(U"%s %s", TThread::Self()->Name(), request.url));
+		}, config);
+		EXPECT_EQ(server.CountShards(), 4U);
+		EXPECT_FALSE(server.IsSteeringByCpu());
+
+		// every client is a new connection, the kernel hashes them onto the four listening sockets
+		TList<TString> shards;
+		for(usys_t i = 0; i < 16; i++)
+		{
+			THttpClient client(U"127.0.0.1", server.LocalAddress().port);
+			const TString url = TString::Format(U"/%d", i);
+			const auto response = client.Get(url);
+			ASSERT_EQ(response.status, EStatus::OK);
+			const TString body = PoolTestBody(response.body);
+			ASSERT_TRUE(body.EndsWith(TString::Format(U" %s", url)));
+			const TString shard = body.SliceSL(0, body.Length() - url.Length() - 1);
+			EXPECT_TRUE(shard.BeginsWith(U"http-shard/"));
+			if(!shards.Contains(shard))
+				shards.Append(shard);
+
+			// keep-alive requests stay on the connection's shard
+			const auto again = client.Get(url);
+			EXPECT_EQ(PoolTestBody(again.body), body);
+		}
+		EXPECT_GT(shards.Count(), 1U);
+	}
+
+	TEST(io_net_http, THttpShardedServer_steer_by_cpu)
+	{
+		THttpShardedServer::config_t config;
+		const TList<usys_t> allowed = TThread::AllowedCpus();
+		config.n_shards = el1::util::Min<usys_t>(2, allowed.Count());
+		config.steer_by_cpu = true;
+		THttpShardedServer server(ipaddr_t(U"127.0.0.1"), 0, [](const THttpServer::request_t&, THttpServer::response_t& response) {
+			PoolTestResponse(response, TThread::Self()->Name());
+		}, config);
+		if(!server.IsSteeringByCpu())
+			GTEST_SKIP() << "SO_ATTACH_REUSEPORT_CBPF not supported by the kernel";
+
+		// loopback connections arrive on the CPU of the client, which selects the shard pinned to that CPU
+		const usys_t shard = config.n_shards - 1;
+		const usys_t cpu = allowed[shard];
+		const port_t port = server.LocalAddress().port;
+		TThread client(U"client", [shard, cpu, port]() {
+			TThread::Self()->PinToCpu(cpu);
+			for(usys_t i = 0; i < 8; i++)
+			{
+				THttpClient client(U"127.0.0.1", port);
+				const auto response = client.Get(U"/");
+				EXPECT_EQ(response.status, EStatus::OK);
+				EXPECT_EQ(PoolTestBody(response.body), TString::Format(U"http-shard/%d", (int)shard));
+			}
+		});
+		EXPECT_EQ(client.Join(), nullptr);
+	}
+
+	TEST(io_net_http, THttpShardedServer_restricted_affinity)
+	{
+		// the server is constructed on a thread which may only use the last allowed CPU, which is not CPU 0 on machines with more than one
+		const TList<usys_t> allowed = TThread::AllowedCpus();
+		ASSERT_GT(allowed.Count(), 0U);
+		const usys_t cpu = allowed[-1];
+
+		TThread runner(U"runner", [cpu]() {
+			TThread::Self()->PinToCpu(cpu);
+			ASSERT_EQ(TThread::AllowedCpus().Count(), 1U);
+
+			auto handler = [](const THttpServer::request_t&, THttpServer::response_t& response) {
+				PoolTestResponse(response, TString::Format(U"%s %d", TThread::Self()->Name(), (int)TThread::AllowedCpus()[0]));
+			};
+
+			// one shard per allowed CPU, pinned to it
+			{
+				THttpShardedServer::config_t config;
+				config.steer_by_cpu = true;
+				config.protocol = THttpServer::EProtocol::HTTP1;
+				THttpShardedServer server(ipaddr_t(U"127.0.0.1"), 0, handler, config);
+				EXPECT_EQ(server.CountShards(), 1U);
+				for(usys_t i = 0; i < 4; i++)
+				{
+					THttpClient client(U"127.0.0.1", server.LocalAddress().port);
+					const auto response = client.Get(U"/");
+					ASSERT_EQ(response.status, EStatus::OK);
+					EXPECT_EQ(PoolTestBody(response.body), TString::Format(U"http-shard/0 %d", (int)cpu));
+				}
+			}
+
+			// more shards than allowed CPUs, no steering, but every shard accepts
+			{
+				THttpShardedServer::config_t config;
+				config.n_shards = 3;
+				config.steer_by_cpu = true;
+				config.protocol = THttpServer::EProtocol::HTTP1;
+				THttpShardedServer server(ipaddr_t(U"127.0.0.1"), 0, handler, config);
+				EXPECT_FALSE(server.IsSteeringByCpu());
+
+				TList<TString> shards;
+				for(usys_t i = 0; i < 64 && shards.Count() < 3; i++)
+				{
+					THttpClient client(U"127.0.0.1", server.LocalAddress().port);
+					const auto response = client.Get(U"/");
+					ASSERT_EQ(response.status, EStatus::OK);
+					const TString body = PoolTestBody(response.body);
+					if(!shards.Contains(body))
+						shards.Append(body);
+				}
+				EXPECT_EQ(shards.Count(), 3U);
+			}
+		});
+		EXPECT_EQ(runner.Join(), nullptr);
+	}
+
 	TEST(io_net_http, THttpServer_curl_http2_prior_knowledge)
 	{
 		TTcpServer tcp_server;
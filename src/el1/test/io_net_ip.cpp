@@ -247,6 +247,110 @@ namespace
 		EXPECT_THROW({ const bool sent = sender.Send(ipport_t{ipaddr_t(U"::1"), 9U}, tx, sizeof(tx)); (void)sent; }, TInvalidArgumentException);
 	}
 
+	TEST(io_net_ip, TUdpSocket_batch_loopback)
+	{
+		TUdpSocket sender(ipaddr_t(U"127.0.0.1"));
+		TUdpSocket receiver(ipaddr_t(U"127.0.0.1"));
+
+		// more messages than one recvmmsg()/sendmmsg() chunk
+		TList<byte_t> payload;
+		payload.SetCount(100);
+		TList<udp_message_t> tx;
+		for(usys_t i = 0; i < 100; i++)
+		{
+			payload[i] = (byte_t)i;
+			tx.Append({ receiver.LocalAddress(), payload.Slice(i, 100 - i), 0, false });
+		}
+		EXPECT_EQ(sender.Send(tx), 100U);
+
+		TUdpReceiveArena arena(128, 256);
+		EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+		usys_t n_received = 0;
+		while(n_received < 100)
+		{
+			if(receiver.Receive(arena) == 0)
+			{
+				EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+				continue;
+			}
+
+			for(const udp_message_t& message : arena.Messages())
+			{
+				EXPECT_EQ(message.remote_address, sender.LocalAddress());
+				EXPECT_EQ(message.segment_size, 0U);
+				EXPECT_FALSE(message.truncated);
+				ASSERT_EQ(message.data.Count(), 100U - n_received);
+				EXPECT_EQ(memcmp(message.data.ItemPtr(0), payload.ItemPtr(n_received), message.data.Count()), 0);
+				n_received++;
+			}
+		}
+		EXPECT_EQ(receiver.Receive(arena), 0U);
+		EXPECT_EQ(arena.Messages().Count(), 0U);
+	}
+
+	TEST(io_net_ip, TUdpSocket_batch_truncates_to_slot_size)
+	{
+		TUdpSocket sender(ipaddr_t(U"127.0.0.1"));
+		TUdpSocket receiver(ipaddr_t(U"127.0.0.1"));
+		const byte_t tx[] = { 0,1,2,3,4,5,6,7,8,9 };
+
+		EXPECT_TRUE(sender.Send(receiver.LocalAddress(), tx, sizeof(tx)));
+		EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+
+		TUdpReceiveArena arena(4, 4);
+		ASSERT_EQ(receiver.Receive(arena), 1U);
+		EXPECT_TRUE(arena.Messages()[0].truncated);
+		ASSERT_EQ(arena.Messages()[0].data.Count(), 4U);
+		EXPECT_EQ(memcmp(arena.Messages()[0].data.ItemPtr(0), tx, 4), 0);
+	}
+
+	TEST(io_net_ip, TUdpSocket_segmentation_offload)
+	{
+		TUdpSocket sender(ipaddr_t(U"127.0.0.1"));
+		TUdpSocket receiver(ipaddr_t(U"127.0.0.1"));
+		TList<byte_t> payload;
+		payload.SetCount(450);
+		for(usys_t i = 0; i < payload.Count(); i++)
+			payload[i] = (byte_t)i;
+		const udp_message_t train = { receiver.LocalAddress(), payload, 100, false };
+		EXPECT_EQ(train.CountSegments(), 5U);
+		EXPECT_EQ(train.Segment(4).Count(), 50U);
+
+		// without GRO the receiver sees the individual datagrams
+		TUdpReceiveArena arena(16, 65536);
+		EXPECT_EQ(sender.Send(array_t<const udp_message_t>::FromUnsafePointer(&train, 1)), 1U);
+		EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+		usys_t n_received = 0;
+		while(n_received < 5)
+		{
+			if(receiver.Receive(arena) == 0)
+			{
+				EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+				continue;
+			}
+
+			for(const udp_message_t& message : arena.Messages())
+			{
+				ASSERT_EQ(message.data.Count(), train.Segment(n_received).Count());
+				EXPECT_EQ(memcmp(message.data.ItemPtr(0), train.Segment(n_received).ItemPtr(0), message.data.Count()), 0);
+				n_received++;
+			}
+		}
+
+		// with GRO the train arrives as one message
+		if(!receiver.ReceiveOffload(true))
+			GTEST_SKIP() << "UDP_GRO not supported by the kernel";
+		EXPECT_EQ(sender.Send(array_t<const udp_message_t>::FromUnsafePointer(&train, 1)), 1U);
+		EXPECT_TRUE(receiver.OnReceiveMsg().WaitFor(1));
+		ASSERT_EQ(receiver.Receive(arena), 1U);
+		const udp_message_t& message = arena.Messages()[0];
+		EXPECT_EQ(message.remote_address, sender.LocalAddress());
+		EXPECT_EQ(message.segment_size, 100U);
+		EXPECT_EQ(message.CountSegments(), 5U);
+		ASSERT_EQ(message.data.Count(), payload.Count());
+		EXPECT_EQ(memcmp(message.data.ItemPtr(0), payload.ItemPtr(0), payload.Count()), 0);
+	}
+
 	TEST(io_net_ip, TTcpServer_construct)
 	{
 		{
@@ -321,4 +425,48 @@ namespace
 			client.Close();
 		}
 	}
+
+	TEST(io_net_ip, TTcpClient_io_uring_echo)
+	{
+		const EIoBackend previous = TThread::Self()->IoBackend();
+		TThread::Self()->IoBackend(EIoBackend::IO_URING);
+
+		{
+			TTcpServer server(ipaddr_t(U"127.0.0.1"), 0);
+			const port_t port = server.LocalAddress().port;
+
+			TFiber fib_server([&](){
+				EXPECT_TRUE(server.OnClientConnect().WaitFor(5));
+				auto client = server.AcceptClient();
+				ASSERT_NE(client, nullptr);
+
+				byte_t buffer[64];
+				for(;;)
+				{
+					const usys_t r = client->BlockingRead(buffer, sizeof(buffer), 5);
+					if(r > 0)
+						client->WriteAll(buffer, r);
+					if(r < sizeof(buffer))
+						break;
+				}
+			});
+
+			TTcpClient client(ipaddr_t(U"127.0.0.1"), port);
+			byte_t request[64 * 16];
+			byte_t response[sizeof(request)];
+			for(usys_t i = 0; i < sizeof(request); i++)
+				request[i] = (byte_t)(i * 13);
+
+			client.WriteAll(request, sizeof(request));
+			client.ReadAll(response, sizeof(response));
+			EXPECT_EQ(memcmp(request, response, sizeof(request)), 0);
+
+			// the server sees EOF, answers nothing and closes
+			client.CloseOutput();
+			EXPECT_EQ(client.BlockingRead(response, sizeof(response), 5), 0U);
+			EXPECT_EQ(fib_server.Join(), nullptr);
+		}
+
+		TThread::Self()->IoBackend(previous);
+	}
 }
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <el1/io_serialization_json.hpp>
 #include <el1/io_serialization_binary.hpp>
+#include <el1/io_serialization_binary_mapped.hpp>
+#include <el1/io_stream_buffer.hpp>
 
 using namespace ::testing;
 using namespace el1;
@@ -94,6 +96,65 @@ namespace
 		return value;
 	}
 
+	template<typename T>
+	TList<byte_t> ToStreamBytes(const T& value)
+	{
+		TList<byte_t> bytes;
+		TListSink<byte_t> sink(&bytes);
+		json::ToStream(sink, value);
+		return bytes;
+	}
+
+	template<typename T>
+	T FromStreamBytes(const TList<byte_t>& bytes, const TDeserializeOptions& options = {})
+	{
+		auto source = bytes.Source();
+		return json::FromStream<T>(source, options);
+	}
+
+	TList<byte_t> Utf8Bytes(const TString& text)
+	{
+		const auto c_str = text.MakeCStr();
+		return TList<byte_t>((const byte_t*)c_str.get(), strlen(c_str.get()));
+	}
+
+	// hands out at most 7 bytes per Read()
+	struct TTrickleSource : io::stream::ISource<byte_t>
+	{
+		array_t<const byte_t> bytes;
+		usys_t pos = 0;
+
+		usys_t Read(byte_t* const arr_items, const usys_t n_items_max) final override
+		{
+			const usys_t n = util::Min<usys_t>(util::Min<usys_t>(n_items_max, 7), bytes.Count() - pos);
+			if(n != 0)
+				memcpy(arr_items, bytes.Data() + pos, n);
+			pos += n;
+			return n;
+		}
+
+		TTrickleSource(const array_t<const byte_t> bytes) : bytes(bytes) {}
+	};
+
+	void ExpectSameRoot(const serialization_test::TRoot& decoded, const serialization_test::TRoot& source)
+	{
+		EXPECT_EQ(decoded.big, source.big);
+		EXPECT_EQ(decoded.count, source.count);
+		EXPECT_DOUBLE_EQ(decoded.ratio, source.ratio);
+		EXPECT_EQ(decoded.title, source.title);
+		ASSERT_EQ(decoded.children.Count(), source.children.Count());
+		for(usys_t i = 0; i < source.children.Count(); i++)
+		{
+			EXPECT_EQ(decoded.children[i].id, source.children[i].id);
+			EXPECT_EQ(decoded.children[i].name, source.children[i].name);
+		}
+		EXPECT_EQ(decoded.scores.Items().Count(), source.scores.Items().Count());
+		EXPECT_EQ(decoded.scores[TString(U"beta")], source.scores[TString(U"beta")]);
+		EXPECT_EQ(decoded.note, source.note);
+		EXPECT_EQ(decoded.mode, source.mode);
+		EXPECT_EQ(decoded.added_in_v2, source.added_in_v2);
+	}
+
 	TEST(io_serialization, SchemaMemberMacroUsesEnclosingTypeAndForwardsMetadata)
 	{
 		constexpr auto members = TSchema<serialization_test::TRoot>::Members();
@@ -153,6 +214,33 @@ namespace
 		EXPECT_EQ(target.added_in_v2, 777);
 	}
 
+	TEST(io_serialization, JsonMapsSpanningSeveralChunks)
+	{
+		TSortedMap<TString, TSortedMap<TString, s32_t>> source;
+		for(s32_t i = 0; i < 3; i++)
+		{
+			TSortedMap<TString, s32_t> inner;
+			for(s32_t j = 0; j < 2000; j++)
+				inner.Add(TString::Format(U"k%d", j), i * 10000 + j);
+			source.Add(TString::Format(U"m%d", i), std::move(inner));
+		}
+
+		const auto decoded = json::FromValue<TSortedMap<TString, TSortedMap<TString, s32_t>>>(json::ToValue(source));
+		ASSERT_EQ(decoded.Items().Count(), 3U);
+		for(const auto& outer : decoded.Items())
+		{
+			const auto& expected = source[outer.key];
+			ASSERT_EQ(outer.value.Items().Count(), expected.Items().Count());
+			auto it = expected.Items().begin();
+			for(const auto& item : outer.value.Items())
+			{
+				EXPECT_EQ(item.key, it->key);
+				EXPECT_EQ(item.value, it->value);
+				++it;
+			}
+		}
+	}
+
 	TEST(io_serialization, TypeMismatchRejected)
 	{
 		const TJsonValue json = json::ToValue(Sample());
@@ -224,4 +312,244 @@ namespace
 		const TString text = info.id.ToString();
 		EXPECT_EQ(TTypeId::FromString(text.View()), info.id);
 	}
+
+	TEST(io_serialization, JsonStreamRoundTrip)
+	{
+		auto source = Sample();
+		source.ratio = 0.1;
+		source.children.Append({-9, TString(U"quote \" backslash \\ newline \n tab \t bell \x07 café 😀")});
+		source.children.Append({0, TString()});
+
+		const TList<byte_t> bytes = ToStreamBytes(source);
+		const char prefix[] = "{\"$el1\":{\"format\":1,\"type\":\"serialization_test::TRoot\",\"type_id\":\"";
+		ASSERT_GT(bytes.Count(), sizeof(prefix));
+		EXPECT_EQ(memcmp(&bytes[0], prefix, sizeof(prefix) - 1), 0);
+
+		// same document as the DOM writer, apart from the order of the keys
+		EXPECT_EQ(TJsonValue::Parse(bytes).ToString(), json::ToString(source));
+
+		ExpectSameRoot(FromStreamBytes<serialization_test::TRoot>(bytes), source);
+	}
+
+	TEST(io_serialization, JsonStreamReaderAcceptsSortedKeys)
+	{
+		// TWriter emits the keys sorted by name, so most fields arrive before they are asked for
+		const auto source = Sample();
+		ExpectSameRoot(FromStreamBytes<serialization_test::TRoot>(Utf8Bytes(json::ToString(source))), source);
+
+		auto no_note = source;
+		no_note.note.reset();
+		ExpectSameRoot(FromStreamBytes<serialization_test::TRoot>(Utf8Bytes(json::ToString(no_note))), no_note);
+	}
+
+	TEST(io_serialization, JsonStreamOlderSchemaAndUnknownKeys)
+	{
+		TJsonValue json = json::ToValue(Sample());
+		json.Map()[TString(U"$el1")].Map()[TString(U"version")] = (s64_t)1;
+		json.Map().Remove(TString(U"added_in_v2"));
+		json.Map().Add(TString(U"unknown"), TJsonValue::Parse(U"{\"x\":[1,{\"y\":null}],\"z\":\"w\"}"));
+
+		serialization_test::TRoot target;
+		target.added_in_v2 = 777;
+		const TList<byte_t> dom_bytes = Utf8Bytes(json.ToString());
+		auto input = dom_bytes.Source();
+		json::FromStream(input, target);
+		EXPECT_EQ(target.big, std::numeric_limits<s64_t>::max());
+		EXPECT_EQ(target.children.Count(), 2U);
+		EXPECT_EQ(target.added_in_v2, 777);
+
+		// unknown keys between the fields of the stream writer
+		const TList<byte_t> bytes = ToStreamBytes(Sample());
+		std::string text((const char*)&bytes[0], bytes.Count());
+		text.insert(text.find(",\"big\":"), ",\"unknown\":{\"x\":[1,{\"y\":null}]},\"$el2\":7");
+		text.insert(text.rfind('}'), ",\"zzz\":[[],{}]");
+		const auto decoded = FromStreamBytes<serialization_test::TRoot>(TList<byte_t>((const byte_t*)text.data(), text.size()));
+		ExpectSameRoot(decoded, Sample());
+	}
+
+	TEST(io_serialization, JsonStreamRejectsMismatchesAndLimits)
+	{
+		const TList<byte_t> bytes = ToStreamBytes(Sample());
+		EXPECT_THROW(FromStreamBytes<serialization_test::TChild>(bytes), error::TException);
+
+		TDeserializeOptions options;
+		options.max_container_items = 1;
+		EXPECT_THROW(FromStreamBytes<serialization_test::TRoot>(bytes, options), error::TException);
+
+		options = {};
+		options.max_depth = 1;
+		EXPECT_THROW(FromStreamBytes<serialization_test::TRoot>(bytes, options), error::TException);
+
+		TJsonValue json = json::ToValue(Sample());
+		json.Map()[TString(U"count")] = TString(U"42");
+		EXPECT_THROW(FromStreamBytes<serialization_test::TRoot>(Utf8Bytes(json.ToString())), error::TException);
+		json.Map().Remove(TString(U"$el1"));
+		EXPECT_THROW(FromStreamBytes<serialization_test::TRoot>(Utf8Bytes(json.ToString())), error::TException);
+
+		EXPECT_THROW(ToStreamBytes(std::numeric_limits<double>::quiet_NaN()), error::TException);
+	}
+
+	TEST(io_serialization, PackedBinaryEncoding)
+	{
+		const serialization_test::TChild child{300, TString(U"é")};
+		const auto bytes = binary::packed::ToBytes(child);
+		const auto id = TSchema<serialization_test::TChild>::Info().id;
+		ASSERT_EQ(bytes.Count(), 4U + 1U + 16U + 1U + 2U + 3U);
+		EXPECT_EQ(bytes[4], 1U);
+		for(unsigned i = 0; i < 8; i++)
+		{
+			EXPECT_EQ(bytes[5 + i], (byte_t)(id.high >> (i * 8)));
+			EXPECT_EQ(bytes[13 + i], (byte_t)(id.low >> (i * 8)));
+		}
+		EXPECT_EQ(bytes[21], 1U);
+		EXPECT_EQ(bytes[22], 0xd8U);	// zigzag(300) = 600
+		EXPECT_EQ(bytes[23], 0x04U);
+		EXPECT_EQ(bytes[24], 2U);
+		EXPECT_EQ(bytes[25], 0xc3U);
+		EXPECT_EQ(bytes[26], 0xa9U);
+	}
+
+	TEST(io_serialization, PackedBinaryBufferedAndInPlaceReaders)
+	{
+		TList<serialization_test::TChild> source;
+		for(s32_t i = 0; i < 3000; i++)
+		{
+			TString name = TString::Format(U"child %d äöü 😀", i);
+			// strings too long for the write buffer take the counting path
+			if(i % 1000 == 1)
+				while(name.Length() < 3000)
+					name += U"日本語 ";
+			source.Append({i * 7919 - 1000000, name});
+		}
+
+		const auto bytes = binary::packed::ToBytes(source);
+		const auto in_place = binary::packed::FromBytes<TList<serialization_test::TChild>>(bytes);
+		TTrickleSource trickle(bytes);
+		const auto buffered = binary::packed::Deserialize<TList<serialization_test::TChild>>(trickle);
+		EXPECT_EQ(trickle.pos, bytes.Count());
+
+		ASSERT_EQ(in_place.Count(), source.Count());
+		ASSERT_EQ(buffered.Count(), source.Count());
+		for(usys_t i = 0; i < source.Count(); i++)
+		{
+			EXPECT_EQ(in_place[i].id, source[i].id);
+			EXPECT_EQ(in_place[i].name, source[i].name);
+			EXPECT_EQ(buffered[i].id, source[i].id);
+			EXPECT_EQ(buffered[i].name, source[i].name);
+		}
+
+		EXPECT_ANY_THROW(binary::packed::FromBytes<TList<serialization_test::TChild>>(bytes.Slice(0, bytes.Count() - 3)));
+		TTrickleSource truncated(bytes.Slice(0, bytes.Count() - 3));
+		EXPECT_ANY_THROW(binary::packed::Deserialize<TList<serialization_test::TChild>>(truncated));
+	}
+
+	TEST(io_serialization, PackedBinaryValuesInSequence)
+	{
+		TList<byte_t> bytes;
+		TListSink<byte_t> sink(&bytes);
+		for(s32_t i = 0; i < 3; i++)
+			binary::packed::Serialize(sink, serialization_test::TChild{i, TString::Format(U"child %d", i)});
+
+		auto expect_sequence = [](auto& source)
+		{
+			for(s32_t i = 0; i < 3; i++)
+			{
+				const auto child = binary::packed::Deserialize<serialization_test::TChild>(source);
+				EXPECT_EQ(child.id, i);
+				EXPECT_EQ(child.name, TString::Format(U"child %d", i));
+			}
+		};
+
+		TTrickleSource trickle(bytes);
+		expect_sequence(trickle);
+		EXPECT_EQ(trickle.pos, bytes.Count());
+
+		auto list_source = bytes.Source();
+		expect_sequence(list_source);
+		EXPECT_EQ(list_source.Count(), 0U);
+
+		TTrickleSource unbuffered(bytes);
+		io::stream::buffer::TPullBuffer<byte_t> pull(&unbuffered);
+		expect_sequence(pull);
+		EXPECT_EQ(pull.Count(), 0U);
+	}
+
+	TEST(io_serialization, MappedBinaryRoundTrip)
+	{
+		const auto source = Sample();
+		const auto bytes = binary::mapped::ToBytes(source);
+		EXPECT_EQ(bytes.Count() % 8, 0U);
+		ExpectSameRoot(binary::mapped::FromBytes<serialization_test::TRoot>(bytes), source);
+
+		auto empty = source;
+		empty.note.reset();
+		empty.children.Clear();
+		const auto decoded = binary::mapped::FromBytes<serialization_test::TRoot>(binary::mapped::ToBytes(empty));
+		EXPECT_FALSE(decoded.note.has_value());
+		EXPECT_EQ(decoded.children.Count(), 0U);
+
+		EXPECT_EQ(binary::mapped::FromBytes<s64_t>(binary::mapped::ToBytes((s64_t)-5)), -5);
+		EXPECT_EQ(binary::mapped::FromBytes<TString>(binary::mapped::ToBytes(TString(U"äöü 😀"))), TString(U"äöü 😀"));
+	}
+
+	TEST(io_serialization, MappedBinaryRandomAccess)
+	{
+		using serialization_test::TRoot;
+		using serialization_test::TChild;
+
+		auto source = Sample();
+		source.children.Clear();
+		for(s32_t i = 0; i < 10000; i++)
+			source.children.Append({i * 3, TString::Format(U"child %d 日本語", i)});
+
+		const auto bytes = binary::mapped::ToBytes(source);
+		const binary::mapped::TImage image(bytes);
+		const binary::mapped::TView<TRoot> root(image);
+
+		EXPECT_EQ(root.Version(), 2U);
+		EXPECT_TRUE(root.Has<&TRoot::added_in_v2>());
+		EXPECT_EQ(root.Field<&TRoot::big>().Load(), source.big);
+		EXPECT_EQ(root.Field<&TRoot::mode>().Load(), serialization_test::EMode::ON);
+		EXPECT_EQ(root.Field<&TRoot::title>().Utf8().Count(), Utf8Bytes(source.title).Count());
+		EXPECT_EQ(memcmp(root.Field<&TRoot::title>().Utf8().Data(), Utf8Bytes(source.title).Data(), Utf8Bytes(source.title).Count()), 0);
+
+		const auto children = root.Field<&TRoot::children>();
+		ASSERT_EQ(children.Count(), 10000U);
+		EXPECT_EQ(children[7777].Field<&TChild::id>().Load(), 7777 * 3);
+		EXPECT_EQ(children[7777].Field<&TChild::name>().Load(), TString(U"child 7777 日本語"));
+		EXPECT_EQ(children[9999].Load().name, TString(U"child 9999 日本語"));
+		EXPECT_ANY_THROW(children[10000]);
+
+		const auto scores = root.Field<&TRoot::scores>();
+		ASSERT_EQ(scores.Count(), 2U);
+		EXPECT_EQ(scores.Key(0).Load(), TString(U"alpha"));
+		EXPECT_EQ(scores.Value(1).Load(), -7);
+		ASSERT_TRUE(scores.Find(U"beta").has_value());
+		EXPECT_EQ(scores.Find(U"beta")->Load(), -7);
+		EXPECT_EQ(scores.Find(U"alpha")->Load(), 11);
+		EXPECT_FALSE(scores.Find(U"gamma").has_value());
+		EXPECT_FALSE(scores.Find(U"").has_value());
+
+		const auto note = root.Field<&TRoot::note>();
+		ASSERT_TRUE(note.HasValue());
+		EXPECT_EQ(note.Value().Load(), TString(U"optional"));
+	}
+
+	TEST(io_serialization, MappedBinaryRejectsCorruptInput)
+	{
+		const auto bytes = binary::mapped::ToBytes(Sample());
+		EXPECT_ANY_THROW(binary::mapped::FromBytes<serialization_test::TRoot>(bytes.Slice(0, bytes.Count() - 8)));
+		EXPECT_ANY_THROW(binary::mapped::FromBytes<serialization_test::TRoot>(bytes.Slice(0, 16)));
+		EXPECT_ANY_THROW(binary::mapped::FromBytes<serialization_test::TChild>(bytes));
+
+		// the root must lie below the footer
+		TList<byte_t> forward = bytes;
+		const u64_t data_end = forward.Count() - binary::mapped::FOOTER_SIZE;
+		memcpy(forward.Data() + data_end, &data_end, 8);
+		EXPECT_ANY_THROW(binary::mapped::FromBytes<serialization_test::TRoot>(forward));
+
+		TDeserializeOptions options;
+		options.max_string_length = 4;
+		EXPECT_ANY_THROW(binary::mapped::FromBytes<serialization_test::TRoot>(bytes, options));
+	}
 }
@@ -2,6 +2,10 @@
 #include <el1/io_stream.hpp>
 #include <el1/io_stream_buffer.hpp>
 #include <el1/io_collection_list.hpp>
+#include <el1/io_file.hpp>
+#include <el1/io_net_ip.hpp>
+#include <el1/system_task.hpp>
+#include <string.h>
 
 using namespace ::testing;
 
@@ -92,5 +96,121 @@ namespace
 		EXPECT_EQ(buffered[1], 8U);
 	}
 
+	TEST(io_stream, NextBatch)
+	{
+		TList<u32_t> list;
+		for(u32_t i = 0; i < 10000; i++)
+			list.Append(i);
+		const TList<u32_t>& values = list;
+
+		// array pipes hand out slices of the array itself
+		{
+			auto pipe = values.Pipe();
+			u32_t buffer[100];
+			const u32_t* batch;
+			EXPECT_EQ(pipe.NextBatch(buffer, 100, batch), 100U);
+			EXPECT_EQ(batch, values.ItemPtr(0));
+			EXPECT_EQ(*pipe.NextItem(), 100U);
+			EXPECT_EQ(pipe.NextBatch(buffer, 100, batch), 100U);
+			EXPECT_EQ(batch[0], 101U);
+		}
+
+		// single items and batches can be mixed through every stage
+		{
+			auto pipe = values.Pipe().Filter([](const u32_t v) { return v % 3 == 0; }).Map([](const u32_t v) { return (u64_t)v * 2; }).Limit(1000);
+			TList<u64_t> collected;
+			u64_t buffer[7];
+			for(;;)
+			{
+				const u64_t* const item = pipe.NextItem();
+				if(item == nullptr)
+					break;
+				collected.Append(*item);
+
+				u64_t* batch;
+				const usys_t n = pipe.NextBatch(buffer, 7, batch);
+				collected.Append(batch, n);
+			}
+
+			ASSERT_EQ(collected.Count(), 1000U);
+			for(usys_t i = 0; i < collected.Count(); i++)
+				EXPECT_EQ(collected[i], i * 6U);
+		}
 
+		EXPECT_EQ(values.Pipe().Filter([](const u32_t v) { return v % 2 == 0; }).Count(), (iosize_t)5000);
+
+		{
+			TList<u32_t> output;
+			TListSink<u32_t> sink(&output);
+			EXPECT_EQ(Concat(values.Pipe(), values.Pipe().Limit(5)).ToStream(sink), (iosize_t)10005);
+			ASSERT_EQ(output.Count(), 10005U);
+			EXPECT_EQ(output[9999], 9999U);
+			EXPECT_EQ(output[10000], 0U);
+			EXPECT_EQ(output[10004], 4U);
+		}
+
+		// pipes over a source
+		{
+			TListSource<u32_t> source { TList<u32_t>(values) };
+			auto pipe = source.Pipe();
+			EXPECT_EQ(*pipe.NextItem(), 0U);
+			u32_t buffer[10];
+			u32_t* batch;
+			EXPECT_EQ(pipe.NextBatch(buffer, 10, batch), 10U);
+			EXPECT_EQ(batch[0], 1U);
+
+			const TList<u32_t> rest = pipe.Collect();
+			ASSERT_EQ(rest.Count(), 10000U - 11U);
+			EXPECT_EQ(rest[0], 11U);
+			EXPECT_EQ(rest[rest.Count() - 1], 9999U);
+		}
+
+		// pipes as a source
+		{
+			auto pipe = values.Pipe().Map([](const u32_t v) { return v + 1; });
+			u32_t buffer[300];
+			EXPECT_EQ(pipe.Read(buffer, 300), 300U);
+			EXPECT_EQ(buffer[0], 1U);
+			EXPECT_EQ(buffer[299], 300U);
+		}
+	}
+
+	TEST(io_stream, Pump_kernel)
+	{
+		using namespace el1::io::file;
+		using namespace el1::io::net::ip;
+		using namespace el1::system::task;
+
+		TList<byte_t> data;
+		data.SetCount(300000);
+		for(usys_t i = 0; i < data.Count(); i++)
+			data[i] = (byte_t)(i * 13);
+
+		// file to socket goes through sendfile(), socket to file through a pipe with splice()
+		TFile source;
+		source.WriteAll(data.ItemPtr(0), data.Count());
+		source.Offset(1000, ESeekOrigin::START);
+
+		TTcpServer server(ipaddr_t(U"127.0.0.1"), 0);
+		TTcpClient client(ipaddr_t(U"127.0.0.1"), server.LocalAddress().port);
+		server.OnClientConnect().WaitFor();
+		std::unique_ptr<TTcpClient> accepted = server.AcceptClient();
+		ASSERT_NE(accepted, nullptr);
+
+		TFiber sender([&source, &client]() {
+			EXPECT_EQ(Pump<byte_t>(source, client, 200000, true), 200000U);
+			client.Close();
+		});
+
+		TFile received;
+		EXPECT_EQ(Pump<byte_t>(*accepted, received, (iosize_t)-1, true), 200000U);
+		EXPECT_EQ(sender.Join(), nullptr);
+		EXPECT_EQ(source.Offset(), 201000U);
+
+		TList<byte_t> copy;
+		copy.SetCount(200000);
+		received.Offset(0, ESeekOrigin::START);
+		received.ReadAll(copy.ItemPtr(0), copy.Count());
+		EXPECT_EQ(memcmp(copy.ItemPtr(0), data.ItemPtr(1000), copy.Count()), 0);
+	}
 }
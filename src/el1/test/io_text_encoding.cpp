@@ -2,6 +2,7 @@
 #include <el1/io_text.hpp>
 #include <el1/io_text_encoding.hpp>
 #include <el1/io_text_encoding_utf8.hpp>
+#include <el1/io_collection_array.hpp>
 #include <el1/io_collection_list.hpp>
 
 using namespace ::testing;
@@ -11,6 +12,7 @@ namespace
 	using namespace el1::io::text;
 	using namespace el1::io::text::encoding;
 	using namespace el1::io::text::encoding::utf8;
+	using namespace el1::io::collection::array;
 	using namespace el1::io::collection::list;
 
 	TEST(io_text_encoding_utf8, TUTF8Decoder)
@@ -80,6 +82,302 @@ namespace
 		}
 	}
 
+	TEST(io_text_encoding_utf8, TUTF8Decoder_Batches)
+	{
+		// several batches long, with sequences cut off at the batch boundaries
+		const char32_t chars[] = { 0x79U, 0x00E4U, 0x20ACU, 0x1D11EU, 0x41U, 0x42U, 0x43U, 0x44U, 0x45U, 0x46U, 0x47U, 0x48U, 0x49U };
+		TList<char32_t> text;
+		for(usys_t i = 0; i < 5000; i++)
+			text.Append(chars[(i * 7 + i / 13) % 13]);
+
+		const TList<byte_t> utf8_data = text.Pipe().Transform(TUTF8Encoder()).Collect();
+		const TList<char32_t> batched = utf8_data.Pipe().Transform(TUTF8Decoder()).Collect();
+		TList<char32_t> single;
+		utf8_data.Pipe().Transform(TUTF8Decoder()).ForEach([&single](const char32_t chr) { single.Append(chr); });
+
+		ASSERT_EQ(batched.Count(), text.Count());
+		ASSERT_EQ(single.Count(), text.Count());
+		for(usys_t i = 0; i < text.Count(); i++)
+		{
+			EXPECT_EQ(batched[i], text[i]);
+			EXPECT_EQ(single[i], text[i]);
+		}
+
+		// both paths report the position of the offending byte
+		TList<byte_t> invalid;
+		for(usys_t i = 0; i < 3000; i++)
+			invalid.Append(i == 2000 ? 0xA4U : 0x79U);
+
+		try
+		{
+			(void)invalid.Pipe().Transform(TUTF8Decoder()).Collect();
+			FAIL();
+		}
+		catch(const TInvalidUtf8SequenceException& e)
+		{
+			EXPECT_EQ(e.index, 2000U);
+		}
+
+		try
+		{
+			invalid.Pipe().Transform(TUTF8Decoder()).ForEach([](const char32_t) {});
+			FAIL();
+		}
+		catch(const TInvalidUtf8SequenceException& e)
+		{
+			EXPECT_EQ(e.index, 2000U);
+		}
+	}
+
+	TEST(io_text_encoding_utf8, Bulk)
+	{
+		// every length up to two AVX2 blocks, with the multi-byte sequences at every position
+		const char32_t chars[] = { 0x79U, 0x00E4U, 0x20ACU, 0x1D11EU, 0x10FFFFU };
+		for(usys_t length = 0; length <= 70; length++)
+			for(usys_t k = 0; k < 5; k++)
+			{
+				TList<char32_t> text;
+				for(usys_t i = 0; i < length; i++)
+					text.Append(i == length / 2 || i % 37 == 36 ? chars[k] : (char32_t)(0x20U + i));
+
+				const TList<byte_t> utf8_pipe = text.Pipe().Transform(TUTF8Encoder()).Collect();
+				const TList<byte_t> utf8_bulk = EncodeUTF8(text);
+				ASSERT_EQ(utf8_bulk.Count(), utf8_pipe.Count());
+				for(usys_t i = 0; i < utf8_pipe.Count(); i++)
+					EXPECT_EQ(utf8_bulk[i], utf8_pipe[i]);
+
+				const TList<char32_t> decoded = DecodeUTF8(utf8_bulk);
+				ASSERT_EQ(decoded.Count(), text.Count());
+				for(usys_t i = 0; i < text.Count(); i++)
+					EXPECT_EQ(decoded[i], text[i]);
+			}
+
+		// several validation chunks, with the sequences crossing the chunk boundaries
+		{
+			TList<char32_t> text;
+			for(usys_t i = 0; i < 7000; i++)
+				text.Append(chars[(i * 3 + i / 7) % 5]);
+
+			TList<byte_t> utf8_data = EncodeUTF8(text);
+			const TList<char32_t> decoded = DecodeUTF8(utf8_data);
+			ASSERT_EQ(decoded.Count(), text.Count());
+			for(usys_t i = 0; i < text.Count(); i++)
+				EXPECT_EQ(decoded[i], text[i]);
+
+			// a surrogate in the third chunk
+			usys_t index = 9000;
+			while(utf8_data[index] >= 0x80)
+				index++;
+			utf8_data[index] = 0xEDU;
+			utf8_data[index + 1] = 0xB0U;
+			utf8_data[index + 2] = 0x80U;
+			try
+			{
+				(void)DecodeUTF8(utf8_data);
+				FAIL();
+			}
+			catch(const TInvalidUtf8SequenceException& e)
+			{
+				EXPECT_EQ(e.index, index + 1);
+			}
+		}
+
+		// a sequence cut off at the end of the input is left over
+		{
+			const byte_t bytes[] = { 0x79U, 0xE2U, 0x82U };
+			char32_t out[3];
+			usys_t n_chars;
+			EXPECT_EQ(DecodeUTF8(bytes, 3, out, n_chars), 1U);
+			EXPECT_EQ(n_chars, 1U);
+			EXPECT_THROW(DecodeUTF8(array_t<const byte_t>(bytes)), el1::io::stream::TStreamDryException);
+		}
+
+		// the encoders report the index of the character which cannot be encoded
+		{
+			TList<char32_t> text;
+			for(usys_t i = 0; i < 100; i++)
+				text.Append(i == 77 ? 0x400000U : 0x41U);
+
+			try
+			{
+				(void)EncodeUTF8(text);
+				FAIL();
+			}
+			catch(const TInvalidUtf8SequenceException& e)
+			{
+				EXPECT_EQ(e.index, 77U);
+				EXPECT_EQ(e.dir, EDirection::ENCODING);
+			}
+
+			try
+			{
+				(void)text.Pipe().Transform(TUTF8Encoder()).Collect();
+				FAIL();
+			}
+			catch(const TInvalidUtf8SequenceException& e)
+			{
+				EXPECT_EQ(e.index, 77U);
+			}
+		}
+	}
+
+	TEST(io_text_encoding_utf8, Exceptions)
+	{
+		// bulk, batched and single item decoding report the same position of the offending byte and the bytes of its sequence
+		const auto expect_error = [](const TList<byte_t>& bytes, const iosize_t index, const usys_t n_bytes_buffer, const ESequenceType seqtype)
+		{
+			for(int path = 0; path < 3; path++)
+			{
+				try
+				{
+					if(path == 0)
+						(void)DecodeUTF8(bytes);
+					else if(path == 1)
+						(void)bytes.Pipe().Transform(TUTF8Decoder()).Collect();
+					else
+						bytes.Pipe().Transform(TUTF8Decoder()).ForEach([](const char32_t) {});
+					ADD_FAILURE() << "no exception on path " << path;
+				}
+				catch(const TInvalidUtf8SequenceException& e)
+				{
+					EXPECT_EQ(e.index, index) << "path " << path;
+					EXPECT_EQ(e.dir, EDirection::DECODING);
+					EXPECT_EQ((usys_t)e.n_bytes_buffer, n_bytes_buffer) << "path " << path;
+					EXPECT_EQ((usys_t)e.n_bytes_processed, n_bytes_buffer - 1) << "path " << path;
+					EXPECT_EQ((unsigned)e.seqtype_current, (unsigned)seqtype) << "path " << path;
+					EXPECT_EQ(e.buffer[0], bytes[index + 1 - n_bytes_buffer]) << "path " << path;
+					EXPECT_EQ(e.buffer[n_bytes_buffer - 1], bytes[index]) << "path " << path;
+				}
+			}
+		};
+
+		// stray follow byte behind a long run of ASCII
+		TList<byte_t> bytes;
+		for(usys_t i = 0; i < 100; i++)
+			bytes.Append(0x61U);
+		bytes.Append(0xA4U);
+		expect_error(bytes, 100, 1, ESequenceType::NONE);
+
+		// 4-byte sequence broken by an ASCII character
+		bytes.Clear();
+		for(usys_t i = 0; i < 1500; i++)
+			bytes.Append(0x61U);
+		bytes.Append(0xF0U);
+		bytes.Append(0x9DU);
+		bytes.Append(0x84U);
+		bytes.Append(0x79U);
+		expect_error(bytes, 1503, 4, ESequenceType::START_BYTE_4);
+
+		// 3-byte sequence broken by another start byte across the first batch boundary
+		bytes.Clear();
+		for(usys_t i = 0; i < 1023; i++)
+			bytes.Append(0x61U);
+		bytes.Append(0xE2U);
+		bytes.Append(0xC3U);
+		bytes.Append(0xA4U);
+		expect_error(bytes, 1024, 2, ESequenceType::START_BYTE_3);
+
+		// ill-formed sequences behind multi-byte text: overlong, surrogate, above U+10FFFF and a byte which starts nothing
+		const TList<byte_t> ill_formed[] = { { 0xC0U, 0xAFU }, { 0xE0U, 0x80U, 0xAFU }, { 0xEDU, 0xA0U, 0x80U }, { 0xF0U, 0x80U, 0x80U, 0xAFU }, { 0xF4U, 0x90U, 0x80U, 0x80U }, { 0xF8U, 0x88U, 0x80U, 0x80U } };
+		const usys_t ill_formed_index[] = { 0, 1, 1, 1, 1, 0 };
+		for(usys_t k = 0; k < 6; k++)
+		{
+			bytes.Clear();
+			for(usys_t i = 0; i < 37 * (k + 1); i++)
+			{
+				bytes.Append(0xC3U);
+				bytes.Append(0xA4U);
+			}
+			const usys_t start = bytes.Count();
+			bytes.Append(ill_formed[k]);
+			bytes.Append(0x79U);
+			expect_error(bytes, start + ill_formed_index[k], ill_formed_index[k] + 1, ill_formed_index[k] == 0 ? ESequenceType::NONE : IdentifyByteType(ill_formed[k][0]));
+		}
+	}
+
+	// well-formed byte sequences as listed by table 3-7 of the unicode standard, returns the position of the first offending byte or n_bytes
+	usys_t FirstIllFormedByte(const byte_t* const arr_bytes, const usys_t n_bytes)
+	{
+		usys_t i = 0;
+		while(i < n_bytes)
+		{
+			const byte_t b = arr_bytes[i];
+			unsigned n_follow;
+			byte_t min = 0x80, max = 0xBF;
+			if(b <= 0x7F)
+				n_follow = 0;
+			else if(b >= 0xC2 && b <= 0xDF)
+				n_follow = 1;
+			else if(b == 0xE0)
+			{
+				n_follow = 2;
+				min = 0xA0;
+			}
+			else if((b >= 0xE1 && b <= 0xEC) || b == 0xEE || b == 0xEF)
+				n_follow = 2;
+			else if(b == 0xED)
+			{
+				n_follow = 2;
+				max = 0x9F;
+			}
+			else if(b == 0xF0)
+			{
+				n_follow = 3;
+				min = 0x90;
+			}
+			else if(b >= 0xF1 && b <= 0xF3)
+				n_follow = 3;
+			else if(b == 0xF4)
+			{
+				n_follow = 3;
+				max = 0x8F;
+			}
+			else
+				return i;
+
+			for(unsigned k = 1; k <= n_follow; k++)
+			{
+				if(i + k >= n_bytes || arr_bytes[i + k] < min || arr_bytes[i + k] > max)
+					return i + k;
+				min = 0x80;
+				max = 0xBF;
+			}
+			i += 1 + n_follow;
+		}
+		return n_bytes;
+	}
+
+	TEST(io_text_encoding_utf8, Validation)
+	{
+		// every pair of leading bytes with some follow-ups, placed across the block boundaries of the vector kernels
+		const byte_t follow_ups[] = { 0x41U, 0x80U, 0xBFU };
+		byte_t bytes[48];
+		char32_t chars[48];
+		for(unsigned b0 = 0; b0 < 256; b0++)
+			for(unsigned b1 = 0; b1 < 256; b1++)
+				for(unsigned f = 0; f < 9; f++)
+				{
+					memset(bytes, 0x61, sizeof(bytes));
+					const usys_t offset = 12 + (b0 + b1) % 24;
+					bytes[offset + 0] = (byte_t)b0;
+					bytes[offset + 1] = (byte_t)b1;
+					bytes[offset + 2] = follow_ups[f / 3];
+					bytes[offset + 3] = follow_ups[f % 3];
+
+					const usys_t expect = FirstIllFormedByte(bytes, sizeof(bytes));
+					try
+					{
+						usys_t n_chars;
+						EXPECT_EQ(DecodeUTF8(bytes, sizeof(bytes), chars, n_chars), sizeof(bytes));
+						EXPECT_EQ(expect, sizeof(bytes)) << b0 << " " << b1 << " " << f;
+					}
+					catch(const TInvalidUtf8SequenceException& e)
+					{
+						EXPECT_EQ(e.index, expect) << b0 << " " << b1 << " " << f;
+					}
+				}
+	}
+
 	TEST(io_text_encoding_utf8, TUTF8Encoder)
 	{
 		// single byte ASCII (y)
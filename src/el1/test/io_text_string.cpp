@@ -215,6 +215,60 @@ namespace
 		}
 	}
 
+	TEST(io_text_string, TString_InlineStorage)
+	{
+		// short strings live inside the TString itself
+		TString s = U"abc";
+		EXPECT_TRUE(s.chars.IsInline());
+		s += U"defgh";
+		EXPECT_TRUE(s.chars.IsInline());
+		EXPECT_EQ(s.Length(), TStringChars::N_INLINE);
+
+		s += U"i";
+		EXPECT_FALSE(s.chars.IsInline());
+		EXPECT_EQ(s, TString(U"abcdefghi"));
+
+		// copies of short strings are inline again, moves take the heap buffer along
+		const TString copy = s.SliceSL(0, 3);
+		EXPECT_TRUE(copy.chars.IsInline());
+		EXPECT_EQ(copy, TString(U"abc"));
+
+		const char32_t* const arr_heap = s.chars.Data();
+		TString moved = std::move(s);
+		EXPECT_EQ(moved.chars.Data(), arr_heap);
+		EXPECT_EQ(s.Length(), 0U);
+		EXPECT_TRUE(s.chars.IsInline());
+
+		TString inline_moved = TString(U"xyz");
+		EXPECT_EQ(inline_moved, TString(U"xyz"));
+		inline_moved = std::move(moved);
+		EXPECT_EQ(inline_moved, TString(U"abcdefghi"));
+
+		// self-referencing appends and inserts must survive the buffer growing
+		TString self = U"0123456";
+		self.chars.Append(self.chars.Data(), self.Length());
+		EXPECT_EQ(self, TString(U"01234560123456"));
+		self.chars.Insert(0, self.chars.Data() + 7, 7);
+		EXPECT_EQ(self, TString(U"012345601234560123456"));
+
+		// TList relocates its items with memmove
+		TList<TString> list;
+		for(usys_t i = 0; i < 1000; i++)
+			list.Append(i % 2 ? TString::Format(U"%d", i) : TString::Format(U"long string number %d", i));
+		for(usys_t i = 0; i < 1000; i++)
+			EXPECT_EQ(list[i], i % 2 ? TString::Format(U"%d", i) : TString::Format(U"long string number %d", i));
+
+		TString cleared = U"abcdefghijklmnop";
+		cleared.chars.Clear(NEG1);
+		EXPECT_EQ(cleared.Length(), 0U);
+		EXPECT_FALSE(cleared.chars.IsInline());
+		cleared.chars.Clear();
+		EXPECT_TRUE(cleared.chars.IsInline());
+
+		const char* const utf8 = "äöü and more than eight";
+		EXPECT_TRUE(strcmp(TString(utf8).MakeCStr().get(), utf8) == 0);
+	}
+
 	TEST(io_text_string, TString_Compare)
 	{
 		const TString s1 = U"hello world";
@@ -2,9 +2,11 @@
 #include <atomic>
 #include <signal.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
 #include <el1/system_task.hpp>
 #include <el1/system_time_timer.hpp>
+#include <el1/io_stream.hpp>
 #include <el1/io_collection_map.hpp>
 #include "util.hpp"
 
@@ -17,6 +19,7 @@ namespace
 	using namespace el1::system::time::timer;
 	using namespace el1::util::function;
 	using namespace el1::io::collection::map;
+	using namespace el1::io::stream;
 	using namespace el1::testing;
 	using namespace el1::error;
 
@@ -472,6 +475,106 @@ namespace
 	}
 	#endif
 
+	TEST(system_task, TFiber_stack_pool_recycles)
+	{
+		// holds on to every 64 KiB stack earlier tests left in the pool, so the counts below do not depend on them
+		TList<std::unique_ptr<TFiber>> drained;
+		for(const u64_t n_misses = TThread::Self()->StackPoolStats().n_misses; TThread::Self()->StackPoolStats().n_misses == n_misses; )
+			drained.MoveAppend(std::make_unique<TFiber>([](){}, false, 64 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC));
+
+		{
+			// makes sure the pool of the thread exists
+			TFiber fiber([](){}, false, 64 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+		}
+
+		const stack_pool_stats_t before = TThread::Self()->StackPoolStats();
+		EXPECT_GE(before.n_cached, 1U);
+
+		for(int i = 0; i < 3; i++)
+		{
+			volatile bool done = false;
+			TFiber fiber([&](){
+				volatile byte_t buffer[32 * 1024];
+				for(usys_t j = 0; j < sizeof(buffer); j++)
+					buffer[j] = (byte_t)j;
+				done = buffer[1] == 1;
+			}, false, 64 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+			EXPECT_EQ(fiber.StackTotal(), 64U * 1024U);
+			fiber.Start();
+			fiber.SwitchTo();
+			EXPECT_TRUE(done);
+		}
+
+		const stack_pool_stats_t after = TThread::Self()->StackPoolStats();
+		EXPECT_EQ(after.n_hits, before.n_hits + 3);
+		EXPECT_EQ(after.n_misses, before.n_misses);
+		EXPECT_EQ(after.n_cached, before.n_cached);
+
+		// more stacks than stay hot, the cold ones get their pages discarded and must still work afterwards
+		for(int round = 0; round < 2; round++)
+		{
+			TList<std::unique_ptr<TFiber>> fibers;
+			unsigned n_done = 0;
+			for(int i = 0; i < 8; i++)
+				fibers.MoveAppend(std::make_unique<TFiber>([&](){
+					volatile byte_t buffer[48 * 1024];
+					for(usys_t j = 0; j < sizeof(buffer); j++)
+						buffer[j] = (byte_t)j;
+					if(buffer[sizeof(buffer) - 1] == (byte_t)(sizeof(buffer) - 1))
+						n_done++;
+				}, true, 64 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC));
+			for(auto& fiber : fibers)
+				EXPECT_EQ(fiber->Join(), nullptr);
+			EXPECT_EQ(n_done, 8U);
+		}
+		EXPECT_GE(TThread::Self()->StackPoolStats().n_cached, 8U);
+
+		// odd sizes are rounded up to their size class
+		TFiber odd([](){}, false, 40 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+		EXPECT_EQ(odd.StackTotal(), 64U * 1024U);
+		EXPECT_EQ(TThread::Self()->StackPoolStats().n_hits, before.n_hits + 3 + 1 + 8 + 1);
+	}
+
+	TEST(system_task, TFiber_stack_pool_disabled)
+	{
+		const usys_t max_old = TFiber::STACK_POOL_MAX_BYTES;
+		{
+			TFiber fiber([](){}, false, 16 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+		}
+		TFiber::STACK_POOL_MAX_BYTES = 0;
+
+		const stack_pool_stats_t before = TThread::Self()->StackPoolStats();
+		{
+			TFiber fiber([](){}, false, 16 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+		}
+		const stack_pool_stats_t after = TThread::Self()->StackPoolStats();
+		EXPECT_EQ(after.n_hits, before.n_hits);
+		EXPECT_EQ(after.n_cached, before.n_cached);
+		EXPECT_EQ(after.sz_cached, before.sz_cached);
+
+		TFiber::STACK_POOL_MAX_BYTES = max_old;
+	}
+
+	#if defined(EL_OS_LINUX)
+	TEST(system_task, TFiber_recycled_stack_guard_faults)
+	{
+		EXPECT_EXIT({
+			TFiber::STACK_POOL_MAX_BYTES = TThread::Self()->StackPoolStats().sz_cached + 1024 * 1024;
+			{
+				TFiber fiber([](){}, false, 16 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+			}
+			const u64_t n_hits = TThread::Self()->StackPoolStats().n_hits;
+			volatile usys_t counter = 1;
+			volatile bool keep_going = true;
+			TFiber fiber([&](){ OverflowFiberStack(&counter, &keep_going); }, false, 16 * 1024, nullptr, EStackAllocator::VIRTUAL_ALLOC);
+			if(TThread::Self()->StackPoolStats().n_hits == n_hits)
+				exit(1);
+			fiber.Start();
+			fiber.SwitchTo();
+		}, KilledBySignal(SIGSEGV), "TFiber stack overflow");
+	}
+	#endif
+
 	TEST(system_task, TFiber_libc_compat)
 	{
 		bool status = false;
@@ -552,6 +655,386 @@ namespace
 		Checkpoint(counter, 11);
 	}
 
+	struct TSchedulerBackendScope
+	{
+		const ESchedulerBackend previous;
+
+		TSchedulerBackendScope(const ESchedulerBackend backend) : previous(TThread::Self()->SchedulerBackend())
+		{
+			TThread::Self()->SchedulerBackend(backend);
+		}
+
+		~TSchedulerBackendScope()
+		{
+			TThread::Self()->SchedulerBackend(previous);
+		}
+	};
+
+	TEST(system_task, TFiber_scheduler_backends_wake_pipe_readers)
+	{
+		for(const ESchedulerBackend backend : { ESchedulerBackend::POLL, ESchedulerBackend::EPOLL })
+		{
+			TSchedulerBackendScope scope(backend);
+			static const unsigned N_PIPES = 16;
+			TList<std::unique_ptr<TPipe>> pipes;
+			TList<std::unique_ptr<TFiber>> readers;
+			byte_t received[N_PIPES] = {};
+
+			for(unsigned i = 0; i < N_PIPES; i++)
+			{
+				TPipe* const pipe = pipes.MoveAppend(std::make_unique<TPipe>()).get();
+				pipe->ReceiveSide().BlockingIO(false);
+				readers.MoveAppend(std::make_unique<TFiber>([pipe, &received, i](){
+					pipe->ReadAll(&received[i], 1);
+				}));
+			}
+
+			// let every reader block on its pipe, then wake them up in reverse order
+			TFiber::Yield();
+			for(unsigned i = N_PIPES; i > 0; i--)
+			{
+				const byte_t value = (byte_t)(0x40 + i - 1);
+				pipes[i - 1]->WriteAll(&value, 1);
+				TFiber::Sleep(0.001);
+				EXPECT_EQ(received[i - 1], value);
+			}
+
+			for(auto& reader : readers)
+				EXPECT_EQ(reader->Join(), nullptr);
+		}
+	}
+
+	TEST(system_task, TFiber_ready_queue_round_robin)
+	{
+		const usys_t n_fibers_before = TThread::Self()->Fibers().Count();
+		TList<unsigned> order;
+		TList<std::unique_ptr<TFiber>> fibers;
+
+		for(unsigned i = 0; i < 4; i++)
+			fibers.MoveAppend(std::make_unique<TFiber>([&order, i](){
+				for(unsigned round = 0; round < 3; round++)
+				{
+					order.Append(i);
+					TFiber::Yield();
+				}
+			}));
+
+		// a stopped fiber is skipped by the scheduler until it gets resumed
+		fibers[3]->Stop();
+
+		// every Yield() of the main fiber lets each ready fiber run once
+		for(unsigned round = 0; round < 3; round++)
+		{
+			TFiber::Yield();
+			EXPECT_EQ(order.Count(), (round + 1) * 3);
+		}
+
+		for(unsigned i = 0; i < 3; i++)
+			EXPECT_EQ(fibers[i]->Join(), nullptr);
+
+		EXPECT_EQ(fibers[3]->State(), EFiberState::STOPPED);
+		fibers[3]->Resume();
+		EXPECT_EQ(fibers[3]->Join(), nullptr);
+
+		const unsigned expected[] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 3, 3, 3 };
+		ASSERT_EQ(order.Count(), sizeof(expected) / sizeof(expected[0]));
+		for(usys_t i = 0; i < order.Count(); i++)
+			EXPECT_EQ(order[i], expected[i]);
+
+		EXPECT_EQ(TThread::Self()->Fibers().Count(), n_fibers_before);
+	}
+
+	TEST(system_task, TFiber_polled_waitables_next_to_handle_waitables)
+	{
+		for(const ESchedulerBackend backend : { ESchedulerBackend::POLL, ESchedulerBackend::EPOLL })
+		{
+			TSchedulerBackendScope scope(backend);
+			static const unsigned N_PIPES = 8;
+			TList<std::unique_ptr<TPipe>> pipes;
+			TList<std::unique_ptr<TFiber>> readers;
+			byte_t received[N_PIPES] = {};
+			u32_t flag = 0;
+			bool woken = false;
+
+			for(unsigned i = 0; i < N_PIPES; i++)
+			{
+				TPipe* const pipe = pipes.MoveAppend(std::make_unique<TPipe>()).get();
+				pipe->ReceiveSide().BlockingIO(false);
+				readers.MoveAppend(std::make_unique<TFiber>([pipe, &received, i](){
+					pipe->ReadAll(&received[i], 1);
+				}));
+			}
+
+			// TMemoryWaitable can not be reported by the kernel - the scheduler has to poll it
+			TFiber waiter([&](){
+				TMemoryWaitable<u32_t> on_flag(&flag, nullptr, 1);
+				on_flag.WaitFor();
+				woken = true;
+			});
+
+			TFiber::Yield();
+			EXPECT_FALSE(woken);
+			EXPECT_EQ(waiter.State(), EFiberState::BLOCKED);
+
+			flag = 1;
+			EXPECT_EQ(waiter.Join(), nullptr);
+			EXPECT_TRUE(woken);
+
+			for(unsigned i = 0; i < N_PIPES; i++)
+			{
+				const byte_t value = (byte_t)(0x20 + i);
+				pipes[i]->WriteAll(&value, 1);
+				EXPECT_EQ(readers[i]->Join(), nullptr);
+				EXPECT_EQ(received[i], value);
+			}
+		}
+	}
+
+	TEST(system_task, TFiber_epoll_handles_reused_fd_numbers)
+	{
+		TSchedulerBackendScope scope(ESchedulerBackend::EPOLL);
+
+		for(unsigned round = 0; round < 3; round++)
+		{
+			TPipe pipe;
+			pipe.ReceiveSide().BlockingIO(false);
+			byte_t value = 0;
+
+			// times out while the fd stays armed in the epoll set
+			EXPECT_FALSE(pipe.OnInputReady()->WaitFor(0.001));
+
+			TFiber writer([&](){
+				const byte_t v = 0x55;
+				pipe.WriteAll(&v, 1);
+			});
+
+			pipe.ReadAll(&value, 1);
+			EXPECT_EQ(value, 0x55);
+			EXPECT_EQ(writer.Join(), nullptr);
+
+			// the next round gets the same fd numbers again, the epoll registration has to follow
+			pipe.Close();
+		}
+	}
+
+	TEST(system_task, TFiber_epoll_regular_file_is_always_ready)
+	{
+		TSchedulerBackendScope scope(ESchedulerBackend::EPOLL);
+		THandle file(EL_SYSERR(open("/proc/self/status", O_RDONLY | O_CLOEXEC)), true);
+		THandleWaitable waitable({ .read = true, .write = false, .other = false }, file);
+		EXPECT_TRUE(waitable.WaitFor(1));
+	}
+
+	struct TIoBackendScope
+	{
+		const EIoBackend previous;
+
+		TIoBackendScope(const EIoBackend backend) : previous(TThread::Self()->IoBackend())
+		{
+			TThread::Self()->IoBackend(backend);
+		}
+
+		~TIoBackendScope()
+		{
+			TThread::Self()->IoBackend(previous);
+		}
+	};
+
+	static void KernelStreamPipe(std::unique_ptr<TKernelStream>& rx, std::unique_ptr<TKernelStream>& tx)
+	{
+		fd_t fds[2] = { -1, -1 };
+		EL_SYSERR(pipe2(fds, O_CLOEXEC));
+		rx = std::make_unique<TKernelStream>(THandle(fds[0], true));
+		tx = std::make_unique<TKernelStream>(THandle(fds[1], true));
+	}
+
+	TEST(system_task, TFiber_io_uring_kernel_stream_transfers)
+	{
+		TIoBackendScope io_backend(EIoBackend::IO_URING);
+
+		for(const ESchedulerBackend backend : { ESchedulerBackend::POLL, ESchedulerBackend::EPOLL })
+		{
+			TSchedulerBackendScope scope(backend);
+			static const unsigned N_PIPES = 8;
+			static const usys_t SZ_DATA = 256 * 1024;	// several times the pipe capacity, readers and writers have to take turns
+
+			TList<std::unique_ptr<TKernelStream>> streams;
+			TList<std::unique_ptr<TFiber>> fibers;
+			std::unique_ptr<byte_t[]> received(new byte_t[N_PIPES * SZ_DATA]);
+			std::unique_ptr<byte_t[]> sent(new byte_t[N_PIPES * SZ_DATA]);
+			for(usys_t i = 0; i < N_PIPES * SZ_DATA; i++)
+				sent[i] = (byte_t)(i * 7 + i / SZ_DATA);
+
+			for(unsigned i = 0; i < N_PIPES; i++)
+			{
+				std::unique_ptr<TKernelStream> rx, tx;
+				KernelStreamPipe(rx, tx);
+				TKernelStream* const p_rx = streams.MoveAppend(std::move(rx)).get();
+				TKernelStream* const p_tx = streams.MoveAppend(std::move(tx)).get();
+
+				fibers.MoveAppend(std::make_unique<TFiber>([p_rx, &received, i](){
+					p_rx->ReadAll(received.get() + i * SZ_DATA, SZ_DATA);
+				}));
+
+				fibers.MoveAppend(std::make_unique<TFiber>([p_tx, &sent, i](){
+					p_tx->WriteAll(sent.get() + i * SZ_DATA, SZ_DATA);
+				}));
+			}
+
+			for(auto& fiber : fibers)
+				EXPECT_EQ(fiber->Join(), nullptr);
+
+			EXPECT_EQ(memcmp(received.get(), sent.get(), N_PIPES * SZ_DATA), 0);
+		}
+	}
+
+	TEST(system_task, TFiber_io_uring_read_timeout_cancels_transfer)
+	{
+		TIoBackendScope io_backend(EIoBackend::IO_URING);
+		std::unique_ptr<TKernelStream> rx, tx;
+		KernelStreamPipe(rx, tx);
+
+		byte_t buffer[4] = {};
+		EXPECT_EQ(rx->BlockingRead(buffer, sizeof(buffer), 0.01), 0U);
+
+		// the cancelled read must not have swallowed anything
+		const byte_t data[4] = { 1, 2, 3, 4 };
+		tx->WriteAll(data, sizeof(data));
+		EXPECT_EQ(rx->BlockingRead(buffer, sizeof(buffer), 1), sizeof(buffer));
+		EXPECT_EQ(memcmp(buffer, data, sizeof(data)), 0);
+
+		// EOF
+		tx.reset();
+		EXPECT_EQ(rx->BlockingRead(buffer, sizeof(buffer), 1), 0U);
+		EXPECT_EQ(rx->OnInputReady(), nullptr);
+	}
+
+	TEST(system_task, TFiber_io_uring_shutdown_while_in_flight)
+	{
+		std::unique_ptr<TKernelStream> rx, tx;
+		KernelStreamPipe(rx, tx);
+		bool shutdown = false;
+
+		{
+			TIoBackendScope io_backend(EIoBackend::IO_URING);
+
+			TFiber reader([&](){
+				try
+				{
+					byte_t value;
+					const usys_t n = rx->BlockingRead(&value, 1);
+					(void)n;
+				}
+				catch(shutdown_t)
+				{
+					shutdown = true;
+					throw;
+				}
+			});
+
+			TFiber::Yield();
+			reader.Shutdown();
+			EXPECT_EQ(reader.Join(), nullptr);
+			EXPECT_TRUE(shutdown);
+
+			// leaving the scope switches back to READINESS, which fails while a transfer is still in flight
+		}
+
+		const byte_t value = 0x42;
+		tx->WriteAll(&value, 1);
+		byte_t received = 0;
+		rx->ReadAll(&received, 1);
+		EXPECT_EQ(received, 0x42);
+	}
+
+	TEST(system_task, TFiber_io_uring_kill_while_in_flight)
+	{
+		std::unique_ptr<TKernelStream> rx, tx;
+		KernelStreamPipe(rx, tx);
+
+		{
+			TIoBackendScope io_backend(EIoBackend::IO_URING);
+
+			{
+				// the buffer lives on the stack of the fiber, the stack must outlive the cancelled read
+				TFiber reader([&](){
+					byte_t value;
+					const usys_t n = rx->BlockingRead(&value, 1);
+					(void)n;
+				});
+
+				TFiber::Yield();
+				EXPECT_TRUE(reader.Kill());
+			}
+
+			// lets the scheduler reap the cancellation, leaving the scope fails while a transfer is still in flight
+			TFiber::Sleep(0.01);
+		}
+
+		const byte_t value = 0x42;
+		tx->WriteAll(&value, 1);
+		byte_t received = 0;
+		rx->ReadAll(&received, 1);
+		EXPECT_EQ(received, 0x42);
+	}
+
+	TEST(system_task, TFiberPool_spawn)
+	{
+		TFiberPool pool(3, 64 * 1024);
+		EXPECT_EQ(pool.CountWorkers(), 3U);
+
+		static const unsigned N_FIBERS = 200;
+		std::atomic<unsigned> n_done(0);
+		TSimpleMutex mutex;
+		TList<const TThread*> threads;
+
+		for(unsigned i = 0; i < N_FIBERS; i++)
+			pool.Spawn([&](){
+				// fibers on the same worker block and yield between each other
+				TFiber::Sleep(0.001);
+				{
+					const TMutexAutoLock lock(&mutex);
+					if(!threads.Contains(TThread::Self()))
+						threads.Append(TThread::Self());
+				}
+				n_done++;
+			});
+
+		EXPECT_TRUE(pool.WaitIdle(10));
+		EXPECT_EQ(n_done.load(), N_FIBERS);
+		EXPECT_EQ(pool.CountPending(), 0U);
+		EXPECT_EQ(threads.Count(), 3U);
+		EXPECT_FALSE(threads.Contains(TThread::Self()));
+	}
+
+	TEST(system_task, TFiberPool_idle_worker_steals)
+	{
+		TFiberPool pool(2, 64 * 1024);
+		static const unsigned N_FIBERS = 8;
+		std::atomic<bool> spinning(false);
+		std::atomic<unsigned> n_done(0);
+		bool all_done_while_spinning = false;
+
+		// the first fiber keeps its worker busy without ever calling the scheduler
+		pool.Spawn([&](){
+			spinning = true;
+			const TTime ts_deadline = TTime::Now(EClock::MONOTONIC) + 5;
+			while(n_done < N_FIBERS && TTime::Now(EClock::MONOTONIC) < ts_deadline);
+			all_done_while_spinning = n_done == N_FIBERS;
+		});
+
+		while(!spinning)
+			TFiber::Sleep(0.001);
+
+		// half of these are queued on the busy worker, the other worker has to steal them
+		for(unsigned i = 0; i < N_FIBERS; i++)
+			pool.Spawn([&](){ n_done++; });
+
+		EXPECT_TRUE(pool.WaitIdle(10));
+		EXPECT_TRUE(all_done_while_spinning);
+		EXPECT_GE(pool.CountStolen(), 1U);
+	}
+
 	TEST(system_task, TFiber_shutdown)
 	{
 		TFiber a([](){
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <el1/io_collection_list.hpp>
+#include <el1/util_event.hpp>
+#include <el1/util_function.hpp>
+#include <memory>
+
+using namespace ::testing;
+
+namespace
+{
+	using namespace el1::io::types;
+	using namespace el1::io::collection::list;
+	using namespace el1::util::event;
+	using namespace el1::util::function;
+
+	static int Twice(int x)
+	{
+		return x * 2;
+	}
+
+	struct TCounter
+	{
+		int n = 0;
+		void Add(int x) { n += x; }
+	};
+
+	TEST(util_function, TFunction_Callables)
+	{
+		TFunction<int, int> empty;
+		EXPECT_FALSE(empty);
+
+		TFunction<int, int> basic(&Twice);
+		EXPECT_TRUE(basic);
+		EXPECT_EQ(basic(21), 42);
+
+		int base = 100;
+		TFunction<int, int> small([&base](int x) { return base + x; });
+		EXPECT_EQ(small(1), 101);
+		base = 200;
+		EXPECT_EQ(small(1), 201);
+
+		// too large to be stored inline
+		const u64_t big[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+		TFunction<int, int> large([big](int x) { return (int)big[7] + x; });
+		EXPECT_EQ(large(2), 10);
+
+		TCounter counter;
+		TFunction<void, int> member(&counter, &TCounter::Add);
+		member(5);
+		member(6);
+		EXPECT_EQ(counter.n, 11);
+
+		TFunction<int, int> moved = std::move(small);
+		EXPECT_FALSE(small);
+		EXPECT_EQ(moved(2), 202);
+
+		small = large;
+		EXPECT_EQ(small(3), 11);
+		EXPECT_EQ(large(3), 11);
+	}
+
+	TEST(util_function, TFunction_Equality)
+	{
+		TCounter a;
+		TCounter b;
+
+		// bindings of the same member function on the same object are equal, even when constructed separately
+		using receiver_t = TFunction<void, int>;
+		EXPECT_TRUE(receiver_t(&a, &TCounter::Add) == receiver_t(&a, &TCounter::Add));
+		EXPECT_FALSE(receiver_t(&a, &TCounter::Add) == receiver_t(&b, &TCounter::Add));
+
+		// heap-allocated callables are only equal to their copies
+		auto shared = std::make_shared<int>(1);
+		TFunction<int> f1([shared]() { return *shared; });
+		TFunction<int> f2([shared]() { return *shared; });
+		const TFunction<int> f1_copy = f1;
+		EXPECT_TRUE(f1 == f1_copy);
+		EXPECT_FALSE(f1 == f2);
+
+		TEvent<int> event;
+		event += receiver_t(&a, &TCounter::Add);
+		event += receiver_t(&b, &TCounter::Add);
+		event.Raise(3);
+		event -= receiver_t(&a, &TCounter::Add);
+		event.Raise(4);
+		EXPECT_EQ(a.n, 3);
+		EXPECT_EQ(b.n, 7);
+	}
+
+	TEST(util_function, TFunction_Lifetime)
+	{
+		auto shared = std::make_shared<int>(7);
+		{
+			TFunction<int> f([shared]() { return *shared; });
+			EXPECT_EQ(shared.use_count(), 2);
+
+			// copies share the callable
+			TList<TFunction<int>> list;
+			for(int i = 0; i < 100; i++)
+				list.Append(f);
+			EXPECT_EQ(shared.use_count(), 2);
+			EXPECT_EQ(list[99](), 7);
+		}
+		EXPECT_EQ(shared.use_count(), 1);
+	}
+
+	TEST(util_function, TUniqueFunction)
+	{
+		// move-only captures are stored inline
+		auto unique = std::make_unique<int>(5);
+		TUniqueFunction<int, int> f([p = std::move(unique)](int x) { return *p + x; });
+		EXPECT_EQ(f(1), 6);
+
+		TList<TUniqueFunction<int, int>> list;
+		for(int i = 0; i < 100; i++)
+			list.MoveAppend(TUniqueFunction<int, int>([p = std::make_unique<int>(i)](int x) { return *p + x; }));
+		list.MoveAppend(std::move(f));
+		EXPECT_FALSE(f);
+		EXPECT_EQ(list[42](1), 43);
+		EXPECT_EQ(list[100](1), 6);
+
+		// large move-only captures are owned through a single heap allocation
+		auto shared = std::make_shared<int>(9);
+		{
+			const u64_t big[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+			TUniqueFunction<int, int> large([big, shared, p = std::make_unique<int>(1)](int x) { return (int)big[7] + *shared + *p + x; });
+			EXPECT_EQ(large(0), 18);
+			EXPECT_EQ(shared.use_count(), 2);
+
+			TUniqueFunction<int, int> moved = std::move(large);
+			EXPECT_EQ(moved(1), 19);
+			EXPECT_EQ(shared.use_count(), 2);
+		}
+		EXPECT_EQ(shared.use_count(), 1);
+
+		// converting a TFunction takes over its storage
+		TCounter counter;
+		TFunction<void, int> member(&counter, &TCounter::Add);
+		TUniqueFunction<void, int> copied = member;
+		TUniqueFunction<void, int> adopted = std::move(member);
+		copied(1);
+		adopted(2);
+		EXPECT_EQ(counter.n, 3);
+	}
+}
@@ -1,80 +1,218 @@
 #pragma once
 
+#include "io_types.hpp"
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <utility>
+#include <string.h>
 
 namespace el1::util::function
 {
-	template<typename R, typename ...A>
-	struct IFunction
-	{
-		virtual R operator()(A ...a) const = 0;
-		virtual ~IFunction() {}
-	};
-
-	template<typename T, typename R, typename ...A>
-	class TMemberFunction : public IFunction<R, A...>
-	{
-		public:
-			using function_ptr_t = R (T::*)(A... a);
+	// callables up to this size are stored inside the function object instead of on the heap
+	// this fits function pointers, member function bindings and lambdas capturing up to three pointers, references or numbers
+	static const io::types::usys_t FUNCTION_INLINE_BYTES = 3 * sizeof(void*);
 
-		protected:
-			T* const object;
-			function_ptr_t function;
+	template<typename R, typename ...A>
+	class TFunction;
 
-		public:
-			R operator()(A ...a) const final override { return (this->object->*function)(a...); }
-			TMemberFunction(T* object, function_ptr_t function) : object(object), function(function) {}
-	};
+	template<typename R, typename ...A>
+	class TUniqueFunction;
 
+	namespace detail
+	{
+		struct function_storage_t
+		{
+			alignas(void*) io::types::byte_t bytes[FUNCTION_INLINE_BYTES];
+		};
+
+		// one table per stored callable type, nullptr entries mean the storage can be copied/moved bytewise and needs no destruction
+		template<typename R, typename ...A>
+		struct function_ops_t
+		{
+			R (*invoke)(const function_storage_t& storage, A&& ... a);
+			void (*copy)(function_storage_t& to, const function_storage_t& from);
+			void (*relocate)(function_storage_t& to, function_storage_t& from) noexcept;
+			void (*destroy)(function_storage_t& storage) noexcept;
+		};
+
+		template<typename L>
+		inline constexpr bool FITS_INLINE = sizeof(L) <= FUNCTION_INLINE_BYTES && alignof(L) <= alignof(function_storage_t) && std::is_nothrow_move_constructible_v<L>;
+
+		template<typename L, typename R, typename ...A>
+		struct inline_callable_tt
+		{
+			static L& Get(const function_storage_t& storage) { return *std::launder(reinterpret_cast<L*>(const_cast<io::types::byte_t*>(storage.bytes))); }
+			static R Invoke(const function_storage_t& storage, A&& ... a) { return static_cast<const L&>(Get(storage))(std::forward<A>(a)...); }
+			static void Copy(function_storage_t& to, const function_storage_t& from) { new (to.bytes) L(static_cast<const L&>(Get(from))); }
+			static void Relocate(function_storage_t& to, function_storage_t& from) noexcept { new (to.bytes) L(std::move(Get(from))); Get(from).~L(); }
+			static void Destroy(function_storage_t& storage) noexcept { Get(storage).~L(); }
+
+			static constexpr function_ops_t<R, A...> MakeOps()
+			{
+				if constexpr(std::is_trivially_copyable_v<L>)
+					return { &Invoke, nullptr, nullptr, nullptr };
+				else if constexpr(std::is_copy_constructible_v<L>)
+					return { &Invoke, &Copy, &Relocate, &Destroy };
+				else
+					return { &Invoke, nullptr, &Relocate, &Destroy };
+			}
+
+			static constexpr function_ops_t<R, A...> OPS = MakeOps();
+		};
+
+		template<typename T, typename R, typename ...A>
+		struct member_binding_tt
+		{
+			T* object;
+			R (T::*function)(A... a);
+
+			R operator()(A ... a) const { return (object->*function)(std::forward<A>(a)...); }
+		};
+
+		// heap storage of TFunction, copies share the callable
+		template<typename L>
+		struct shared_callable_tt
+		{
+			std::shared_ptr<const L> callable;
+
+			template<typename ...P>
+			decltype(auto) operator()(P&& ... p) const { return (*callable)(std::forward<P>(p)...); }
+		};
+
+		// heap storage of TUniqueFunction
+		template<typename L>
+		struct unique_callable_tt
+		{
+			std::unique_ptr<const L> callable;
+
+			template<typename ...P>
+			decltype(auto) operator()(P&& ... p) const { return (*callable)(std::forward<P>(p)...); }
+		};
+
+		template<typename R, typename ...A>
+		class TFunctionBase
+		{
+			protected:
+				using ops_t = function_ops_t<R, A...>;
+
+				const ops_t* ops;
+				function_storage_t storage;
+
+				// the unused bytes are zeroed, so two functions holding the same callable compare equal bytewise
+				template<typename L>
+				void Emplace(L&& callable)
+				{
+					using callable_t = std::decay_t<L>;
+					static_assert(FITS_INLINE<callable_t>);
+					memset(storage.bytes, 0, sizeof(storage.bytes));
+					new (storage.bytes) callable_t(std::forward<L>(callable));
+					ops = &inline_callable_tt<callable_t, R, A...>::OPS;
+				}
+
+				void CopyFrom(const TFunctionBase& other)
+				{
+					if(other.ops != nullptr && other.ops->copy != nullptr)
+					{
+						memset(storage.bytes, 0, sizeof(storage.bytes));
+						other.ops->copy(storage, other.storage);
+					}
+					else
+						storage = other.storage;
+					ops = other.ops;
+				}
+
+				void MoveFrom(TFunctionBase& other) noexcept
+				{
+					if(other.ops != nullptr && other.ops->relocate != nullptr)
+					{
+						memset(storage.bytes, 0, sizeof(storage.bytes));
+						other.ops->relocate(storage, other.storage);
+					}
+					else
+						storage = other.storage;
+					ops = other.ops;
+					other.ops = nullptr;
+				}
+
+				void Release() noexcept
+				{
+					if(ops != nullptr && ops->destroy != nullptr)
+						ops->destroy(storage);
+					ops = nullptr;
+				}
+
+				TFunctionBase() : ops(nullptr), storage() {}
+				~TFunctionBase() { Release(); }
+
+			public:
+				// calling an empty function is undefined
+				R operator()(A ... a) const { return ops->invoke(storage, std::forward<A>(a)...); }
+				explicit operator bool() const { return ops != nullptr; }
+		};
+	}
+
+	// copyable function object
+	// trivially copyable callables which fit into FUNCTION_INLINE_BYTES are stored inline and copied along with the TFunction,
+	// all other callables are allocated on the heap once and shared between the copies
+	// two TFunctions compare equal when they are copies of each other or hold bytewise identical inline callables (e.g. the same member function of the same object)
 	template<typename R, typename ...A>
-	class TBasicFunction : public IFunction<R, A...>
+	class TFunction : public detail::TFunctionBase<R, A...>
 	{
 		public:
-			using function_ptr_t = R (*)(A... a);
-
-		protected:
-			function_ptr_t function;
+			TFunction() = default;
+			TFunction(const TFunction& other) : detail::TFunctionBase<R, A...>() { this->CopyFrom(other); }
+			TFunction(TFunction&& other) noexcept : detail::TFunctionBase<R, A...>() { this->MoveFrom(other); }
+			TFunction& operator=(TFunction&& rhs) noexcept { if(this != &rhs) { this->Release(); this->MoveFrom(rhs); } return *this; }
+			TFunction& operator=(const TFunction& rhs) { if(this != &rhs) { this->Release(); this->CopyFrom(rhs); } return *this; }
 
-		public:
-			R operator()(A ...a) const final override { return function(a...); }
-			TBasicFunction(function_ptr_t function) : function(function) {}
-	};
+			bool operator==(const TFunction& rhs) const { return this->ops == rhs.ops && (this->ops == nullptr || memcmp(this->storage.bytes, rhs.storage.bytes, sizeof(this->storage.bytes)) == 0); }
 
-	template<typename L, typename R, typename ...A>
-	class TLambdaFunction : public IFunction<R, A...>
-	{
-		protected:
-			L lambda;
+			TFunction(R (*function)(A... a)) { this->Emplace(function); }
 
-		public:
-			R operator()(A ...a) const final override { return lambda(a...); }
-			TLambdaFunction(L lambda) : lambda(std::move(lambda)) {}
+			template<typename T>
+			TFunction(T* const object, R (T::*function)(A... a)) { this->Emplace(detail::member_binding_tt<T, R, A...> { object, function }); }
+
+			template<typename L> requires (!std::is_base_of_v<detail::TFunctionBase<R, A...>, std::decay_t<L>>) && std::is_invocable_r_v<R, const std::decay_t<L>&, A...>
+			TFunction(L&& lambda)
+			{
+				using lambda_t = std::decay_t<L>;
+				if constexpr(detail::FITS_INLINE<lambda_t> && std::is_trivially_copyable_v<lambda_t>)
+					this->Emplace(std::forward<L>(lambda));
+				else
+					this->Emplace(detail::shared_callable_tt<lambda_t> { std::make_shared<const lambda_t>(std::forward<L>(lambda)) });
+			}
 	};
 
+	// move-only function object without reference counting
+	// every callable which fits into FUNCTION_INLINE_BYTES is stored inline (including move-only ones), larger ones are owned through a single heap allocation
+	// a TFunction can be converted without allocating
 	template<typename R, typename ...A>
-	class TFunction
+	class TUniqueFunction : public detail::TFunctionBase<R, A...>
 	{
-		protected:
-			std::shared_ptr< IFunction<R, A...> > function;
-
 		public:
-			TFunction() = default;
-			TFunction(const TFunction& other) = default;
-			TFunction(TFunction&&) = default;
-			TFunction& operator=(TFunction&& rhs) = default;
-			TFunction& operator=(const TFunction& rhs) = default;
+			TUniqueFunction() = default;
+			TUniqueFunction(const TUniqueFunction&) = delete;
+			TUniqueFunction(TUniqueFunction&& other) noexcept : detail::TFunctionBase<R, A...>() { this->MoveFrom(other); }
+			TUniqueFunction& operator=(const TUniqueFunction&) = delete;
+			TUniqueFunction& operator=(TUniqueFunction&& rhs) noexcept { if(this != &rhs) { this->Release(); this->MoveFrom(rhs); } return *this; }
 
-			bool operator==(const TFunction& rhs) const { return function.get() == rhs.function.get(); }
-			R operator()(A... a) const { return (*function)(a...); }
+			TUniqueFunction(TFunction<R, A...>&& other) noexcept : detail::TFunctionBase<R, A...>() { this->MoveFrom(other); }
+			TUniqueFunction(const TFunction<R, A...>& other) : detail::TFunctionBase<R, A...>() { this->CopyFrom(other); }
 
-			TFunction(R (*function)(A... a)) : function(new TBasicFunction<R, A...>(function)) {}
+			TUniqueFunction(R (*function)(A... a)) { this->Emplace(function); }
 
 			template<typename T>
-			TFunction(T* const object, R (T::*function)(A... a)) : function(new TMemberFunction<T, R, A...>(object, function)) {}
-
-			template<typename L>
-			TFunction(L lambda) : function(new TLambdaFunction<L, R, A...>(std::move(lambda))) {}
-
+			TUniqueFunction(T* const object, R (T::*function)(A... a)) { this->Emplace(detail::member_binding_tt<T, R, A...> { object, function }); }
+
+			template<typename L> requires (!std::is_base_of_v<detail::TFunctionBase<R, A...>, std::decay_t<L>>) && std::is_invocable_r_v<R, const std::decay_t<L>&, A...>
+			TUniqueFunction(L&& lambda)
+			{
+				using lambda_t = std::decay_t<L>;
+				if constexpr(detail::FITS_INLINE<lambda_t>)
+					this->Emplace(std::forward<L>(lambda));
+				else
+					this->Emplace(detail::unique_callable_tt<lambda_t> { std::make_unique<const lambda_t>(std::forward<L>(lambda)) });
+			}
 	};
 }